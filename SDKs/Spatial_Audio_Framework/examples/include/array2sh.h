@@ -37,6 +37,10 @@
  *     array2sh_setNormType(hA2sh, NORM_N3D);
  *     array2sh_setGain(hA2sh, 6.0f);
  *
+ *     // Build the filterbank and compute the encoder for these settings (also
+ *     // after any later set function; the output is silent until then)
+ *     array2sh_initCodec(hA2sh);
+ *
  *     // The framesize of this example is fixed, and can be found with
  *     frameSize = array2sh_getFrameSize();
  *
@@ -147,6 +151,52 @@ typedef enum {
 /** Number of available filter types */
 #define ARRAY2SH_NUM_FILTER_TYPES ( 4 )
 
+/**
+ * Available time-frequency transforms (filterbanks), which the encoding
+ * filters are applied in. All of them use a hop size of 128 samples.
+ *
+ * The figures given below are the processing delay (analysis + synthesis), and
+ * the approximate cost of passing one channel through the filterbank (analysis
+ * + synthesis) for one hop, as measured on an x86-64 desktop machine with
+ * OpenBLAS. With the Eigenmike32 at 4th order, the filterbank accounts for
+ * roughly 90% of the total encoding cost with the default afSTFT. The
+ * memory held per instance is dominated by the (at most 133 band) time-
+ * frequency buffers in every case, except for the QMF bank, which additionally
+ * holds its ~0.5 MB of analysis/synthesis modulators.
+ *
+ * @note The hybrid filtering of #ARRAY2SH_FILTERBANK_AFSTFT_HYBRID subdivides
+ *       the lowest bands, which gives finer frequency resolution for the
+ *       strong low-frequency equalisation of the higher orders. The other
+ *       filterbanks trade this resolution for lower latency and/or cost.
+ */
+typedef enum {
+    ARRAY2SH_FILTERBANK_AFSTFT_HYBRID = 1, /**< afSTFT with hybrid filtering
+                                            *   (default); 133 bands, 1536
+                                            *   samples delay, ~8 us */
+    ARRAY2SH_FILTERBANK_AFSTFT_LD,         /**< afSTFT in low-delay mode,
+                                            *   without hybrid filtering; 129
+                                            *   bands, 512 samples delay, ~7.5
+                                            *   us */
+    ARRAY2SH_FILTERBANK_AFSTFT,            /**< afSTFT without hybrid
+                                            *   filtering; 129 bands, 1152
+                                            *   samples delay, ~7.5 us */
+    ARRAY2SH_FILTERBANK_QMF,               /**< SAF's complex QMF bank, without
+                                            *   hybrid filtering; 128 bands,
+                                            *   1153 samples delay, ~100 us */
+    ARRAY2SH_FILTERBANK_STFT               /**< Uniform STFT (rectangular
+                                            *   window, 2x zero-padded); 129
+                                            *   bands, 64 samples delay, ~4.5
+                                            *   us. The encoding filters are
+                                            *   applied by circular convolution,
+                                            *   which is only alias-free for
+                                            *   responses of up to 129 taps, so
+                                            *   expect more low-frequency error
+                                            *   than with the other options */
+}ARRAY2SH_FILTERBANKS;
+
+/** Number of available filterbanks */
+#define ARRAY2SH_NUM_FILTERBANKS ( 5 )
+
 /**
  * List of supported array types.
  *
@@ -191,9 +241,53 @@ typedef enum {
 
 }ARRAY2SH_EVAL_STATUS;
 
+/**
+ * Processing stages of array2sh, which may be timed by installing a stage hook
+ * (see array2sh_setStageHook())
+ */
+typedef enum {
+    ARRAY2SH_STAGE_TFT = 1, /**< Forward or backward time-frequency transform
+                             *   (reported once per direction and batch) */
+    ARRAY2SH_STAGE_SHT      /**< Spherical harmonic transform; i.e. the per-
+                             *   band encoding GEMMs, including the time-domain
+                             *   projection, if any */
+}ARRAY2SH_STAGES;
+
+/**
+ * Stage hook; called with begin=1 when entering, and with begin=0 when leaving
+ * one of the #ARRAY2SH_STAGES
+ */
+typedef void (*array2sh_stageHook)(void* userData, ARRAY2SH_STAGES stage, int begin);
+
+/**
+ * Cache of encoding matrices, through which instances with the same settings
+ * may share them (see array2sh_setEncoderCache())
+ *
+ * An encoder is identified by a key of keySize bytes, which holds everything
+ * that it is computed from; i.e. encoders with equal keys are identical. Once
+ * published, an encoder is only read. The functions may be called from any
+ * instance's processing thread, so the cache must be thread-safe.
+ */
+typedef struct _array2sh_encoderCache {
+    /** Returns a new reference to the encoder published under 'key', or NULL
+     *  if there is none */
+    void* (*acquire)(void* userData, const void* key, int keySize);
+    /** Publishes a newly computed encoder under 'key', which is freed with
+     *  'destroy' once its last reference is released. Returns a reference to
+     *  it, or to one that was published under the same key meanwhile (in which
+     *  case 'encoder' is destroyed straight away) */
+    void* (*publish)(void* userData, const void* key, int keySize, void* encoder,
+                     void (*destroy)(void* encoder));
+    /** Releases a reference returned by acquire() or publish() */
+    void (*release)(void* userData, void* encoder);
+}array2sh_encoderCache;
+
 /** Maximum number of sensors supported */
 #define ARRAY2SH_MAX_NUM_SENSORS ( 2702 ) // ( 64 ) // TODO: not all arrays need that size
 
+/** Maximum number of frequency bands, of any filterbank */
+#define ARRAY2SH_MAX_NUM_BANDS ( 133 )
+
 /** Minimum gain value used for regularised inverse of modal coeffs, dB */
 #define ARRAY2SH_MAX_GAIN_MIN_VALUE ( 0.0f )
 
@@ -224,6 +318,12 @@ typedef enum {
 /** Maximum baffle radius supported, mm */
 #define ARRAY2SH_BAFFLE_RADIUS_MAX_VALUE ( 400.0f ) 
 
+/** Minimum encoder compression tolerance (practically lossless), dB */
+#define ARRAY2SH_COMPRESSION_TOL_MIN_VALUE ( -120.0f )
+
+/** Maximum encoder compression tolerance (cheapest), dB */
+#define ARRAY2SH_COMPRESSION_TOL_MAX_VALUE ( -10.0f )
+
 
 /* ========================================================================== */
 /*                               Main Functions                               */
@@ -252,6 +352,19 @@ void array2sh_destroy(void** const phA2sh);
 void array2sh_init(void* const hA2sh,
                    int samplerate);
 
+/**
+ * Initialises the filterbank, and computes the encoder for the current
+ * settings, if they have changed
+ *
+ * The _process() functions never do so themselves: they output silence from
+ * a change of the settings until this function has returned. It may be called
+ * from a thread other than the processing one; a block being processed is
+ * left to finish first.
+ *
+ * @param[in] hA2sh array2sh handle
+ */
+void array2sh_initCodec(void* const hA2sh);
+
 /**
  * Evaluates the encoder, based on current global/user parameters
  *
@@ -269,6 +382,9 @@ void array2sh_evalEncoder(void* const hA2sh);
  * @param[in] nInputs   Number of input channels
  * @param[in] nOutputs  Number of output channels
  * @param[in] nSamples  Number of samples in 'inputs'/'output' matrices
+ *
+ * @note The outputs are silent until array2sh_initCodec() has been called
+ *       for the current settings
  */
 void array2sh_process(void* const hA2sh,
                       const float *const * inputs,
@@ -277,6 +393,140 @@ void array2sh_process(void* const hA2sh,
                       int nOutputs,
                       int nSamples);
 
+/**
+ * Spatially encode a whole block of microphone/hydrophone array signals into
+ * spherical harmonic signals
+ *
+ * Unlike array2sh_process(), which encodes one frame at a time, this function
+ * applies the filterbank and the encoding matrices over all time slots of the
+ * block at once (in batches of up to 8 time slots); so the per-band encoding
+ * is carried out as a matrix-matrix product, rather than a matrix-vector
+ * product per time slot.
+ *
+ * @note nSamples may be any integer multiple of array2sh_getHopSize()
+ * @note The GEMMs are run on the calling thread only if the BLAS library is
+ *       single-threaded (e.g. OpenBLAS with openblas_set_num_threads(1), or
+ *       MKL sequential); OpenBLAS also locks a shared buffer pool in each
+ *       GEMM, unless it is built with USE_TLS=1
+ *
+ * @param[in] hA2sh     array2sh handle
+ * @param[in] inputs    Input channel buffers; 2-D array: nInputs x nSamples
+ * @param[in] outputs   Output channel buffers; 2-D array: nOutputs x nSamples
+ * @param[in] nInputs   Number of input channels
+ * @param[in] nOutputs  Number of output channels
+ * @param[in] nSamples  Number of samples in 'inputs'/'output' matrices
+ */
+void array2sh_processBlock(void* const hA2sh,
+                           const float *const * inputs,
+                           float** const outputs,
+                           int nInputs,
+                           int nOutputs,
+                           int nSamples);
+
+/**
+ * Same as array2sh_processBlock(), but with the input signals held in a
+ * strided (planar) span; i.e. input channel 'ch' starts at
+ * inputs[ch*inputStride]
+ *
+ * This allows the encoder to read directly from e.g. the channel rows of a
+ * FIFO, without first gathering the samples into separate channel buffers.
+ * Neither the input nor the output samples are copied into intermediate
+ * time-domain buffers; the filterbank reads 'inputs' and writes 'outputs' in
+ * place.
+ *
+ * @note nSamples may be any integer multiple of array2sh_getHopSize(). The
+ *       input span and the output buffers must not overlap.
+ *
+ * @param[in] hA2sh       array2sh handle
+ * @param[in] inputs      First sample of the first input channel
+ * @param[in] inputStride Distance between input channels, in samples
+ * @param[in] outputs     Output channel buffers; 2-D array: nOutputs x nSamples
+ * @param[in] nInputs     Number of input channels
+ * @param[in] nOutputs    Number of output channels
+ * @param[in] nSamples    Number of samples to encode per channel
+ */
+void array2sh_processStrided(void* const hA2sh,
+                             const float* inputs,
+                             int inputStride,
+                             float** const outputs,
+                             int nInputs,
+                             int nOutputs,
+                             int nSamples);
+
+/**
+ * Same as array2sh_processStrided(), but with the output signals held in a
+ * strided (planar) span too; i.e. output channel 'ch' starts at
+ * outputs[ch*outputStride]
+ *
+ * This allows the encoder to write directly into e.g. the channel rows of an
+ * output FIFO, or of a contiguous multichannel buffer.
+ *
+ * @note nSamples may be any integer multiple of array2sh_getHopSize(). The
+ *       input and output spans must not overlap.
+ *
+ * @param[in] hA2sh        array2sh handle
+ * @param[in] inputs       First sample of the first input channel
+ * @param[in] inputStride  Distance between input channels, in samples
+ * @param[in] outputs      First sample of the first output channel
+ * @param[in] outputStride Distance between output channels, in samples
+ * @param[in] nInputs      Number of input channels
+ * @param[in] nOutputs     Number of output channels
+ * @param[in] nSamples     Number of samples to encode per channel
+ */
+void array2sh_processSpans(void* const hA2sh,
+                           const float* inputs,
+                           int inputStride,
+                           float* outputs,
+                           int outputStride,
+                           int nInputs,
+                           int nOutputs,
+                           int nSamples);
+
+/**
+ * Encodes a whole block of source signals, which are first mixed into the
+ * (order+1)^2 projected signals in each band (see array2sh_setCompressionTol()),
+ * into spherical harmonic signals
+ *
+ * Rather than the sensor signals, only the sources are passed through the
+ * filterbank. In each band, the projected signals are mixed from them with
+ * 'mixing', and then encoded as the projected sensor signals would be. E.g.
+ * the signals of the sensors may be formed from a smaller number of sources,
+ * with a delay and a gain each; these are then applied in the time-frequency
+ * domain, as a phase and a gain per band folded into 'mixing' together with
+ * the projection (see array2sh_getProjection()), rather than to each sensor
+ * signal in the time-domain.
+ *
+ * @note nSamples may be any integer multiple of array2sh_getHopSize(). The
+ *       number of sources must be set beforehand with
+ *       array2sh_setNumMixtureSources(); otherwise (or if nSources differs,
+ *       or the encoder has no projection, see array2sh_getProjection()),
+ *       the outputs are silent.
+ *
+ * @param[in] hA2sh        array2sh handle
+ * @param[in] sources      First sample of the first source signal
+ * @param[in] sourceStride Distance between source signals, in samples
+ * @param[in] mixing       Mixing matrices, per band: the projected signals
+ *                         from the sources, complex (interleaved real and
+ *                         imaginary parts); FLAT: nBands x nSH x nSources x 2,
+ *                         nSH = (order+1)^2 of the current encoding order,
+ *                         and nBands as of array2sh_getFreqVector(). In the
+ *                         bands outside of the band range (see
+ *                         array2sh_setBandRange()): the SH signals (N3D, ACN)
+ *                         from the sources, i.e. their encoder
+ * @param[in] outputs      Output channel buffers; 2-D array: nOutputs x nSamples
+ * @param[in] nSources     Number of source signals
+ * @param[in] nOutputs     Number of output channels
+ * @param[in] nSamples     Number of samples to encode per channel
+ */
+void array2sh_processMixture(void* const hA2sh,
+                             const float* sources,
+                             int sourceStride,
+                             const float* mixing,
+                             float** const outputs,
+                             int nSources,
+                             int nOutputs,
+                             int nSamples);
+
 
 /* ========================================================================== */
 /*                                Set Functions                               */
@@ -414,6 +664,95 @@ void array2sh_setc(void* const hA2sh, float newc);
 /** Sets the amount of post gain to apply after the encoding, in DECIBELS */
 void array2sh_setGain(void* const hA2sh, float newGain);
 
+/**
+ * Sets the tolerance used when compressing the encoding matrices, in DECIBELS
+ * (relative error energy, per band)
+ *
+ * In each band, the highest orders whose encoding filters together carry less
+ * energy than this tolerance (relative to the whole band) are not encoded.
+ * Furthermore, if every band of the encoder is found to lie (within this
+ * tolerance) in the space spanned by the pseudo-inverse of the sensor
+ * spherical harmonics, then the sensor signals are first projected onto
+ * (order+1)^2 signals in the time-domain; so only these need to be passed
+ * through the filterbank, and each band only requires a small
+ * (order+1)^2 x (order+1)^2 mixing matrix. Lower values are more accurate,
+ * higher values are cheaper.
+ *
+ * @see array2sh_getCompressionError_Handle(),
+ *      array2sh_getSpatialCorrelationCompressed_Handle()
+ */
+void array2sh_setCompressionTol(void* const hA2sh, float newTol_dB);
+
+/**
+ * Sets the filterbank used for the time-frequency transform (see
+ * #ARRAY2SH_FILTERBANKS enum)
+ *
+ * The new filterbank is created, and the encoding matrices are recomputed for
+ * its frequency bands, with the next array2sh_initCodec() call. Note that the processing
+ * delay (see array2sh_getFilterbankProcessingDelay()) changes with the filterbank.
+ * Values outside the enum are clamped to the nearest filterbank.
+ */
+void array2sh_setFilterbank(void* const hA2sh, int newFilterbank);
+
+/**
+ * Sets the number of source signals that array2sh_processMixture() mixes into
+ * the projected signals (at most #MAX_NUM_SH_SIGNALS), or 0 to encode the
+ * sensor signals
+ *
+ * The filterbank is reconfigured for them with the next array2sh_initCodec() call. As
+ * long as this is non-zero, array2sh_process() and array2sh_processBlock()
+ * output silence, and vice versa.
+ */
+void array2sh_setNumMixtureSources(void* const hA2sh, int nSources);
+
+/**
+ * Sets the range of centre frequencies of the bands that are encoded:
+ * [minFreq, maxFreq), in Hz; all bands by default
+ *
+ * The encoder is not applied in the other bands. These are silent, or, with
+ * array2sh_processMixture(), encoded straight from the sources by the mixing
+ * matrices; e.g. with the encoder of another array of those sensors (see
+ * array2sh_getEncodingMatrix()), so that each array is encoded in its own
+ * bands, without a crossover filter. Nothing is recomputed; it may be called
+ * from the processing thread, and applies from the next block on.
+ */
+void array2sh_setBandRange(void* const hA2sh, float minFreq, float maxFreq);
+
+/**
+ * Installs a function, which is called whenever the processing functions enter
+ * or leave one of the #ARRAY2SH_STAGES (e.g. for profiling)
+ *
+ * @note The hook is called from the processing thread, so it should be
+ *       real-time safe. Pass NULL to remove it.
+ *
+ * @param[in] hA2sh    array2sh handle
+ * @param[in] hook     Function to call (or NULL)
+ * @param[in] userData Pointer passed on to the hook
+ */
+void array2sh_setStageHook(void* const hA2sh,
+                           array2sh_stageHook hook,
+                           void* userData);
+
+/**
+ * Makes the instance take its encoding matrices from a cache, which may be
+ * shared with other instances, rather than computing its own
+ *
+ * Whenever the matrices are to be recomputed, they are first looked up in the
+ * cache, and only computed (and then published) if no instance with the same
+ * settings has done so already. The filterbank and all other processing state
+ * remain per instance.
+ *
+ * @warning This should not be called while the instance is processing, and
+ *          the cache must outlive the instance. Pass NULL to remove it.
+ *
+ * @param[in] hA2sh    array2sh handle
+ * @param[in] cache    Cache functions (or NULL)
+ * @param[in] userData Pointer passed on to the cache functions
+ */
+void array2sh_setEncoderCache(void* const hA2sh,
+                              const array2sh_encoderCache* cache,
+                              void* userData);
+
 
 /* ========================================================================== */
 /*                                Get Functions                               */
@@ -425,6 +764,12 @@ void array2sh_setGain(void* const hA2sh, float newGain);
  */
 int array2sh_getFrameSize(void);
 
+/**
+ * Returns the hop size of the filterbank; array2sh_processBlock() accepts any
+ * integer multiple of this number of samples
+ */
+int array2sh_getHopSize(void);
+
 /** Returns current eval status (see #ARRAY2SH_EVAL_STATUS enum) */
 ARRAY2SH_EVAL_STATUS array2sh_getEvalStatus(void* const hA2sh);
 
@@ -535,6 +880,12 @@ int array2sh_getWeightType(void* const hA2sh);
  */
 int array2sh_getFilterType(void* const hA2sh);
 
+/**
+ * Returns the filterbank used for the time-frequency transform (see
+ * #ARRAY2SH_FILTERBANKS enum)
+ */
+int array2sh_getFilterbank(void* const hA2sh);
+
 /**
  * Returns the value of the regurlisation parameter; the maximum permitted
  * gain provided by the filters, in DECIBELS
@@ -564,6 +915,76 @@ float array2sh_getc(void* const hA2sh);
 /** Returns the amount of post gain to apply after the encoding, in DECIBELS */
 float array2sh_getGain(void* const hA2sh);
 
+/**
+ * Returns the tolerance used when compressing the encoding matrices, in
+ * DECIBELS (see array2sh_setCompressionTol())
+ */
+float array2sh_getCompressionTol(void* const hA2sh);
+
+/**
+ * Returns a pointer to the relative error between the compressed and the full
+ * encoding matrices, per frequency, in DECIBELS
+ *
+ * @param[in]  hA2sh       array2sh handle
+ * @param[out] nFreqPoints (&) number of frequencies
+ * @returns                Relative error per frequency; nFreqPoints x 1
+ */
+float* array2sh_getCompressionError_Handle(void* const hA2sh, int* nFreqPoints);
+
+/**
+ * Returns the (estimated) number of operations required to apply the
+ * compressed encoder, relative to applying the full encoding matrices
+ * (filterbank analysis and synthesis included)
+ */
+float array2sh_getCompressionRatio(void* const hA2sh);
+
+/**
+ * Returns 1 if the sensor signals are currently projected onto (order+1)^2
+ * signals prior to the filterbank, or 0, if all sensors are transformed
+ * (see array2sh_setCompressionTol())
+ */
+int array2sh_getCompressionProjectionFLAG(void* const hA2sh);
+
+/**
+ * Returns the number of source signals of array2sh_processMixture(), or 0 if
+ * the sensor signals are encoded (see array2sh_setNumMixtureSources())
+ */
+int array2sh_getNumMixtureSources(void* const hA2sh);
+
+/**
+ * Returns the range of centre frequencies of the bands that are encoded (see
+ * array2sh_setBandRange())
+ *
+ * @param[in]  hA2sh   array2sh handle
+ * @param[out] minFreq (&) lowest centre frequency that is encoded, Hz
+ * @param[out] maxFreq (&) the centre frequencies are below this one, Hz
+ */
+void array2sh_getBandRange(void* const hA2sh, float* minFreq, float* maxFreq);
+
+/**
+ * Returns a pointer to the projection of the sensor signals onto the
+ * (order+1)^2 signals that are mixed in each band (see
+ * array2sh_setCompressionTol()), or NULL if the encoder is yet to be computed,
+ * or if it is not the projection followed by the mixing in every band (within
+ * the compression tolerance); array2sh_processMixture() then outputs silence
+ *
+ * @returns Projection matrix; FLAT: nSH x nSensors
+ */
+const float* array2sh_getProjection(void* const hA2sh);
+
+/**
+ * Returns a pointer to the encoding matrix of one band, or NULL if the encoder
+ * is yet to be computed; as computed, i.e. neither compressed (see
+ * array2sh_setCompressionTol()) nor post-gained
+ *
+ * @param[in]  hA2sh  array2sh handle
+ * @param[in]  band   Band index (see array2sh_getFreqVector())
+ * @param[out] stride (&) distance between its rows, in complex elements
+ * @returns Encoding matrix, complex (interleaved real and imaginary parts);
+ *          nSH x nSensors, rows 'stride' apart (N3D, ACN)
+ */
+const float* array2sh_getEncodingMatrix(void* const hA2sh, int band, int* stride);
+
 /**
  * Returns a pointer to the frequency vector
  *
@@ -644,15 +1065,63 @@ float* array2sh_getSpatialCorrelation_Handle(void* const hA2sh,
  *          120.
  */
 float* array2sh_getLevelDifference_Handle(void* const hA2sh, int* nCurves, int* nFreqPoints);
+
+/**
+ * Same as array2sh_getSpatialCorrelation_Handle(), but for the compressed
+ * encoder that is actually applied during processing (see
+ * array2sh_setCompressionTol())
+ */
+float* array2sh_getSpatialCorrelationCompressed_Handle(void* const hA2sh,
+                                                       int* nCurves,
+                                                       int* nFreqPoints);
+
+/**
+ * Same as array2sh_getLevelDifference_Handle(), but for the compressed encoder
+ * that is actually applied during processing (see
+ * array2sh_setCompressionTol())
+ */
+float* array2sh_getLevelDifferenceCompressed_Handle(void* const hA2sh,
+                                                    int* nCurves,
+                                                    int* nFreqPoints);
+
+/**
+ * Returns a counter that is incremented whenever the curves returned by
+ * array2sh_getbN_inv() and array2sh_getbN_modal() are recomputed; a display
+ * only needs to redraw them when it has changed
+ */
+unsigned int array2sh_getbNVersion(void* const hA2sh);
+
+/**
+ * Returns a counter that is incremented whenever the spatial correlation and
+ * level difference data (including the compressed ones) are recomputed
+ */
+unsigned int array2sh_getEvalVersion(void* const hA2sh);
     
 /** Returns the DAW/Host sample rate */
 int array2sh_getSamplingRate(void* const hA2sh);
     
 /**
  * Returns the processing delay in samples (may be used for delay compensation
- * features) 
+ * features), with the default filterbank
+ *
+ * @see array2sh_getFilterbankProcessingDelay()
  */
 int array2sh_getProcessingDelay(void);
+
+/**
+ * Returns the processing delay in samples, with the selected filterbank (see
+ * #ARRAY2SH_FILTERBANKS); this already reflects a new selection before it
+ * takes effect
+ */
+int array2sh_getFilterbankProcessingDelay(void* const hA2sh);
+
+/**
+ * Returns the delay of the analysis of a filterbank alone, in samples; i.e.
+ * the time-frequency samples of a time slot are centred on the input that
+ * many samples before the centre of the hop they are computed with (see
+ * array2sh_processMixture())
+ */
+int array2sh_getFilterbankAnalysisDelay(ARRAY2SH_FILTERBANKS filterbank);
    
     
 #ifdef __cplusplus
@@ -65,16 +65,39 @@ void array2sh_create
     pData->norm = NORM_SN3D;
     pData->c = 343.0f;
     pData->gain_dB = 0.0f; /* post-gain */ 
+    pData->compressionTol_dB = -100.0f;
     array2sh_arrayPars* arraySpecs = (array2sh_arrayPars*)(pData->arraySpecs);
     array2sh_initArray(arraySpecs, MICROPHONE_ARRAY_PRESET_DEFAULT, &(pData->order), 1);
     pData->enableDiffEQpastAliasing = 1;
     
-    /* time-frequency transform + buffers */
+    /* time-frequency transform + buffers (the input buffers are allocated in array2sh_initTFT()) */
     pData->hSTFT = NULL;
-    pData->inputFrameTD = (float**)malloc2d(MAX_NUM_SENSORS, ARRAY2SH_FRAME_SIZE, sizeof(float));
-    pData->SHframeTD = (float**)malloc2d(MAX_NUM_SH_SIGNALS, ARRAY2SH_FRAME_SIZE, sizeof(float));
-    pData->inputframeTF = (float_complex***)malloc3d(HYBRID_BANDS, MAX_NUM_SENSORS, TIME_SLOTS, sizeof(float_complex));
-    pData->SHframeTF = (float_complex***)malloc3d(HYBRID_BANDS, MAX_NUM_SH_SIGNALS, TIME_SLOTS, sizeof(float_complex));
+    pData->filterbank = pData->new_filterbank = ARRAY2SH_FILTERBANK_AFSTFT_HYBRID;
+    pData->stageHook = NULL;
+    pData->stageHookData = NULL;
+    pData->nBands = HYBRID_BANDS;
+    pData->tftCost = 0.0;
+    pData->inputframeTF = NULL;
+    pData->nBufferSensors = 0;
+    memset(pData->zeroFrameTD, 0, MAX_BATCH_SIZE*sizeof(float));
+    pData->SHframeTD = (float**)malloc2d(MAX_NUM_SH_SIGNALS, MAX_BATCH_SIZE, sizeof(float));
+    pData->SHframeTF = (float_complex***)malloc3d(HYBRID_BANDS, MAX_NUM_SH_SIGNALS, MAX_BATCH_TIME_SLOTS, sizeof(float_complex));
+
+    /* encoder (computed in array2sh_calculate_sht_matrix()) */
+    pData->enc = NULL;
+    pData->retiredEnc = NULL;
+    pData->encoderCache = NULL;
+    pData->encoderCacheData = NULL;
+    pData->projFrameTD = (float**)malloc2d(MAX_NUM_SH_SIGNALS, MAX_BATCH_SIZE, sizeof(float));
+    pData->projectFLAG = 0;
+    pData->nTFTinputs = 0;
+    pData->nMixtureSources = pData->new_nMixtureSources = 0;
+    pData->bandRange[0] = 0.0f;
+    pData->bandRange[1] = FLT_MAX;
+    pData->firstBand = -1;
+    pData->mixframeTF = (float_complex***)malloc3d(HYBRID_BANDS, MAX_NUM_SH_SIGNALS, MAX_BATCH_TIME_SLOTS, sizeof(float_complex));
+    memset(pData->compressionErr_dB, 0, HYBRID_BANDS*sizeof(float));
+    pData->compressionRatio = 1.0f;
 
     /* internal */
     pData->progressBar0_1 = 0.0f;
@@ -82,6 +105,7 @@ void array2sh_create
     strcpy(pData->progressBarText,"");
     pData->evalStatus = EVAL_STATUS_NOT_EVALUATED;
     pData->evalRequestedFLAG = 0;
+    pData->procStatus = PROC_STATUS_NOT_ONGOING;
     pData->reinitSHTmatrixFLAG = 1;
     pData->new_order = pData->order;
     pData->bN = NULL;
@@ -91,6 +115,10 @@ void array2sh_create
     pData->bN_inv_dB = (float**)calloc2d(HYBRID_BANDS, MAX_SH_ORDER + 1, sizeof(float));
     pData->cSH = (float*)calloc1d((HYBRID_BANDS)*(MAX_SH_ORDER + 1),sizeof(float));
     pData->lSH = (float*)calloc1d((HYBRID_BANDS)*(MAX_SH_ORDER + 1),sizeof(float));
+    pData->cSH_compressed = (float*)calloc1d((HYBRID_BANDS)*(MAX_SH_ORDER + 1),sizeof(float));
+    pData->lSH_compressed = (float*)calloc1d((HYBRID_BANDS)*(MAX_SH_ORDER + 1),sizeof(float));
+    pData->bNVersion = 0;
+    pData->evalVersion = 0;
 }
 
 void array2sh_destroy
@@ -105,13 +133,14 @@ void array2sh_destroy
         while (pData->evalStatus == EVAL_STATUS_EVALUATING)
             SAF_SLEEP(10);
         
-        /* free afSTFT and buffers */
-        if (pData->hSTFT != NULL)
-            afSTFT_destroy(&(pData->hSTFT));
-        free(pData->inputFrameTD);
+        /* free filterbank and buffers */
+        array2sh_tftDestroy(pData);
         free(pData->SHframeTD);
         free(pData->inputframeTF);
         free(pData->SHframeTF);
+        array2sh_setEncoderCache(pData, NULL, NULL); /* releases the encoders */
+        free(pData->projFrameTD);
+        free(pData->mixframeTF);
         array2sh_destroyArray(&(pData->arraySpecs));
         
         /* Display stuff */
@@ -123,6 +152,8 @@ void array2sh_destroy
         free(pData->bN);
         free(pData->cSH);
         free(pData->lSH);
+        free(pData->cSH_compressed);
+        free(pData->lSH_compressed);
         
         free(pData);
         pData = NULL;
@@ -138,8 +169,34 @@ void array2sh_init
     array2sh_data *pData = (array2sh_data*)(hA2sh); 
     
     pData->fs = sampleRate;
-    afSTFT_getCentreFreqs(pData->hSTFT, (float)pData->fs, HYBRID_BANDS, pData->freqVector);
-    pData->freqVector[0] = pData->freqVector[1]/4.0f; /* avoids NaNs at DC */
+    array2sh_calculate_centre_freqs(hA2sh);
+}
+
+void array2sh_initCodec
+(
+    void* const hA2sh
+)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+
+    if (pData->reinitSHTmatrixFLAG == 0 && pData->hSTFT != NULL)
+        return; /* up to date */
+
+    /* the _process() functions output silence from here on, until the
+     * filterbank and encoder are ready; a block already being processed is
+     * left to finish first */
+    while (pData->procStatus == PROC_STATUS_ONGOING)
+        SAF_SLEEP(1);
+
+    /* reinit TFT if needed */
+    array2sh_initTFT(hA2sh);
+
+    /* compute encoding matrix if needed */
+    if (pData->reinitSHTmatrixFLAG) {
+        array2sh_calculate_sht_matrix(hA2sh); /* compute encoding matrix */
+        array2sh_calculate_mag_curves(hA2sh); /* calculate magnitude response curves */
+        pData->reinitSHTmatrixFLAG = 0;
+    }
 }
 
 void array2sh_evalEncoder
@@ -151,6 +208,8 @@ void array2sh_evalEncoder
     
     if (pData->evalStatus != EVAL_STATUS_NOT_EVALUATED)
         return; /* eval not required */
+    if (pData->enc == NULL)
+        return; /* nothing to evaluate until the encoder has been computed */
     
     /* for progress bar */
     pData->evalStatus = EVAL_STATUS_EVALUATING;
@@ -177,80 +236,144 @@ void array2sh_process
 )
 {
     array2sh_data *pData = (array2sh_data*)(hA2sh);
-    array2sh_arrayPars* arraySpecs = (array2sh_arrayPars*)(pData->arraySpecs);
-    int ch, i, band, Q, order, nSH;
-    const float_complex calpha = cmplxf(1.0f,0.0f), cbeta = cmplxf(0.0f, 0.0f);
-    CH_ORDER chOrdering;
-    NORM_TYPES norm;
-    float gain_lin;
-    
-    /* reinit TFT if needed */
-    array2sh_initTFT(hA2sh);
+    int ch;
     
-    /* compute encoding matrix if needed */
-    if (pData->reinitSHTmatrixFLAG) {
-        array2sh_calculate_sht_matrix(hA2sh); /* compute encoding matrix */
-        array2sh_calculate_mag_curves(hA2sh); /* calculate magnitude response curves */
-        pData->reinitSHTmatrixFLAG = 0;
+    /* processing loop; marked as ongoing before the settings are checked, so
+     * that array2sh_initCodec() cannot start on them meanwhile */
+    pData->procStatus = PROC_STATUS_ONGOING;
+    if ((nSamples == ARRAY2SH_FRAME_SIZE) && (pData->reinitSHTmatrixFLAG==0) && (pData->nMixtureSources==0) ) {
+        array2sh_encodeTimeSlots(hA2sh, inputs, 0, outputs, nInputs, nOutputs, 0, TIME_SLOTS);
     }
+    else{
+        for (ch=0; ch < nOutputs; ch++)
+            memset(outputs[ch],0, ARRAY2SH_FRAME_SIZE*sizeof(float));
+    }
+
+    pData->procStatus = PROC_STATUS_NOT_ONGOING;
+}
 
-    /* local copy of user parameters */
-    chOrdering = pData->chOrdering;
-    norm = pData->norm;
-    gain_lin = powf(10.0f, pData->gain_dB/20.0f);
-    Q = arraySpecs->Q;
-    order = pData->order;
-    nSH = (order+1)*(order+1);
-
-    /* processing loop */
-    if ((nSamples == ARRAY2SH_FRAME_SIZE) && (pData->reinitSHTmatrixFLAG==0) ) {
-        pData->procStatus = PROC_STATUS_ONGOING;
-
-        /* Load time-domain data */
-        for(i=0; i < nInputs; i++)
-            utility_svvcopy(inputs[i], ARRAY2SH_FRAME_SIZE, pData->inputFrameTD[i]);
-        for(; i<Q; i++)
-            memset(pData->inputFrameTD[i], 0, ARRAY2SH_FRAME_SIZE * sizeof(float));
-
-        /* Apply time-frequency transform (TFT) */
-        afSTFT_forward_knownDimensions(pData->hSTFT, pData->inputFrameTD, ARRAY2SH_FRAME_SIZE, MAX_NUM_SENSORS, TIME_SLOTS, pData->inputframeTF);
-
-        /* Apply spherical harmonic transform (SHT) */
-        for(band=0; band<HYBRID_BANDS; band++){
-            cblas_cgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, nSH, TIME_SLOTS, Q, &calpha,
-                        pData->W[band], MAX_NUM_SENSORS,
-                        FLATTEN2D(pData->inputframeTF[band]), TIME_SLOTS, &cbeta,
-                        FLATTEN2D(pData->SHframeTF[band]), TIME_SLOTS);
+/* array2sh_processBlock(), with the distance between the input channels if
+ * they lie in one strided span (0 if not) */
+static void array2sh_processBatches
+(
+    void        *  const hA2sh,
+    const float *const * inputs,
+    int                  inputStride,
+    float       ** const outputs,
+    int                  nInputs,
+    int                  nOutputs,
+    int                  nSamples
+)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    int ch, offset, nTimeSlots;
+
+    /* processing loop; in batches of up to MAX_BATCH_TIME_SLOTS (marked as
+     * ongoing first, see array2sh_process()) */
+    pData->procStatus = PROC_STATUS_ONGOING;
+    if ((nSamples % HOP_SIZE == 0) && (pData->reinitSHTmatrixFLAG==0) && (pData->nMixtureSources==0) ) {
+        for(offset=0; offset<nSamples; offset+=nTimeSlots*HOP_SIZE){
+            nTimeSlots = SAF_MIN((nSamples-offset)/HOP_SIZE, MAX_BATCH_TIME_SLOTS);
+            array2sh_encodeTimeSlots(hA2sh, inputs, inputStride, outputs, nInputs, nOutputs, offset, nTimeSlots);
         }
+    }
+    else{
+        for (ch=0; ch < nOutputs; ch++)
+            memset(outputs[ch],0, nSamples*sizeof(float));
+    }
 
-        /* inverse-TFT */
-        afSTFT_backward_knownDimensions(pData->hSTFT, pData->SHframeTF, ARRAY2SH_FRAME_SIZE, MAX_NUM_SH_SIGNALS, TIME_SLOTS, pData->SHframeTD);
+    pData->procStatus = PROC_STATUS_NOT_ONGOING;
+}
 
-        /* account for output channel order */
-        switch(chOrdering){
-            case CH_ACN:  /* already ACN, do nothing */ break;
-            case CH_FUMA: convertHOAChannelConvention(FLATTEN2D(pData->SHframeTD), order, ARRAY2SH_FRAME_SIZE, HOA_CH_ORDER_ACN, HOA_CH_ORDER_FUMA); break;
-        }
+void array2sh_processBlock
+(
+    void        *  const hA2sh,
+    const float *const * inputs,
+    float       ** const outputs,
+    int                  nInputs,
+    int                  nOutputs,
+    int                  nSamples
+)
+{
+    array2sh_processBatches(hA2sh, inputs, 0, outputs, nInputs, nOutputs, nSamples);
+}
 
-        /* account for normalisation scheme */
-        switch(norm){
-            case NORM_N3D:  /* already N3D, do nothing */ break;  
-            case NORM_SN3D: convertHOANormConvention(FLATTEN2D(pData->SHframeTD), order, ARRAY2SH_FRAME_SIZE, HOA_NORM_N3D, HOA_NORM_SN3D); break;
-            case NORM_FUMA: convertHOANormConvention(FLATTEN2D(pData->SHframeTD), order, ARRAY2SH_FRAME_SIZE, HOA_NORM_N3D, HOA_NORM_FUMA); break;
-        }
+void array2sh_processStrided
+(
+    void        *  const hA2sh,
+    const float *        inputs,
+    int                  inputStride,
+    float       ** const outputs,
+    int                  nInputs,
+    int                  nOutputs,
+    int                  nSamples
+)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    int ch;
+
+    nInputs = SAF_MIN(nInputs, MAX_NUM_SENSORS);
 
-        /* Apply post-gain */
-        utility_svsmul(FLATTEN2D(pData->SHframeTD), &gain_lin, nSH*ARRAY2SH_FRAME_SIZE, NULL);
+    /* Only the channel pointers are gathered here; the samples themselves are
+     * read by the filterbank in place */
+    for(ch=0; ch<nInputs; ch++)
+        pData->spanInputs[ch] = &inputs[ch*inputStride];
 
-        /* Copy to output */
-        for(i = 0; i < SAF_MIN(nSH,nOutputs); i++)
-            utility_svvcopy(pData->SHframeTD[i], ARRAY2SH_FRAME_SIZE, outputs[i]);
-        for(; i < nOutputs; i++)
-            memset(outputs[i], 0, ARRAY2SH_FRAME_SIZE * sizeof(float));
+    array2sh_processBatches(hA2sh, pData->spanInputs, inputStride, outputs, nInputs, nOutputs, nSamples);
+}
+
+void array2sh_processSpans
+(
+    void        *  const hA2sh,
+    const float *        inputs,
+    int                  inputStride,
+    float       *        outputs,
+    int                  outputStride,
+    int                  nInputs,
+    int                  nOutputs,
+    int                  nSamples
+)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    int ch;
+
+    nOutputs = SAF_MIN(nOutputs, MAX_NUM_SH_SIGNALS);
+    for(ch=0; ch<nOutputs; ch++)
+        pData->spanOutputs[ch] = &outputs[ch*outputStride];
+
+    array2sh_processStrided(hA2sh, inputs, inputStride, pData->spanOutputs, nInputs, nOutputs, nSamples);
+}
+
+void array2sh_processMixture
+(
+    void          *  const hA2sh,
+    const float   *        sources,
+    int                    sourceStride,
+    const float   *        mixing,
+    float         ** const outputs,
+    int                    nSources,
+    int                    nOutputs,
+    int                    nSamples
+)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    int ch, offset, nTimeSlots;
+
+    /* processing loop; in batches of up to MAX_BATCH_TIME_SLOTS (marked as
+     * ongoing first, see array2sh_process()) */
+    pData->procStatus = PROC_STATUS_ONGOING;
+    if ((nSamples % HOP_SIZE == 0) && (pData->reinitSHTmatrixFLAG==0) &&
+        (pData->nMixtureSources>0) && (nSources==pData->nMixtureSources) && pData->enc->mixtureFLAG ) {
+        for(ch=0; ch<nSources; ch++)
+            pData->spanInputs[ch] = &sources[ch*sourceStride];
+        for(offset=0; offset<nSamples; offset+=nTimeSlots*HOP_SIZE){
+            nTimeSlots = SAF_MIN((nSamples-offset)/HOP_SIZE, MAX_BATCH_TIME_SLOTS);
+            array2sh_encodeMixtureTimeSlots(hA2sh, pData->spanInputs, (const float_complex*)mixing, outputs, nOutputs, offset, nTimeSlots);
+        }
     }
     else{
         for (ch=0; ch < nOutputs; ch++)
-            memset(outputs[ch],0, ARRAY2SH_FRAME_SIZE*sizeof(float));
+            memset(outputs[ch],0, nSamples*sizeof(float));
     }
 
     pData->procStatus = PROC_STATUS_NOT_ONGOING;
@@ -494,6 +617,88 @@ void array2sh_setGain(void* const hA2sh, float newGain)
     pData->gain_dB = SAF_CLAMP(newGain, ARRAY2SH_POST_GAIN_MIN_VALUE, ARRAY2SH_POST_GAIN_MAX_VALUE);
 }
 
+void array2sh_setCompressionTol(void* const hA2sh, float newTol_dB)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    newTol_dB = SAF_CLAMP(newTol_dB, ARRAY2SH_COMPRESSION_TOL_MIN_VALUE, ARRAY2SH_COMPRESSION_TOL_MAX_VALUE);
+    if(pData->compressionTol_dB!=newTol_dB){
+        pData->compressionTol_dB = newTol_dB;
+        pData->reinitSHTmatrixFLAG = 1;
+        array2sh_setEvalStatus(hA2sh, EVAL_STATUS_NOT_EVALUATED);
+    }
+}
+
+void array2sh_setFilterbank(void* const hA2sh, int newFilterbank)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    newFilterbank = SAF_CLAMP(newFilterbank, ARRAY2SH_FILTERBANK_AFSTFT_HYBRID, ARRAY2SH_NUM_FILTERBANKS);
+    if(pData->new_filterbank!=(ARRAY2SH_FILTERBANKS)newFilterbank){
+        pData->new_filterbank = (ARRAY2SH_FILTERBANKS)newFilterbank;
+        pData->reinitSHTmatrixFLAG = 1;
+        array2sh_setEvalStatus(hA2sh, EVAL_STATUS_NOT_EVALUATED);
+    }
+}
+
+void array2sh_setNumMixtureSources(void* const hA2sh, int nSources)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    nSources = SAF_CLAMP(nSources, 0, MAX_NUM_SH_SIGNALS);
+    if(pData->new_nMixtureSources!=nSources){
+        pData->new_nMixtureSources = nSources;
+        pData->reinitSHTmatrixFLAG = 1; /* the filterbank takes other signals */
+    }
+}
+
+void array2sh_setBandRange(void* const hA2sh, float minFreq, float maxFreq)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    pData->bandRange[0] = SAF_MAX(minFreq, 0.0f);
+    pData->bandRange[1] = SAF_MAX(maxFreq, pData->bandRange[0]);
+}
+
+void array2sh_setStageHook
+(
+    void* const hA2sh,
+    array2sh_stageHook hook,
+    void* userData
+)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    pData->stageHook = hook;
+    pData->stageHookData = userData;
+}
+
+void array2sh_setEncoderCache
+(
+    void* const hA2sh,
+    const array2sh_encoderCache* cache,
+    void* userData
+)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+
+    /* waits for any evaluation to finish, and recomputes the encoder with the
+     * next array2sh_initCodec() call */
+    array2sh_refreshSettings(hA2sh);
+
+    /* the current encoders belong to the current cache (or to this instance) */
+    if(pData->enc!=NULL){
+        if(pData->encoderCache!=NULL)
+            pData->encoderCache->release(pData->encoderCacheData, pData->enc);
+        else
+            free(pData->enc);
+    }
+    if(pData->retiredEnc!=NULL){
+        if(pData->encoderCache!=NULL)
+            pData->encoderCache->release(pData->encoderCacheData, pData->retiredEnc);
+        else
+            free(pData->retiredEnc);
+    }
+    pData->enc = pData->retiredEnc = NULL;
+    pData->encoderCache = cache;
+    pData->encoderCacheData = userData;
+}
+
 
 /* Get Functions */
 
@@ -502,6 +707,11 @@ int array2sh_getFrameSize(void)
     return ARRAY2SH_FRAME_SIZE;
 }
 
+int array2sh_getHopSize(void)
+{
+    return HOP_SIZE;
+}
+
 ARRAY2SH_EVAL_STATUS array2sh_getEvalStatus(void* const hA2sh)
 {
     array2sh_data *pData = (array2sh_data*)(hA2sh);
@@ -631,6 +841,12 @@ int array2sh_getFilterType(void* const hA2sh)
     return (int)pData->filterType;
 }
 
+int array2sh_getFilterbank(void* const hA2sh)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    return (int)pData->new_filterbank;
+}
+
 float array2sh_getRegPar(void* const hA2sh)
 {
     array2sh_data *pData = (array2sh_data*)(hA2sh);
@@ -661,10 +877,63 @@ float array2sh_getGain(void* const hA2sh)
     return pData->gain_dB;
 }
 
+float array2sh_getCompressionTol(void* const hA2sh)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    return pData->compressionTol_dB;
+}
+
+float* array2sh_getCompressionError_Handle(void* const hA2sh, int* nFreqPoints)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    (*nFreqPoints) = pData->nBands;
+    return pData->compressionErr_dB;
+}
+
+float array2sh_getCompressionRatio(void* const hA2sh)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    return pData->compressionRatio;
+}
+
+int array2sh_getCompressionProjectionFLAG(void* const hA2sh)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    return pData->projectFLAG;
+}
+
+int array2sh_getNumMixtureSources(void* const hA2sh)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    return pData->new_nMixtureSources;
+}
+
+void array2sh_getBandRange(void* const hA2sh, float* minFreq, float* maxFreq)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    (*minFreq) = pData->bandRange[0];
+    (*maxFreq) = pData->bandRange[1];
+}
+
+const float* array2sh_getProjection(void* const hA2sh)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    return pData->enc!=NULL && pData->enc->mixtureFLAG ? pData->enc->P : NULL;
+}
+
+const float* array2sh_getEncodingMatrix(void* const hA2sh, int band, int* stride)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    (*stride) = MAX_NUM_SENSORS;
+    if(pData->enc==NULL || band<0 || band>=pData->nBands)
+        return NULL;
+    return (const float*)&(pData->enc->W[band][0][0]);
+}
+
 float* array2sh_getFreqVector(void* const hA2sh, int* nFreqPoints)
 {
     array2sh_data *pData = (array2sh_data*)(hA2sh);
-    (*nFreqPoints) = HYBRID_BANDS;
+    (*nFreqPoints) = pData->nBands;
     return &(pData->freqVector[0]);
 }
 
@@ -672,7 +941,7 @@ float** array2sh_getbN_inv(void* const hA2sh, int* nCurves, int* nFreqPoints)
 {
     array2sh_data *pData = (array2sh_data*)(hA2sh);
     (*nCurves) = pData->order+1;
-    (*nFreqPoints) = HYBRID_BANDS;
+    (*nFreqPoints) = pData->nBands;
     return pData->bN_inv_dB;
 }
 
@@ -680,7 +949,7 @@ float** array2sh_getbN_modal(void* const hA2sh, int* nCurves, int* nFreqPoints)
 {
     array2sh_data *pData = (array2sh_data*)(hA2sh);
     (*nCurves) = pData->order+1;
-    (*nFreqPoints) = HYBRID_BANDS;
+    (*nFreqPoints) = pData->nBands;
     return pData->bN_modal_dB;
 }
 
@@ -688,7 +957,7 @@ float* array2sh_getSpatialCorrelation_Handle(void* const hA2sh, int* nCurves, in
 {
     array2sh_data *pData = (array2sh_data*)(hA2sh);
     (*nCurves) = pData->order+1;
-    (*nFreqPoints) = HYBRID_BANDS;
+    (*nFreqPoints) = pData->nBands;
     return pData->cSH;
 }
 
@@ -696,10 +965,38 @@ float* array2sh_getLevelDifference_Handle(void* const hA2sh, int* nCurves, int*
 {
     array2sh_data *pData = (array2sh_data*)(hA2sh);
     (*nCurves) = pData->order+1;
-    (*nFreqPoints) = HYBRID_BANDS;
+    (*nFreqPoints) = pData->nBands;
     return pData->lSH;
 }
 
+float* array2sh_getSpatialCorrelationCompressed_Handle(void* const hA2sh, int* nCurves, int* nFreqPoints)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    (*nCurves) = pData->order+1;
+    (*nFreqPoints) = pData->nBands;
+    return pData->cSH_compressed;
+}
+
+float* array2sh_getLevelDifferenceCompressed_Handle(void* const hA2sh, int* nCurves, int* nFreqPoints)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    (*nCurves) = pData->order+1;
+    (*nFreqPoints) = pData->nBands;
+    return pData->lSH_compressed;
+}
+
+unsigned int array2sh_getbNVersion(void* const hA2sh)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    return pData->bNVersion;
+}
+
+unsigned int array2sh_getEvalVersion(void* const hA2sh)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    return pData->evalVersion;
+}
+
 int array2sh_getSamplingRate(void* const hA2sh)
 {
     array2sh_data *pData = (array2sh_data*)(hA2sh);
@@ -708,5 +1005,25 @@ int array2sh_getSamplingRate(void* const hA2sh)
 
 int array2sh_getProcessingDelay()
 {
-    return 12*HOP_SIZE;
+    return array2sh_getFilterbankDelay(ARRAY2SH_FILTERBANK_AFSTFT_HYBRID);
+}
+
+int array2sh_getFilterbankProcessingDelay(void* const hA2sh)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    return array2sh_getFilterbankDelay(pData->new_filterbank);
+}
+
+int array2sh_getFilterbankAnalysisDelay(ARRAY2SH_FILTERBANKS filterbank)
+{
+    /* as measured with an impulse, to the centroid of the band energy over
+     * the time slots (the same for all bands) */
+    switch(filterbank){
+        default:
+        case ARRAY2SH_FILTERBANK_AFSTFT_HYBRID: return 15*HOP_SIZE/2;
+        case ARRAY2SH_FILTERBANK_AFSTFT_LD:     return 9*HOP_SIZE/4;
+        case ARRAY2SH_FILTERBANK_AFSTFT:        return 9*HOP_SIZE/2;
+        case ARRAY2SH_FILTERBANK_QMF:           return 9*HOP_SIZE/2;
+        case ARRAY2SH_FILTERBANK_STFT:          return 0;
+    }
 }
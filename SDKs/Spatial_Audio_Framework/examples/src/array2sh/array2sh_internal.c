@@ -56,6 +56,7 @@
 static void array2sh_replicate_order
 (
     void* const hA2sh,
+    array2sh_encoder* enc,
     int order
 )
 {
@@ -65,10 +66,10 @@ static void array2sh_replicate_order
     
     for(n=0; n<order+2; n++)
         o[n] = n*n;
-    for(band=0; band<HYBRID_BANDS; band++)
+    for(band=0; band<pData->nBands; band++)
         for(n=0; n < order+1; n++)
             for(i=o[n]; i < o[n+1]; i++)
-                pData->bN_inv_R[band][i] = pData->bN_inv[band][n];
+                enc->bN_inv_R[band][i] = enc->bN_inv[band][n];
 }
 
 void array2sh_initTFT
@@ -82,35 +83,462 @@ void array2sh_initTFT
     
     new_nSH = (pData->new_order+1)*(pData->new_order+1);
     nSH = (pData->order+1)*(pData->order+1);
-    if(pData->hSTFT==NULL)
-        afSTFT_create(&(pData->hSTFT), arraySpecs->newQ, new_nSH, HOP_SIZE, 0, 1, AFSTFT_BANDS_CH_TIME);
+    if(pData->hSTFT==NULL || pData->filterbank != pData->new_filterbank){
+        array2sh_tftDestroy(hA2sh);
+        pData->filterbank = pData->new_filterbank;
+        array2sh_tftCreate(hA2sh, arraySpecs->newQ, new_nSH);
+        pData->nTFTinputs = arraySpecs->newQ;
+        pData->projectFLAG = 0;
+        pData->reinitSHTmatrixFLAG = 1; /* the frequency bands may have changed */
+    }
     else if(arraySpecs->newQ != arraySpecs->Q || nSH != new_nSH){
-        afSTFT_channelChange(pData->hSTFT, arraySpecs->newQ, new_nSH);
-        afSTFT_clearBuffers(pData->hSTFT); 
+        array2sh_tftChannelChange(hA2sh, arraySpecs->newQ, new_nSH);
+        pData->nTFTinputs = arraySpecs->newQ;
+        pData->projectFLAG = 0;
         pData->reinitSHTmatrixFLAG = 1; /* filters will need to be updated too */
     }
     arraySpecs->Q = arraySpecs->newQ;
+
+    /* input buffers are only as large as the current number of sensors (or
+     * the number of projected signals, if larger) */
+    if(pData->nBufferSensors != arraySpecs->Q){
+        free(pData->inputframeTF);
+        pData->inputframeTF = (float_complex***)malloc3d(HYBRID_BANDS, SAF_MAX(arraySpecs->Q, MAX_NUM_SH_SIGNALS), MAX_BATCH_TIME_SLOTS, sizeof(float_complex));
+        pData->nBufferSensors = arraySpecs->Q;
+    }
 }
 
-void array2sh_calculate_sht_matrix
+void array2sh_tftCreate
+(
+    void* const hA2sh,
+    int nCHin,
+    int nCHout
+)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+
+    /* tftCost is the time one channel takes through the filterbank for one hop
+     * (the mean of the forward and backward transforms), divided by the time
+     * of one flop of the per-band encoding GEMM; as measured with OpenBLAS on
+     * x86-64 (GEMM of 25 x 8 x 32 complex at ~14 Gflop/s; afSTFT ~4 us, QMF
+     * ~57 us, STFT ~2.5 us per channel and hop) */
+    switch(pData->filterbank){
+        default:
+        case ARRAY2SH_FILTERBANK_AFSTFT_HYBRID:
+            afSTFT_create(&(pData->hSTFT), nCHin, nCHout, HOP_SIZE, 0, 1, AFSTFT_BANDS_CH_TIME);
+            pData->nBands = afSTFT_getNBands(pData->hSTFT);
+            pData->tftCost = 5.5e4;
+            break;
+        case ARRAY2SH_FILTERBANK_AFSTFT_LD:
+            afSTFT_create(&(pData->hSTFT), nCHin, nCHout, HOP_SIZE, 1, 0, AFSTFT_BANDS_CH_TIME);
+            pData->nBands = afSTFT_getNBands(pData->hSTFT);
+            pData->tftCost = 6.5e4;
+            break;
+        case ARRAY2SH_FILTERBANK_AFSTFT:
+            afSTFT_create(&(pData->hSTFT), nCHin, nCHout, HOP_SIZE, 0, 0, AFSTFT_BANDS_CH_TIME);
+            pData->nBands = afSTFT_getNBands(pData->hSTFT);
+            pData->tftCost = 5.5e4;
+            break;
+        case ARRAY2SH_FILTERBANK_QMF:
+            qmf_create(&(pData->hSTFT), nCHin, nCHout, HOP_SIZE, 0, QMF_BANDS_CH_TIME);
+            pData->nBands = qmf_getNBands(pData->hSTFT);
+            pData->tftCost = 8.0e5;
+            break;
+        case ARRAY2SH_FILTERBANK_STFT:
+            saf_stft_create(&(pData->hSTFT), HOP_SIZE, HOP_SIZE, nCHin, nCHout, SAF_STFT_BANDS_CH_TIME);
+            pData->nBands = HOP_SIZE+1;
+            pData->tftCost = 3.5e4;
+            break;
+    }
+    saf_assert(pData->nBands<=HYBRID_BANDS, "The time-frequency buffers are too small for this filterbank");
+    array2sh_calculate_centre_freqs(hA2sh);
+}
+
+void array2sh_tftDestroy
+(
+    void* const hA2sh
+)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+
+    if(pData->hSTFT==NULL)
+        return;
+    switch(pData->filterbank){
+        default:
+        case ARRAY2SH_FILTERBANK_AFSTFT_HYBRID:
+        case ARRAY2SH_FILTERBANK_AFSTFT_LD:
+        case ARRAY2SH_FILTERBANK_AFSTFT: afSTFT_destroy(&(pData->hSTFT)); break;
+        case ARRAY2SH_FILTERBANK_QMF:    qmf_destroy(&(pData->hSTFT)); break;
+        case ARRAY2SH_FILTERBANK_STFT:   saf_stft_destroy(&(pData->hSTFT)); break;
+    }
+}
+
+void array2sh_tftChannelChange
+(
+    void* const hA2sh,
+    int nCHin,
+    int nCHout
+)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+
+    switch(pData->filterbank){
+        default:
+        case ARRAY2SH_FILTERBANK_AFSTFT_HYBRID:
+        case ARRAY2SH_FILTERBANK_AFSTFT_LD:
+        case ARRAY2SH_FILTERBANK_AFSTFT:
+            afSTFT_channelChange(pData->hSTFT, nCHin, nCHout);
+            afSTFT_clearBuffers(pData->hSTFT);
+            break;
+        case ARRAY2SH_FILTERBANK_QMF:
+            qmf_channelChange(pData->hSTFT, nCHin, nCHout);
+            qmf_clearBuffers(pData->hSTFT);
+            break;
+        case ARRAY2SH_FILTERBANK_STFT:
+            saf_stft_channelChange(pData->hSTFT, nCHin, nCHout);
+            saf_stft_flushBuffers(pData->hSTFT);
+            break;
+    }
+}
+
+void array2sh_tftForward
+(
+    void* const hA2sh,
+    float** dataTD,
+    int nSamples
+)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+
+    switch(pData->filterbank){
+        default:
+        case ARRAY2SH_FILTERBANK_AFSTFT_HYBRID:
+        case ARRAY2SH_FILTERBANK_AFSTFT_LD:
+        case ARRAY2SH_FILTERBANK_AFSTFT:
+            afSTFT_forward_knownDimensions(pData->hSTFT, dataTD, nSamples, SAF_MAX(pData->nBufferSensors, MAX_NUM_SH_SIGNALS),
+                                           MAX_BATCH_TIME_SLOTS, pData->inputframeTF);
+            break;
+        case ARRAY2SH_FILTERBANK_QMF:  qmf_analysis(pData->hSTFT, dataTD, nSamples, pData->inputframeTF); break;
+        case ARRAY2SH_FILTERBANK_STFT: saf_stft_forward(pData->hSTFT, dataTD, nSamples, pData->inputframeTF); break;
+    }
+}
+
+void array2sh_tftBackward
+(
+    void* const hA2sh,
+    int nSamples
+)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+
+    switch(pData->filterbank){
+        default:
+        case ARRAY2SH_FILTERBANK_AFSTFT_HYBRID:
+        case ARRAY2SH_FILTERBANK_AFSTFT_LD:
+        case ARRAY2SH_FILTERBANK_AFSTFT:
+            afSTFT_backward_knownDimensions(pData->hSTFT, pData->SHframeTF, nSamples, MAX_NUM_SH_SIGNALS,
+                                            MAX_BATCH_TIME_SLOTS, pData->SHframePtrs);
+            break;
+        case ARRAY2SH_FILTERBANK_QMF:  qmf_synthesis(pData->hSTFT, pData->SHframeTF, nSamples, pData->SHframePtrs); break;
+        case ARRAY2SH_FILTERBANK_STFT: saf_stft_backward(pData->hSTFT, pData->SHframeTF, nSamples, pData->SHframePtrs); break;
+    }
+}
+
+int array2sh_getFilterbankDelay
+(
+    ARRAY2SH_FILTERBANKS filterbank
+)
+{
+    switch(filterbank){
+        default:
+        case ARRAY2SH_FILTERBANK_AFSTFT_HYBRID: return 12*HOP_SIZE;
+        case ARRAY2SH_FILTERBANK_AFSTFT_LD:     return 4*HOP_SIZE;
+        case ARRAY2SH_FILTERBANK_AFSTFT:        return 9*HOP_SIZE;
+        case ARRAY2SH_FILTERBANK_QMF:           return 9*HOP_SIZE+1;
+        case ARRAY2SH_FILTERBANK_STFT:          return STFT_FILTER_DELAY;
+    }
+}
+
+void array2sh_calculate_centre_freqs
+(
+    void* const hA2sh
+)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+
+    switch(pData->filterbank){
+        default:
+        case ARRAY2SH_FILTERBANK_AFSTFT_HYBRID:
+        case ARRAY2SH_FILTERBANK_AFSTFT_LD:
+        case ARRAY2SH_FILTERBANK_AFSTFT:
+            /* (the hybrid centre frequencies are tabulated, if the afSTFT has not been created yet) */
+            afSTFT_getCentreFreqs(pData->hSTFT, (float)pData->fs, HYBRID_BANDS, pData->freqVector);
+            break;
+        case ARRAY2SH_FILTERBANK_QMF:
+            qmf_getCentreFreqs(pData->hSTFT, (float)pData->fs, pData->nBands, pData->freqVector);
+            break;
+        case ARRAY2SH_FILTERBANK_STFT:
+            getUniformFreqVector(2*HOP_SIZE, (float)pData->fs, pData->freqVector);
+            break;
+    }
+    if(pData->freqVector[0] < pData->freqVector[1]/4.0f)
+        pData->freqVector[0] = pData->freqVector[1]/4.0f; /* avoids NaNs at DC */
+}
+
+void array2sh_applyBandRange
 (
     void* const hA2sh
 )
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    int band;
+
+    if(pData->firstBand>=0 && pData->appliedBandRange[0]==pData->bandRange[0] &&
+       pData->appliedBandRange[1]==pData->bandRange[1])
+        return;
+    pData->appliedBandRange[0] = pData->bandRange[0];
+    pData->appliedBandRange[1] = pData->bandRange[1];
+
+    /* (the centre frequencies ascend) */
+    for(band=0; band<pData->nBands && pData->freqVector[band]<pData->appliedBandRange[0]; band++);
+    pData->firstBand = band;
+    for(; band<pData->nBands && pData->freqVector[band]<pData->appliedBandRange[1]; band++);
+    pData->lastBand = band;
+
+    /* the bands outside of the range are no longer written (but by
+     * array2sh_processMixture()), nor the pruned orders of those within it */
+    memset(FLATTEN3D(pData->SHframeTF), 0, HYBRID_BANDS*MAX_NUM_SH_SIGNALS*MAX_BATCH_TIME_SLOTS*sizeof(float_complex));
+}
+
+/* the inverse-TFT of nTimeSlots of 'SHframeTF', followed by the post-gains and
+ * the channel ordering, into the outputs (from sample 'offset' on) */
+static void array2sh_synthesiseTimeSlots
+(
+    void        *  const hA2sh,
+    float       ** const outputs,
+    int                  nOutputs,
+    int                  offset,
+    int                  nTimeSlots
+)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    int i, order, nSH, nSamples;
+    float gain_lin;
+    float chGains[MAX_NUM_SH_SIGNALS];
+
+    order = pData->order;
+    nSH = (order+1)*(order+1);
+    nSamples = nTimeSlots*HOP_SIZE;
+
+    /* ACN ordered SH signals are written straight to the outputs. FuMa
+     * signals first need reordering, so these go via the scratch buffer */
+    for(i=0; i<nSH; i++){
+        if(pData->chOrdering==CH_ACN && i<nOutputs)
+            pData->SHframePtrs[i] = &outputs[i][offset];
+        else
+            pData->SHframePtrs[i] = pData->SHframeTD[i];
+    }
+
+    /* inverse-TFT */
+    ARRAY2SH_STAGE_BEGIN(pData, ARRAY2SH_STAGE_TFT);
+    array2sh_tftBackward(hA2sh, nSamples);
+    ARRAY2SH_STAGE_END(pData, ARRAY2SH_STAGE_TFT);
+
+    /* post-gain per channel, which also accounts for the normalisation scheme */
+    gain_lin = powf(10.0f, pData->gain_dB/20.0f);
+    for(i=0; i<nSH; i++)
+        chGains[i] = gain_lin;
+    switch(pData->norm){
+        case NORM_N3D:  /* already N3D, do nothing */ break;
+        case NORM_SN3D: convertHOANormConvention(chGains, order, 1, HOA_NORM_N3D, HOA_NORM_SN3D); break;
+        case NORM_FUMA: convertHOANormConvention(chGains, order, 1, HOA_NORM_N3D, HOA_NORM_FUMA); break;
+    }
+
+    /* account for output channel order (FuMa is 1st order only, so 4 channels at most) */
+    switch(pData->chOrdering){
+        case CH_ACN:
+            /* already in place, only apply the gains */
+            for(i = 0; i < SAF_MIN(nSH,nOutputs); i++)
+                if(chGains[i]!=1.0f)
+                    utility_svsmul(pData->SHframePtrs[i], &chGains[i], nSamples, NULL);
+            break;
+        case CH_FUMA:
+            convertHOAChannelConvention(FLATTEN2D(pData->SHframeTD), order, MAX_BATCH_SIZE, HOA_CH_ORDER_ACN, HOA_CH_ORDER_FUMA);
+            for(i = 0; i < SAF_MIN(nSH,nOutputs); i++)
+                utility_svsmul(pData->SHframeTD[i], &chGains[i], nSamples, &outputs[i][offset]);
+            break;
+    }
+    for(i = nSH; i < nOutputs; i++)
+        memset(&outputs[i][offset], 0, nSamples * sizeof(float));
+}
+
+
+void array2sh_encodeTimeSlots
+(
+    void        *  const hA2sh,
+    const float *const * inputs,
+    int                  inputStride,
+    float       ** const outputs,
+    int                  nInputs,
+    int                  nOutputs,
+    int                  offset,
+    int                  nTimeSlots
+)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    array2sh_arrayPars* arraySpecs = (array2sh_arrayPars*)(pData->arraySpecs);
+    const array2sh_encoder* enc = pData->enc;
+    int i, band, Q, nQ, nSH, nSamples;
+    const float_complex calpha = cmplxf(1.0f,0.0f), cbeta = cmplxf(0.0f, 0.0f);
+
+    saf_assert(nTimeSlots<=MAX_BATCH_TIME_SLOTS, "Too many time slots for one batch");
+    Q = arraySpecs->Q;
+    nSH = (pData->order+1)*(pData->order+1);
+    nSamples = nTimeSlots*HOP_SIZE;
+    array2sh_applyBandRange(hA2sh);
+
+    if(pData->projectFLAG){
+        ARRAY2SH_STAGE_BEGIN(pData, ARRAY2SH_STAGE_SHT);
+
+        /* Project the sensor signals onto nSH signals in the time-domain (z = P*x).
+         * If the input channels lie in one strided span (e.g. the rows of a
+         * FIFO), then this is a single GEMM; otherwise one rank-1 update is
+         * made per sensor. Missing sensors contribute nothing. */
+        nQ = SAF_MIN(nInputs, Q);
+        if(inputStride>=nSamples && nQ>0)
+            cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, nSH, nSamples, nQ, 1.0f,
+                        enc->P, Q,
+                        &inputs[0][offset], inputStride, 0.0f,
+                        FLATTEN2D(pData->projFrameTD), MAX_BATCH_SIZE);
+        else{
+            for(i=0; i<nSH; i++)
+                memset(pData->projFrameTD[i], 0, nSamples*sizeof(float));
+            for(i=0; i<nQ; i++)
+                cblas_sger(CblasRowMajor, nSH, nSamples, 1.0f, &(enc->P[i]), Q, &inputs[i][offset], 1,
+                           FLATTEN2D(pData->projFrameTD), MAX_BATCH_SIZE);
+        }
+
+        /* Apply time-frequency transform (TFT) to the projected signals */
+        ARRAY2SH_STAGE_END(pData, ARRAY2SH_STAGE_SHT);
+        ARRAY2SH_STAGE_BEGIN(pData, ARRAY2SH_STAGE_TFT);
+        array2sh_tftForward(hA2sh, pData->projFrameTD, nSamples);
+        ARRAY2SH_STAGE_END(pData, ARRAY2SH_STAGE_TFT);
+
+        /* Mix the projected signals in each band; (pruned) nSH_band x nSH */
+        ARRAY2SH_STAGE_BEGIN(pData, ARRAY2SH_STAGE_SHT);
+        for(band=pData->firstBand; band<pData->lastBand; band++){
+            cblas_cgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, enc->nSH_band[band], nTimeSlots, nSH, &calpha,
+                        enc->C[band], MAX_NUM_SH_SIGNALS,
+                        FLATTEN2D(pData->inputframeTF[band]), MAX_BATCH_TIME_SLOTS, &cbeta,
+                        FLATTEN2D(pData->SHframeTF[band]), MAX_BATCH_TIME_SLOTS);
+        }
+        ARRAY2SH_STAGE_END(pData, ARRAY2SH_STAGE_SHT);
+    }
+    else{
+        /* Point the filterbank straight at the input signals (no copies) */
+        for(i=0; i < SAF_MIN(nInputs, Q); i++)
+            pData->inputFramePtrs[i] = (float*)&inputs[i][offset];
+        for(; i<Q; i++)
+            pData->inputFramePtrs[i] = pData->zeroFrameTD;
+
+        /* Apply time-frequency transform (TFT) over all time slots */
+        ARRAY2SH_STAGE_BEGIN(pData, ARRAY2SH_STAGE_TFT);
+        array2sh_tftForward(hA2sh, pData->inputFramePtrs, nSamples);
+        ARRAY2SH_STAGE_END(pData, ARRAY2SH_STAGE_TFT);
+
+        /* Apply spherical harmonic transform (SHT); one (pruned) GEMM per band */
+        ARRAY2SH_STAGE_BEGIN(pData, ARRAY2SH_STAGE_SHT);
+        for(band=pData->firstBand; band<pData->lastBand; band++){
+            cblas_cgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, enc->nSH_band[band], nTimeSlots, Q, &calpha,
+                        enc->W[band], MAX_NUM_SENSORS,
+                        FLATTEN2D(pData->inputframeTF[band]), MAX_BATCH_TIME_SLOTS, &cbeta,
+                        FLATTEN2D(pData->SHframeTF[band]), MAX_BATCH_TIME_SLOTS);
+        }
+        ARRAY2SH_STAGE_END(pData, ARRAY2SH_STAGE_SHT);
+    }
+
+    array2sh_synthesiseTimeSlots(hA2sh, outputs, nOutputs, offset, nTimeSlots);
+}
+
+void array2sh_encodeMixtureTimeSlots
+(
+    void          *  const hA2sh,
+    const float   *const * sources,
+    const float_complex  * mixing,
+    float         ** const outputs,
+    int                    nOutputs,
+    int                    offset,
+    int                    nTimeSlots
+)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    const array2sh_encoder* enc = pData->enc;
+    int i, band, nSources, nSH, nSamples;
+    const float_complex calpha = cmplxf(1.0f,0.0f), cbeta = cmplxf(0.0f, 0.0f);
+
+    saf_assert(nTimeSlots<=MAX_BATCH_TIME_SLOTS, "Too many time slots for one batch");
+    nSources = pData->nMixtureSources;
+    nSH = (pData->order+1)*(pData->order+1);
+    nSamples = nTimeSlots*HOP_SIZE;
+    array2sh_applyBandRange(hA2sh);
+
+    /* Apply time-frequency transform (TFT) to the source signals */
+    for(i=0; i<nSources; i++)
+        pData->inputFramePtrs[i] = (float*)&sources[i][offset];
+    ARRAY2SH_STAGE_BEGIN(pData, ARRAY2SH_STAGE_TFT);
+    array2sh_tftForward(hA2sh, pData->inputFramePtrs, nSamples);
+    ARRAY2SH_STAGE_END(pData, ARRAY2SH_STAGE_TFT);
+
+    /* Mix the sources into the projected signals, and these as for the
+     * projected sensor signals; nSH x nSources, and (pruned) nSH_band x nSH.
+     * Outside of the band range, the sources are mixed straight into the SH
+     * signals instead; nSH x nSources */
+    ARRAY2SH_STAGE_BEGIN(pData, ARRAY2SH_STAGE_SHT);
+    for(band=0; band<pData->nBands; band++){
+        if(band<pData->firstBand || band>=pData->lastBand){
+            cblas_cgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, nSH, nTimeSlots, nSources, &calpha,
+                        &mixing[(size_t)band*nSH*nSources], nSources,
+                        FLATTEN2D(pData->inputframeTF[band]), MAX_BATCH_TIME_SLOTS, &cbeta,
+                        FLATTEN2D(pData->SHframeTF[band]), MAX_BATCH_TIME_SLOTS);
+            continue;
+        }
+        cblas_cgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, nSH, nTimeSlots, nSources, &calpha,
+                    &mixing[(size_t)band*nSH*nSources], nSources,
+                    FLATTEN2D(pData->inputframeTF[band]), MAX_BATCH_TIME_SLOTS, &cbeta,
+                    FLATTEN2D(pData->mixframeTF[band]), MAX_BATCH_TIME_SLOTS);
+        cblas_cgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, enc->nSH_band[band], nTimeSlots, nSH, &calpha,
+                    enc->C[band], MAX_NUM_SH_SIGNALS,
+                    FLATTEN2D(pData->mixframeTF[band]), MAX_BATCH_TIME_SLOTS, &cbeta,
+                    FLATTEN2D(pData->SHframeTF[band]), MAX_BATCH_TIME_SLOTS);
+    }
+    ARRAY2SH_STAGE_END(pData, ARRAY2SH_STAGE_SHT);
+
+    array2sh_synthesiseTimeSlots(hA2sh, outputs, nOutputs, offset, nTimeSlots);
+}
+
+/* computes the encoder for the current settings into 'enc' */
+static void array2sh_build_sht_matrix
+(
+    void* const hA2sh,
+    array2sh_encoder* enc
+)
 {
     array2sh_data *pData = (array2sh_data*)(hA2sh);
     array2sh_arrayPars* arraySpecs = (array2sh_arrayPars*)(pData->arraySpecs);
-    int i, j, band, n, order, nSH;
+    int i, j, band, n, order, nSH, nBands;
     double alpha, beta, g_lim, regPar;
     double kr[HYBRID_BANDS], kR[HYBRID_BANDS];
     float* Y_mic, *pinv_Y_mic;
     float_complex* pinv_Y_mic_cmplx, *diag_bN_inv_R;
+    float_complex delay_ph;
     const float_complex calpha = cmplxf(1.0f, 0.0f); const float_complex cbeta  = cmplxf(0.0f, 0.0f);
     
     /* prep */
     order = pData->new_order;
     nSH = (order+1)*(order+1);
+    nBands = pData->nBands;
     arraySpecs->R = SAF_MIN(arraySpecs->R, arraySpecs->r);
-    for(band=0; band<HYBRID_BANDS; band++){
+    for(band=0; band<nBands; band++){
         kr[band] = 2.0*SAF_PId*(pData->freqVector[band])*(arraySpecs->r)/pData->c;
         kR[band] = 2.0*SAF_PId*(pData->freqVector[band])*(arraySpecs->R)/pData->c;
     }
@@ -130,53 +558,53 @@ void array2sh_calculate_sht_matrix
     if ( (pData->filterType==FILTER_SOFT_LIM) || (pData->filterType==FILTER_TIKHONOV) ){
         /* Compute modal responses */
         free(pData->bN);
-        pData->bN = malloc1d((HYBRID_BANDS)*(order+1)*sizeof(double_complex));
+        pData->bN = malloc1d((nBands)*(order+1)*sizeof(double_complex));
         switch(arraySpecs->arrayType){
             case ARRAY_CYLINDRICAL:
                 switch (arraySpecs->weightType){
-                    case WEIGHT_RIGID_OMNI:   cylModalCoeffs(order, kr, HYBRID_BANDS, ARRAY_CONSTRUCTION_RIGID, pData->bN); break;
+                    case WEIGHT_RIGID_OMNI:   cylModalCoeffs(order, kr, nBands, ARRAY_CONSTRUCTION_RIGID, pData->bN); break;
                     case WEIGHT_RIGID_CARD:   saf_print_error("weightType is not supported"); break;
                     case WEIGHT_RIGID_DIPOLE: saf_print_error("weightType is not supported"); break;
-                    case WEIGHT_OPEN_OMNI:    cylModalCoeffs(order, kr, HYBRID_BANDS, ARRAY_CONSTRUCTION_OPEN, pData->bN);  break;
+                    case WEIGHT_OPEN_OMNI:    cylModalCoeffs(order, kr, nBands, ARRAY_CONSTRUCTION_OPEN, pData->bN);  break;
                     case WEIGHT_OPEN_CARD:    saf_print_error("weightType is not supported"); break;
                     case WEIGHT_OPEN_DIPOLE:  saf_print_error("weightType is not supported"); break;
                 }
                 break;
             case ARRAY_SPHERICAL:
                 switch (arraySpecs->weightType){
-                    case WEIGHT_OPEN_OMNI:   sphModalCoeffs(order, kr, HYBRID_BANDS, ARRAY_CONSTRUCTION_OPEN, 1.0, pData->bN); break;
-                    case WEIGHT_OPEN_CARD:   sphModalCoeffs(order, kr, HYBRID_BANDS, ARRAY_CONSTRUCTION_OPEN_DIRECTIONAL, 0.5, pData->bN); break;
-                    case WEIGHT_OPEN_DIPOLE: sphModalCoeffs(order, kr, HYBRID_BANDS, ARRAY_CONSTRUCTION_OPEN_DIRECTIONAL, 0.0, pData->bN); break;
+                    case WEIGHT_OPEN_OMNI:   sphModalCoeffs(order, kr, nBands, ARRAY_CONSTRUCTION_OPEN, 1.0, pData->bN); break;
+                    case WEIGHT_OPEN_CARD:   sphModalCoeffs(order, kr, nBands, ARRAY_CONSTRUCTION_OPEN_DIRECTIONAL, 0.5, pData->bN); break;
+                    case WEIGHT_OPEN_DIPOLE: sphModalCoeffs(order, kr, nBands, ARRAY_CONSTRUCTION_OPEN_DIRECTIONAL, 0.0, pData->bN); break;
                     case WEIGHT_RIGID_OMNI:
                     case WEIGHT_RIGID_CARD:
                     case WEIGHT_RIGID_DIPOLE:
                         /* if sensors are flushed with the rigid baffle: */
                         if(arraySpecs->R == arraySpecs->r )
-                            sphModalCoeffs(order, kr, HYBRID_BANDS, ARRAY_CONSTRUCTION_RIGID, 1.0, pData->bN);
+                            sphModalCoeffs(order, kr, nBands, ARRAY_CONSTRUCTION_RIGID, 1.0, pData->bN);
 
                         /* if sensors protrude from the rigid baffle: */
                         else{
                             if (arraySpecs->weightType == WEIGHT_RIGID_OMNI)
-                                sphScattererModalCoeffs(order, kr, kR, HYBRID_BANDS, pData->bN);
+                                sphScattererModalCoeffs(order, kr, kR, nBands, pData->bN);
                             else if (arraySpecs->weightType == WEIGHT_RIGID_CARD)
-                                sphScattererDirModalCoeffs(order, kr, kR, HYBRID_BANDS, 0.5, pData->bN);
+                                sphScattererDirModalCoeffs(order, kr, kR, nBands, 0.5, pData->bN);
                             else if (arraySpecs->weightType == WEIGHT_RIGID_DIPOLE)
-                                sphScattererDirModalCoeffs(order, kr, kR, HYBRID_BANDS, 0.0, pData->bN);
+                                sphScattererDirModalCoeffs(order, kr, kR, nBands, 0.0, pData->bN);
                         }
                         break;
                 }
                 break;
         }
         
-        for(band=0; band<HYBRID_BANDS; band++)
+        for(band=0; band<nBands; band++)
             for(n=0; n < order+1; n++)
                 pData->bN[band*(order+1)+n] = ccdiv(pData->bN[band*(order+1)+n], cmplx(4.0*SAF_PId, 0.0)); /* 4pi term */
 
         /* direct inverse */
         regPar = pData->regPar;
-        for(band=0; band<HYBRID_BANDS; band++)
+        for(band=0; band<nBands; band++)
             for(n=0; n < order+1; n++)
-                pData->bN_modal[band][n] = ccdiv(cmplx(1.0,0.0), (pData->bN[band*(order+1)+n]));
+                enc->bN_modal[band][n] = ccdiv(cmplx(1.0,0.0), (pData->bN[band*(order+1)+n]));
         
         /* regularised inverse */
         if (pData->filterType == FILTER_SOFT_LIM){
@@ -184,34 +612,34 @@ void array2sh_calculate_sht_matrix
              modalen amplitudenverst?rkung bei sph?rischen mikrofonarrays im plane wave decomposition verfahren.
              Proceedings of the 37. Deutsche Jahrestagung fur Akustik (DAGA 2011) */
             g_lim = sqrt(arraySpecs->Q)*pow(10.0,(regPar/20.0));
-            for(band=0; band<HYBRID_BANDS; band++)
+            for(band=0; band<nBands; band++)
                 for(n=0; n < order+1; n++)
-                    pData->bN_inv[band][n] = crmul(pData->bN_modal[band][n], (2.0*g_lim*cabs(pData->bN[band*(order+1)+n]) / SAF_PId)
+                    enc->bN_inv[band][n] = crmul(enc->bN_modal[band][n], (2.0*g_lim*cabs(pData->bN[band*(order+1)+n]) / SAF_PId)
                                                      * atan(SAF_PId / (2.0*g_lim*cabs(pData->bN[band*(order+1)+n]))) );
         }
         else if(pData->filterType == FILTER_TIKHONOV){
             /* Moreau, S., Daniel, J., Bertet, S., 2006, 3D sound field recording with higher order ambisonics-objective
              measurements and validation of spherical microphone. In Audio Engineering Society Convention 120. */
             alpha = sqrt(arraySpecs->Q)*pow(10.0,(regPar/20.0));
-            for(band=0; band<HYBRID_BANDS; band++){
+            for(band=0; band<nBands; band++){
                 for(n=0; n < order+1; n++){
                     beta = sqrt((1.0-sqrt(1.0-1.0/ pow(alpha,2.0)))/(1.0+sqrt(1.0-1.0/pow(alpha,2.0))));
-                    pData->bN_inv[band][n] = ccdiv(conj(pData->bN[band*(order+1)+n]), cmplx((pow(cabs(pData->bN[band*(order+1)+n]), 2.0) + pow(beta, 2.0)),0.0));
+                    enc->bN_inv[band][n] = ccdiv(conj(pData->bN[band*(order+1)+n]), cmplx((pow(cabs(pData->bN[band*(order+1)+n]), 2.0) + pow(beta, 2.0)),0.0));
                 }
             }
         }
         
         /* diag(filters) * Y */
-        array2sh_replicate_order(hA2sh, order); /* replicate orders */
+        array2sh_replicate_order(hA2sh, enc, order); /* replicate orders */
         
         diag_bN_inv_R = calloc1d(nSH*nSH, sizeof(float_complex));
-        for(band=0; band<HYBRID_BANDS; band++){
+        for(band=0; band<nBands; band++){
             for(i=0; i<nSH; i++)
-                diag_bN_inv_R[i*nSH+i] = cmplxf((float)creal(pData->bN_inv_R[band][i]), (float)cimag(pData->bN_inv_R[band][i]));
+                diag_bN_inv_R[i*nSH+i] = cmplxf((float)creal(enc->bN_inv_R[band][i]), (float)cimag(enc->bN_inv_R[band][i]));
             cblas_cgemm(CblasRowMajor, CblasNoTrans, CblasTrans, nSH, (arraySpecs->Q), nSH, &calpha,
                         diag_bN_inv_R, nSH,
                         pinv_Y_mic_cmplx, nSH, &cbeta,
-                        pData->W[band], MAX_NUM_SENSORS);
+                        enc->W[band], MAX_NUM_SENSORS);
         }
         free(diag_bN_inv_R);
     }
@@ -239,7 +667,7 @@ void array2sh_calculate_sht_matrix
         }
         
         /* design prototype filterbank */
-        for(band=0; band<HYBRID_BANDS; band++){
+        for(band=0; band<nBands; band++){
             normH = 0.0;
             for (n=0; n<order+1; n++){
                 if (n==0)
@@ -260,38 +688,38 @@ void array2sh_calculate_sht_matrix
                 
         /* compute inverse radial response */ 
         free(pData->bN);
-        pData->bN = malloc1d((HYBRID_BANDS)*(order+1)*sizeof(double_complex));
+        pData->bN = malloc1d((nBands)*(order+1)*sizeof(double_complex));
         switch(arraySpecs->arrayType){
             case ARRAY_CYLINDRICAL:
                 switch (arraySpecs->weightType){
-                    case WEIGHT_RIGID_OMNI:   cylModalCoeffs(order, kr, HYBRID_BANDS, ARRAY_CONSTRUCTION_RIGID, pData->bN); break;
+                    case WEIGHT_RIGID_OMNI:   cylModalCoeffs(order, kr, nBands, ARRAY_CONSTRUCTION_RIGID, pData->bN); break;
                     case WEIGHT_RIGID_CARD:   /* not supported */ break;
                     case WEIGHT_RIGID_DIPOLE: /* not supported */ break;
-                    case WEIGHT_OPEN_OMNI:    cylModalCoeffs(order, kr, HYBRID_BANDS, ARRAY_CONSTRUCTION_OPEN, pData->bN);  break;
+                    case WEIGHT_OPEN_OMNI:    cylModalCoeffs(order, kr, nBands, ARRAY_CONSTRUCTION_OPEN, pData->bN);  break;
                     case WEIGHT_OPEN_CARD:    /* not supported */ break;
                     case WEIGHT_OPEN_DIPOLE:  /* not supported */ break;
                 }
                 break;
             case ARRAY_SPHERICAL:
                 switch (arraySpecs->weightType){
-                    case WEIGHT_OPEN_OMNI:   sphModalCoeffs(order, kr, HYBRID_BANDS, ARRAY_CONSTRUCTION_OPEN, 1.0, pData->bN); break;
-                    case WEIGHT_OPEN_CARD:   sphModalCoeffs(order, kr, HYBRID_BANDS, ARRAY_CONSTRUCTION_OPEN_DIRECTIONAL, 0.5, pData->bN); break;
-                    case WEIGHT_OPEN_DIPOLE: sphModalCoeffs(order, kr, HYBRID_BANDS, ARRAY_CONSTRUCTION_OPEN_DIRECTIONAL, 0.0, pData->bN); break;
+                    case WEIGHT_OPEN_OMNI:   sphModalCoeffs(order, kr, nBands, ARRAY_CONSTRUCTION_OPEN, 1.0, pData->bN); break;
+                    case WEIGHT_OPEN_CARD:   sphModalCoeffs(order, kr, nBands, ARRAY_CONSTRUCTION_OPEN_DIRECTIONAL, 0.5, pData->bN); break;
+                    case WEIGHT_OPEN_DIPOLE: sphModalCoeffs(order, kr, nBands, ARRAY_CONSTRUCTION_OPEN_DIRECTIONAL, 0.0, pData->bN); break;
                     case WEIGHT_RIGID_OMNI:
                     case WEIGHT_RIGID_CARD:
                     case WEIGHT_RIGID_DIPOLE:
                         /* if sensors are flushed with the rigid baffle: */
                         if(arraySpecs->R == arraySpecs->r )
-                            sphModalCoeffs(order, kr, HYBRID_BANDS, ARRAY_CONSTRUCTION_RIGID, 1.0, pData->bN);
+                            sphModalCoeffs(order, kr, nBands, ARRAY_CONSTRUCTION_RIGID, 1.0, pData->bN);
                         
                         /* if sensors protrude from the rigid baffle: */
                         else{
                             if (arraySpecs->weightType == WEIGHT_RIGID_OMNI)
-                                sphScattererModalCoeffs(order, kr, kR, HYBRID_BANDS, pData->bN);
+                                sphScattererModalCoeffs(order, kr, kR, nBands, pData->bN);
                             else if (arraySpecs->weightType == WEIGHT_RIGID_CARD)
-                                sphScattererDirModalCoeffs(order, kr, kR, HYBRID_BANDS, 0.5, pData->bN);
+                                sphScattererDirModalCoeffs(order, kr, kR, nBands, 0.5, pData->bN);
                             else if (arraySpecs->weightType == WEIGHT_RIGID_DIPOLE)
-                                sphScattererDirModalCoeffs(order, kr, kR, HYBRID_BANDS, 0.0, pData->bN);
+                                sphScattererDirModalCoeffs(order, kr, kR, nBands, 0.0, pData->bN);
                         }
                         break;
                 }
@@ -299,12 +727,12 @@ void array2sh_calculate_sht_matrix
         }
         
         /* direct inverse (only required for GUI) */
-        for(band=0; band<HYBRID_BANDS; band++)
+        for(band=0; band<nBands; band++)
             for(n=0; n < order+1; n++)
-                pData->bN_modal[band][n] = ccdiv(cmplx(4.0*SAF_PId, 0.0), pData->bN[band*(order+1)+n]);
+                enc->bN_modal[band][n] = ccdiv(cmplx(4.0*SAF_PId, 0.0), pData->bN[band*(order+1)+n]);
 
         /* phase shift */
-        for(band=0; band<HYBRID_BANDS; band++)
+        for(band=0; band<nBands; band++)
             for (n=0; n<order+1; n++)
                 Hs[band][n] = ccmul(cexp(cmplx(0.0, kr[band])), ccdiv(cmplx(4.0*SAF_PId, 0.0), pData->bN[band*(order+1)+n]));
         
@@ -339,29 +767,29 @@ void array2sh_calculate_sht_matrix
         double H_np[HYBRID_BANDS][MAX_SH_ORDER+1];
         double W_np[MAX_SH_ORDER+1];
         for (n=0; n<order+1; n++){
-            for(band=0; band< HYBRID_BANDS; band++)
+            for(band=0; band< nBands; band++)
                 for (i=n, j=0; i<order+1; i++, j++)
                     H_np[band][j] = H[band][i];
             for (i=n, j=0; i<order+1; i++, j++)
                 W_np[j] = W[n][i];
-            cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasTrans, HYBRID_BANDS, 1, order+1-n, 1.0,
+            cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasTrans, nBands, 1, order+1-n, 1.0,
                         (const double*)H_np, MAX_SH_ORDER+1,
                         (const double*)W_np, MAX_SH_ORDER+1, 0.0,
                         (double*)HW, 1);
-            for(band=0; band<HYBRID_BANDS; band++)
-                pData->bN_inv[band][n] = crmul(Hs[band][n], HW[band]);
+            for(band=0; band<nBands; band++)
+                enc->bN_inv[band][n] = crmul(Hs[band][n], HW[band]);
         }
         
         /* diag(filters) * Y */
-        array2sh_replicate_order(hA2sh, order); /* replicate orders */
+        array2sh_replicate_order(hA2sh, enc, order); /* replicate orders */
         diag_bN_inv_R = calloc1d(nSH*nSH, sizeof(float_complex));
-        for(band=0; band<HYBRID_BANDS; band++){
+        for(band=0; band<nBands; band++){
             for(i=0; i<nSH; i++)
-                diag_bN_inv_R[i*nSH+i] = cmplxf((float)creal(pData->bN_inv_R[band][i]), (float)cimag(pData->bN_inv_R[band][i])); /* double->single */
+                diag_bN_inv_R[i*nSH+i] = cmplxf((float)creal(enc->bN_inv_R[band][i]), (float)cimag(enc->bN_inv_R[band][i])); /* double->single */
             cblas_cgemm(CblasRowMajor, CblasNoTrans, CblasTrans, nSH, (arraySpecs->Q), nSH, &calpha,
                         diag_bN_inv_R, nSH,
                         pinv_Y_mic_cmplx, nSH, &cbeta,
-                        pData->W[band], MAX_NUM_SENSORS);
+                        enc->W[band], MAX_NUM_SENSORS);
         }
         free(diag_bN_inv_R);
         
@@ -370,19 +798,146 @@ void array2sh_calculate_sht_matrix
     pData->order = order;
     
     if(pData->enableDiffEQpastAliasing)
-        array2sh_apply_diff_EQ(hA2sh);
+        array2sh_apply_diff_EQ(hA2sh, enc);
+
+    /* The STFT applies the filters by (circular) convolution; so delay them, such that their non-causal part does
+     * not wrap around to the end of the frame */
+    if(pData->filterbank==ARRAY2SH_FILTERBANK_STFT){
+        for(band=0; band<nBands; band++){
+            delay_ph = cexpf(cmplxf(0.0f, -2.0f*SAF_PI*(float)band*(float)STFT_FILTER_DELAY/(2.0f*(float)HOP_SIZE)));
+            for(i=0; i<nSH; i++)
+                for(j=0; j<arraySpecs->Q; j++)
+                    enc->W[band][i][j] = ccmulf(enc->W[band][i][j], delay_ph);
+        }
+    }
+
+    /* derive the representation that is actually applied during processing */
+    array2sh_compress_sht_matrix(hA2sh, enc);
     
     free(Y_mic);
     free(pinv_Y_mic);
     free(pinv_Y_mic_cmplx);
 }
 
+/* fills 'encKey' with the current settings; returns its size in bytes */
+static int array2sh_fill_encoder_key(void* const hA2sh)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    array2sh_arrayPars* arraySpecs = (array2sh_arrayPars*)(pData->arraySpecs);
+    array2sh_encoderKey* key = &(pData->encKey);
+    int i;
+
+    memset(key, 0, sizeof(array2sh_encoderKey)); /* padding too, as keys are compared bytewise */
+    key->order = pData->new_order;
+    key->Q = arraySpecs->Q;
+    key->nBands = pData->nBands;
+    key->filterbank = pData->filterbank;
+    key->arrayType = arraySpecs->arrayType;
+    key->weightType = arraySpecs->weightType;
+    key->filterType = pData->filterType;
+    key->enableDiffEQpastAliasing = pData->enableDiffEQpastAliasing;
+    key->r = arraySpecs->r;
+    key->R = arraySpecs->R;
+    key->c = pData->c;
+    key->regPar = pData->regPar;
+    key->compressionTol_dB = pData->compressionTol_dB;
+    key->tftCost = pData->tftCost;
+    memcpy(key->freqVector, pData->freqVector, pData->nBands*sizeof(float));
+    for(i=0; i<arraySpecs->Q; i++){
+        key->sensorCoords[i][0] = arraySpecs->sensorCoords_rad[i][0];
+        key->sensorCoords[i][1] = arraySpecs->sensorCoords_rad[i][1];
+        key->sensorCoords[i][2] = arraySpecs->sensorCoords_deg[i][0];
+        key->sensorCoords[i][3] = arraySpecs->sensorCoords_deg[i][1];
+    }
+    return (int)(offsetof(array2sh_encoderKey, sensorCoords) + (size_t)(arraySpecs->Q)*sizeof(key->sensorCoords[0]));
+}
+
+/* drops this instance's reference to an encoder, which is freed with its last
+ * reference (or straight away, if it is not shared) */
+static void array2sh_release_encoder(void* const hA2sh, array2sh_encoder* enc)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    if(enc==NULL)
+        return;
+    if(pData->encoderCache!=NULL)
+        pData->encoderCache->release(pData->encoderCacheData, enc);
+    else
+        free(enc);
+}
+
+void array2sh_calculate_sht_matrix
+(
+    void* const hA2sh
+)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    array2sh_arrayPars* arraySpecs = (array2sh_arrayPars*)(pData->arraySpecs);
+    array2sh_encoder* enc, *oldEnc;
+    int keySize, nSH, nTFTinputs;
+
+    /* look the encoder up in the cache, if there is one, and otherwise compute
+     * it; an encoder that is not shared is simply recomputed in place */
+    arraySpecs->R = SAF_MIN(arraySpecs->R, arraySpecs->r);
+    enc = NULL;
+    oldEnc = pData->enc;
+    if(pData->encoderCache!=NULL){
+        keySize = array2sh_fill_encoder_key(hA2sh);
+        enc = (array2sh_encoder*)pData->encoderCache->acquire(pData->encoderCacheData, &(pData->encKey), keySize);
+        if(enc==NULL){
+            enc = (array2sh_encoder*)calloc1d(1, sizeof(array2sh_encoder));
+            array2sh_build_sht_matrix(hA2sh, enc);
+            enc = (array2sh_encoder*)pData->encoderCache->publish(pData->encoderCacheData, &(pData->encKey), keySize, enc, free);
+        }
+    }
+    else{
+        enc = oldEnc!=NULL ? oldEnc : (array2sh_encoder*)calloc1d(1, sizeof(array2sh_encoder));
+        array2sh_build_sht_matrix(hA2sh, enc);
+    }
+    pData->enc = enc;
+    pData->order = pData->new_order;
+
+    /* an evaluation that is running may still be reading the previous encoder */
+    if(oldEnc!=NULL && oldEnc!=enc){
+        if(pData->evalStatus==EVAL_STATUS_EVALUATING && pData->retiredEnc==NULL)
+            pData->retiredEnc = oldEnc;
+        else
+            array2sh_release_encoder(hA2sh, oldEnc);
+    }
+    if(pData->retiredEnc!=NULL && pData->evalStatus!=EVAL_STATUS_EVALUATING){
+        array2sh_release_encoder(hA2sh, pData->retiredEnc);
+        pData->retiredEnc = NULL;
+    }
+
+    /* per-instance copies of the compression results */
+    pData->projectFLAG = enc->projectFLAG;
+    pData->compressionRatio = enc->compressionRatio;
+    memcpy(pData->compressionErr_dB, enc->compressionErr_dB, HYBRID_BANDS*sizeof(float));
+
+    /* the filterbank takes the mixture sources, the projected signals, or all
+     * of the sensor signals */
+    pData->nMixtureSources = pData->new_nMixtureSources;
+    nSH = (pData->order+1)*(pData->order+1);
+    if(pData->nMixtureSources>0)
+        nTFTinputs = pData->nMixtureSources;
+    else
+        nTFTinputs = pData->projectFLAG ? nSH : arraySpecs->Q;
+    if(nTFTinputs != pData->nTFTinputs){
+        array2sh_tftChannelChange(hA2sh, nTFTinputs, nSH);
+        pData->nTFTinputs = nTFTinputs;
+    }
+
+    /* pruned components are never written to, so they are zeroed once here;
+     * the bands may have changed, so the band range is applied anew */
+    memset(FLATTEN3D(pData->SHframeTF), 0, HYBRID_BANDS*MAX_NUM_SH_SIGNALS*MAX_BATCH_TIME_SLOTS*sizeof(float_complex));
+    pData->firstBand = -1;
+}
+
 /* Based on a MatLab script by Archontis Politis, 2019 */
-void array2sh_apply_diff_EQ(void* const hA2sh)
+void array2sh_apply_diff_EQ(void* const hA2sh, array2sh_encoder* enc)
 {
     array2sh_data *pData = (array2sh_data*)(hA2sh);
     array2sh_arrayPars* arraySpecs = (array2sh_arrayPars*)(pData->arraySpecs);
-    int i, j, band, array_order, idxf_alias, nSH;
+    int i, j, band, array_order, idxf_alias, nSH, nBands;
     float f_max, kR_max, f_alias, f_f_alias;
     double_complex* dM_diffcoh_s;
     const double_complex calpha = cmplx(1.0, 0.0); const double_complex cbeta  = cmplx(0.0, 0.0);
@@ -399,12 +954,13 @@ void array2sh_apply_diff_EQ(void* const hA2sh)
     
     /* prep */
     nSH = (pData->order+1)*(pData->order+1);
-    dM_diffcoh = malloc1d((arraySpecs->Q)*(arraySpecs->Q)* (HYBRID_BANDS) * sizeof(double_complex));
+    nBands = pData->nBands;
+    dM_diffcoh = malloc1d((arraySpecs->Q)*(arraySpecs->Q)* (nBands) * sizeof(double_complex));
     dM_diffcoh_s = malloc1d((arraySpecs->Q)*(arraySpecs->Q) * sizeof(double_complex));
     f_max = 20e3f;
     kR_max = 2.0f*SAF_PI*f_max*(arraySpecs->r)/pData->c;
     array_order = SAF_MIN((int)(ceilf(2.0f*kR_max)+0.01f), 28); /* Cap at around 28, as Bessels at 30+ can be numerically unstable */
-    for(band=0; band<HYBRID_BANDS; band++)
+    for(band=0; band<nBands; band++)
         kr[band] = 2.0*SAF_PId*(pData->freqVector[band])*(arraySpecs->r)/pData->c;
     
     /* Get theoretical diffuse coherence matrix */
@@ -415,22 +971,22 @@ void array2sh_apply_diff_EQ(void* const hA2sh)
         case ARRAY_SPHERICAL:
             switch (arraySpecs->weightType){
                 case WEIGHT_RIGID_OMNI: /* Does not handle the case where kr != kR ! */
-                    sphDiffCohMtxTheory(array_order, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q, ARRAY_CONSTRUCTION_RIGID, 1.0, kr, HYBRID_BANDS, dM_diffcoh);
+                    sphDiffCohMtxTheory(array_order, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q, ARRAY_CONSTRUCTION_RIGID, 1.0, kr, nBands, dM_diffcoh);
                     break;
                 case WEIGHT_RIGID_CARD:
-                    sphDiffCohMtxTheory(array_order, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q, ARRAY_CONSTRUCTION_RIGID_DIRECTIONAL, 0.5, kr, HYBRID_BANDS, dM_diffcoh);
+                    sphDiffCohMtxTheory(array_order, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q, ARRAY_CONSTRUCTION_RIGID_DIRECTIONAL, 0.5, kr, nBands, dM_diffcoh);
                     break;
                 case WEIGHT_RIGID_DIPOLE:
-                    sphDiffCohMtxTheory(array_order, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q, ARRAY_CONSTRUCTION_RIGID_DIRECTIONAL, 0.0, kr, HYBRID_BANDS, dM_diffcoh);
+                    sphDiffCohMtxTheory(array_order, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q, ARRAY_CONSTRUCTION_RIGID_DIRECTIONAL, 0.0, kr, nBands, dM_diffcoh);
                     break;
                 case WEIGHT_OPEN_OMNI:
-                    sphDiffCohMtxTheory(array_order, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q, ARRAY_CONSTRUCTION_OPEN, 1.0, kr, HYBRID_BANDS, dM_diffcoh);
+                    sphDiffCohMtxTheory(array_order, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q, ARRAY_CONSTRUCTION_OPEN, 1.0, kr, nBands, dM_diffcoh);
                     break;
                 case WEIGHT_OPEN_CARD:
-                    sphDiffCohMtxTheory(array_order, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q, ARRAY_CONSTRUCTION_OPEN_DIRECTIONAL, 0.5, kr, HYBRID_BANDS, dM_diffcoh);
+                    sphDiffCohMtxTheory(array_order, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q, ARRAY_CONSTRUCTION_OPEN_DIRECTIONAL, 0.5, kr, nBands, dM_diffcoh);
                     break;
                 case WEIGHT_OPEN_DIPOLE:
-                    sphDiffCohMtxTheory(array_order, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q, ARRAY_CONSTRUCTION_OPEN_DIRECTIONAL, 0.0, kr, HYBRID_BANDS, dM_diffcoh);
+                    sphDiffCohMtxTheory(array_order, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q, ARRAY_CONSTRUCTION_OPEN_DIRECTIONAL, 0.0, kr, nBands, dM_diffcoh);
                     break;
             }
             break;
@@ -440,7 +996,7 @@ void array2sh_apply_diff_EQ(void* const hA2sh)
     f_alias = sphArrayAliasLim(arraySpecs->r, pData->c, pData->order);
     idxf_alias = 1;
     f_f_alias = 1e13f;
-    for(band=0; band<HYBRID_BANDS; band++){
+    for(band=0; band<nBands; band++){
         if( fabsf(pData->freqVector[band]-f_alias) < f_f_alias){
             f_f_alias = fabsf(pData->freqVector[band]-f_alias);
             idxf_alias = band;
@@ -450,10 +1006,10 @@ void array2sh_apply_diff_EQ(void* const hA2sh)
     /* baseline */
     for(i=0; i<arraySpecs->Q; i++)
         for(j=0; j<arraySpecs->Q; j++)
-            dM_diffcoh_s[i*(arraySpecs->Q)+j] = cmplx(dM_diffcoh[i*(arraySpecs->Q)* (HYBRID_BANDS) + j*(HYBRID_BANDS) + (idxf_alias)], 0.0);
+            dM_diffcoh_s[i*(arraySpecs->Q)+j] = cmplx(dM_diffcoh[i*(arraySpecs->Q)* (nBands) + j*(nBands) + (idxf_alias)], 0.0);
     for(i=0; i<nSH; i++)
         for(j=0; j<arraySpecs->Q; j++)
-            W_tmp[i][j]= cmplx((double)crealf(pData->W[idxf_alias][i][j]), (double)cimagf(pData->W[idxf_alias][i][j]));
+            W_tmp[i][j]= cmplx((double)crealf(enc->W[idxf_alias][i][j]), (double)cimagf(enc->W[idxf_alias][i][j]));
     cblas_zgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, nSH, (arraySpecs->Q), (arraySpecs->Q), &calpha,
                 W_tmp, MAX_NUM_SENSORS,
                 dM_diffcoh_s, (arraySpecs->Q), &cbeta,
@@ -466,13 +1022,13 @@ void array2sh_apply_diff_EQ(void* const hA2sh)
         L_diff_fal[i][i] = crmul(L_diff_fal[i][i], 1.0/(4.0*SAF_PId)); /* only care about the diagonal entries */
     
     /* diffuse-field equalise bands above aliasing. */
-    for(band = SAF_MAX(idxf_alias,0)+1; band<HYBRID_BANDS; band++){
+    for(band = SAF_MAX(idxf_alias,0)+1; band<nBands; band++){
         for(i=0; i<arraySpecs->Q; i++)
             for(j=0; j<arraySpecs->Q; j++)
-                dM_diffcoh_s[i*(arraySpecs->Q)+j] = cmplx(dM_diffcoh[i*(arraySpecs->Q)* (HYBRID_BANDS) + j*(HYBRID_BANDS) + (band)], 0.0);
+                dM_diffcoh_s[i*(arraySpecs->Q)+j] = cmplx(dM_diffcoh[i*(arraySpecs->Q)* (nBands) + j*(nBands) + (band)], 0.0);
         for(i=0; i<nSH; i++)
             for(j=0; j<arraySpecs->Q; j++)
-                W_tmp[i][j]= cmplx((double)crealf(pData->W[band][i][j]), (double)cimagf(pData->W[band][i][j]));
+                W_tmp[i][j]= cmplx((double)crealf(enc->W[band][i][j]), (double)cimagf(enc->W[band][i][j]));
         cblas_zgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, nSH, (arraySpecs->Q), (arraySpecs->Q), &calpha,
                     W_tmp, MAX_NUM_SENSORS,
                     dM_diffcoh_s, (arraySpecs->Q), &cbeta,
@@ -490,7 +1046,7 @@ void array2sh_apply_diff_EQ(void* const hA2sh)
                     W_diffEQ, MAX_NUM_SENSORS);
         for(i=0; i<nSH; i++)
             for(j=0; j<arraySpecs->Q; j++)
-                pData->W[band][i][j] = cmplxf((float)creal(W_diffEQ[i][j]), (float)cimag(W_diffEQ[i][j]));
+                enc->W[band][i][j] = cmplxf((float)creal(W_diffEQ[i][j]), (float)cimag(W_diffEQ[i][j]));
     }
     
     pData->evalStatus = EVAL_STATUS_NOT_EVALUATED;
@@ -499,30 +1055,148 @@ void array2sh_apply_diff_EQ(void* const hA2sh)
     free(dM_diffcoh_s);
 }
 
+void array2sh_compress_sht_matrix(void* const hA2sh, array2sh_encoder* enc)
+{
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    array2sh_arrayPars* arraySpecs = (array2sh_arrayPars*)(pData->arraySpecs);
+    int i, j, n, band, Q, order, nSH, nBands, n_band, projectable, mixable, sum_nSH_band;
+    float tol;
+    double E_n, E_W, E_proj, cost_dense, cost_pruned, cost_projected;
+    double E_row[MAX_NUM_SH_SIGNALS], E_total[HYBRID_BANDS], E_pruned[HYBRID_BANDS], E_res[HYBRID_BANDS];
+    float* Y_mic, *pinv_Y_mic, *G;
+    float_complex* Yt_cmplx, *G_cmplx, *CG;
+    const float_complex calpha = cmplxf(1.0f, 0.0f); const float_complex cbeta  = cmplxf(0.0f, 0.0f);
+
+    /* prep */
+    Q = arraySpecs->Q;
+    order = pData->order;
+    nSH = (order+1)*(order+1);
+    nBands = pData->nBands;
+    tol = powf(10.0f, pData->compressionTol_dB/10.0f);
+
+    /* Projection P = pinv(Y)^T, where Y are the spherical harmonics at the sensor directions */
+    Y_mic = malloc1d(nSH*Q*sizeof(float));
+    getRSH(order, (float*)arraySpecs->sensorCoords_deg, Q, Y_mic); /* nSH x Q */
+    pinv_Y_mic = malloc1d(Q*nSH*sizeof(float));
+    utility_spinv(NULL, Y_mic, nSH, Q, pinv_Y_mic); /* Q x nSH */
+    for(i=0; i<nSH; i++)
+        for(j=0; j<Q; j++)
+            enc->P[i*Q+j] = pinv_Y_mic[j*nSH+i];
+    Yt_cmplx = malloc1d(Q*nSH*sizeof(float_complex));
+    for(j=0; j<Q; j++)
+        for(i=0; i<nSH; i++)
+            Yt_cmplx[j*nSH+i] = cmplxf(Y_mic[i*Q+j], 0.0f);
+
+    /* G = P*P^T; so that the energy of a row of C*P is given by c*G*c^H */
+    G = malloc1d(nSH*nSH*sizeof(float));
+    cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, nSH, nSH, Q, 1.0f,
+                enc->P, Q,
+                enc->P, Q, 0.0f,
+                G, nSH);
+    G_cmplx = malloc1d(nSH*nSH*sizeof(float_complex));
+    for(i=0; i<nSH*nSH; i++)
+        G_cmplx[i] = cmplxf(G[i], 0.0f);
+    CG = malloc1d(nSH*nSH*sizeof(float_complex));
+
+    projectable = nSH < Q ? 1 : 0; /* projecting only pays off if there are more sensors than SH components */
+    mixable = 1;
+    for(band=0; band<nBands; band++){
+        /* C = W*Y^T; since P = pinv(Y)^T, C*P is the projection of W onto the row space of Y */
+        cblas_cgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, nSH, nSH, Q, &calpha,
+                    enc->W[band], MAX_NUM_SENSORS,
+                    Yt_cmplx, nSH, &cbeta,
+                    enc->C[band], MAX_NUM_SH_SIGNALS);
+        cblas_cgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, nSH, nSH, nSH, &calpha,
+                    enc->C[band], MAX_NUM_SH_SIGNALS,
+                    G_cmplx, nSH, &cbeta,
+                    CG, nSH);
+
+        /* energy of each encoding filter (row of W), and of what is lost by projecting it */
+        E_total[band] = E_res[band] = 0.0;
+        for(i=0; i<nSH; i++){
+            E_W = 0.0;
+            for(j=0; j<Q; j++)
+                E_W += (double)crealf(ccmulf(enc->W[band][i][j], conjf(enc->W[band][i][j])));
+            E_proj = 0.0;
+            for(j=0; j<nSH; j++)
+                E_proj += (double)crealf(ccmulf(CG[i*nSH+j], conjf(enc->C[band][i][j])));
+            E_row[i] = E_W;
+            E_total[band] += E_W;
+            E_res[band] += SAF_MAX(E_W-E_proj, 0.0);
+        }
+        if(E_res[band] > tol*E_total[band])
+            projectable = 0;
+        if(E_res[band] > SAF_MAX(tol, MIN_MIXTURE_TOL)*E_total[band])
+            mixable = 0;
+
+        /* prune the highest orders, using the part of the tolerance that is
+         * left (if this band could be projected) */
+        E_pruned[band] = 0.0;
+        n_band = order;
+        for(n=order; n>0; n--){
+            E_n = 0.0;
+            for(i=n*n; i<(n+1)*(n+1); i++)
+                E_n += E_row[i];
+            if(E_pruned[band] + E_n + (projectable ? E_res[band] : 0.0) > tol*E_total[band])
+                break;
+            E_pruned[band] += E_n;
+            n_band = n-1;
+        }
+        enc->nSH_band[band] = (n_band+1)*(n_band+1);
+    }
+
+    /* estimated cost per hop (forward+backward filterbank, and encoding), with and without the projection */
+    sum_nSH_band = 0;
+    for(band=0; band<nBands; band++)
+        sum_nSH_band += enc->nSH_band[band];
+    cost_dense     = (double)(Q+nSH)*pData->tftCost+ 8.0*(double)nSH*(double)Q*(double)nBands;
+    cost_pruned    = (double)(Q+nSH)*pData->tftCost+ 8.0*(double)sum_nSH_band*(double)Q;
+    cost_projected = (double)(2*nSH)*pData->tftCost + 2.0*(double)nSH*(double)Q*(double)HOP_SIZE + 8.0*(double)sum_nSH_band*(double)nSH;
+    enc->projectFLAG = projectable && cost_projected<cost_pruned ? 1 : 0;
+    enc->mixtureFLAG = mixable;
+    enc->compressionRatio = (float)((enc->projectFLAG ? cost_projected : cost_pruned)/cost_dense);
+
+    /* relative error w.r.t. applying W */
+    for(band=0; band<nBands; band++){
+        E_n = E_pruned[band] + (enc->projectFLAG ? E_res[band] : 0.0);
+        enc->compressionErr_dB[band] = (float)(10.0*log10(SAF_MAX(E_n/SAF_MAX(E_total[band], 2.23e-20), 1e-15)));
+    }
+
+    free(Y_mic);
+    free(pinv_Y_mic);
+    free(Yt_cmplx);
+    free(G);
+    free(G_cmplx);
+    free(CG);
+}
+
 void array2sh_calculate_mag_curves(void* const hA2sh)
 {
     array2sh_data *pData = (array2sh_data*)(hA2sh);
     int band, n;
     
-    for(band = 0; band <HYBRID_BANDS; band++){
+    for(band = 0; band <pData->nBands; band++){
         for(n = 0; n <pData->order+1; n++){
-            pData->bN_inv_dB[band][n] = 20.0f * (float)log10(cabs(pData->bN_inv[band][n]));
-            pData->bN_modal_dB[band][n] = 20.0f * (float)log10(cabs(pData->bN_modal[band][n]));
+            pData->bN_inv_dB[band][n] = 20.0f * (float)log10(cabs(pData->enc->bN_inv[band][n]));
+            pData->bN_modal_dB[band][n] = 20.0f * (float)log10(cabs(pData->enc->bN_modal[band][n]));
         }
     }
+    pData->bNVersion++;
 }
 
 void array2sh_evaluateSHTfilters(void* hA2sh)
 {
     array2sh_data *pData = (array2sh_data*)(hA2sh);
     array2sh_arrayPars* arraySpecs = (array2sh_arrayPars*)(pData->arraySpecs);
-    int band, i, j, simOrder, order, nSH;
+    const array2sh_encoder* enc = pData->enc; /* see array2sh_calculate_sht_matrix() */
+    int band, i, j, simOrder, order, nSH, nBands;
     double kr[HYBRID_BANDS];
     double kR[HYBRID_BANDS];
     float* Y_grid_real;
-    float_complex* Y_grid, *H_array, *Wshort;
+    float_complex* Y_grid, *H_array, *Wshort, *P_cmplx;
+    const float_complex calpha = cmplxf(1.0f, 0.0f); const float_complex cbeta  = cmplxf(0.0f, 0.0f);
      
-    saf_assert(pData->W != NULL, "The initCodec function must have been called prior to calling array2sh_evaluateSHTfilters()");
+    saf_assert(enc != NULL, "The initCodec function must have been called prior to calling array2sh_evaluateSHTfilters()");
     
     strcpy(pData->progressBarText,"Simulating microphone array");
     pData->progressBar0_1 = 0.35f;
@@ -530,37 +1204,38 @@ void array2sh_evaluateSHTfilters(void* hA2sh)
     /* simulate the current array by firing 812 plane-waves around the surface of a theoretical version of the array
      * and ascertaining the transfer function for each */
     simOrder = (int)(2.0f*SAF_PI*MAX_EVAL_FREQ_HZ*(arraySpecs->r)/pData->c)+1;
-    for(band=0; band<HYBRID_BANDS; band++){
+    nBands = pData->nBands;
+    for(band=0; band<nBands; band++){
         kr[band] = 2.0*SAF_PId*(pData->freqVector[band])*(arraySpecs->r)/pData->c;
         kR[band] = 2.0*SAF_PId*(pData->freqVector[band])*(arraySpecs->R)/pData->c;
     }
-    H_array = malloc1d((HYBRID_BANDS) * (arraySpecs->Q) * 812*sizeof(float_complex));
+    H_array = malloc1d((nBands) * (arraySpecs->Q) * 812*sizeof(float_complex));
     switch(arraySpecs->arrayType){
         case ARRAY_SPHERICAL:
             switch(arraySpecs->weightType){
                 default:
                 case WEIGHT_RIGID_OMNI:
-                    simulateSphArray(simOrder, kr, kR, HYBRID_BANDS, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q,
+                    simulateSphArray(simOrder, kr, kR, nBands, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q,
                                      (float*)__geosphere_ico_9_0_dirs_deg, 812, ARRAY_CONSTRUCTION_RIGID, 1.0, H_array);
                     break;
                 case WEIGHT_RIGID_CARD:
-                    simulateSphArray(simOrder, kr, kR, HYBRID_BANDS, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q,
+                    simulateSphArray(simOrder, kr, kR, nBands, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q,
                                      (float*)__geosphere_ico_9_0_dirs_deg, 812, ARRAY_CONSTRUCTION_RIGID_DIRECTIONAL, 0.5, H_array);
                     break;
                 case WEIGHT_RIGID_DIPOLE:
-                    simulateSphArray(simOrder, kr, kR, HYBRID_BANDS, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q,
+                    simulateSphArray(simOrder, kr, kR, nBands, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q,
                                      (float*)__geosphere_ico_9_0_dirs_deg, 812, ARRAY_CONSTRUCTION_RIGID_DIRECTIONAL, 0.0, H_array);
                     break;
                 case WEIGHT_OPEN_OMNI:
-                    simulateSphArray(simOrder, kr, NULL, HYBRID_BANDS, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q,
+                    simulateSphArray(simOrder, kr, NULL, nBands, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q,
                                      (float*)__geosphere_ico_9_0_dirs_deg, 812, ARRAY_CONSTRUCTION_OPEN, 1.0, H_array);
                     break;
                 case WEIGHT_OPEN_CARD:
-                    simulateSphArray(simOrder, kr, NULL, HYBRID_BANDS, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q,
+                    simulateSphArray(simOrder, kr, NULL, nBands, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q,
                                      (float*)__geosphere_ico_9_0_dirs_deg, 812, ARRAY_CONSTRUCTION_OPEN_DIRECTIONAL, 0.5, H_array);
                     break;
                 case WEIGHT_OPEN_DIPOLE:
-                    simulateSphArray(simOrder, kr, NULL, HYBRID_BANDS, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q,
+                    simulateSphArray(simOrder, kr, NULL, nBands, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q,
                                      (float*)__geosphere_ico_9_0_dirs_deg, 812, ARRAY_CONSTRUCTION_OPEN_DIRECTIONAL, 0.0, H_array);
                     break;
             }
@@ -572,12 +1247,12 @@ void array2sh_evaluateSHTfilters(void* hA2sh)
                 case WEIGHT_RIGID_OMNI:
                 case WEIGHT_RIGID_CARD:
                 case WEIGHT_RIGID_DIPOLE:
-                    simulateCylArray(simOrder, kr, HYBRID_BANDS, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q, (float*)__geosphere_ico_9_0_dirs_deg, 812, ARRAY_CONSTRUCTION_RIGID, H_array);
+                    simulateCylArray(simOrder, kr, nBands, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q, (float*)__geosphere_ico_9_0_dirs_deg, 812, ARRAY_CONSTRUCTION_RIGID, H_array);
                     break;
                 case WEIGHT_OPEN_DIPOLE:
                 case WEIGHT_OPEN_CARD:
                 case WEIGHT_OPEN_OMNI:
-                    simulateCylArray(simOrder, kr, HYBRID_BANDS, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q, (float*)__geosphere_ico_9_0_dirs_deg, 812, ARRAY_CONSTRUCTION_OPEN, H_array);
+                    simulateCylArray(simOrder, kr, nBands, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q, (float*)__geosphere_ico_9_0_dirs_deg, 812, ARRAY_CONSTRUCTION_OPEN, H_array);
                     break;
             }
             break;
@@ -596,12 +1271,36 @@ void array2sh_evaluateSHTfilters(void* hA2sh)
         Y_grid[i] = cmplxf(Y_grid_real[i], 0.0f); /* "evaluateSHTfilters" function requires complex data type */
     
     /* compare the spherical harmonics obtained from encoding matrix 'W' with the ideal patterns */
-    Wshort = malloc1d(HYBRID_BANDS*nSH*(arraySpecs->Q)*sizeof(float_complex));
-    for(band=0; band<HYBRID_BANDS; band++)
+    Wshort = malloc1d(nBands*nSH*(arraySpecs->Q)*sizeof(float_complex));
+    for(band=0; band<nBands; band++)
         for(i=0; i<nSH; i++)
             for(j=0; j<(arraySpecs->Q); j++)
-                Wshort[band*nSH*(arraySpecs->Q) + i*(arraySpecs->Q) + j] = pData->W[band][i][j];
-    evaluateSHTfilters(order, Wshort, arraySpecs->Q, HYBRID_BANDS, H_array, 812, Y_grid, pData->cSH, pData->lSH);
+                Wshort[band*nSH*(arraySpecs->Q) + i*(arraySpecs->Q) + j] = enc->W[band][i][j];
+    evaluateSHTfilters(order, Wshort, arraySpecs->Q, nBands, H_array, 812, Y_grid, pData->cSH, pData->lSH);
+
+    /* and likewise for the compressed encoder, as it is applied during processing */
+    strcpy(pData->progressBarText,"Evaluating compressed encoder");
+    pData->progressBar0_1 = 0.9f;
+    memset(Wshort, 0, nBands*nSH*(arraySpecs->Q)*sizeof(float_complex));
+    if(enc->projectFLAG){
+        P_cmplx = malloc1d(nSH*(arraySpecs->Q)*sizeof(float_complex));
+        for(i=0; i<nSH*(arraySpecs->Q); i++)
+            P_cmplx[i] = cmplxf(enc->P[i], 0.0f);
+        for(band=0; band<nBands; band++)
+            cblas_cgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, enc->nSH_band[band], (arraySpecs->Q), nSH, &calpha,
+                        enc->C[band], MAX_NUM_SH_SIGNALS,
+                        P_cmplx, (arraySpecs->Q), &cbeta,
+                        &Wshort[band*nSH*(arraySpecs->Q)], (arraySpecs->Q));
+        free(P_cmplx);
+    }
+    else{
+        for(band=0; band<nBands; band++)
+            for(i=0; i<enc->nSH_band[band]; i++)
+                for(j=0; j<(arraySpecs->Q); j++)
+                    Wshort[band*nSH*(arraySpecs->Q) + i*(arraySpecs->Q) + j] = enc->W[band][i][j];
+    }
+    evaluateSHTfilters(order, Wshort, arraySpecs->Q, nBands, H_array, 812, Y_grid, pData->cSH_compressed, pData->lSH_compressed);
+    pData->evalVersion++;
 
     free(Y_grid_real);
     free(Y_grid);
@@ -611,7 +1310,9 @@ void array2sh_evaluateSHTfilters(void* hA2sh)
 
 void array2sh_createArray(void ** const hPars)
 {
-    array2sh_arrayPars* pars = (array2sh_arrayPars*)malloc1d(sizeof(array2sh_arrayPars));
+    /* zeroed, as the sensor setters only write (both the radians and degrees
+     * of) a direction that differs from the current one */
+    array2sh_arrayPars* pars = (array2sh_arrayPars*)calloc1d(1, sizeof(array2sh_arrayPars));
     *hPars = (void*)pars;
 }
 
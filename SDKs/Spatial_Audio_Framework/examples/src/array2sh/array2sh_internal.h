@@ -70,16 +70,30 @@ extern "C" {
 # endif
 #endif
 #define HOP_SIZE ( 128 )                              /**< STFT hop size */
-#define HYBRID_BANDS ( HOP_SIZE + 5 )                 /**< Number of frequency bands */
+#define HYBRID_BANDS ( ARRAY2SH_MAX_NUM_BANDS )       /**< Maximum number of frequency bands (afSTFT with hybrid filtering: HOP_SIZE + 5) */
 #define TIME_SLOTS ( ARRAY2SH_FRAME_SIZE / HOP_SIZE ) /**< Number of STFT timeslots */
+#define MAX_BATCH_TIME_SLOTS ( 8 )                    /**< Maximum number of STFT timeslots encoded at once by array2sh_processBlock() */
+#define MAX_BATCH_SIZE ( MAX_BATCH_TIME_SLOTS * HOP_SIZE ) /**< Maximum number of time-domain samples encoded at once */
 #define MAX_NUM_SENSORS ( ARRAY2SH_MAX_NUM_SENSORS )  /**< Maximum permitted number of inputs/sensors */
 #define MAX_EVAL_FREQ_HZ ( 20e3f )                    /**< Up to which frequency should the evaluation be accurate */
+#define STFT_FILTER_DELAY ( HOP_SIZE/2 )              /**< Delay imposed on the encoding filters when using #ARRAY2SH_FILTERBANK_STFT, in samples */
+#define MIN_MIXTURE_TOL ( 1e-5f )                     /**< Relative energy of the residual of W - C*P below which signals may be mixed into the projected ones, whatever the compression tolerance (that of float precision, see array2sh_compress_sht_matrix()) */
 #define MAX_NUM_SENSORS_IN_PRESET ( MAX_NUM_SENSORS ) /**< Maximum permitted number of inputs/sensors */
 
+/** Notifies the stage hook (if any) that a processing stage is entered */
+#define ARRAY2SH_STAGE_BEGIN(pData, stage) \
+    do{ if((pData)->stageHook!=NULL) (pData)->stageHook((pData)->stageHookData, stage, 1); }while(0)
+/** Notifies the stage hook (if any) that a processing stage is left */
+#define ARRAY2SH_STAGE_END(pData, stage) \
+    do{ if((pData)->stageHook!=NULL) (pData)->stageHook((pData)->stageHookData, stage, 0); }while(0)
+
 /* Checks: */
 #if (ARRAY2SH_FRAME_SIZE % HOP_SIZE != 0)
 # error "ARRAY2SH_FRAME_SIZE must be an integer multiple of HOP_SIZE"
 #endif
+#if (TIME_SLOTS > MAX_BATCH_TIME_SLOTS)
+# error "ARRAY2SH_FRAME_SIZE must not exceed MAX_BATCH_SIZE"
+#endif
 
 /* ========================================================================== */
 /*                                 Structures                                 */
@@ -98,6 +112,53 @@ typedef struct _array2sh_arrayPars {
         
 }array2sh_arrayPars;
 
+/**
+ * Encoding matrices; computed by array2sh_calculate_sht_matrix(), and only
+ * read once computed, so that they may be shared by several instances (see
+ * array2sh_setEncoderCache())
+ */
+typedef struct _array2sh_encoder {
+    double_complex bN_modal[HYBRID_BANDS][MAX_SH_ORDER + 1];    /**< Current modal coeffients */
+    double_complex bN_inv[HYBRID_BANDS][MAX_SH_ORDER + 1];      /**< 1/bN_modal */
+    double_complex bN_inv_R[HYBRID_BANDS][MAX_NUM_SH_SIGNALS];  /**< 1/bN_modal with regularisation */
+    float_complex W[HYBRID_BANDS][MAX_NUM_SH_SIGNALS][MAX_NUM_SENSORS]; /**< Encoding weights */
+
+    /* compressed encoder (see array2sh_compress_sht_matrix()) */
+    float_complex C[HYBRID_BANDS][MAX_NUM_SH_SIGNALS][MAX_NUM_SH_SIGNALS]; /**< Per-band mixing of the projected signals (W ~= C*P); only used if projectFLAG */
+    float P[MAX_NUM_SH_SIGNALS*MAX_NUM_SENSORS]; /**< Band-independent projection of the sensor signals, pinv(Y)^T; FLAT: nSH x Q */
+    int nSH_band[HYBRID_BANDS];     /**< Number of SH components encoded per band (the remaining orders are pruned) */
+    float compressionErr_dB[HYBRID_BANDS]; /**< Relative error of the compressed encoder w.r.t. 'W', per band, dB */
+    float compressionRatio;         /**< Estimated cost of the compressed encoder relative to 'W' */
+    int projectFLAG;                /**< 1: sensors are projected with 'P' and mixed with 'C'; 0: 'W' is applied */
+    int mixtureFLAG;                /**< 1: W ~= C*P in every band (within the compression tolerance, or #MIN_MIXTURE_TOL), so that signals may be mixed into the projected ones (see array2sh_processMixture()) */
+
+}array2sh_encoder;
+
+/**
+ * Everything that the encoding matrices are computed from; encoders with equal
+ * keys are identical. Only the first Q rows of 'sensorCoords' are part of the
+ * key (see array2sh_encoderKeySize())
+ */
+typedef struct _array2sh_encoderKey {
+    int order;                      /**< Encoding order */
+    int Q;                          /**< Number of sensors */
+    int nBands;                     /**< Number of frequency bands */
+    ARRAY2SH_FILTERBANKS filterbank; /**< see #ARRAY2SH_FILTERBANKS */
+    ARRAY2SH_ARRAY_TYPES arrayType; /**< see #ARRAY2SH_ARRAY_TYPES */
+    ARRAY2SH_WEIGHT_TYPES weightType; /**< see #ARRAY2SH_WEIGHT_TYPES */
+    ARRAY2SH_FILTER_TYPES filterType; /**< see #ARRAY2SH_FILTER_TYPES */
+    int enableDiffEQpastAliasing;   /**< 0: disabled, 1: enabled */
+    float r;                        /**< radius of sensors */
+    float R;                        /**< radius of scatterer */
+    float c;                        /**< speed of sound, m/s */
+    float regPar;                   /**< regularisation upper gain limit, dB */
+    float compressionTol_dB;        /**< encoder compression tolerance, dB */
+    double tftCost;                 /**< filterbank cost estimate (see array2sh_compress_sht_matrix()) */
+    float freqVector[HYBRID_BANDS]; /**< frequency vector */
+    float sensorCoords[MAX_NUM_SENSORS][4]; /**< Sensor directions in radians, then in degrees */
+
+}array2sh_encoderKey;
+
 /**
  * Main structure for array2sh. Contains variables for audio buffers, afSTFT,
  * encoding matrices, internal variables, flags, user parameters
@@ -105,28 +166,53 @@ typedef struct _array2sh_arrayPars {
 typedef struct _array2sh
 {
     /* audio buffers */
-    float** inputFrameTD;           /**< Input sensor signals in the time-domain; #MAX_NUM_SENSORS x #ARRAY2SH_FRAME_SIZE */
-    float** SHframeTD;              /**< Output SH signals in the time-domain; #MAX_NUM_SH_SIGNALS x #ARRAY2SH_FRAME_SIZE */
-    float_complex*** inputframeTF;  /**< Input sensor signals in the time-domain; #HYBRID_BANDS x #MAX_NUM_SENSORS x #TIME_SLOTS */
-    float_complex*** SHframeTF;     /**< Output SH signals in the time-domain; #HYBRID_BANDS x #MAX_NUM_SH_SIGNALS x #TIME_SLOTS */
+    float** SHframeTD;              /**< Scratch for SH signals that are not written straight to the caller; #MAX_NUM_SH_SIGNALS x #MAX_BATCH_SIZE */
+    float_complex*** inputframeTF;  /**< Input sensor signals in the time-frequency domain; #HYBRID_BANDS x max(nBufferSensors, #MAX_NUM_SH_SIGNALS) x #MAX_BATCH_TIME_SLOTS */
+    float_complex*** SHframeTF;     /**< Output SH signals in the time-frequency domain; #HYBRID_BANDS x #MAX_NUM_SH_SIGNALS x #MAX_BATCH_TIME_SLOTS */
+    int nBufferSensors;             /**< Number of sensors the input buffers are currently allocated for */
+    float zeroFrameTD[MAX_BATCH_SIZE];            /**< Silence; read in place of sensors that the caller does not provide */
+    float* inputFramePtrs[MAX_NUM_SENSORS];       /**< Per-sensor read positions for the current batch (points into the caller's buffers) */
+    float* SHframePtrs[MAX_NUM_SH_SIGNALS];       /**< Per-SH-channel write positions for the current batch (points into the caller's buffers) */
+    const float* spanInputs[MAX_NUM_SENSORS];     /**< Channel pointers of a strided input span; see array2sh_processStrided() */
+    float* spanOutputs[MAX_NUM_SH_SIGNALS];       /**< Channel pointers of a strided output span; see array2sh_processSpans() */
     
-    /* intermediates */
-    double_complex bN_modal[HYBRID_BANDS][MAX_SH_ORDER + 1];    /**< Current modal coeffients */
-    double_complex* bN;                                         /**< Temp vector for the modal coefficients */
-    double_complex bN_inv[HYBRID_BANDS][MAX_SH_ORDER + 1];      /**< 1/bN_modal */
-    double_complex bN_inv_R[HYBRID_BANDS][MAX_NUM_SH_SIGNALS];  /**< 1/bN_modal with regularisation */
-    float_complex W[HYBRID_BANDS][MAX_NUM_SH_SIGNALS][MAX_NUM_SENSORS];        /**< Encoding weights */
-    float_complex W_diffEQ[HYBRID_BANDS][MAX_NUM_SH_SIGNALS][MAX_NUM_SENSORS]; /**< Encoding weights with diffuse-field EQ above the spatial aliasing limit */
+    /* encoding matrices (see array2sh_calculate_sht_matrix()); owned by this
+     * instance, or shared through the encoder cache (if one is set) */
+    array2sh_encoder* enc;          /**< Current encoder; NULL until first computed */
+    array2sh_encoder* retiredEnc;   /**< Previous encoder, kept until a running evaluation has finished with it */
+    array2sh_encoderKey encKey;     /**< Key of the encoder being looked up or computed */
+    const array2sh_encoderCache* encoderCache; /**< see array2sh_setEncoderCache(); NULL: no sharing */
+    void* encoderCacheData;         /**< user data passed on to the cache functions */
+    double_complex* bN;             /**< Temp vector for the modal coefficients */
+    float** projFrameTD;            /**< Projected sensor signals in the time-domain; #MAX_NUM_SH_SIGNALS x #MAX_BATCH_SIZE */
+    int projectFLAG;                /**< 1: sensors are projected with 'P' and mixed with 'C'; 0: 'W' is applied (copied from 'enc') */
+    float compressionErr_dB[HYBRID_BANDS]; /**< Relative error of the compressed encoder w.r.t. 'W', per band, dB (copied from 'enc') */
+    float compressionRatio;         /**< Estimated cost of the compressed encoder relative to 'W' (copied from 'enc') */
+    int nTFTinputs;                 /**< Current number of filterbank input channels (Q, nSH if projectFLAG, or nMixtureSources) */
+    int nMixtureSources;            /**< Number of source signals mixed into the projected signals; 0: the sensors are encoded (see array2sh_setNumMixtureSources()) */
+    int new_nMixtureSources;        /**< new number of mixture sources (current value will be replaced by this after next re-init) */
+    float_complex*** mixframeTF;    /**< Projected signals mixed from the sources, in the time-frequency domain; #HYBRID_BANDS x #MAX_NUM_SH_SIGNALS x #MAX_BATCH_TIME_SLOTS */
+    float bandRange[2];             /**< Centre frequencies of the bands that are encoded, [min, max) Hz (see array2sh_setBandRange()) */
+    float appliedBandRange[2];      /**< bandRange, as last applied (see array2sh_applyBandRange()) */
+    int firstBand;                  /**< First band that is encoded; -1: bandRange is yet to be applied */
+    int lastBand;                   /**< One past the last band that is encoded */
+    double tftCost;                 /**< Approximate cost of passing one channel through the current filterbank for one hop, in GEMM flops (see array2sh_tftCreate()) */
     
     /* for displaying the bNs */
     float** bN_modal_dB;            /**< modal responses / no regulaisation; HYBRID_BANDS x (MAX_SH_ORDER +1)  */
     float** bN_inv_dB;              /**< modal responses / with regularisation; HYBRID_BANDS x (MAX_SH_ORDER +1)  */
     float* cSH;                     /**< spatial correlation; HYBRID_BANDS x 1 */
     float* lSH;                     /**< level difference; HYBRID_BANDS x 1 */
+    float* cSH_compressed;          /**< spatial correlation of the compressed encoder; HYBRID_BANDS x 1 */
+    float* lSH_compressed;          /**< level difference of the compressed encoder; HYBRID_BANDS x 1 */
+    unsigned int bNVersion;         /**< incremented whenever bN_modal_dB/bN_inv_dB are recomputed */
+    unsigned int evalVersion;       /**< incremented whenever cSH/lSH (and the compressed ones) are recomputed */
     
     /* time-frequency transform and array details */
     float freqVector[HYBRID_BANDS]; /**< frequency vector */
-    void* hSTFT;                    /**< filterbank handle */
+    void* hSTFT;                    /**< filterbank handle (afSTFT, qmf or saf_stft; see #ARRAY2SH_FILTERBANKS) */
+    ARRAY2SH_FILTERBANKS filterbank; /**< current filterbank */
+    int nBands;                     /**< number of frequency bands of the current filterbank; at most #HYBRID_BANDS */
     void* arraySpecs;               /**< array configuration */
     
     /* internal parameters */
@@ -135,9 +221,12 @@ typedef struct _array2sh
     char* progressBarText;          /**< Current (re)initialisation step, string */ 
     int fs;                         /**< sampling rate, hz */
     int new_order;                  /**< new encoding order (current value will be replaced by this after next re-init) */
+    ARRAY2SH_FILTERBANKS new_filterbank; /**< new filterbank (current one will be replaced by this after next re-init) */
     
     /* flags */
     PROC_STATUS procStatus;         /**< see #PROC_STATUS */
+    array2sh_stageHook stageHook;   /**< called when entering/leaving a processing stage (or NULL); see array2sh_setStageHook() */
+    void* stageHookData;            /**< user data passed on to stageHook */
     int reinitSHTmatrixFLAG;        /**< 0: do not reinit; 1: reinit; */
     int evalRequestedFLAG;          /**< 0: do not reinit; 1: reinit; */
     
@@ -150,6 +239,7 @@ typedef struct _array2sh
     NORM_TYPES norm;                /**< Ambisonic normalisation convention (see #NORM_TYPES) */
     float c;                        /**< speed of sound, m/s */
     float gain_dB;                  /**< post gain, dB */
+    float compressionTol_dB;        /**< encoder compression tolerance, dB */
     int enableDiffEQpastAliasing;   /**< 0: disabled, 1: enabled */
     
 } array2sh_data;
@@ -162,21 +252,147 @@ typedef struct _array2sh
 /**
  * Initialise the filterbank used by array2sh.
  *
- * @note Call this function before array2sh_calculate_sht_matrix()
+ * The filterbank is (re)created if a different one has been selected, and the
+ * input buffers are (re)allocated whenever the number of sensors changes.
+ *
+ * @note Call this function before array2sh_calculate_sht_matrix(), and only
+ *       from array2sh_initCodec(); it is never called while processing
  */
 void array2sh_initTFT(void* const hA2sh);
 
+/**
+ * Creates the filterbank specified by 'filterbank', and sets the number of
+ * bands, the cost estimate and the frequency vector accordingly
+ */
+void array2sh_tftCreate(void* const hA2sh, int nCHin, int nCHout);
+
+/** Destroys the current filterbank (if any) */
+void array2sh_tftDestroy(void* const hA2sh);
+
+/** Changes the number of filterbank input/output channels, and flushes it */
+void array2sh_tftChannelChange(void* const hA2sh, int nCHin, int nCHout);
+
+/**
+ * Forward transform of nSamples of the current input channels of the
+ * filterbank, into 'inputframeTF' (the band data are laid out as the 3-D
+ * array; i.e. channel rows of #MAX_BATCH_TIME_SLOTS, in the same way for all
+ * filterbanks)
+ */
+void array2sh_tftForward(void* const hA2sh, float** dataTD, int nSamples);
+
+/**
+ * Applies the band range (see array2sh_setBandRange()), if it has changed
+ * since it was last applied, or the encoder has been recomputed: 'SHframeTF'
+ * is silenced, and the bands outside of the range are then skipped by the
+ * encoding (or mixed straight from the sources, by the mixture encoding)
+ */
+void array2sh_applyBandRange(void* const hA2sh);
+
+/**
+ * Backward transform of nSamples from 'SHframeTF', into the buffers pointed to
+ * by 'SHframePtrs'
+ */
+void array2sh_tftBackward(void* const hA2sh, int nSamples);
+
+/** Returns the processing delay of a filterbank, in samples */
+int array2sh_getFilterbankDelay(ARRAY2SH_FILTERBANKS filterbank);
+
+/**
+ * Computes the centre frequencies of the current filterbank (the tabulated
+ * afSTFT hybrid ones, if the filterbank is yet to be created)
+ */
+void array2sh_calculate_centre_freqs(void* const hA2sh);
+
+/**
+ * Encodes nTimeSlots hops of the input signals, starting at sample 'offset' of
+ * each input/output channel buffer.
+ *
+ * The afSTFT is applied over all of the time slots at once, so that the
+ * per-band encoding becomes a single (nSH x Q) * (Q x nTimeSlots) matrix
+ * multiplication. The filterbank reads the input buffers and (for ACN
+ * ordering) writes the output buffers directly; no time-domain staging copies
+ * are made.
+ *
+ * @note nTimeSlots must not exceed #MAX_BATCH_TIME_SLOTS. The input and output
+ *       buffers must not overlap.
+ *
+ * @param[in]  hA2sh      array2sh handle
+ * @param[in]  inputs      Input channel buffers; nInputs x (offset+nSamples)
+ * @param[in]  inputStride Distance between the input channels, in samples, if
+ *                         they lie in one strided span (see
+ *                         array2sh_processStrided()); 0 if they do not
+ * @param[out] outputs     Output channel buffers; nOutputs x (offset+nSamples)
+ * @param[in]  nInputs     Number of input channels
+ * @param[in]  nOutputs    Number of output channels
+ * @param[in]  offset      Sample offset into the input/output buffers
+ * @param[in]  nTimeSlots  Number of time slots (hops) to encode
+ */
+void array2sh_encodeTimeSlots(void* const hA2sh,
+                              const float *const * inputs,
+                              int inputStride,
+                              float** const outputs,
+                              int nInputs,
+                              int nOutputs,
+                              int offset,
+                              int nTimeSlots);
+
+/**
+ * Encodes nTimeSlots hops of source signals, which are first mixed into the
+ * projected signals in each band (see array2sh_processMixture()), starting at
+ * sample 'offset' of each source/output channel buffer.
+ *
+ * @note nTimeSlots must not exceed #MAX_BATCH_TIME_SLOTS.
+ *
+ * @param[in]  hA2sh      array2sh handle
+ * @param[in]  sources    Source channel buffers; nMixtureSources x (offset+nSamples)
+ * @param[in]  mixing     Mixing matrices; nBands x nSH x nMixtureSources
+ * @param[out] outputs    Output channel buffers; nOutputs x (offset+nSamples)
+ * @param[in]  nOutputs   Number of output channels
+ * @param[in]  offset     Sample offset into the source/output buffers
+ * @param[in]  nTimeSlots Number of time slots (hops) to encode
+ */
+void array2sh_encodeMixtureTimeSlots(void* const hA2sh,
+                                     const float *const * sources,
+                                     const float_complex* mixing,
+                                     float** const outputs,
+                                     int nOutputs,
+                                     int offset,
+                                     int nTimeSlots);
+
 /**
  * Computes the spherical harmonic transform (SHT) matrix, to spatially encode
  * input microphone/hydrophone signals into spherical harmonic signals.
+ *
+ * If an encoder cache is set (see array2sh_setEncoderCache()), the matrices
+ * are taken from it when another instance has already computed them for the
+ * same settings, and are otherwise computed and published to it. Either way,
+ * the filterbank is then reconfigured for the (compressed) encoder.
  */
 void array2sh_calculate_sht_matrix(void* const hA2sh);
 
 /**
  * Applies diffuse-field equalisation at frequencies above the spatial aliasing
- * limit.
+ * limit, to the encoding matrices of 'enc'.
  */
-void array2sh_apply_diff_EQ(void* const hA2sh);
+void array2sh_apply_diff_EQ(void* const hA2sh, array2sh_encoder* enc);
+
+/**
+ * Derives the compressed representation of the current encoding matrices 'W',
+ * which is the one that is actually applied during processing.
+ *
+ * In each band, the highest orders are pruned for as long as the discarded
+ * energy stays below the compression tolerance. Since the encoders are built
+ * as diag(filters) * pinv(Y)^T (where 'Y' are the spherical harmonics at the
+ * sensor directions), each band is also tested for whether it lies within the
+ * row space of Y: W_band ~= C_band * P, where C_band = W_band * Y^T and
+ * P = pinv(Y)^T. If all bands pass, then the sensor signals are projected by
+ * 'P' in the time-domain, and the filterbank is only applied to nSH channels
+ * (which array2sh_calculate_sht_matrix() then reconfigures it for).
+ *
+ * @note Called at the end of array2sh_calculate_sht_matrix(), for the encoder
+ *       'enc' that it computes
+ */
+void array2sh_compress_sht_matrix(void* const hA2sh, array2sh_encoder* enc);
 
 /**
  * Computes the magnitude responses of the equalisation filters; the
@@ -188,6 +404,9 @@ void array2sh_calculate_mag_curves(void* const hA2sh);
  * Evaluates the spherical harmonic transform performance with the currently
  * configured microphone/hydrophone array.
  *
+ * The compressed encoder (see array2sh_compress_sht_matrix()) is evaluated in
+ * the same manner, so that the two may be compared.
+ *
  * @note This is based on an analytical model of the array, so may differ in
  *       practice (although, it is usually pretty close, and saves from having
  *       to measure the array)
@@ -451,11 +451,12 @@ void saf_stft_backward
 
     for (t = 0; t<nHops; t++){
         for(ch=0; ch < h->nCHout; ch++){
-            /* Shift data down */
-            memcpy(h->overlapAddBuffer[ch], h->overlapAddBuffer[ch] + h->hopsize, (h->numOvrlpAddBlocks-1)*(h->hopsize)*sizeof(float));
+            /* Shift data down (the whole buffer, since the inverse FFT output
+             * spans fftsize=2*winsize samples, not just winsize) */
+            memmove(h->overlapAddBuffer[ch], h->overlapAddBuffer[ch] + h->hopsize, (h->bufferlength - h->hopsize)*sizeof(float));
 
             /* Append with zeros */
-            memset(h->overlapAddBuffer[ch] + (h->numOvrlpAddBlocks-1)*(h->hopsize), 0, h->hopsize*sizeof(float));
+            memset(h->overlapAddBuffer[ch] + (h->bufferlength - h->hopsize), 0, h->hopsize*sizeof(float));
 
             /* Apply inverse FFT */
             switch(h->FDformat){
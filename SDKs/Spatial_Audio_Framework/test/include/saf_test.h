@@ -114,6 +114,11 @@ void test__saf_stft_50pc_overlap(void);
  * Testing for perfect reconstruction of the saf_stft (when configured for
  * linear time-invariant (LTI) filtering applications) */
 void test__saf_stft_LTI(void);
+/** 
+ * Testing that the saf_stft (when configured for linear time-invariant (LTI)
+ * filtering applications) retains the whole output of a filter, which extends
+ * beyond the hop it was applied to */
+void test__saf_stft_LTI_filtering(void);
 /**
  * Testing the forward and backward real-(half)complex FFT (saf_rfft) */
 void test__saf_rfft(void);
@@ -93,6 +93,7 @@ int main_test(void) {
     RUN_TEST(test__quaternion);
     RUN_TEST(test__saf_stft_50pc_overlap);
     RUN_TEST(test__saf_stft_LTI);
+    RUN_TEST(test__saf_stft_LTI_filtering);
     RUN_TEST(test__saf_matrixConv);
     RUN_TEST(test__saf_rfft);
     RUN_TEST(test__saf_fft);
@@ -263,16 +263,17 @@ void test__saf_example_ambi_enc(void){
 }
 
 void test__saf_example_array2sh(void){
-    int nSH, i, j, framesize, ch;
-    void* hA2sh, *safFFT, *hMC;
+    int nSH, i, j, framesize, blocksize, ch, nFreqPoints, delay;
+    void* hA2sh, *hA2sh_block, *hA2sh_strided, *safFFT, *hMC;
     float direction_deg[2], radius;
-    float* inSig, *f;
-    float** shSig, **inSig_32, **micSig, **h_array, **micSig_frame, **shSig_frame;
-    double* kr;
+    float* inSig, *f, *compressionErr;
+    float** shSig, **shSig_block, **shSig_strided, **inSig_32, **micSig, **h_array, **micSig_frame, **shSig_frame;
+    double* kr, errEnergy, refEnergy;
     float_complex* tmp_H;
     float_complex*** H_array;
 
     /* Config */
+    const float acceptedTolerance = 0.0001f;
     const int order = 4;
     const int fs = 48000;
     const int signalLength = fs*2;
@@ -284,6 +285,21 @@ void test__saf_example_array2sh(void){
     array2sh_init(hA2sh, fs); /* Cannot be called while "process" is on-going */
     array2sh_setPreset(hA2sh, MICROPHONE_ARRAY_PRESET_EIGENMIKE32);
     array2sh_setNormType(hA2sh, NORM_N3D);
+    array2sh_initCodec(hA2sh); /* Builds the filterbank and encoder; the output is silent until then */
+
+    /* Second instance, which encodes whole host blocks at once */
+    array2sh_create(&hA2sh_block);
+    array2sh_init(hA2sh_block, fs);
+    array2sh_setPreset(hA2sh_block, MICROPHONE_ARRAY_PRESET_EIGENMIKE32);
+    array2sh_setNormType(hA2sh_block, NORM_N3D);
+    array2sh_initCodec(hA2sh_block);
+
+    /* Third instance, which reads the input signals as one strided span */
+    array2sh_create(&hA2sh_strided);
+    array2sh_init(hA2sh_strided, fs);
+    array2sh_setPreset(hA2sh_strided, MICROPHONE_ARRAY_PRESET_EIGENMIKE32);
+    array2sh_setNormType(hA2sh_strided, NORM_N3D);
+    array2sh_initCodec(hA2sh_strided);
 
     /* Define input mono signal */
     nSH = ORDER2NSH(order);
@@ -338,12 +354,81 @@ void test__saf_example_array2sh(void){
         array2sh_process(hA2sh, (const float* const*)micSig_frame, shSig_frame, 32, nSH, framesize);
     }
 
+    /* Encode again, but with blocks spanning several hops (which are also
+     * longer than the maximum batch size) */
+    blocksize = 10*array2sh_getHopSize();
+    shSig_block = (float**)calloc2d(nSH,signalLength,sizeof(float));
+    for(i=0; i<(int)((float)signalLength/(float)blocksize); i++){
+        for(ch=0; ch<32; ch++)
+            micSig_frame[ch] = &micSig[ch][i*blocksize];
+        for(ch=0; ch<nSH; ch++)
+            shSig_frame[ch] = &shSig_block[ch][i*blocksize];
+
+        array2sh_processBlock(hA2sh_block, (const float* const*)micSig_frame, shSig_frame, 32, nSH, blocksize);
+    }
+
+    /* And again, reading the sensor signals directly from the (contiguous)
+     * 32 x signalLength input matrix; every other block is also written
+     * directly into the (contiguous) nSH x signalLength output matrix */
+    shSig_strided = (float**)calloc2d(nSH,signalLength,sizeof(float));
+    for(i=0; i<(int)((float)signalLength/(float)blocksize); i++){
+        for(ch=0; ch<nSH; ch++)
+            shSig_frame[ch] = &shSig_strided[ch][i*blocksize];
+
+        if(i%2==0)
+            array2sh_processStrided(hA2sh_strided, &micSig[0][i*blocksize], signalLength, shSig_frame, 32, nSH, blocksize);
+        else
+            array2sh_processSpans(hA2sh_strided, &micSig[0][i*blocksize], signalLength, &shSig_strided[0][i*blocksize], signalLength, 32, nSH, blocksize);
+    }
+
+    /* The batched encodings should match the frame-by-frame encoding */
+    for(i=0; i<nSH; i++){
+        for(j=0; j<(signalLength/blocksize)*blocksize; j++){
+            TEST_ASSERT_FLOAT_WITHIN(acceptedTolerance, shSig[i][j], shSig_block[i][j]);
+            TEST_ASSERT_FLOAT_WITHIN(acceptedTolerance, shSig[i][j], shSig_strided[i][j]);
+        }
+    }
+
+    /* The compressed encoder must stay within the requested tolerance, and
+     * should never cost more than the full encoder */
+    compressionErr = array2sh_getCompressionError_Handle(hA2sh, &nFreqPoints);
+    for(i=0; i<nFreqPoints; i++)
+        TEST_ASSERT_TRUE(compressionErr[i] <= array2sh_getCompressionTol(hA2sh) + 0.01f);
+    TEST_ASSERT_TRUE(array2sh_getCompressionRatio(hA2sh) <= 1.0f);
+
+    /* Encode once more using the (low-latency) STFT filterbank; the omni
+     * component should match the default encoding, once time-aligned */
+    delay = array2sh_getFilterbankProcessingDelay(hA2sh_block);
+    array2sh_setFilterbank(hA2sh_block, ARRAY2SH_FILTERBANK_STFT);
+    TEST_ASSERT_TRUE(array2sh_getFilterbank(hA2sh_block) == ARRAY2SH_FILTERBANK_STFT);
+    array2sh_initCodec(hA2sh_block);
+    delay -= array2sh_getFilterbankProcessingDelay(hA2sh_block);
+    TEST_ASSERT_TRUE(delay > 0);
+    for(i=0; i<(int)((float)signalLength/(float)blocksize); i++){
+        for(ch=0; ch<32; ch++)
+            micSig_frame[ch] = &micSig[ch][i*blocksize];
+        for(ch=0; ch<nSH; ch++)
+            shSig_frame[ch] = &shSig_block[ch][i*blocksize];
+
+        array2sh_processBlock(hA2sh_block, (const float* const*)micSig_frame, shSig_frame, 32, nSH, blocksize);
+    }
+    errEnergy = refEnergy = 0.0;
+    for(j=0; j<(signalLength/blocksize)*blocksize-delay; j++){
+        errEnergy += (shSig[0][j+delay]-shSig_block[0][j])*(shSig[0][j+delay]-shSig_block[0][j]);
+        refEnergy += shSig[0][j+delay]*shSig[0][j+delay];
+    }
+    TEST_ASSERT_TRUE(10.0*log10(errEnergy/refEnergy) < -20.0);
+
     /* Clean-up */
     array2sh_destroy(&hA2sh);
+    array2sh_destroy(&hA2sh_block);
+    array2sh_destroy(&hA2sh_strided);
     saf_rfft_destroy(&safFFT);
     saf_multiConv_destroy(&hMC);
     free(inSig);
     free(shSig);
+    free(shSig_block);
+    free(shSig_strided);
     free(inSig_32);
     free(f);
     free(kr);
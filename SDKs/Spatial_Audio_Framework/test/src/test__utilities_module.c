@@ -327,6 +327,71 @@ void test__saf_stft_LTI(void){
     free(outspec);
 }
 
+void test__saf_stft_LTI_filtering(void){
+    int frame, winsize, hopsize, nFrames, ch, i, nBands, nTimesSlots, band, t;
+    void* hSTFT;
+    float** insig, **outsig, **inframe, **outframe;
+    float_complex*** inspec, ***outspec;
+    float_complex delayBin;
+
+    /* prep */
+    const float acceptedTolerance = 0.0001f;
+    const int fs = 48000;
+    const int framesize = 512;
+    const int nCH = 4;
+    const int delay = 97; /* samples; applied as a phase ramp, < winsize */
+    insig = (float**)malloc2d(nCH,fs,sizeof(float)); /* One second long */
+    outsig = (float**)malloc2d(nCH,fs,sizeof(float));
+    inframe = (float**)malloc2d(nCH,framesize,sizeof(float));
+    outframe = (float**)malloc2d(nCH,framesize,sizeof(float));
+    rand_m1_1(FLATTEN2D(insig), nCH*fs); /* populate with random numbers */
+
+    /* Set-up STFT suitable for LTI filtering applications */
+    winsize = hopsize = 128;
+    nBands = winsize+1;
+    nTimesSlots = framesize/hopsize;
+    inspec = (float_complex***)malloc3d(nBands, nCH, nTimesSlots, sizeof(float_complex));
+    outspec = (float_complex***)malloc3d(nBands, nCH, nTimesSlots, sizeof(float_complex));
+    saf_stft_create(&hSTFT, winsize, hopsize, nCH, nCH, SAF_STFT_BANDS_CH_TIME);
+
+    /* Pass insig through STFT, and delay it in the frequency domain; the
+     * output of the inverse FFT then extends past the hop it belongs to */
+    nFrames = (int)((float)fs/(float)framesize);
+    for(frame = 0; frame<nFrames; frame++){
+        /* Forward */
+        for(ch=0; ch<nCH; ch++)
+            memcpy(inframe[ch], &insig[ch][frame*framesize], framesize*sizeof(float));
+        saf_stft_forward(hSTFT, inframe, framesize, inspec);
+
+        /* Apply the delay */
+        for(band=0; band<nBands; band++){
+            delayBin = cexpf(crmulf(cmplxf(0.0f, -2.0f*SAF_PI*(float)band/(float)(2*winsize)), (float)delay));
+            for(ch=0; ch<nCH; ch++)
+                for(t=0; t<nTimesSlots; t++)
+                    outspec[band][ch][t] = ccmulf(inspec[band][ch][t], delayBin);
+        }
+
+        /* Backward */
+        saf_stft_backward(hSTFT, outspec, framesize, outframe);
+        for(ch=0; ch<nCH; ch++)
+            memcpy(&outsig[ch][frame*framesize], outframe[ch], framesize*sizeof(float));
+    }
+
+    /* Check that output==delayed input (given some numerical precision) */
+    for(ch=0; ch<nCH; ch++)
+        for(i=0; i<fs-framesize-delay; i++)
+            TEST_ASSERT_TRUE( fabsf(insig[ch][i] - outsig[ch][i+delay]) <= acceptedTolerance );
+
+    /* Clean-up */
+    saf_stft_destroy(&hSTFT);
+    free(insig);
+    free(outsig);
+    free(inframe);
+    free(outframe);
+    free(inspec);
+    free(outspec);
+}
+
 void test__saf_matrixConv(void){
     int i, frame;
     float** inputTD, **outputTD, **inputFrameTD, **outputFrameTD;
@@ -0,0 +1,406 @@
+//
+//  sarita_bench.cpp
+//  sparta_array2sh
+//
+//  Headless benchmark of the SARITA engine (upsampling + array2sh encoding).
+//  Drives the engine through its API (sarita.h), as the plug-in does, for every
+//  config in sarita_vst_configs/ and a matrix of host block sizes, overlaps and
+//  SHT on/off, and writes the results as JSON.
+//
+//  usage: sarita_bench [--configs <dir>] [--input <file>] [--seconds <s>]
+//                      [--order <n>] [--out <file.json>] [--trace <file.json>]
+//                      [--shift-estimation <full|decimated>] [--band-split <off|on>]
+//                      [--domain <time|tf>] [--quality <full|high|medium|low>]
+//                      [--allow-rt-violations]
+//
+//  One run is made with synthetic (white noise) input, and one more with the
+//  recorded input if a WAV, RF64 or W64 file is given (its channels are
+//  repeated cyclically, if it has fewer than the sparse grid requires, and it
+//  is looped if it is shorter than the requested duration). --trace
+//  additionally records the timeline of all runs as a Chrome trace (see
+//  SaritaTrace.h). --shift-estimation selects how the time shifts are
+//  estimated in all runs (see SARITA_SHIFT_ESTIMATION; full rate by default),
+//  and --band-split whether the SH signals below the spatial aliasing frequency
+//  are encoded from the sparse array itself (see SARITA_BAND_SPLIT; off by
+//  default), in which case all sensors of the array are input, and the SH
+//  signals are encoded in the time-frequency domain. --domain tf
+//  encodes the SH signals in the time-frequency domain, straight from the
+//  sparse array (see SARITA_UPSAMPLING_DOMAIN; time by default), and
+//  --quality prunes the neighbours of small weights (see SARITA_QUALITY; full
+//  by default), for which the JSON also records the number of
+//  cross-correlations computed and the largest expected error. Each run
+//  records the time shift estimation in effect, which is the full rate in
+//  builds with Apple Accelerate, whatever is selected.
+//
+//  The timed callbacks are checked for allocations, locks and file I/O (see
+//  SaritaRtCheck.h); the most frequent offending call stacks are printed, and
+//  the benchmark fails (exit code 2) if there were any, unless
+//  --allow-rt-violations is given. The known and accepted ones (the lock of
+//  the OpenBLAS buffer pool) are suppressed: they are only counted, per run,
+//  as rt_suppressed.
+
+#include "saf.h"
+#include "array2sh.h"
+#include "sarita.h"
+#include "SaritaTrace.h"
+#include "../src/SaritaRtCheck.h"
+#include "../render/SaritaAudioFile.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifndef SARITA_CONFIG_DIR
+# define SARITA_CONFIG_DIR "sarita_vst_configs"
+#endif
+#ifndef SARITA_BENCH_REVISION
+# define SARITA_BENCH_REVISION "unknown"
+#endif
+
+/* ========================================================================== */
+/*                                    Input                                   */
+/* ========================================================================== */
+
+/* Reads a whole WAV, RF64 or W64 file (see SaritaAudioFile.h), as planar
+ * float signals */
+static bool readAudioFile(const char* path, std::vector<std::vector<float>>& signals, int& fs)
+{
+    SaritaAudioFileReader reader;
+    if (!reader.open(path) || reader.getInfo().numFrames == 0)
+        return false;
+
+    const SaritaAudioFileInfo& info = reader.getInfo();
+    signals.assign(info.numChannels, std::vector<float>((size_t)info.numFrames));
+    std::vector<float*> channels;
+    for (auto& ch : signals)
+        channels.push_back(ch.data());
+    fs = info.sampleRate;
+    return reader.read(0, channels.data(), info.numChannels, (int)info.numFrames) == info.numFrames;
+}
+
+/* ========================================================================== */
+/*                                 Benchmark                                  */
+/* ========================================================================== */
+
+struct RunResult
+{
+    std::string config, input;
+    int blockSize, numSparse, numDense, numOutputs;
+    float overlapPercent;
+    bool sht;
+    SARITA_SHIFT_ESTIMATION shiftEstimation; // in effect
+    long numCallbacks, numOverruns, allocations;
+    size_t memoryBytes;   // reserved by the engine for its buffers
+    int numCrossCorrelations; // per frame, once pruned
+    float maxPruningError;    // expected, of the worst dense grid sensor
+    uint64_t rtViolations[SARITA_RT_NUM_KINDS];
+    uint64_t rtSuppressed[SARITA_RT_NUM_KINDS];
+    double realtimeFactor, p50, p99, max, mean;
+    double stageShare[SARITA_NUM_STAGES]; // fraction of the timed stage ticks
+};
+
+static double percentile(std::vector<double>& sorted, double p)
+{
+    size_t idx = (size_t)(p * (double)(sorted.size()-1) + 0.5);
+    return sorted[SAF_MIN(idx, sorted.size()-1)];
+}
+
+static const char* qualityName(SARITA_QUALITY quality)
+{
+    switch (quality) {
+        case SARITA_QUALITY_HIGH:   return "high";
+        case SARITA_QUALITY_MEDIUM: return "medium";
+        case SARITA_QUALITY_LOW:    return "low";
+        case SARITA_QUALITY_FULL:
+        default:                    return "full";
+    }
+}
+
+static bool parseQuality(const std::string& name, SARITA_QUALITY& quality)
+{
+    for (int q = SARITA_QUALITY_FULL; q <= SARITA_QUALITY_LOW; q++) {
+        if (name == qualityName((SARITA_QUALITY)q)) {
+            quality = (SARITA_QUALITY)q;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* One run: sets up a fresh engine + encoder, feeds one second of warm-up
+ * (not timed; the encoder is computed on the first call), and then times every
+ * host callback for the requested duration */
+static bool benchmarkRun(const std::string& cfgPath, const std::vector<std::vector<float>>& input,
+                         int fs, int blockSize, float overlapPercent, bool sht, int order,
+                         SARITA_SHIFT_ESTIMATION shiftEstimation, SARITA_BAND_SPLIT bandSplit,
+                         SARITA_UPSAMPLING_DOMAIN domain, SARITA_QUALITY quality, double seconds, RunResult& result)
+{
+    void* hSar;
+    sarita_create(&hSar);
+    sarita_init(hSar, fs, blockSize);
+    sarita_parameters params;
+    sarita_getParameters(hSar, &params);
+    params.overlapPercent = overlapPercent;
+    params.outputType = sht ? SARITA_OUTPUT_SH : SARITA_OUTPUT_DENSE_GRID;
+    params.order = order;
+    params.shiftEstimation = shiftEstimation;
+    params.bandSplit = bandSplit;
+    params.upsamplingDomain = domain;
+    sarita_applyQualityPreset(&params, quality);
+    sarita_setParameters(hSar, &params);
+    if (sarita_loadConfig(hSar, cfgPath.c_str()) != 0 || sarita_getConfigSamplingRate(hSar) != fs) {
+        sarita_destroy(&hSar);
+        return false;
+    }
+
+    const int numInputs = bandSplit == SARITA_BAND_SPLIT_ON ? sarita_getNumArraySensors(hSar) : sarita_getNumSparseSensors(hSar);
+    const int numOutputs = sht ? ORDER2NSH(order) : SAF_MIN(sarita_getNumDenseSensors(hSar), 64);
+    const long numWarmUp = (long)ceil((double)fs / (double)blockSize);
+    const long numCallbacks = (long)ceil(seconds * (double)fs / (double)blockSize);
+    const double deadline_us = 1e6 * (double)blockSize / (double)fs;
+    const size_t inputLength = input[0].size();
+    float** inFrame = (float**)malloc2d(numInputs, blockSize, sizeof(float));
+    float** outFrame = (float**)malloc2d(numOutputs, blockSize, sizeof(float));
+    std::vector<double> callback_us((size_t)numCallbacks);
+    size_t readPos = 0;
+    double total_us = 0.0;
+    long numOverruns = 0;
+
+    for (long n = 0; n < numWarmUp + numCallbacks; n++) {
+        /* next host block (looped), outside of the timed section */
+        for (int ch = 0; ch < numInputs; ch++) {
+            const std::vector<float>& src = input[ch % input.size()];
+            for (int i = 0; i < blockSize; i++)
+                inFrame[ch][i] = src[(readPos + i) % inputLength];
+        }
+        readPos = (readPos + blockSize) % inputLength;
+        if (n == numWarmUp) {
+            SaritaRtCheck::reset();
+            sarita_resetTimingStats(hSar);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        if (n >= numWarmUp)
+            SaritaRtCheck::enterCallback();
+        sarita_process(hSar, inFrame, outFrame, numInputs, numOutputs, blockSize);
+        if (n >= numWarmUp)
+            SaritaRtCheck::exitCallback();
+        auto stop = std::chrono::steady_clock::now();
+
+        if (n >= numWarmUp) {
+            double t_us = std::chrono::duration<double, std::micro>(stop - start).count();
+            callback_us[n - numWarmUp] = t_us;
+            total_us += t_us;
+            numOverruns += t_us > deadline_us ? 1 : 0;
+        }
+    }
+
+    std::sort(callback_us.begin(), callback_us.end());
+    result.blockSize = blockSize;
+    result.overlapPercent = overlapPercent;
+    result.sht = sht;
+    result.shiftEstimation = sarita_getActiveShiftEstimation(hSar);
+    result.numSparse = numInputs;
+    result.numDense = sarita_getNumDenseSensors(hSar);
+    result.numOutputs = numOutputs;
+    result.memoryBytes = sarita_getMemorySize(hSar);
+    result.numCrossCorrelations = sarita_getNumCrossCorrelations(hSar);
+    result.maxPruningError = sarita_getPruningErrors(hSar, NULL, 0);
+    result.numCallbacks = numCallbacks;
+    result.numOverruns = numOverruns;
+    for (int k = 0; k < SARITA_RT_NUM_KINDS; k++) {
+        result.rtViolations[k] = SaritaRtCheck::getNumViolations(k);
+        result.rtSuppressed[k] = SaritaRtCheck::getNumSuppressed(k);
+    }
+    result.allocations = (long)result.rtViolations[SARITA_RT_ALLOC];
+    result.realtimeFactor = (double)numCallbacks * deadline_us / total_us;
+    result.p50 = percentile(callback_us, 0.50);
+    result.p99 = percentile(callback_us, 0.99);
+    result.max = callback_us.back();
+    result.mean = total_us / (double)numCallbacks;
+    SaritaTimingStats stats;
+    sarita_getTimingStats(hSar, &stats);
+    uint64_t totalTicks = 0;
+    for (int i = 0; i < SARITA_NUM_STAGES; i++)
+        totalTicks += stats.stageTicks[i];
+    for (int i = 0; i < SARITA_NUM_STAGES; i++)
+        result.stageShare[i] = totalTicks > 0 ? (double)stats.stageTicks[i] / (double)totalTicks : 0.0;
+
+    free(inFrame);
+    free(outFrame);
+    sarita_destroy(&hSar);
+    return true;
+}
+
+static void writeJson(FILE* fid, const std::vector<RunResult>& results, int fs, double seconds, int order,
+                      SARITA_SHIFT_ESTIMATION shiftEstimation, SARITA_BAND_SPLIT bandSplit,
+                      SARITA_UPSAMPLING_DOMAIN domain, SARITA_QUALITY quality)
+{
+    fprintf(fid, "{\n");
+    fprintf(fid, "  \"benchmark\": \"sarita_bench\",\n");
+    fprintf(fid, "  \"revision\": \"%s\",\n", SARITA_BENCH_REVISION);
+    fprintf(fid, "  \"fs\": %d,\n", fs);
+    fprintf(fid, "  \"seconds_per_run\": %g,\n", seconds);
+    fprintf(fid, "  \"sh_order\": %d,\n", order);
+    fprintf(fid, "  \"shift_estimation\": \"%s\",\n", shiftEstimation == SARITA_SHIFT_ESTIMATION_DECIMATED ? "decimated" : "full");
+    fprintf(fid, "  \"band_split\": %s,\n", bandSplit == SARITA_BAND_SPLIT_ON ? "true" : "false");
+    fprintf(fid, "  \"upsampling_domain\": \"%s\",\n", domain == SARITA_UPSAMPLING_DOMAIN_TIME_FREQUENCY ? "tf" : "time");
+    fprintf(fid, "  \"quality\": \"%s\",\n", qualityName(quality));
+    fprintf(fid, "  \"rt_check\": %s,\n", SARITA_RT_CHECK ? "true" : "false");
+    fprintf(fid, "  \"counts_malloc\": %s,\n", SaritaRtCheck::interposesLibc() ? "true" : "false");
+    fprintf(fid, "  \"runs\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const RunResult& r = results[i];
+        fprintf(fid, "    {\"config\": \"%s\", \"input\": \"%s\", \"block_size\": %d, \"overlap_percent\": %g, "
+                "\"sht\": %s, \"shift_estimation\": \"%s\", \"sparse_channels\": %d, \"dense_channels\": %d, \"output_channels\": %d, "
+                "\"callbacks\": %ld, \"realtime_factor\": %.3f, "
+                "\"callback_us\": {\"p50\": %.2f, \"p99\": %.2f, \"max\": %.2f, \"mean\": %.2f}, "
+                "\"deadline_us\": %.2f, \"overruns\": %ld, \"allocations\": %ld, \"memory_bytes\": %zu, "
+                "\"cross_correlations\": %d, \"max_pruning_error\": %.4f, \"stage_share\": {",
+                r.config.c_str(), r.input.c_str(), r.blockSize, r.overlapPercent,
+                r.sht ? "true" : "false", r.shiftEstimation == SARITA_SHIFT_ESTIMATION_DECIMATED ? "decimated" : "full", r.numSparse, r.numDense, r.numOutputs,
+                r.numCallbacks, r.realtimeFactor, r.p50, r.p99, r.max, r.mean,
+                1e6 * (double)r.blockSize / (double)fs, r.numOverruns, r.allocations, r.memoryBytes,
+                r.numCrossCorrelations, r.maxPruningError);
+        for (int s = 0; s < SARITA_NUM_STAGES; s++)
+            fprintf(fid, "\"%s\": %.4f%s", sarita_getStageName(s), r.stageShare[s], s + 1 < SARITA_NUM_STAGES ? ", " : "");
+        fprintf(fid, "}, \"rt_violations\": {");
+        for (int k = 0; k < SARITA_RT_NUM_KINDS; k++)
+            fprintf(fid, "\"%s\": %llu%s", SaritaRtCheck::getKindName(k), (unsigned long long)r.rtViolations[k],
+                    k + 1 < SARITA_RT_NUM_KINDS ? ", " : "");
+        fprintf(fid, "}, \"rt_suppressed\": {");
+        for (int k = 0; k < SARITA_RT_NUM_KINDS; k++)
+            fprintf(fid, "\"%s\": %llu%s", SaritaRtCheck::getKindName(k), (unsigned long long)r.rtSuppressed[k],
+                    k + 1 < SARITA_RT_NUM_KINDS ? ", " : "");
+        fprintf(fid, "}}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(fid, "  ]\n}\n");
+}
+
+int main(int argc, char** argv)
+{
+    std::string configDir = SARITA_CONFIG_DIR;
+    const char* inputPath = NULL;
+    const char* outPath = NULL;
+    const char* tracePath = NULL;
+    bool allowRtViolations = false;
+    double seconds = 5.0;
+    int order = MAX_SH_ORDER;
+    SARITA_SHIFT_ESTIMATION shiftEstimation = SARITA_SHIFT_ESTIMATION_FULL_RATE;
+    SARITA_BAND_SPLIT bandSplit = SARITA_BAND_SPLIT_OFF;
+    SARITA_UPSAMPLING_DOMAIN domain = SARITA_UPSAMPLING_DOMAIN_TIME;
+    SARITA_QUALITY quality = SARITA_QUALITY_FULL;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--configs" && i+1 < argc)       configDir = argv[++i];
+        else if (arg == "--input" && i+1 < argc)    inputPath = argv[++i];
+        else if (arg == "--out" && i+1 < argc)      outPath = argv[++i];
+        else if (arg == "--seconds" && i+1 < argc)  seconds = atof(argv[++i]);
+        else if (arg == "--order" && i+1 < argc)    order = atoi(argv[++i]);
+        else if (arg == "--trace" && i+1 < argc)    tracePath = argv[++i];
+        else if (arg == "--allow-rt-violations")    allowRtViolations = true;
+        else if (arg == "--shift-estimation" && i+1 < argc && (std::string(argv[i+1]) == "full" || std::string(argv[i+1]) == "decimated"))
+            shiftEstimation = std::string(argv[++i]) == "decimated" ? SARITA_SHIFT_ESTIMATION_DECIMATED : SARITA_SHIFT_ESTIMATION_FULL_RATE;
+        else if (arg == "--band-split" && i+1 < argc && (std::string(argv[i+1]) == "off" || std::string(argv[i+1]) == "on"))
+            bandSplit = std::string(argv[++i]) == "on" ? SARITA_BAND_SPLIT_ON : SARITA_BAND_SPLIT_OFF;
+        else if (arg == "--domain" && i+1 < argc && (std::string(argv[i+1]) == "time" || std::string(argv[i+1]) == "tf"))
+            domain = std::string(argv[++i]) == "tf" ? SARITA_UPSAMPLING_DOMAIN_TIME_FREQUENCY : SARITA_UPSAMPLING_DOMAIN_TIME;
+        else if (arg == "--quality" && i+1 < argc && parseQuality(argv[i+1], quality))
+            i++;
+        else {
+            fprintf(stderr, "usage: %s [--configs <dir>] [--input <file>] [--seconds <s>] [--order <n>] [--out <file.json>] [--trace <file.json>] [--shift-estimation <full|decimated>] [--band-split <off|on>] [--domain <time|tf>] [--quality <full|high|medium|low>] [--allow-rt-violations]\n", argv[0]);
+            return 1;
+        }
+    }
+    order = SAF_CLAMP(order, 1, MAX_SH_ORDER);
+
+    /* all configs are exported for 48 kHz */
+    const int fs = 48000;
+    const char* configs[] = { "eigenmike32_N4", "eigenmike64_N6", "hosma_N7", "zylia_N3" };
+    const int blockSizes[] = { 256, 512, 1024, 2048 };
+    const float overlaps[] = { 12.5f, 25.0f, 49.0f }; /* as offered by the plug-in (which limits "50 %" to 49) */
+
+    /* inputs: white noise, and optionally a recording */
+    std::vector<std::pair<std::string, std::vector<std::vector<float>>>> inputs;
+    std::vector<std::vector<float>> noise(MAX_NUM_SH_SIGNALS, std::vector<float>(fs));
+    for (auto& ch : noise)
+        rand_m1_1(ch.data(), fs);
+    inputs.emplace_back("noise", noise);
+    if (inputPath != NULL) {
+        std::vector<std::vector<float>> recorded;
+        int fileFs = 0;
+        if (!readAudioFile(inputPath, recorded, fileFs)) {
+            fprintf(stderr, "could not read %s (16/24/32-bit PCM or 32/64-bit float WAV, RF64 or W64 expected)\n", inputPath);
+            return 1;
+        }
+        if (fileFs != fs)
+            fprintf(stderr, "warning: %s is %d Hz; it is processed as if it were %d Hz\n", inputPath, fileFs, fs);
+        inputs.emplace_back("recorded", recorded);
+    }
+
+    if (tracePath != NULL && !SaritaTrace::start(tracePath)) {
+        fprintf(stderr, "could not open %s\n", tracePath);
+        return 1;
+    }
+    SARITA_TRACE_THREAD_NAME("bench");
+
+    std::vector<RunResult> results;
+    uint64_t totalRtViolations = 0;
+    for (const char* config : configs) {
+        std::string cfgPath = configDir + "/Sarita_" + config + ".cfg";
+        FILE* cfgFile = fopen(cfgPath.c_str(), "rb");
+        if (cfgFile == NULL) {
+            fprintf(stderr, "skipping %s (not found)\n", cfgPath.c_str());
+            continue;
+        }
+        fclose(cfgFile);
+        for (auto& input : inputs) {
+            for (int blockSize : blockSizes) {
+                for (float overlap : overlaps) {
+                    for (int sht = 0; sht < 2; sht++) {
+                        RunResult r;
+                        if (!benchmarkRun(cfgPath, input.second, fs, blockSize, overlap, sht == 1, order, shiftEstimation, bandSplit, domain, quality, seconds, r)) {
+                            fprintf(stderr, "could not load %s\n", cfgPath.c_str());
+                            SaritaTrace::stop();
+                            return 1;
+                        }
+                        r.config = config;
+                        r.input = input.first;
+                        if (results.empty() && r.shiftEstimation != shiftEstimation)
+                            fprintf(stderr, "note: this build searches the time shifts at the full rate only (Apple Accelerate)\n");
+                        results.push_back(r);
+                        fprintf(stderr, "%-15s %-8s block %4d overlap %4.1f%% sht %d: %7.1fx realtime, p99 %8.1f us\n",
+                                config, input.first.c_str(), blockSize, overlap, sht, r.realtimeFactor, r.p99);
+                        if (SaritaRtCheck::getNumViolations() > 0) {
+                            fprintf(stderr, "  %llu real-time violations in the callback:\n",
+                                    (unsigned long long)SaritaRtCheck::getNumViolations());
+                            SaritaRtCheck::printReport(stderr, 3);
+                            totalRtViolations += SaritaRtCheck::getNumViolations();
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    SaritaTrace::stop();
+    if (SaritaTrace::getNumDropped() > 0)
+        fprintf(stderr, "warning: %llu trace events were dropped\n", (unsigned long long)SaritaTrace::getNumDropped());
+
+    FILE* fid = outPath != NULL ? fopen(outPath, "w") : stdout;
+    if (fid == NULL) {
+        fprintf(stderr, "could not open %s\n", outPath);
+        return 1;
+    }
+    writeJson(fid, results, fs, seconds, order, shiftEstimation, bandSplit, domain, quality);
+    if (fid != stdout)
+        fclose(fid);
+    if (totalRtViolations > 0 && !allowRtViolations) {
+        fprintf(stderr, "%llu real-time violations in total\n", (unsigned long long)totalRtViolations);
+        return 2;
+    }
+    return 0;
+}
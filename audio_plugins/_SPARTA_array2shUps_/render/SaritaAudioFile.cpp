@@ -0,0 +1,629 @@
+//
+//  SaritaAudioFile.cpp
+//  sparta_array2sh
+//
+
+#include "SaritaAudioFile.h"
+#include "SaritaInterleave.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#if SARITA_AUDIO_FILE_MMAP
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <unistd.h>
+#endif
+
+namespace {
+
+// Wave64 chunk ids (the RIFF ones, as GUIDs)
+const uint8_t kW64Riff[16] = { 'r','i','f','f', 0x2E,0x91, 0xCF,0x11, 0xA5,0xD6, 0x28,0xDB,0x04,0xC1,0x00,0x00 };
+const uint8_t kW64Wave[16] = { 'w','a','v','e', 0xF3,0xAC, 0xD3,0x11, 0x8C,0xD1, 0x00,0xC0,0x4F,0x8E,0xDB,0x8A };
+const uint8_t kW64Fmt[16]  = { 'f','m','t',' ', 0xF3,0xAC, 0xD3,0x11, 0x8C,0xD1, 0x00,0xC0,0x4F,0x8E,0xDB,0x8A };
+const uint8_t kW64Data[16] = { 'd','a','t','a', 0xF3,0xAC, 0xD3,0x11, 0x8C,0xD1, 0x00,0xC0,0x4F,0x8E,0xDB,0x8A };
+// sub-format of WAVE_FORMAT_EXTENSIBLE, after the format tag
+const uint8_t kSubFormatTail[14] = { 0x00,0x00, 0x00,0x00, 0x10,0x00, 0x80,0x00,0x00,0xAA,0x00,0x38,0x9B,0x71 };
+
+// flags of the CAF 'desc' chunk
+const uint32_t kCafFlagFloat = 1;
+const uint32_t kCafFlagLittleEndian = 2;
+
+const uint16_t kFormatPcm = 1;
+const uint16_t kFormatFloat = 3;
+const uint16_t kFormatExtensible = 0xFFFE;
+const uint32_t kMaxRiffSize = 0xFFFFFFFFu;
+
+int seek64(FILE* fid, int64_t offset, int origin)
+{
+#ifdef _WIN32
+    return _fseeki64(fid, offset, origin);
+#else
+    return fseeko(fid, (off_t)offset, origin);
+#endif
+}
+
+int64_t tell64(FILE* fid)
+{
+#ifdef _WIN32
+    return _ftelli64(fid);
+#else
+    return (int64_t)ftello(fid);
+#endif
+}
+
+uint16_t get16(const uint8_t* p) { return (uint16_t)(p[0] | p[1] << 8); }
+uint32_t get32(const uint8_t* p) { return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24; }
+uint64_t get64(const uint8_t* p) { return (uint64_t)get32(p) | (uint64_t)get32(p + 4) << 32; }
+
+uint16_t getBE16(const uint8_t* p) { return (uint16_t)(p[0] << 8 | p[1]); }
+uint32_t getBE32(const uint8_t* p) { return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | (uint32_t)p[3]; }
+uint64_t getBE64(const uint8_t* p) { return (uint64_t)getBE32(p) << 32 | (uint64_t)getBE32(p + 4); }
+
+void put16(std::vector<uint8_t>& out, uint16_t v) { out.push_back((uint8_t)v); out.push_back((uint8_t)(v >> 8)); }
+void put32(std::vector<uint8_t>& out, uint32_t v) { put16(out, (uint16_t)v); put16(out, (uint16_t)(v >> 16)); }
+void put64(std::vector<uint8_t>& out, uint64_t v) { put32(out, (uint32_t)v); put32(out, (uint32_t)(v >> 32)); }
+void putBE16(std::vector<uint8_t>& out, uint16_t v) { out.push_back((uint8_t)(v >> 8)); out.push_back((uint8_t)v); }
+void putBE32(std::vector<uint8_t>& out, uint32_t v) { putBE16(out, (uint16_t)(v >> 16)); putBE16(out, (uint16_t)v); }
+void putBE64(std::vector<uint8_t>& out, uint64_t v) { putBE32(out, (uint32_t)(v >> 32)); putBE32(out, (uint32_t)v); }
+void putId(std::vector<uint8_t>& out, const char* id) { out.insert(out.end(), id, id + 4); }
+void putGuid(std::vector<uint8_t>& out, const uint8_t* guid) { out.insert(out.end(), guid, guid + 16); }
+
+bool hostIsBigEndian()
+{
+    const uint16_t one = 1;
+    uint8_t first;
+    memcpy(&first, &one, 1);
+    return first == 0;
+}
+
+bool setSampleFormat(SaritaAudioFileInfo& info, bool isFloat, int bitsPerSample)
+{
+    if (!isFloat && bitsPerSample == 16)       info.sampleFormat = SARITA_SAMPLE_PCM16;
+    else if (!isFloat && bitsPerSample == 24)  info.sampleFormat = SARITA_SAMPLE_PCM24;
+    else if (!isFloat && bitsPerSample == 32)  info.sampleFormat = SARITA_SAMPLE_PCM32;
+    else if (isFloat && bitsPerSample == 32)   info.sampleFormat = SARITA_SAMPLE_FLOAT32;
+    else if (isFloat && bitsPerSample == 64)   info.sampleFormat = SARITA_SAMPLE_FLOAT64;
+    else
+        return false;
+    return info.numChannels > 0 && info.sampleRate > 0;
+}
+
+// parses the contents of a fmt chunk
+bool parseFmt(const uint8_t* fmt, uint64_t size, SaritaAudioFileInfo& info)
+{
+    if (size < 16)
+        return false;
+    uint16_t tag = get16(&fmt[0]);
+    uint16_t bitsPerSample = get16(&fmt[14]);
+    if (tag == kFormatExtensible && size >= 40)
+        tag = get16(&fmt[24]);
+    info.numChannels = get16(&fmt[2]);
+    info.sampleRate = (int)get32(&fmt[4]);
+    info.bigEndian = false;
+    return (tag == kFormatPcm || tag == kFormatFloat) && setSampleFormat(info, tag == kFormatFloat, bitsPerSample);
+}
+
+// parses the contents of a CAF 'desc' chunk (32 bytes); only packed linear PCM
+bool parseDesc(const uint8_t* desc, SaritaAudioFileInfo& info)
+{
+    uint64_t rateBits = getBE64(&desc[0]);
+    double sampleRate;
+    memcpy(&sampleRate, &rateBits, 8);
+    const uint32_t flags = getBE32(&desc[12]);
+    const uint32_t bytesPerPacket = getBE32(&desc[16]);
+    const uint32_t framesPerPacket = getBE32(&desc[20]);
+    const uint32_t bitsPerSample = getBE32(&desc[28]);
+    info.numChannels = (int)getBE32(&desc[24]);
+    info.sampleRate = (int)lrint(sampleRate);
+    info.bigEndian = (flags & kCafFlagLittleEndian) == 0;
+    return memcmp(&desc[8], "lpcm", 4) == 0 && framesPerPacket == 1 &&
+           setSampleFormat(info, (flags & kCafFlagFloat) != 0, (int)bitsPerSample) &&
+           bytesPerPacket == (uint32_t)(saritaSampleSize(info.sampleFormat) * info.numChannels);
+}
+
+// converts a sample to float
+float decodeSample(const uint8_t* p, SARITA_SAMPLE_FORMATS sampleFormat, bool bigEndian)
+{
+    uint8_t swapped[8];
+    if (bigEndian) {
+        const int sampleSize = saritaSampleSize(sampleFormat);
+        for (int i = 0; i < sampleSize; i++)
+            swapped[i] = p[sampleSize - 1 - i];
+        p = swapped;
+    }
+    switch (sampleFormat) {
+        case SARITA_SAMPLE_PCM16:
+            return (float)(int16_t)get16(p) / 32768.0f;
+        case SARITA_SAMPLE_PCM24:
+            return (float)((int32_t)((uint32_t)p[0] << 8 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 24) >> 8) / 8388608.0f;
+        case SARITA_SAMPLE_PCM32:
+            return (float)((double)(int32_t)get32(p) / 2147483648.0);
+        case SARITA_SAMPLE_FLOAT32: {
+            uint32_t bits = get32(p);
+            float value;
+            memcpy(&value, &bits, 4);
+            return value;
+        }
+        default: {
+            uint64_t bits = get64(p);
+            double value;
+            memcpy(&value, &bits, 8);
+            return (float)value;
+        }
+    }
+}
+
+// converts a float to a (little-endian) sample of one of the formats written
+void encodeSample(float value, uint8_t* p, SARITA_SAMPLE_FORMATS sampleFormat)
+{
+    switch (sampleFormat) {
+        case SARITA_SAMPLE_PCM16: {
+            int32_t v = (int32_t)lrintf(std::min(std::max(value, -1.0f), 1.0f) * 32767.0f);
+            p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8);
+            break;
+        }
+        case SARITA_SAMPLE_PCM24: {
+            int32_t v = (int32_t)lrintf(std::min(std::max(value, -1.0f), 1.0f) * 8388607.0f);
+            p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16);
+            break;
+        }
+        default: {
+            uint32_t bits;
+            memcpy(&bits, &value, 4);
+            p[0] = (uint8_t)bits; p[1] = (uint8_t)(bits >> 8); p[2] = (uint8_t)(bits >> 16); p[3] = (uint8_t)(bits >> 24);
+        }
+    }
+}
+
+// whether frames at p are native floats, that can be (de)interleaved as such
+bool isNativeFloat(const SaritaAudioFileInfo& info, const void* p)
+{
+    return info.sampleFormat == SARITA_SAMPLE_FLOAT32 && info.bigEndian == hostIsBigEndian() &&
+           ((uintptr_t)p & (sizeof(float) - 1)) == 0;
+}
+
+// appends the contents of a fmt chunk (WAVE_FORMAT_EXTENSIBLE if there are
+// more than two channels, as expected by most readers)
+void appendFmt(std::vector<uint8_t>& out, const SaritaAudioFileInfo& info)
+{
+    int sampleSize = saritaSampleSize(info.sampleFormat);
+    uint16_t tag = info.sampleFormat == SARITA_SAMPLE_FLOAT32 || info.sampleFormat == SARITA_SAMPLE_FLOAT64 ? kFormatFloat : kFormatPcm;
+    bool extensible = info.numChannels > 2;
+    put16(out, extensible ? kFormatExtensible : tag);
+    put16(out, (uint16_t)info.numChannels);
+    put32(out, (uint32_t)info.sampleRate);
+    put32(out, (uint32_t)(info.sampleRate * sampleSize * info.numChannels));
+    put16(out, (uint16_t)(sampleSize * info.numChannels));
+    put16(out, (uint16_t)(8 * sampleSize));
+    if (extensible) {
+        put16(out, 22);                        /* cbSize */
+        put16(out, (uint16_t)(8 * sampleSize)); /* valid bits */
+        put32(out, 0);                         /* no speaker positions */
+        put16(out, tag);
+        out.insert(out.end(), kSubFormatTail, kSubFormatTail + sizeof(kSubFormatTail));
+    }
+}
+
+} // namespace
+
+int saritaSampleSize(SARITA_SAMPLE_FORMATS sampleFormat)
+{
+    switch (sampleFormat) {
+        case SARITA_SAMPLE_PCM16:   return 2;
+        case SARITA_SAMPLE_PCM24:   return 3;
+        case SARITA_SAMPLE_PCM32:   return 4;
+        case SARITA_SAMPLE_FLOAT32: return 4;
+        case SARITA_SAMPLE_FLOAT64: return 8;
+    }
+    return 0;
+}
+
+/* ========================================================================== */
+/*                               Mapped window                                */
+/* ========================================================================== */
+
+uint8_t* SaritaMappedWindow::map(int fd, int64_t fileSize, int64_t offset, size_t length, bool writable)
+{
+#if SARITA_AUDIO_FILE_MMAP
+    if (offset < 0 || offset + (int64_t)length > fileSize || length == 0)
+        return nullptr;
+    if (base != nullptr && writable == mappedWritable && offset >= begin && offset + (int64_t)length <= begin + (int64_t)size)
+        return base + (offset - begin);
+
+    /* move the window (which starts on a page boundary) */
+    unmap();
+    const int64_t pageSize = (int64_t)sysconf(_SC_PAGESIZE);
+    const int64_t newBegin = offset / pageSize * pageSize;
+    const size_t newSize = (size_t)std::min<int64_t>(std::max<int64_t>(offset + (int64_t)length - newBegin, (int64_t)kWindowSize),
+                                                     fileSize - newBegin);
+    void* p = mmap(nullptr, newSize, writable ? PROT_READ | PROT_WRITE : PROT_READ, writable ? MAP_SHARED : MAP_PRIVATE,
+                   fd, (off_t)newBegin);
+    if (p == MAP_FAILED)
+        return nullptr;
+    base = (uint8_t*)p;
+    begin = newBegin;
+    size = newSize;
+    mappedWritable = writable;
+
+    /* the file is accessed front to back: read ahead aggressively, and let
+     * the pages behind be dropped early */
+    madvise(p, size, MADV_SEQUENTIAL);
+    if (!writable)
+        madvise(p, size, MADV_WILLNEED);
+    return base + (offset - begin);
+#else
+    (void)fd; (void)fileSize; (void)offset; (void)length; (void)writable;
+    return nullptr;
+#endif
+}
+
+void SaritaMappedWindow::unmap()
+{
+#if SARITA_AUDIO_FILE_MMAP
+    if (base != nullptr)
+        munmap(base, size);
+#endif
+    base = nullptr;
+    size = 0;
+}
+
+/* ========================================================================== */
+/*                                   Reader                                   */
+/* ========================================================================== */
+
+bool SaritaAudioFileReader::open(const char* path)
+{
+    close();
+    fid = fopen(path, "rb");
+    if (fid == nullptr)
+        return false;
+
+    uint8_t header[40];
+    bool haveFmt = false;
+    uint64_t ds64DataSize = 0, dataSize = 0;
+    int64_t dataOffset = -1;
+
+    seek64(fid, 0, SEEK_END);
+    const int64_t fileSize = tell64(fid);
+    seek64(fid, 0, SEEK_SET);
+
+    if (fread(header, 1, 12, fid) == 12 && (memcmp(header, "RIFF", 4) == 0 || memcmp(header, "RF64", 4) == 0) &&
+        memcmp(&header[8], "WAVE", 4) == 0) {
+        info.format = memcmp(header, "RF64", 4) == 0 ? SARITA_FILE_RF64 : SARITA_FILE_WAV;
+        /* 8-byte chunk headers: id and 32-bit size (padded to even sizes) */
+        while (!(haveFmt && dataOffset >= 0) && fread(header, 1, 8, fid) == 8) {
+            uint64_t size = get32(&header[4]);
+            int64_t next = tell64(fid) + (int64_t)(size + (size & 1));
+            if (memcmp(header, "ds64", 4) == 0) {
+                uint8_t ds64[24];
+                if (size < 24 || fread(ds64, 1, 24, fid) != 24)
+                    break;
+                ds64DataSize = get64(&ds64[8]);
+            }
+            else if (memcmp(header, "fmt ", 4) == 0) {
+                std::vector<uint8_t> fmt((size_t)std::min<uint64_t>(size, 64));
+                haveFmt = fread(fmt.data(), 1, fmt.size(), fid) == fmt.size() && parseFmt(fmt.data(), fmt.size(), info);
+            }
+            else if (memcmp(header, "data", 4) == 0) {
+                dataOffset = tell64(fid);
+                dataSize = info.format == SARITA_FILE_RF64 && size == kMaxRiffSize ? ds64DataSize : size;
+                next = dataOffset + (int64_t)(dataSize + (dataSize & 1));
+            }
+            seek64(fid, next, SEEK_SET);
+        }
+    }
+    else if (seek64(fid, 0, SEEK_SET) == 0 && fread(header, 1, 40, fid) == 40 &&
+             memcmp(header, kW64Riff, 16) == 0 && memcmp(&header[24], kW64Wave, 16) == 0) {
+        info.format = SARITA_FILE_W64;
+        /* 24-byte chunk headers: GUID and 64-bit size, including the header
+         * (padded to multiples of 8 bytes) */
+        while (!(haveFmt && dataOffset >= 0) && fread(header, 1, 24, fid) == 24) {
+            uint64_t size = get64(&header[16]);
+            if (size < 24)
+                break;
+            int64_t next = tell64(fid) - 24 + (int64_t)((size + 7) & ~(uint64_t)7);
+            if (memcmp(header, kW64Fmt, 16) == 0) {
+                std::vector<uint8_t> fmt((size_t)std::min<uint64_t>(size - 24, 64));
+                haveFmt = fread(fmt.data(), 1, fmt.size(), fid) == fmt.size() && parseFmt(fmt.data(), fmt.size(), info);
+            }
+            else if (memcmp(header, kW64Data, 16) == 0) {
+                dataOffset = tell64(fid);
+                dataSize = size - 24;
+            }
+            seek64(fid, next, SEEK_SET);
+        }
+    }
+
+    else if (seek64(fid, 0, SEEK_SET) == 0 && fread(header, 1, 8, fid) == 8 &&
+             memcmp(header, "caff", 4) == 0 && getBE16(&header[4]) == 1) {
+        info.format = SARITA_FILE_CAF;
+        /* 12-byte chunk headers: id and big-endian 64-bit size (-1 for a
+         * data chunk that extends to the end of the file) */
+        while (!(haveFmt && dataOffset >= 0) && fread(header, 1, 12, fid) == 12) {
+            int64_t size = (int64_t)getBE64(&header[4]);
+            int64_t next = tell64(fid) + size;
+            if (memcmp(header, "desc", 4) == 0) {
+                uint8_t desc[32];
+                haveFmt = size >= 32 && fread(desc, 1, 32, fid) == 32 && parseDesc(desc, info);
+            }
+            else if (memcmp(header, "data", 4) == 0 && (size == -1 || size >= 4)) {
+                dataOffset = tell64(fid) + 4; /* after the edit count */
+                dataSize = size == -1 ? (uint64_t)std::max<int64_t>(fileSize - dataOffset, 0) : (uint64_t)(size - 4);
+                next = dataOffset + (int64_t)dataSize;
+            }
+            else if (size < 0)
+                break;
+            seek64(fid, next, SEEK_SET);
+        }
+    }
+
+    if (!haveFmt || dataOffset < 0) {
+        close();
+        return false;
+    }
+
+    /* files still being recorded (or truncated) may claim more data than
+     * there is */
+    const int64_t frameSize = (int64_t)saritaSampleSize(info.sampleFormat) * info.numChannels;
+    dataSize = std::min<uint64_t>(dataSize, (uint64_t)std::max<int64_t>(fileSize - dataOffset, 0));
+    info.dataOffset = dataOffset;
+    info.numFrames = (int64_t)dataSize / frameSize;
+    this->fileSize = fileSize;
+    position = -1;
+    mapped = SARITA_AUDIO_FILE_MMAP;
+    return true;
+}
+
+void SaritaAudioFileReader::close()
+{
+    window.unmap();
+    if (fid != nullptr)
+        fclose(fid);
+    fid = nullptr;
+    mapped = false;
+}
+
+const uint8_t* SaritaAudioFileReader::getFrames(int64_t first, int64_t last)
+{
+    const int64_t frameSize = (int64_t)saritaSampleSize(info.sampleFormat) * info.numChannels;
+    const size_t numBytes = (size_t)((last - first) * frameSize);
+    if (mapped) {
+        const uint8_t* frames = window.map(fileno(fid), fileSize, info.dataOffset + first * frameSize, numBytes, false);
+        if (frames != nullptr)
+            return frames;
+        mapped = false; /* e.g. out of address space; read it instead */
+    }
+
+    if (position != first && seek64(fid, info.dataOffset + first * frameSize, SEEK_SET) != 0) {
+        position = -1;
+        return nullptr;
+    }
+    raw.resize(numBytes);
+    const size_t numRead = fread(raw.data(), (size_t)frameSize, (size_t)(last - first), fid);
+    position = first + (int64_t)numRead;
+    return numRead == (size_t)(last - first) ? raw.data() : nullptr;
+}
+
+const float* SaritaAudioFileReader::view(int64_t start, int numFrames)
+{
+    if (fid == nullptr || !mapped || numFrames <= 0 || start < 0 || start + numFrames > info.numFrames)
+        return nullptr;
+    const uint8_t* frames = getFrames(start, start + numFrames);
+    return mapped && isNativeFloat(info, frames) ? (const float*)frames : nullptr;
+}
+
+int64_t SaritaAudioFileReader::read(int64_t start, float* const* outputs, int numChannels, int numFrames)
+{
+    const int sampleSize = saritaSampleSize(info.sampleFormat);
+    const int frameSize = sampleSize * info.numChannels;
+    int64_t first = std::max<int64_t>(start, 0);
+    int64_t last = std::min<int64_t>(start + numFrames, info.numFrames);
+    const uint8_t* frames = fid != nullptr && last > first ? getFrames(first, last) : nullptr;
+    const int numRead = frames != nullptr ? (int)(last - first) : 0;
+
+    /* zero the frames that aren't in the file, and the channels it doesn't
+     * have */
+    const int offset = (int)(first - start);
+    const int numFileChannels = numRead > 0 ? std::min(numChannels, info.numChannels) : 0;
+    for (int ch = 0; ch < numChannels; ch++) {
+        if (ch >= numFileChannels) {
+            memset(outputs[ch], 0, (size_t)numFrames * sizeof(float));
+            continue;
+        }
+        memset(outputs[ch], 0, (size_t)offset * sizeof(float));
+        memset(&outputs[ch][offset + numRead], 0, (size_t)(numFrames - offset - numRead) * sizeof(float));
+    }
+
+    /* and deinterleave the rest */
+    if (numFileChannels > 0 && isNativeFloat(info, frames))
+        saritaDeinterleave((const float*)frames, info.numChannels, numFileChannels, numRead, outputs, offset);
+    else if (numFileChannels > 0) {
+        for (int i = 0; i < numRead; i++, frames += frameSize)
+            for (int ch = 0; ch < numFileChannels; ch++)
+                outputs[ch][offset + i] = decodeSample(&frames[ch * sampleSize], info.sampleFormat, info.bigEndian);
+    }
+    return numRead;
+}
+
+/* ========================================================================== */
+/*                                   Writer                                   */
+/* ========================================================================== */
+
+bool SaritaAudioFileWriter::create(const char* path, SARITA_FILE_FORMATS format, SARITA_SAMPLE_FORMATS sampleFormat,
+                                   int numChannels, int sampleRate, int64_t numFrames)
+{
+    close();
+    if (sampleFormat != SARITA_SAMPLE_PCM16 && sampleFormat != SARITA_SAMPLE_PCM24 && sampleFormat != SARITA_SAMPLE_FLOAT32)
+        return false;
+
+    info.sampleFormat = sampleFormat;
+    info.numChannels = numChannels;
+    info.sampleRate = sampleRate;
+    info.numFrames = numFrames;
+    info.bigEndian = false;
+    const uint64_t dataSize = (uint64_t)numFrames * (uint64_t)(saritaSampleSize(sampleFormat) * numChannels);
+
+    std::vector<uint8_t> fmt, header;
+    appendFmt(fmt, info);
+    if (format == SARITA_FILE_CAF) {
+        /* little-endian samples, which may be written as they are */
+        const bool isFloat = sampleFormat == SARITA_SAMPLE_FLOAT32;
+        const double rate = (double)sampleRate;
+        uint64_t rateBits;
+        memcpy(&rateBits, &rate, 8);
+        putId(header, "caff");
+        putBE16(header, 1); /* version */
+        putBE16(header, 0);
+        putId(header, "desc");
+        putBE64(header, 32);
+        putBE64(header, rateBits);
+        putId(header, "lpcm");
+        putBE32(header, kCafFlagLittleEndian | (isFloat ? kCafFlagFloat : 0));
+        putBE32(header, (uint32_t)(saritaSampleSize(sampleFormat) * numChannels));
+        putBE32(header, 1); /* frames per packet */
+        putBE32(header, (uint32_t)numChannels);
+        putBE32(header, (uint32_t)(8 * saritaSampleSize(sampleFormat)));
+        putId(header, "data");
+        putBE64(header, 4 + dataSize);
+        putBE32(header, 0); /* edit count */
+        info.format = SARITA_FILE_CAF;
+    }
+    else if (format == SARITA_FILE_W64) {
+        const uint64_t fmtChunkSize = 24 + fmt.size();
+        const uint64_t paddedData = (dataSize + 7) & ~(uint64_t)7;
+        putGuid(header, kW64Riff);
+        put64(header, 40 + ((fmtChunkSize + 7) & ~(uint64_t)7) + 24 + paddedData);
+        putGuid(header, kW64Wave);
+        putGuid(header, kW64Fmt);
+        put64(header, fmtChunkSize);
+        header.insert(header.end(), fmt.begin(), fmt.end());
+        header.resize((header.size() + 7) & ~(size_t)7, 0);
+        putGuid(header, kW64Data);
+        put64(header, 24 + dataSize);
+        info.format = SARITA_FILE_W64;
+    }
+    else {
+        /* 'RIFF', size, 'WAVE', fmt chunk, data chunk header */
+        const uint64_t riffSize = 4 + 8 + fmt.size() + 8 + dataSize + (dataSize & 1);
+        const bool rf64 = format == SARITA_FILE_RF64 || riffSize + 36 > kMaxRiffSize;
+        putId(header, rf64 ? "RF64" : "RIFF");
+        put32(header, rf64 ? kMaxRiffSize : (uint32_t)riffSize);
+        putId(header, "WAVE");
+        if (rf64) {
+            putId(header, "ds64");
+            put32(header, 28);
+            put64(header, riffSize + 36); /* including this chunk */
+            put64(header, dataSize);
+            put64(header, (uint64_t)numFrames);
+            put32(header, 0);             /* no table */
+        }
+        putId(header, "fmt ");
+        put32(header, (uint32_t)fmt.size());
+        header.insert(header.end(), fmt.begin(), fmt.end());
+        putId(header, "data");
+        put32(header, rf64 ? kMaxRiffSize : (uint32_t)dataSize);
+        info.format = rf64 ? SARITA_FILE_RF64 : SARITA_FILE_WAV;
+    }
+    info.dataOffset = (int64_t)header.size();
+
+    /* write the header, and the last byte of the data (and any padding), so
+     * that the file has its final size */
+    const uint64_t padding = info.format == SARITA_FILE_W64 ? ((8 - (dataSize & 7)) & 7) :
+                             info.format == SARITA_FILE_CAF ? 0 : (dataSize & 1);
+    const uint8_t zero = 0;
+    fid = fopen(path, "wb");
+    failed = fid == nullptr ||
+             fwrite(header.data(), 1, header.size(), fid) != header.size() ||
+             (dataSize + padding > 0 &&
+              (seek64(fid, info.dataOffset + (int64_t)(dataSize + padding) - 1, SEEK_SET) != 0 || fwrite(&zero, 1, 1, fid) != 1));
+    reserve();
+    return !failed;
+}
+
+bool SaritaAudioFileWriter::open(const char* path, const SaritaAudioFileInfo& fileInfo)
+{
+    close();
+    info = fileInfo;
+    fid = fopen(path, "r+b");
+    failed = fid == nullptr;
+    reserve();
+    return !failed;
+}
+
+void SaritaAudioFileWriter::reserve()
+{
+    position = -1;
+    mapped = false;
+    if (fid == nullptr || failed || fflush(fid) != 0 || seek64(fid, 0, SEEK_END) != 0)
+        return;
+    fileSize = tell64(fid);
+#if SARITA_AUDIO_FILE_MMAP && defined(__linux__)
+    /* a write to a mapping of a sparse file fails with SIGBUS if the disk is
+     * full, so the file is only mapped once its blocks are allocated */
+    mapped = posix_fallocate(fileno(fid), 0, (off_t)fileSize) == 0;
+#endif
+}
+
+bool SaritaAudioFileWriter::close()
+{
+    window.unmap();
+    mapped = false;
+    bool ok = !failed;
+    if (fid != nullptr)
+        ok = fclose(fid) == 0 && ok;
+    fid = nullptr;
+    failed = false;
+    return ok;
+}
+
+bool SaritaAudioFileWriter::write(int64_t start, const float* const* inputs, int numChannels, int numFrames)
+{
+    const int sampleSize = saritaSampleSize(info.sampleFormat);
+    const int frameSize = sampleSize * info.numChannels;
+    int64_t first = std::max<int64_t>(start, 0);
+    int64_t last = std::min<int64_t>(start + numFrames, info.numFrames);
+    if (fid == nullptr || failed)
+        return false;
+    if (last <= first)
+        return true;
+
+    /* the frames are interleaved straight into the mapped file, or else into
+     * a buffer that is then written */
+    const int offset = (int)(first - start);
+    const int numInputChannels = std::min(numChannels, info.numChannels);
+    const size_t numBytes = (size_t)((last - first) * frameSize);
+    uint8_t* frames = nullptr;
+    if (mapped) {
+        frames = window.map(fileno(fid), fileSize, info.dataOffset + first * frameSize, numBytes, true);
+        mapped = frames != nullptr;
+    }
+    if (frames == nullptr) {
+        raw.resize(numBytes);
+        frames = raw.data();
+    }
+
+    /* channels that aren't given are silent */
+    const int count = (int)(last - first);
+    if (isNativeFloat(info, frames))
+        saritaInterleave(inputs, offset, numInputChannels, count, (float*)frames, info.numChannels);
+    else {
+        uint8_t* p = frames;
+        for (int i = 0; i < count; i++, p += frameSize)
+            for (int ch = 0; ch < numInputChannels; ch++)
+                encodeSample(inputs[ch][offset + i], &p[ch * sampleSize], info.sampleFormat);
+    }
+    if (numInputChannels < info.numChannels) {
+        uint8_t* p = frames + (size_t)numInputChannels * sampleSize;
+        for (int i = 0; i < count; i++, p += frameSize)
+            memset(p, 0, (size_t)(info.numChannels - numInputChannels) * sampleSize);
+    }
+    if (mapped)
+        return true;
+
+    if (position != first && seek64(fid, info.dataOffset + first * frameSize, SEEK_SET) != 0)
+        failed = true;
+    else if (fwrite(raw.data(), (size_t)frameSize, (size_t)(last - first), fid) != (size_t)(last - first))
+        failed = true;
+    position = failed ? -1 : last;
+    return !failed;
+}
@@ -0,0 +1,173 @@
+//
+//  SaritaAudioFile.h
+//  sparta_array2sh
+//
+//  Block-wise reading and writing of multichannel WAV, RF64, Wave64 and CAF
+//  files, for the offline renderer (and the benchmark). Samples are converted
+//  to and from planar float signals.
+//
+//  On POSIX systems the sample data are accessed through a window of the file
+//  mapped into memory (see SaritaMappedWindow), which is moved along as the
+//  file is read or written, so that the memory used does not grow with the
+//  length of the file, and a seek costs no more than remapping the window.
+//  Interleaved 32-bit float files may be read without any conversion (see
+//  SaritaAudioFileReader::view()). Elsewhere (or if the file can't be mapped)
+//  the samples are read and written with stdio.
+//
+//  Any block of frames may be read or written by position, and several
+//  readers and writers may have the same file open at once (a writer opened
+//  with open() writes into a file made by create(), whose size and header are
+//  already final), so that segments of a file may be processed on separate
+//  threads.
+//
+
+#ifndef sarita_audio_file_h
+#define sarita_audio_file_h
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+/* container formats */
+typedef enum {
+    SARITA_FILE_WAV = 0, // RIFF/WAVE; data up to 4 GB
+    SARITA_FILE_RF64,    // EBU Tech 3306 RF64 (64-bit sizes in a ds64 chunk)
+    SARITA_FILE_W64,     // Sony Wave64 (GUID chunk ids, 64-bit sizes)
+    SARITA_FILE_CAF      // Apple Core Audio Format (linear PCM only)
+} SARITA_FILE_FORMATS;
+
+/* sample formats (interleaved; little-endian, except in big-endian CAF files) */
+typedef enum {
+    SARITA_SAMPLE_PCM16 = 0,
+    SARITA_SAMPLE_PCM24,
+    SARITA_SAMPLE_PCM32,
+    SARITA_SAMPLE_FLOAT32,
+    SARITA_SAMPLE_FLOAT64
+} SARITA_SAMPLE_FORMATS;
+
+struct SaritaAudioFileInfo
+{
+    SARITA_FILE_FORMATS format;
+    SARITA_SAMPLE_FORMATS sampleFormat;
+    int numChannels;
+    int sampleRate;
+    int64_t numFrames;
+    int64_t dataOffset; // of the first sample, in bytes
+    bool bigEndian;     // samples are big-endian (CAF only)
+};
+
+// number of bytes per sample
+int saritaSampleSize(SARITA_SAMPLE_FORMATS sampleFormat);
+
+#if !defined(_WIN32)
+# define SARITA_AUDIO_FILE_MMAP 1
+#else
+# define SARITA_AUDIO_FILE_MMAP 0
+#endif
+
+// A window of a file mapped into memory, which is moved along the file as
+// it is accessed (POSIX only)
+class SaritaMappedWindow
+{
+public:
+    SaritaMappedWindow() = default;
+    ~SaritaMappedWindow() { unmap(); }
+    SaritaMappedWindow(const SaritaMappedWindow&) = delete;
+    SaritaMappedWindow& operator=(const SaritaMappedWindow&) = delete;
+
+    // returns bytes [offset, offset + length) of the file (of fileSize bytes)
+    // open as fd; if they aren't mapped yet, the window is moved to start at
+    // them, and to cover at least kWindowSize bytes. Returns nullptr if they
+    // can't be mapped. The pointer is valid until the next call
+    uint8_t* map(int fd, int64_t fileSize, int64_t offset, size_t length, bool writable);
+    void unmap();
+
+    static const size_t kWindowSize = (size_t)64 << 20;
+
+private:
+    uint8_t* base = nullptr;
+    int64_t begin = 0; // file offset of 'base'
+    size_t size = 0;
+    bool mappedWritable = false;
+};
+
+class SaritaAudioFileReader
+{
+public:
+    SaritaAudioFileReader() = default;
+    ~SaritaAudioFileReader() { close(); }
+    SaritaAudioFileReader(const SaritaAudioFileReader&) = delete;
+    SaritaAudioFileReader& operator=(const SaritaAudioFileReader&) = delete;
+
+    // opens a WAV, RF64, Wave64 or CAF file with PCM (16/24/32-bit) or float
+    // (32/64-bit) samples; returns false if it can't be read
+    bool open(const char* path);
+    void close();
+    const SaritaAudioFileInfo& getInfo() const { return info; }
+
+    // reads numFrames frames from frame 'start' on into the first numChannels
+    // channels (zeroed past the end of the file, and for channels it doesn't
+    // have); returns the number of frames read from the file
+    int64_t read(int64_t start, float* const* outputs, int numChannels, int numFrames);
+
+    // returns the frames [start, start + numFrames) in place, as interleaved
+    // floats whose frames are getInfo().numChannels samples apart, if the file
+    // is mapped, its samples are native 32-bit floats, and all of the frames
+    // are in the file; nullptr otherwise (use read()). The pointer is valid
+    // until the next call to view() or read()
+    const float* view(int64_t start, int numFrames);
+
+private:
+    // the raw bytes of frames [first, last), or nullptr if they can't be read
+    const uint8_t* getFrames(int64_t first, int64_t last);
+
+    FILE* fid = nullptr;
+    int64_t fileSize = 0;
+    int64_t position = -1; // of the file pointer, in frames
+    SaritaAudioFileInfo info {};
+    std::vector<uint8_t> raw;
+    SaritaMappedWindow window;
+    bool mapped = false;
+};
+
+class SaritaAudioFileWriter
+{
+public:
+    SaritaAudioFileWriter() = default;
+    ~SaritaAudioFileWriter() { close(); }
+    SaritaAudioFileWriter(const SaritaAudioFileWriter&) = delete;
+    SaritaAudioFileWriter& operator=(const SaritaAudioFileWriter&) = delete;
+
+    // creates a file of numFrames (silent) frames, with its final header; a
+    // WAV file whose data would exceed 4 GB is made an RF64 file instead (see
+    // getInfo().format). Only the PCM16/24 and FLOAT32 sample formats may be
+    // written. Returns false if the file can't be written
+    bool create(const char* path, SARITA_FILE_FORMATS format, SARITA_SAMPLE_FORMATS sampleFormat,
+                int numChannels, int sampleRate, int64_t numFrames);
+    // opens a file made by create() (e.g. on another thread), to write into it
+    bool open(const char* path, const SaritaAudioFileInfo& fileInfo);
+    // flushes and closes the file; returns false if any write failed
+    bool close();
+    const SaritaAudioFileInfo& getInfo() const { return info; }
+
+    // writes numFrames frames of the first numChannels channels at frame
+    // 'start' (frames past the end of the file are dropped); returns false if
+    // the write failed
+    bool write(int64_t start, const float* const* inputs, int numChannels, int numFrames);
+
+private:
+    // maps the file if its blocks can be reserved (so that writing to the
+    // mapping can't fail for lack of space)
+    void reserve();
+
+    FILE* fid = nullptr;
+    int64_t fileSize = 0;
+    int64_t position = -1; // of the file pointer, in frames
+    bool failed = false;
+    SaritaAudioFileInfo info {};
+    std::vector<uint8_t> raw;
+    SaritaMappedWindow window;
+    bool mapped = false;
+};
+
+#endif /* sarita_audio_file_h */
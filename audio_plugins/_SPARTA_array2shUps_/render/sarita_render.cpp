@@ -0,0 +1,364 @@
+//
+//  sarita_render.cpp
+//  sparta_array2sh
+//
+//  Offline renderer: upsamples multichannel recordings (WAV, RF64, Wave64 or
+//  CAF) of a sparse array with the SARITA engine, and writes the spherical
+//  harmonic (or dense grid) signals; as the plug-in would, but faster than
+//  real time.
+//
+//  usage: sarita_render --config <file.cfg> [--output sh|dense] [--order <n>]
+//                       [--block-size <n>] [--overlap <percent>]
+//                       [--shift-estimation full|decimated] [--band-split off|on] [--crossover <Hz>]
+//                       [--format wav|rf64|w64|caf] [--sample-format float|pcm24|pcm16]
+//                       [--out-dir <dir>] [--threads <n>] [--segment-seconds <s>]
+//                       <input files...>
+//
+//  The output of <dir>/<name>.<ext> is written to <out-dir>/<name>_sh.<ext>
+//  (or _dense); by default next to the input, in the same format, as 32-bit
+//  float. It has the length of the input, and is compensated for the
+//  processing delay. The block size and overlap have the same meaning as the
+//  host block size and the overlap setting of the plug-in; --shift-estimation
+//  decimated searches the time shifts at a quarter of the sampling rate first
+//  (see SARITA_SHIFT_ESTIMATION), which is faster. --band-split on takes the
+//  SH signals below the crossover (by default, the spatial aliasing frequency
+//  of the array) from the sparse array itself (see SARITA_BAND_SPLIT), and
+//  --domain tf encodes the SH signals in the time-frequency domain, straight
+//  from the sparse array (see SARITA_UPSAMPLING_DOMAIN).
+//
+//  The files are split into segments, which are rendered on a pool of threads
+//  (one per core, by default), so that several files, and long files on their
+//  own, keep all cores busy. Each segment is rendered by a new instance, which
+//  is started early enough, and at a point where the frames line up with those
+//  of a single instance running through the whole file (see
+//  sarita_getSegmentAlignment()), that the segments join without a seam: the
+//  output is the same as that of one instance. The throughput is reported as
+//  a multiple of real time (xRT) per file and overall.
+//
+
+#include "saf.h"
+#include "array2sh.h"
+#include "sarita.h"
+#include "SaritaAudioFile.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct RenderSettings
+{
+    std::string configPath;
+    std::string outDir;
+    SARITA_OUTPUT_TYPES outputType = SARITA_OUTPUT_SH;
+    int order = 4;
+    int blockSize = 1024;
+    float overlapPercent = 25.0f;
+    SARITA_SHIFT_ESTIMATION shiftEstimation = SARITA_SHIFT_ESTIMATION_FULL_RATE;
+    SARITA_BAND_SPLIT bandSplit = SARITA_BAND_SPLIT_OFF;
+    float crossoverFreq = 0.0f; // the spatial aliasing frequency
+    SARITA_UPSAMPLING_DOMAIN domain = SARITA_UPSAMPLING_DOMAIN_TIME;
+    int format = -1; // as the input
+    SARITA_SAMPLE_FORMATS sampleFormat = SARITA_SAMPLE_FLOAT32;
+    int numThreads = 0;
+    double segmentSeconds = 60.0;
+};
+
+struct RenderFile
+{
+    std::string inputPath, outputPath;
+    SaritaAudioFileInfo outputInfo;
+    int64_t numFrames;
+    int sampleRate;
+    /* progress, updated by the workers */
+    std::atomic<int> segmentsLeft { 0 };
+    std::atomic<bool> failed { false };
+    std::chrono::steady_clock::time_point start, stop;
+    std::once_flag started;
+};
+
+struct RenderJob
+{
+    RenderFile* file;
+    int64_t first, last; // output frames
+};
+
+/* properties of the configuration, with the given settings */
+struct EngineInfo
+{
+    int configFs, numSparse, numOutputs, delay, alignment, warmUp;
+};
+
+/* ========================================================================== */
+/*                                   Engine                                   */
+/* ========================================================================== */
+
+static bool createEngine(const RenderSettings& settings, int fs, void** phSar)
+{
+    sarita_create(phSar);
+    sarita_parameters params;
+    sarita_getParameters(*phSar, &params);
+    params.overlapPercent = settings.overlapPercent;
+    params.outputType = settings.outputType;
+    params.order = settings.order;
+    params.shiftEstimation = settings.shiftEstimation;
+    params.bandSplit = settings.bandSplit;
+    params.crossoverFreq = settings.crossoverFreq;
+    params.upsamplingDomain = settings.domain;
+    sarita_setParameters(*phSar, &params);
+    sarita_init(*phSar, fs, settings.blockSize);
+    if (sarita_loadConfig(*phSar, settings.configPath.c_str()) != 0) {
+        sarita_destroy(phSar);
+        return false;
+    }
+    return true;
+}
+
+static bool getEngineInfo(const RenderSettings& settings, EngineInfo& info)
+{
+    void* hSar;
+    if (!createEngine(settings, 48000, &hSar))
+        return false;
+    info.configFs = sarita_getConfigSamplingRate(hSar);
+    // the low band of a band split is encoded from all sensors of the array
+    info.numSparse = settings.bandSplit == SARITA_BAND_SPLIT_ON ? sarita_getNumArraySensors(hSar) : sarita_getNumSparseSensors(hSar);
+    info.numOutputs = settings.outputType == SARITA_OUTPUT_SH ? ORDER2NSH(settings.order) : sarita_getNumDenseSensors(hSar);
+    info.delay = sarita_getProcessingDelay(hSar);
+    info.alignment = sarita_getSegmentAlignment(hSar);
+    info.warmUp = sarita_getWarmUpLength(hSar);
+    sarita_destroy(&hSar);
+    return true;
+}
+
+/* Renders the output frames [job.first, job.last) of a file: a new instance
+ * starts at the latest aligned point that leaves it enough input to warm up,
+ * and its output is written from job.first on, shifted by the processing
+ * delay */
+static bool renderJob(const RenderSettings& settings, const EngineInfo& engineInfo, const RenderJob& job)
+{
+    const RenderFile& file = *job.file;
+    const int blockSize = settings.blockSize;
+    SaritaAudioFileReader reader;
+    SaritaAudioFileWriter writer;
+    void* hSar;
+
+    if (!reader.open(file.inputPath.c_str()) || !writer.open(file.outputPath.c_str(), file.outputInfo))
+        return false;
+    if (!createEngine(settings, file.sampleRate, &hSar))
+        return false;
+
+    int64_t start = job.first + engineInfo.delay - engineInfo.warmUp;
+    start = start <= 0 ? 0 : start / engineInfo.alignment * engineInfo.alignment;
+
+    float** inFrame = (float**)malloc2d(engineInfo.numSparse, blockSize, sizeof(float));
+    float** outFrame = (float**)malloc2d(engineInfo.numOutputs, blockSize, sizeof(float));
+    std::vector<float*> segment(engineInfo.numOutputs);
+    bool ok = true;
+    for (int64_t pos = start; ok && pos - engineInfo.delay < job.last; pos += blockSize) {
+        /* interleaved float input is fed to the engine straight from the
+         * mapped file */
+        const float* view = reader.view(pos, blockSize);
+        if (view != nullptr)
+            sarita_processInterleaved(hSar, view, reader.getInfo().numChannels, outFrame, engineInfo.numSparse,
+                                      engineInfo.numOutputs, blockSize);
+        else {
+            reader.read(pos, inFrame, engineInfo.numSparse, blockSize);
+            sarita_process(hSar, inFrame, outFrame, engineInfo.numSparse, engineInfo.numOutputs, blockSize);
+        }
+
+        /* the part of the block that belongs to this segment */
+        int64_t outPos = pos - engineInfo.delay;
+        int skip = (int)SAF_CLAMP(job.first - outPos, 0, (int64_t)blockSize);
+        int count = (int)SAF_CLAMP(job.last - outPos, 0, (int64_t)blockSize) - skip;
+        if (count > 0) {
+            for (int ch = 0; ch < engineInfo.numOutputs; ch++)
+                segment[ch] = &outFrame[ch][skip];
+            ok = writer.write(outPos + skip, segment.data(), engineInfo.numOutputs, count);
+        }
+    }
+
+    free(inFrame);
+    free(outFrame);
+    sarita_destroy(&hSar);
+    return writer.close() && ok;
+}
+
+/* ========================================================================== */
+/*                                    Main                                    */
+/* ========================================================================== */
+
+static std::string outputPathFor(const std::string& inputPath, const RenderSettings& settings, SARITA_FILE_FORMATS format)
+{
+    size_t slash = inputPath.find_last_of("/\\");
+    size_t dot = inputPath.find_last_of('.');
+    std::string dir = slash == std::string::npos ? "" : inputPath.substr(0, slash + 1);
+    std::string name = inputPath.substr(dir.size(), dot == std::string::npos || dot < dir.size() ? std::string::npos : dot - dir.size());
+    if (!settings.outDir.empty())
+        dir = settings.outDir + "/";
+    return dir + name + (settings.outputType == SARITA_OUTPUT_SH ? "_sh" : "_dense") + (format == SARITA_FILE_W64 ? ".w64" : format == SARITA_FILE_CAF ? ".caf" : ".wav");
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr, "usage: %s --config <file.cfg> [--output sh|dense] [--order <n>] [--block-size <n>] [--overlap <percent>]\n"
+                    "       [--shift-estimation full|decimated] [--band-split off|on] [--crossover <Hz>] [--domain time|tf]\n"
+                    "       [--format wav|rf64|w64|caf] [--sample-format float|pcm24|pcm16] [--out-dir <dir>] [--threads <n>] [--segment-seconds <s>] <input files...>\n", name);
+}
+
+int main(int argc, char** argv)
+{
+    RenderSettings settings;
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        std::string value = i+1 < argc ? argv[i+1] : "";
+        if (arg.compare(0, 2, "--") != 0)                 inputs.push_back(arg);
+        else if (i+1 >= argc)                             { usage(argv[0]); return 1; }
+        else if (arg == "--config")                       settings.configPath = argv[++i];
+        else if (arg == "--out-dir")                      settings.outDir = argv[++i];
+        else if (arg == "--order")                        settings.order = atoi(argv[++i]);
+        else if (arg == "--block-size")                   settings.blockSize = atoi(argv[++i]);
+        else if (arg == "--overlap")                      settings.overlapPercent = (float)atof(argv[++i]);
+        else if (arg == "--threads")                      settings.numThreads = atoi(argv[++i]);
+        else if (arg == "--segment-seconds")              settings.segmentSeconds = atof(argv[++i]);
+        else if (arg == "--crossover")                    settings.crossoverFreq = (float)atof(argv[++i]);
+        else if (arg == "--output" && value == "sh")      { settings.outputType = SARITA_OUTPUT_SH; i++; }
+        else if (arg == "--output" && value == "dense")   { settings.outputType = SARITA_OUTPUT_DENSE_GRID; i++; }
+        else if (arg == "--shift-estimation" && value == "full")      { settings.shiftEstimation = SARITA_SHIFT_ESTIMATION_FULL_RATE; i++; }
+        else if (arg == "--shift-estimation" && value == "decimated") { settings.shiftEstimation = SARITA_SHIFT_ESTIMATION_DECIMATED; i++; }
+        else if (arg == "--band-split" && value == "off") { settings.bandSplit = SARITA_BAND_SPLIT_OFF; i++; }
+        else if (arg == "--band-split" && value == "on")  { settings.bandSplit = SARITA_BAND_SPLIT_ON; i++; }
+        else if (arg == "--domain" && value == "time")    { settings.domain = SARITA_UPSAMPLING_DOMAIN_TIME; i++; }
+        else if (arg == "--domain" && value == "tf")      { settings.domain = SARITA_UPSAMPLING_DOMAIN_TIME_FREQUENCY; i++; }
+        else if (arg == "--format" && value == "wav")     { settings.format = SARITA_FILE_WAV; i++; }
+        else if (arg == "--format" && value == "rf64")    { settings.format = SARITA_FILE_RF64; i++; }
+        else if (arg == "--format" && value == "w64")     { settings.format = SARITA_FILE_W64; i++; }
+        else if (arg == "--format" && value == "caf")     { settings.format = SARITA_FILE_CAF; i++; }
+        else if (arg == "--sample-format" && value == "float") { settings.sampleFormat = SARITA_SAMPLE_FLOAT32; i++; }
+        else if (arg == "--sample-format" && value == "pcm24") { settings.sampleFormat = SARITA_SAMPLE_PCM24; i++; }
+        else if (arg == "--sample-format" && value == "pcm16") { settings.sampleFormat = SARITA_SAMPLE_PCM16; i++; }
+        else { usage(argv[0]); return 1; }
+    }
+    if (settings.configPath.empty() || inputs.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+    settings.order = SAF_CLAMP(settings.order, 1, MAX_SH_ORDER);
+    settings.overlapPercent = SAF_CLAMP(settings.overlapPercent, 0.0f, SARITA_MAX_OVERLAP_PERCENT);
+    if (settings.blockSize <= 0 || settings.blockSize % array2sh_getHopSize() != 0) {
+        fprintf(stderr, "the block size must be a multiple of %d\n", array2sh_getHopSize());
+        return 1;
+    }
+    if (settings.numThreads <= 0)
+        settings.numThreads = (int)SAF_MAX(std::thread::hardware_concurrency(), 1u);
+
+    EngineInfo engineInfo;
+    if (!getEngineInfo(settings, engineInfo)) {
+        fprintf(stderr, "could not load %s\n", settings.configPath.c_str());
+        return 1;
+    }
+
+    /* Create the outputs, and split them into segments. A segment boundary is
+     * placed where an instance started at an aligned point has just warmed
+     * up, so that none renders more than the warm-up in addition to its
+     * segment */
+    std::vector<std::unique_ptr<RenderFile>> files;
+    std::vector<RenderJob> jobs;
+    int numFailed = 0;
+    for (const std::string& inputPath : inputs) {
+        SaritaAudioFileReader reader;
+        if (!reader.open(inputPath.c_str())) {
+            fprintf(stderr, "%s: could not be read (16/24/32-bit PCM or 32/64-bit float WAV, RF64, W64 or CAF expected)\n", inputPath.c_str());
+            numFailed++;
+            continue;
+        }
+        const SaritaAudioFileInfo& inputInfo = reader.getInfo();
+        if (inputInfo.sampleRate != engineInfo.configFs) {
+            fprintf(stderr, "%s: is %d Hz, but the config is for %d Hz\n", inputPath.c_str(), inputInfo.sampleRate, engineInfo.configFs);
+            numFailed++;
+            continue;
+        }
+        if (inputInfo.numChannels < engineInfo.numSparse) {
+            fprintf(stderr, "%s: has %d channels, but the config requires %d\n", inputPath.c_str(), inputInfo.numChannels, engineInfo.numSparse);
+            numFailed++;
+            continue;
+        }
+
+        std::unique_ptr<RenderFile> file(new RenderFile);
+        SARITA_FILE_FORMATS format = settings.format >= 0 ? (SARITA_FILE_FORMATS)settings.format : inputInfo.format;
+        SaritaAudioFileWriter writer;
+        file->inputPath = inputPath;
+        file->outputPath = outputPathFor(inputPath, settings, format);
+        file->numFrames = inputInfo.numFrames;
+        file->sampleRate = inputInfo.sampleRate;
+        if (!writer.create(file->outputPath.c_str(), format, settings.sampleFormat, engineInfo.numOutputs,
+                           inputInfo.sampleRate, inputInfo.numFrames) || !writer.close()) {
+            fprintf(stderr, "%s: could not be written\n", file->outputPath.c_str());
+            numFailed++;
+            continue;
+        }
+        file->outputInfo = writer.getInfo();
+
+        const int64_t segmentLength = SAF_MAX((int64_t)llround(settings.segmentSeconds * inputInfo.sampleRate / engineInfo.alignment), (int64_t)1) * engineInfo.alignment;
+        int64_t first = 0;
+        for (int64_t restart = segmentLength; first < file->numFrames; restart += segmentLength) {
+            int64_t last = SAF_MIN(restart + engineInfo.warmUp - engineInfo.delay, file->numFrames);
+            jobs.push_back({ file.get(), first, last });
+            file->segmentsLeft++;
+            first = last;
+        }
+        if (file->numFrames == 0)
+            fprintf(stderr, "%s: is empty\n", inputPath.c_str());
+        files.push_back(std::move(file));
+    }
+
+    /* the workers take the segments in order, so the files are (mostly)
+     * finished one after another */
+    std::atomic<size_t> nextJob { 0 };
+    std::mutex printMutex;
+    auto renderStart = std::chrono::steady_clock::now();
+    auto worker = [&]() {
+        for (size_t j = nextJob++; j < jobs.size(); j = nextJob++) {
+            RenderFile& file = *jobs[j].file;
+            std::call_once(file.started, [&file]() { file.start = std::chrono::steady_clock::now(); });
+            if (!file.failed && !renderJob(settings, engineInfo, jobs[j]))
+                file.failed = true;
+            if (--file.segmentsLeft == 0) {
+                file.stop = std::chrono::steady_clock::now();
+                double seconds = (double)file.numFrames / (double)file.sampleRate;
+                double wall = std::chrono::duration<double>(file.stop - file.start).count();
+                std::lock_guard<std::mutex> lock(printMutex);
+                if (file.failed)
+                    fprintf(stderr, "%s: failed\n", file.inputPath.c_str());
+                else
+                    fprintf(stderr, "%s -> %s: %.1f s in %.1f s (%.1f xRT)\n", file.inputPath.c_str(), file.outputPath.c_str(),
+                            seconds, wall, seconds / SAF_MAX(wall, 1e-9));
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int t = 0; t < SAF_MIN(settings.numThreads, (int)SAF_MAX(jobs.size(), (size_t)1)); t++)
+        threads.emplace_back(worker);
+    for (std::thread& t : threads)
+        t.join();
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - renderStart).count();
+
+    double totalSeconds = 0.0;
+    for (const auto& file : files) {
+        if (file->failed)
+            numFailed++;
+        else
+            totalSeconds += (double)file->numFrames / (double)file->sampleRate;
+    }
+    fprintf(stderr, "%d file(s), %.1f s of audio in %.1f s on %d thread(s): %.1f xRT\n", (int)files.size(), totalSeconds,
+            wall, (int)threads.size(), totalSeconds / SAF_MAX(wall, 1e-9));
+    if (numFailed > 0)
+        fprintf(stderr, "%d file(s) failed\n", numFailed);
+    return numFailed > 0 ? 1 : 0;
+}
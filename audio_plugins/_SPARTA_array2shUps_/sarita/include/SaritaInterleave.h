@@ -0,0 +1,97 @@
+//
+//  SaritaInterleave.h
+//  sparta_array2sh
+//
+//  Conversion between interleaved frames (as in audio files, and memory-mapped
+//  views of them) and planar channels. With SAF_ENABLE_SIMD, blocks of 4
+//  channels x 4 frames are transposed in SSE registers; otherwise the frames
+//  are walked in order, so that the interleaved side is read (or written)
+//  sequentially.
+//
+
+#ifndef sarita_interleave_h
+#define sarita_interleave_h
+
+#include <cstddef>
+#if defined(SAF_ENABLE_SIMD)
+# include <xmmintrin.h>
+#endif
+
+// copies numFrames frames of the first numChannels channels of 'src' (whose
+// frames are 'stride' samples apart) to dst[ch][dstOffset...]
+inline void saritaDeinterleave(const float* src, int stride, int numChannels, int numFrames,
+                               float* const* dst, int dstOffset = 0)
+{
+    int ch = 0;
+#if defined(SAF_ENABLE_SIMD)
+    for (; ch + 4 <= numChannels; ch += 4) {
+        float* d0 = dst[ch] + dstOffset;
+        float* d1 = dst[ch+1] + dstOffset;
+        float* d2 = dst[ch+2] + dstOffset;
+        float* d3 = dst[ch+3] + dstOffset;
+        const float* s = src + ch;
+        int i = 0;
+        for (; i + 4 <= numFrames; i += 4, s += 4*(size_t)stride) {
+            __m128 r0 = _mm_loadu_ps(s);
+            __m128 r1 = _mm_loadu_ps(s + stride);
+            __m128 r2 = _mm_loadu_ps(s + 2*(size_t)stride);
+            __m128 r3 = _mm_loadu_ps(s + 3*(size_t)stride);
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            _mm_storeu_ps(d0 + i, r0);
+            _mm_storeu_ps(d1 + i, r1);
+            _mm_storeu_ps(d2 + i, r2);
+            _mm_storeu_ps(d3 + i, r3);
+        }
+        for (; i < numFrames; i++, s += stride) {
+            d0[i] = s[0]; d1[i] = s[1]; d2[i] = s[2]; d3[i] = s[3];
+        }
+    }
+#endif
+    if (ch < numChannels) {
+        const float* s = src;
+        for (int i = 0; i < numFrames; i++, s += stride)
+            for (int c = ch; c < numChannels; c++)
+                dst[c][dstOffset + i] = s[c];
+    }
+}
+
+// copies numFrames samples of src[ch][srcOffset...] for numChannels channels
+// to the first numChannels channels of 'dst' (whose frames are 'stride'
+// samples apart)
+inline void saritaInterleave(const float* const* src, int srcOffset, int numChannels, int numFrames,
+                             float* dst, int stride)
+{
+    int ch = 0;
+#if defined(SAF_ENABLE_SIMD)
+    for (; ch + 4 <= numChannels; ch += 4) {
+        const float* s0 = src[ch] + srcOffset;
+        const float* s1 = src[ch+1] + srcOffset;
+        const float* s2 = src[ch+2] + srcOffset;
+        const float* s3 = src[ch+3] + srcOffset;
+        float* d = dst + ch;
+        int i = 0;
+        for (; i + 4 <= numFrames; i += 4, d += 4*(size_t)stride) {
+            __m128 r0 = _mm_loadu_ps(s0 + i);
+            __m128 r1 = _mm_loadu_ps(s1 + i);
+            __m128 r2 = _mm_loadu_ps(s2 + i);
+            __m128 r3 = _mm_loadu_ps(s3 + i);
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            _mm_storeu_ps(d, r0);
+            _mm_storeu_ps(d + stride, r1);
+            _mm_storeu_ps(d + 2*(size_t)stride, r2);
+            _mm_storeu_ps(d + 3*(size_t)stride, r3);
+        }
+        for (; i < numFrames; i++, d += stride) {
+            d[0] = s0[i]; d[1] = s1[i]; d[2] = s2[i]; d[3] = s3[i];
+        }
+    }
+#endif
+    if (ch < numChannels) {
+        float* d = dst;
+        for (int i = 0; i < numFrames; i++, d += stride)
+            for (int c = ch; c < numChannels; c++)
+                d[c] = src[c][srcOffset + i];
+    }
+}
+
+#endif /* sarita_interleave_h */
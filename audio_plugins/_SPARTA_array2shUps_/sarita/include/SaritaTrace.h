@@ -0,0 +1,86 @@
+//
+//  SaritaTrace.h
+//  sparta_array2sh
+//
+//  Optional timeline tracing, written as a Chrome trace (JSON) that can be
+//  opened in Perfetto (ui.perfetto.dev) or chrome://tracing.
+//
+//  Begin/end events are recorded from any thread into a preallocated,
+//  lock-free ring buffer (a bounded multi-producer queue), and a background
+//  thread writes them to the file. Recording does not allocate or block; if
+//  the writer falls behind, events are dropped and counted. Nothing is
+//  recorded until start() is called (e.g. by setting the SARITA_TRACE
+//  environment variable to an output path, see PluginProcessor), and
+//  SARITA_ENABLE_TRACING=0 compiles all trace points away.
+//
+
+#ifndef sarita_trace_h
+#define sarita_trace_h
+
+#ifndef SARITA_ENABLE_TRACING
+#define SARITA_ENABLE_TRACING 1
+#endif
+
+#include <atomic>
+#include <cstdint>
+
+class SaritaTrace
+{
+public:
+    // starts writing to a new trace file; returns false if tracing is already
+    // running (in this process), or the file can't be opened
+    static bool start(const char* path);
+    // stops tracing, and flushes and closes the file
+    static void stop();
+    static bool isRunning() { return running.load(std::memory_order_relaxed); }
+
+    // records an event; 'name' and 'category' must be string literals (only
+    // the pointers are stored). phase: 'B'egin, 'E'nd or 'i'nstant
+    static void record(const char* name, const char* category, char phase);
+    // names the calling thread in the trace (once per thread and trace)
+    static void nameThread(const char* name);
+
+    // number of events lost since start(), because the buffer was full
+    static uint64_t getNumDropped() { return numDropped.load(std::memory_order_relaxed); }
+
+private:
+    static std::atomic<bool> running;
+    static std::atomic<uint64_t> numDropped;
+};
+
+// records a begin event now, and the matching end event when going out of scope
+class SaritaTraceScope
+{
+public:
+    SaritaTraceScope(const char* _name, const char* _category) : name(_name), category(_category)
+    {
+        if (SaritaTrace::isRunning())
+            SaritaTrace::record(name, category, 'B');
+    }
+    ~SaritaTraceScope()
+    {
+        if (SaritaTrace::isRunning())
+            SaritaTrace::record(name, category, 'E');
+    }
+
+private:
+    const char* name;
+    const char* category;
+};
+
+#define SARITA_TRACE_CONCAT_(a, b) a##b
+#define SARITA_TRACE_CONCAT(a, b) SARITA_TRACE_CONCAT_(a, b)
+
+#if SARITA_ENABLE_TRACING
+    #define SARITA_TRACE_SCOPE(name, category) SaritaTraceScope SARITA_TRACE_CONCAT(saritaTraceScope_, __LINE__) (name, category)
+    #define SARITA_TRACE_BEGIN(name, category) do { if (SaritaTrace::isRunning()) SaritaTrace::record(name, category, 'B'); } while (0)
+    #define SARITA_TRACE_END(name, category) do { if (SaritaTrace::isRunning()) SaritaTrace::record(name, category, 'E'); } while (0)
+    #define SARITA_TRACE_THREAD_NAME(name) do { if (SaritaTrace::isRunning()) SaritaTrace::nameThread(name); } while (0)
+#else
+    #define SARITA_TRACE_SCOPE(name, category) ((void)0)
+    #define SARITA_TRACE_BEGIN(name, category) ((void)0)
+    #define SARITA_TRACE_END(name, category) ((void)0)
+    #define SARITA_TRACE_THREAD_NAME(name) ((void)0)
+#endif
+
+#endif /* sarita_trace_h */
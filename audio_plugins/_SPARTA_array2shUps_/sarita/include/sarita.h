@@ -0,0 +1,650 @@
+//
+//  sarita.h
+//  sparta_array2sh
+//
+//  SARITA upsampling of sparse spherical microphone array signals to a dense
+//  grid, optionally followed by their encoding into spherical harmonic signals
+//  (with an internal instance of array2sh); in the same form as the SAF
+//  examples, so that it may be used without JUCE (e.g. by a server-side
+//  renderer or the sarita_bench target), and by the plug-in as a thin wrapper.
+//
+//  Example usage:
+//
+//      void* hSar;
+//      sarita_create(&hSar);
+//      sarita_init(hSar, hostSamplingRate, hostBlockSize);
+//      if (sarita_loadConfig(hSar, "Sarita_eigenmike32_N4.cfg") != 0)
+//          ... // could not be read
+//      sarita_parameters params;
+//      sarita_getParameters(hSar, &params);
+//      params.outputType = SARITA_OUTPUT_SH;
+//      params.order = 4;
+//      sarita_setParameters(hSar, &params);
+//
+//      // block-by-block, with blocks of hostBlockSize samples
+//      sarita_process(hSar, inputs, outputs, numInputs, numOutputs, hostBlockSize);
+//
+//      sarita_destroy(&hSar);
+//
+
+#ifndef __SARITA_H_INCLUDED__
+#define __SARITA_H_INCLUDED__
+
+#include "_common.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* ========================================================================== */
+/*                             Presets + Constants                            */
+/* ========================================================================== */
+
+/** Available output signals */
+typedef enum {
+    SARITA_OUTPUT_DENSE_GRID = 1, /**< Upsampled dense grid (sensor) signals */
+    SARITA_OUTPUT_SH              /**< Spherical harmonic signals; the dense
+                                   *   grid signals, encoded with array2sh */
+}SARITA_OUTPUT_TYPES;
+
+/**
+ * Quality presets, which trade accuracy for processing time by pruning the
+ * neighbours of small weights (see sarita_applyQualityPreset()). Neither the
+ * time shifts of the dropped neighbours nor the cross-correlations that only
+ * they use are computed, and the kept neighbours are aligned to the mean time
+ * shift of the kept ones, so that the expected error of each dense grid sensor
+ * is that of the weights and of the alignment (see sarita_getPruningErrors())
+ */
+typedef enum {
+    SARITA_QUALITY_FULL = 1, /**< All neighbours, as exported */
+    SARITA_QUALITY_HIGH,     /**< Neighbours of weights below 0.01 dropped, for
+                              *   an expected error of up to 10 % (-20 dB) */
+    SARITA_QUALITY_MEDIUM,   /**< ... below 0.05, up to 20 % (-14 dB) */
+    SARITA_QUALITY_LOW       /**< ... below 0.1, up to 30 % (-10 dB) */
+}SARITA_QUALITY;
+
+/**
+ * How the time shifts of the neighbours are estimated from their
+ * cross-correlations. With Apple Accelerate, always at the full rate */
+typedef enum {
+    SARITA_SHIFT_ESTIMATION_FULL_RATE = 1, /**< The correlations of the frames,
+                                            *   at all lags */
+    SARITA_SHIFT_ESTIMATION_DECIMATED      /**< The peaks are searched in the
+                                            *   correlations of the frames
+                                            *   decimated by
+                                            *   #SARITA_SHIFT_DECIMATION, and
+                                            *   refined at the full rate at
+                                            *   a few lags around them */
+}SARITA_SHIFT_ESTIMATION;
+
+/** Decimation factor of #SARITA_SHIFT_ESTIMATION_DECIMATED */
+#define SARITA_SHIFT_DECIMATION ( 4 )
+
+/**
+ * Whether the spherical harmonic signals are encoded from the upsampled dense
+ * grid over the whole band, or only above a crossover frequency; below it,
+ * where the sparse array does not alias yet, they are encoded from its sensors
+ * directly (with the encoder of the sparse array, up to its order). The bands
+ * are split by the filterbank of the encoder rather than by a crossover
+ * filter, so a split implies #SARITA_UPSAMPLING_DOMAIN_TIME_FREQUENCY: in the
+ * bands below the crossover, the sparse array signals are encoded straight
+ * away, and the dense grid is not mixed. If the encoder cannot mix the sparse
+ * array signals (see sarita_getActiveUpsamplingDomain()), the band is not
+ * split. Only applies to the SH output */
+typedef enum {
+    SARITA_BAND_SPLIT_OFF = 1, /**< The dense grid over the whole band */
+    SARITA_BAND_SPLIT_ON       /**< The sparse array below the crossover
+                                *   frequency, the dense grid above */
+}SARITA_BAND_SPLIT;
+
+/** Range of the crossover frequency of #SARITA_BAND_SPLIT_ON, in Hz */
+#define SARITA_MIN_CROSSOVER_FREQ ( 100.0f )
+#define SARITA_MAX_CROSSOVER_FREQ ( 16000.0f )
+
+/**
+ * Where the neighbours of the dense grid sensors are aligned and summed. In
+ * the time-frequency domain, only the sparse array signals go through the
+ * filterbank of array2sh, rather than one signal per dense grid sensor: the
+ * time shifts of each frame (as estimated in the time domain) are applied as
+ * a phase per band, and folded together with the weights and the projection
+ * of the encoder into one mixing matrix per band, from the sparse array
+ * signals to the (order+1)^2 projected ones. The dense grid signals are then
+ * never formed. The switch between frames is made per time slot of the
+ * filterbank, rather than by the crossfade over the overlap. Only applies to
+ * the SH output; the dense grid output is always upsampled in the time domain,
+ * and so is the SH output while the encoder is not a projection followed by a
+ * mixing in every band, within the compression tolerance (see
+ * sarita_getActiveUpsamplingDomain())
+ */
+typedef enum {
+    SARITA_UPSAMPLING_DOMAIN_TIME = 1,       /**< The dense grid signals are
+                                              *   formed, and then encoded */
+    SARITA_UPSAMPLING_DOMAIN_TIME_FREQUENCY  /**< The sparse array signals are
+                                              *   encoded, through per-band
+                                              *   mixing matrices */
+}SARITA_UPSAMPLING_DOMAIN;
+
+/** Maximum overlap of consecutive frames, in percent of the block size */
+#define SARITA_MAX_OVERLAP_PERCENT ( 49.0f )
+/**
+ * Step of the overlap settings, in percent of the block size; other values
+ * are rounded to the nearest step. The frame windows of all steps are
+ * computed when the engine is built, so switching between them is free */
+#define SARITA_OVERLAP_STEP_PERCENT ( 0.5f )
+
+/**
+ * The user parameters of an instance, which are published and taken over as a
+ * whole (see sarita_setParameters()). The encoding parameters are those of
+ * the internal array2sh instance, with the values of the array2sh enums
+ */
+typedef struct _sarita_parameters {
+    float overlapPercent; /**< Overlap of consecutive frames, in percent of the
+                           *   block size (0..#SARITA_MAX_OVERLAP_PERCENT, in
+                           *   steps of #SARITA_OVERLAP_STEP_PERCENT) */
+    int32_t outputType;   /**< see #SARITA_OUTPUT_TYPES enum */
+    int32_t order;        /**< Encoding order (1..#MAX_SH_ORDER) */
+    int32_t chOrdering;   /**< see #CH_ORDER enum */
+    int32_t norm;         /**< see #NORM_TYPES enum */
+    int32_t filterType;   /**< see #ARRAY2SH_FILTER_TYPES enum */
+    float regPar;         /**< Maximum gain of the regularised filters, in dB */
+    float gain_dB;        /**< Post gain, in dB */
+    float compressionTol_dB; /**< Tolerance of the encoder compression, in dB */
+    int32_t filterbank;   /**< see #ARRAY2SH_FILTERBANKS enum */
+    float pruningThreshold; /**< Neighbours of smaller weights are dropped
+                           *   (0: none; see
+                           *   #SARITA_QUALITY enum)... */
+    float maxPruningError; /**< ...as long as the expected relative error of
+                           *   each dense grid sensor stays within this */
+    int32_t shiftEstimation; /**< see #SARITA_SHIFT_ESTIMATION enum */
+    int32_t bandSplit;    /**< see #SARITA_BAND_SPLIT enum */
+    float crossoverFreq;  /**< Crossover frequency of the band split, in Hz
+                           *   (0: the spatial aliasing frequency of the
+                           *   sparse array, see
+                           *   sarita_getAliasingFrequency()) */
+    int32_t upsamplingDomain; /**< see #SARITA_UPSAMPLING_DOMAIN enum */
+}sarita_parameters;
+
+/**
+ * The largest configuration an instance may load (see
+ * sarita_setConfigLimits())
+ */
+typedef struct _sarita_configLimits {
+    int32_t maxSparseSensors;     /**< Sensors of the sparse array (at least
+                                   *   (N+1)^2, at most #MAX_NUM_SH_SIGNALS) */
+    int32_t maxDenseSensors;      /**< Dense grid sensors */
+    int32_t maxTimeShift;         /**< Largest time shift, in samples */
+    int32_t maxCrossCorrelations; /**< Pairs of neighbours correlated per
+                                   *   frame */
+    int32_t maxNeighbors;         /**< Neighbours per dense grid sensor */
+}sarita_configLimits;
+
+/**
+ * Default configuration limits; those of the configurations in
+ * sarita_vst_configs/ are well within them */
+#define SARITA_DEFAULT_MAX_DENSE_SENSORS ( 1024 )
+#define SARITA_DEFAULT_MAX_TIME_SHIFT ( 32 )
+#define SARITA_DEFAULT_MAX_CROSS_CORRELATIONS ( 512 )
+#define SARITA_DEFAULT_MAX_NEIGHBORS ( 16 )
+
+/** Timed processing stages (see sarita_getTimingStats()) */
+typedef enum {
+    SARITA_STAGE_XCORR = 0,   /**< Windowing and cross-correlation of the
+                               *   neighbours */
+    SARITA_STAGE_PEAK_SEARCH, /**< Lag search and mean time shift, per
+                               *   direction */
+    SARITA_STAGE_ALIGN_SUM,   /**< Alignment and weighted sum, per direction
+                               *   (in the time-frequency domain: the mixing
+                               *   matrices of the frames) */
+    SARITA_STAGE_OVERLAP_ADD, /**< Overlap-add of the frames into the output
+                               *   FIFO */
+    SARITA_STAGE_TFT,         /**< array2sh filterbank (forward and backward) */
+    SARITA_STAGE_SHT,         /**< array2sh per-band encoding GEMMs */
+    SARITA_NUM_STAGES
+}SARITA_STAGES;
+
+/**
+ * Number of buckets of the callback load histogram. The time taken by each
+ * call to sarita_process(), relative to its deadline (nSamples/fs), is
+ * histogrammed in octaves: bucket i holds [2^(i-9), 2^(i-8)), except for the
+ * first and last ones, which are open-ended. So bucket
+ * #SARITA_LOAD_BUCKET_DEADLINE onwards are overruns */
+#define SARITA_NUM_LOAD_BUCKETS ( 12 )
+/** First load histogram bucket past the deadline */
+#define SARITA_LOAD_BUCKET_DEADLINE ( 9 )
+
+/** Snapshot of the timing counters (see sarita_getTimingStats()) */
+typedef struct _SaritaTimingStats {
+    uint64_t stageTicks[SARITA_NUM_STAGES];  /**< Accumulated ticks per stage */
+    uint64_t loadHistogram[SARITA_NUM_LOAD_BUCKETS];
+    uint64_t numCallbacks;
+    uint64_t numOverruns;                    /**< Callbacks that took longer
+                                              *   than the deadline */
+    double meanLoad;                         /**< Mean callback time/deadline */
+    double maxLoad;                          /**< Worst callback time/deadline */
+}SaritaTimingStats;
+
+
+/* ========================================================================== */
+/*                               Main Functions                               */
+/* ========================================================================== */
+
+/**
+ * Creates an instance of sarita
+ *
+ * The encoding GEMMs are run on the thread calling sarita_process(), so the
+ * BLAS library must not split them among threads of its own, nor take locks:
+ * OpenBLAS (and Intel MKL) are pinned to one thread here, for the whole
+ * process. OpenBLAS takes the work buffer of each GEMM from a pool shared by
+ * all threads, under a lock, unless it is built with USE_TLS=1; use such a
+ * build (or MKL, sequential) for real-time use.
+ *
+ * @param[in] phSar (&) address of sarita handle
+ */
+void sarita_create(void** const phSar);
+
+/**
+ * Destroys an instance of sarita
+ *
+ * @param[in] phSar (&) address of sarita handle
+ */
+void sarita_destroy(void** const phSar);
+
+/**
+ * Initialises an instance of sarita with default settings
+ *
+ * The engine processes frames of the host block size, so a change of the
+ * block size rebuilds it from the current configuration file (if there is
+ * one), and checked against new configuration limits (see
+ * sarita_setConfigLimits()). Each engine reserves all the memory it needs,
+ * sized for its configuration, in one block, when it is built; so the memory
+ * of two engines is only taken while one is loaded, until it is swapped in.
+ *
+ * @warning This should not be called while sarita_process() is running
+ *
+ * @param[in] hSar       sarita handle
+ * @param[in] samplerate Host samplerate
+ * @param[in] blockSize  Host block size, in samples
+ */
+void sarita_init(void* const hSar,
+                 int samplerate,
+                 int blockSize);
+
+/**
+ * Loads a SARITA configuration file (as exported from MATLAB)
+ *
+ * The new engine is built on the calling thread, which may be any thread
+ * other than the one calling sarita_process(), and is then swapped in between
+ * two blocks; the blocks processed meanwhile are not interrupted. If the file
+ * cannot be read, or exceeds the configuration limits, the current
+ * configuration is kept. If called before sarita_init(), the file is only
+ * read by sarita_init().
+ *
+ * @param[in] hSar sarita handle
+ * @param[in] path Path to the configuration file
+ * @returns 0 if the configuration was loaded (or will be), -1 otherwise
+ */
+int sarita_loadConfig(void* const hSar,
+                      const char* path);
+
+/**
+ * Upsamples the sparse grid input signals and, if configured, encodes them
+ * into spherical harmonic signals
+ *
+ * The output is silent until the engine has buffered enough frames, while no
+ * configuration is loaded, or if nSamples is not the block size given to
+ * sarita_init(). Outputs past the number of dense grid sensors (or spherical
+ * harmonic signals) are zeroed. The inputs are consumed before the outputs are
+ * written, so the two may refer to the same buffers.
+ *
+ * @param[in]  hSar     sarita handle
+ * @param[in]  inputs   Input channel buffers; 2-D array: nInputs x nSamples
+ * @param[out] outputs  Output channel buffers; 2-D array: nOutputs x nSamples
+ * @param[in]  nInputs  Number of input channels
+ * @param[in]  nOutputs Number of output channels
+ * @param[in]  nSamples Number of samples in 'inputs'/'output' matrices
+ */
+void sarita_process(void* const hSar,
+                    const float* const* inputs,
+                    float* const* outputs,
+                    int nInputs,
+                    int nOutputs,
+                    int nSamples);
+
+/**
+ * As sarita_process(), but with interleaved input (e.g. a memory-mapped view
+ * of an audio file), which is deinterleaved straight into the engine's input
+ * FIFO
+ *
+ * @param[in]  hSar        sarita handle
+ * @param[in]  inputs      Interleaved input frames; nSamples x inputStride
+ * @param[in]  inputStride Distance between the frames of 'inputs', in
+ *                         samples (at least nInputs)
+ * @param[out] outputs     Output channel buffers; 2-D array: nOutputs x
+ *                         nSamples
+ * @param[in]  nInputs     Number of input channels (the first nInputs of each
+ *                         frame)
+ * @param[in]  nOutputs    Number of output channels
+ * @param[in]  nSamples    Number of frames in 'inputs', and samples in
+ *                         'outputs'
+ */
+void sarita_processInterleaved(void* const hSar,
+                               const float* inputs,
+                               int inputStride,
+                               float* const* outputs,
+                               int nInputs,
+                               int nOutputs,
+                               int nSamples);
+
+
+/* ========================================================================== */
+/*                                Set Functions                               */
+/* ========================================================================== */
+
+/**
+ * Publishes a new set of user parameters
+ *
+ * May be called from any thread (including the one calling sarita_process()),
+ * and never waits; but this and the other set functions for the parameters
+ * must be called from one thread at a time (e.g. an audio plug-in may publish
+ * its parameters from its audio thread only). sarita_process() takes the
+ * latest parameters over as a whole at the start of a block, so a block never
+ * sees a mix of two sets.
+ * The output type, channel order, normalisation, gain and overlap are applied
+ * by that block (a new overlap from the next frame on, which overlaps the
+ * previous one as before, and the next one as set, so that the switch does
+ * not click); what has to be recomputed for the others (the array2sh encoder
+ * and filterbank) is done on a background thread, and swapped in between two
+ * blocks once ready. While the encoder is rebuilt, the
+ * spherical harmonic output is silent; the upsampling carries on meanwhile.
+ * A new pruning (quality) rebuilds the engine from the configuration file on
+ * that thread, and swaps it in as sarita_loadConfig() does.
+ *
+ * The encoding parameters are only passed on to array2sh when they change, so
+ * array2sh may still be set up directly through sarita_getArray2shHandle()
+ * (e.g. before processing starts).
+ *
+ * @param[in] hSar   sarita handle
+ * @param[in] params New parameters
+ */
+void sarita_setParameters(void* const hSar,
+                          const sarita_parameters* params);
+
+/**
+ * Sets the overlap of consecutive frames, in percent of the block size
+ * (0..#SARITA_MAX_OVERLAP_PERCENT, rounded to a multiple of
+ * #SARITA_OVERLAP_STEP_PERCENT); as sarita_setParameters(), for this
+ * parameter only
+ */
+void sarita_setOverlap(void* const hSar, float newOverlap);
+
+/**
+ * Sets the output signals (see #SARITA_OUTPUT_TYPES enum); as
+ * sarita_setParameters(), for this parameter only
+ */
+void sarita_setOutputType(void* const hSar, SARITA_OUTPUT_TYPES newType);
+
+/**
+ * Sets how the time shifts are estimated (see #SARITA_SHIFT_ESTIMATION enum);
+ * as sarita_setParameters(), for this parameter only. Applies from the next
+ * frame on
+ */
+void sarita_setShiftEstimation(void* const hSar, SARITA_SHIFT_ESTIMATION estimation);
+
+/**
+ * Sets whether the SH signals are encoded from the sparse array below a
+ * crossover frequency (see #SARITA_BAND_SPLIT enum); as sarita_setParameters(),
+ * for this parameter only. The encoder of the sparse array is computed on the
+ * background thread, meanwhile the SH output is silent
+ */
+void sarita_setBandSplit(void* const hSar, SARITA_BAND_SPLIT split);
+
+/**
+ * Sets where the dense grid sensors are upsampled (see
+ * #SARITA_UPSAMPLING_DOMAIN enum); as sarita_setParameters(), for this
+ * parameter only. The filterbank of array2sh is reconfigured on the background
+ * thread, meanwhile the SH output is silent
+ */
+void sarita_setUpsamplingDomain(void* const hSar, SARITA_UPSAMPLING_DOMAIN domain);
+
+/**
+ * Sets the crossover frequency of the band split, in Hz (0: the spatial
+ * aliasing frequency of the sparse array); as sarita_setParameters(), for
+ * this parameter only
+ */
+void sarita_setCrossoverFrequency(void* const hSar, float crossoverFreq);
+
+/**
+ * Sets the pruning of the neighbours to that of a quality preset (see
+ * #SARITA_QUALITY enum); as sarita_setParameters(), for these parameters only
+ */
+void sarita_setQuality(void* const hSar, SARITA_QUALITY quality);
+
+/**
+ * Sets the pruning parameters of 'params' to those of a quality preset
+ *
+ * @param[out] params  Parameters, of which pruningThreshold and
+ *                     maxPruningError are set
+ * @param[in]  quality see #SARITA_QUALITY enum
+ */
+void sarita_applyQualityPreset(sarita_parameters* params,
+                               SARITA_QUALITY quality);
+
+/**
+ * Sets the largest configuration that may be loaded, from the next call to
+ * sarita_init() on (by default, #SARITA_DEFAULT_MAX_DENSE_SENSORS dense grid
+ * sensors etc., and #MAX_NUM_SH_SIGNALS sparse grid sensors)
+ *
+ * @param[in] hSar   sarita handle
+ * @param[in] limits New limits
+ */
+void sarita_setConfigLimits(void* const hSar,
+                            const sarita_configLimits* limits);
+
+/** Clears the timing counters, from the next call to sarita_process() on */
+void sarita_resetTimingStats(void* const hSar);
+
+
+/* ========================================================================== */
+/*                                Get Functions                               */
+/* ========================================================================== */
+
+/**
+ * Returns the internal array2sh handle, which encodes the dense grid signals
+ *
+ * The array data (sensor directions, radius etc.) are set from the loaded
+ * configuration; the encoding settings (order, filters, normalisation etc.)
+ * may be set and queried through the array2sh API, and array2sh_evalEncoder()
+ * may be called on it from a background thread, as for array2sh itself.
+ */
+void* sarita_getArray2shHandle(void* const hSar);
+
+/**
+ * Returns the user parameters last published (which may not have been taken
+ * over by sarita_process() yet)
+ *
+ * As this and the getters of single parameters may be called from any thread,
+ * they may return a mix of two sets while one is being published (but never
+ * on the thread publishing them).
+ */
+void sarita_getParameters(void* const hSar,
+                          sarita_parameters* params);
+
+/** Returns the configuration limits last set (see sarita_setConfigLimits()) */
+void sarita_getConfigLimits(void* const hSar,
+                            sarita_configLimits* limits);
+
+/**
+ * Returns the memory reserved by the current engine for its buffers, in bytes
+ * (0 if there is none; the configuration tables and the array2sh encoder are
+ * not included, the former are shared between instances)
+ */
+size_t sarita_getMemorySize(void* const hSar);
+
+/** Returns the overlap of consecutive frames, in percent of the block size */
+float sarita_getOverlap(void* const hSar);
+
+/** Returns the output signals (see #SARITA_OUTPUT_TYPES enum) */
+SARITA_OUTPUT_TYPES sarita_getOutputType(void* const hSar);
+
+/** Returns how the time shifts are estimated (see #SARITA_SHIFT_ESTIMATION) */
+SARITA_SHIFT_ESTIMATION sarita_getShiftEstimation(void* const hSar);
+
+/**
+ * Returns how the time shifts are estimated in effect: at the full rate in
+ * builds with Apple Accelerate, which have no decimated search; as selected
+ * otherwise (see #SARITA_SHIFT_ESTIMATION)
+ */
+SARITA_SHIFT_ESTIMATION sarita_getActiveShiftEstimation(void* const hSar);
+
+/** Returns whether the band is split (see #SARITA_BAND_SPLIT enum) */
+SARITA_BAND_SPLIT sarita_getBandSplit(void* const hSar);
+
+/** Returns where the dense grid is upsampled (see #SARITA_UPSAMPLING_DOMAIN) */
+SARITA_UPSAMPLING_DOMAIN sarita_getUpsamplingDomain(void* const hSar);
+
+/**
+ * Returns where the dense grid is upsampled in effect: in the time-frequency
+ * domain only if it is selected for the SH output (or the band is split, see
+ * #SARITA_BAND_SPLIT), a configuration is loaded, and the encoder has a
+ * projection to mix the sparse array signals into (see
+ * #SARITA_UPSAMPLING_DOMAIN); in the time domain otherwise
+ */
+SARITA_UPSAMPLING_DOMAIN sarita_getActiveUpsamplingDomain(void* const hSar);
+
+/**
+ * Returns the crossover frequency of the band split in effect, in Hz (within
+ * #SARITA_MIN_CROSSOVER_FREQ..#SARITA_MAX_CROSSOVER_FREQ, and below the Nyquist
+ * frequency), or 0 if no configuration is loaded
+ */
+float sarita_getCrossoverFrequency(void* const hSar);
+
+/**
+ * Returns the quality preset of the current parameters (see #SARITA_QUALITY
+ * enum), or 0 if the pruning was set otherwise
+ */
+SARITA_QUALITY sarita_getQuality(void* const hSar);
+
+/**
+ * Returns whether a configuration is loaded and processing
+ * (#CODEC_STATUS_INITIALISED), none is loaded (#CODEC_STATUS_NOT_INITIALISED),
+ * or one is being swapped in (#CODEC_STATUS_INITIALISING)
+ */
+CODEC_STATUS sarita_getCodecStatus(void* const hSar);
+
+/** Returns the block size given to sarita_init() */
+int sarita_getBlockSize(void* const hSar);
+
+/** Returns the samplerate the loaded configuration was exported for */
+int sarita_getConfigSamplingRate(void* const hSar);
+
+/** Returns the spherical harmonic order of the sparse (source) grid */
+int sarita_getSourceOrder(void* const hSar);
+
+/** Returns the spherical harmonic order of the dense (target) grid */
+int sarita_getTargetOrder(void* const hSar);
+
+/** Returns the number of sparse grid sensors (input channels) required */
+int sarita_getNumSparseSensors(void* const hSar);
+
+/**
+ * Returns the number of sensors of the sparse array, as the configuration
+ * refers to them; these are all encoded below the crossover frequency of a
+ * band split (see #SARITA_BAND_SPLIT enum)
+ */
+int sarita_getNumArraySensors(void* const hSar);
+
+/**
+ * Returns the spatial aliasing frequency of the sparse array, in Hz: that at
+ * which kr reaches its order N, N c / (2 pi r); or 0 if no configuration is
+ * loaded
+ */
+float sarita_getAliasingFrequency(void* const hSar);
+
+/** Returns the number of dense grid sensors */
+int sarita_getNumDenseSensors(void* const hSar);
+
+/** Returns the largest time shift of the loaded configuration, in samples */
+int sarita_getMaxTimeShift(void* const hSar);
+
+/**
+ * Returns the number of cross-correlations computed per frame (correlations
+ * that no dense grid sensor uses, or only the neighbours the pruning dropped,
+ * are left out)
+ */
+int sarita_getNumCrossCorrelations(void* const hSar);
+
+/**
+ * Returns the largest expected error of a dense grid sensor due to the pruning
+ * of the loaded configuration (relative, RMS; 0 if none was pruned, or no
+ * configuration is loaded), and copies that of each dense grid sensor to
+ * 'errors', if given
+ *
+ * The error is the sum of that of the weights, for the weighted sum of aligned
+ * neighbour signals of equal power (exact if they are uncorrelated, and an
+ * upper bound if they are alike correlated with each other, e.g. a single
+ * plane wave, for which it is 0), and that of the alignment to the mean time
+ * shift of the kept neighbours only, for time shifts uniform over their range
+ * and a signal of flat spectrum.
+ * May be called from any thread other than the one calling sarita_process()
+ *
+ * @param[in]  hSar         sarita handle
+ * @param[out] errors       Errors per dense grid sensor; maxNumErrors x 1
+ * @param[in]  maxNumErrors Length of 'errors'
+ */
+float sarita_getPruningErrors(void* const hSar,
+                              float* errors,
+                              int maxNumErrors);
+
+/**
+ * Returns the processing delay in samples (the block size, plus the largest
+ * time shift, plus the array2sh delay if encoding; may be used for delay
+ * compensation features), or 0 if no configuration is loaded
+ */
+int sarita_getProcessingDelay(void* const hSar);
+
+/**
+ * Returns the spacing of the points in time (in samples, counted from the
+ * first block) at which a new instance with the same settings may take over
+ * the processing of a stream, or 0 if no configuration is loaded
+ *
+ * The frames advance by the block size less the overlap, so the frames and
+ * the blocks (and the internal FIFOs) only line up again after a whole number
+ * of both. An instance that is started at such a point, and fed the same
+ * input from there on, produces the same output as one that has been running
+ * from the start, once sarita_getWarmUpLength() samples have been processed.
+ * This allows a long recording to be rendered in segments on separate
+ * threads.
+ */
+int sarita_getSegmentAlignment(void* const hSar);
+
+/**
+ * Returns the number of samples after which the output of an instance no
+ * longer depends on its initial (silent) state, or 0 if no configuration is
+ * loaded (see sarita_getSegmentAlignment())
+ */
+int sarita_getWarmUpLength(void* const hSar);
+
+/**
+ * Takes a snapshot of the per-stage timing counters and the callback load
+ * histogram (all zero if built with SARITA_ENABLE_TIMING=0). May be called
+ * from any thread; a snapshot may mix values of two consecutive callbacks
+ */
+void sarita_getTimingStats(void* const hSar, SaritaTimingStats* stats);
+
+/** Returns the name of a timed stage (see #SARITA_STAGES enum) */
+const char* sarita_getStageName(int stage);
+
+/**
+ * Returns the lower edge of a load histogram bucket, relative to the deadline
+ * (0 for the first)
+ */
+double sarita_getLoadBucketEdge(int bucket);
+
+
+#ifdef __cplusplus
+} /* extern "C" { */
+#endif /* __cplusplus */
+
+#endif /* __SARITA_H_INCLUDED__ */
@@ -0,0 +1,143 @@
+//
+//  SaritaArena.h
+//  sparta_array2sh
+//
+//  One block of memory, from which buffers are carved in turn. Each buffer
+//  starts on a 64-byte boundary (a cache line, and the alignment of the SIMD
+//  loads of IPP/Accelerate), so that no two buffers share a cache line, even
+//  if different threads write them. Nothing is freed on its own: reset() gives
+//  up everything carved so far, and the block is freed with the arena.
+//
+//  Carving into an arena without memory (or past its end) returns nullptr,
+//  but still counts the bytes; so the size an arena needs is found by carving
+//  the same buffers into an empty one first, and reading size().
+//
+
+#ifndef sarita_arena_h
+#define sarita_arena_h
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+class SaritaArena
+{
+public:
+    static constexpr size_t alignment = 64;
+
+    SaritaArena() = default;
+    ~SaritaArena() { release(); }
+
+    SaritaArena(const SaritaArena&) = delete;
+    SaritaArena& operator=(const SaritaArena&) = delete;
+
+    // allocates a block of (at least) numBytes; false if it cannot be
+    // allocated, in which case the arena is left without memory
+    bool reserve(size_t numBytes)
+    {
+        release();
+        numBytes = roundUp(numBytes);
+        void* block = nullptr;
+        if (numBytes > 0) {
+#ifdef _WIN32
+            block = _aligned_malloc(numBytes, alignment);
+#else
+            if (posix_memalign(&block, alignment, numBytes) != 0)
+                block = nullptr;
+#endif
+            if (block == nullptr)
+                return false;
+        }
+        memory = (uint8_t*)block;
+        capacity = numBytes;
+        return true;
+    }
+
+    void release()
+    {
+#ifdef _WIN32
+        _aligned_free(memory);
+#else
+        free(memory);
+#endif
+        memory = nullptr;
+        capacity = 0;
+        reset();
+    }
+
+    // gives up all buffers carved so far; the memory is reused from the start
+    void reset()
+    {
+        used = 0;
+        exhausted = false;
+    }
+
+    // count zeroed elements of T, or nullptr if they do not fit
+    template <typename T>
+    T* alloc(size_t count)
+    {
+        static_assert(alignof(T) <= alignment, "SaritaArena cannot align T");
+        size_t offset = used;
+        used += roundUp(count * sizeof(T));
+        if (used > capacity || memory == nullptr) {
+            exhausted = true;
+            return nullptr;
+        }
+        memset(&memory[offset], 0, used - offset);
+        return (T*)&memory[offset];
+    }
+
+    // dim1 x dim2 elements, contiguous (as calloc2d() of SAF)
+    template <typename T>
+    T** alloc2d(size_t dim1, size_t dim2)
+    {
+        T** rows = alloc<T*>(dim1);
+        T* data = alloc<T>(dim1 * dim2);
+        if (rows == nullptr || data == nullptr)
+            return nullptr;
+        for (size_t i = 0; i < dim1; i++)
+            rows[i] = &data[i * dim2];
+        return rows;
+    }
+
+    // dim1 x dim2 x dim3 elements, contiguous (as calloc3d() of SAF)
+    template <typename T>
+    T*** alloc3d(size_t dim1, size_t dim2, size_t dim3)
+    {
+        T*** planes = alloc<T**>(dim1);
+        T** rows = alloc<T*>(dim1 * dim2);
+        T* data = alloc<T>(dim1 * dim2 * dim3);
+        if (planes == nullptr || rows == nullptr || data == nullptr)
+            return nullptr;
+        for (size_t i = 0; i < dim1; i++) {
+            planes[i] = &rows[i * dim2];
+            for (size_t j = 0; j < dim2; j++)
+                planes[i][j] = &data[(i * dim2 + j) * dim3];
+        }
+        return planes;
+    }
+
+    // false once a buffer did not fit (or if there is no memory at all)
+    bool ok() const { return !exhausted; }
+
+    // bytes carved so far (including those that did not fit), and available
+    size_t size() const { return used; }
+    size_t reserved() const { return capacity; }
+
+    static size_t roundUp(size_t numBytes)
+    {
+        return (numBytes + alignment - 1) & ~(alignment - 1);
+    }
+
+private:
+    uint8_t* memory = nullptr;
+    size_t capacity = 0;
+    size_t used = 0;
+    bool exhausted = false;
+};
+
+#endif /* sarita_arena_h */
@@ -0,0 +1,234 @@
+//
+//  SaritaRegistry.cpp
+//  sparta_array2sh
+//
+//  See SaritaRegistry.h
+//
+
+#include "SaritaRegistry.h"
+#include "saf.h"
+#include <cstdio>
+#include <cstring>
+
+/*
+ * config tables
+ */
+SaritaConfig::~SaritaConfig()
+{
+    free(neighborCombinations);
+    free(numNeighborsDense);
+    free(idxNeighborsDense);
+    free(weightsNeighborsDense);
+    free(maxShiftDense);
+    free(combinationsPtr);
+    free(denseGrid);
+}
+
+// reads sizeX * sizeY elements into a (contiguous) 2-D array
+template <typename T>
+static bool readTable(const std::string& src, size_t& pos, T** dst, int sizeX, int sizeY)
+{
+    size_t numBytes = (size_t)sizeX * (size_t)sizeY * sizeof(T);
+    if (src.size() - pos < numBytes)
+        return false;
+    if (numBytes > 0)
+        memcpy(FLATTEN2D(dst), &src[pos], numBytes);
+    pos += numBytes;
+    return true;
+}
+
+bool SaritaConfig::parse(std::string fileContent)
+{
+    content = std::move(fileContent);
+
+    /* header: fs, order, maxShiftOverall, ... (all 32 bits) */
+    uint32_t* header[] = { &fs, &N, &NUpsampling, (uint32_t*)&radius, &denseGridSize, &maxShiftOverall,
+                           &neighborCombLength, &idxNeighborsDenseLen, &combinationsPtrLen };
+    const size_t headerSize = sizeof(header) / sizeof(header[0]) * sizeof(uint32_t);
+    if (content.size() < headerSize)
+        return false;
+    for (size_t i = 0; i < sizeof(header) / sizeof(header[0]); i++)
+        memcpy(header[i], &content[i * sizeof(uint32_t)], sizeof(uint32_t));
+
+    // poor man's plausibility check
+    if (denseGridSize > ARRAY2SH_MAX_NUM_SENSORS || denseGridSize == 0)
+        return false;
+    if (N > 7 || idxNeighborsDenseLen == 0)
+        return false;
+
+    /* the tables must fit into the rest of the file; checked before anything
+     * is allocated, so that a corrupt header cannot request gigabytes */
+    const size_t tableBytes[] = {
+        (size_t)neighborCombLength * 2 * sizeof(uint8_t),
+        (size_t)denseGridSize * sizeof(uint8_t),
+        (size_t)idxNeighborsDenseLen * denseGridSize * sizeof(uint8_t),
+        (size_t)idxNeighborsDenseLen * denseGridSize * sizeof(float),
+        (size_t)(idxNeighborsDenseLen-1) * denseGridSize * sizeof(uint8_t),
+        (size_t)combinationsPtrLen * 2 * sizeof(int8_t),
+        (size_t)2 * denseGridSize * sizeof(float) };
+    size_t requiredBytes = 0;
+    for (size_t numBytes : tableBytes)
+        requiredBytes += numBytes;
+    if (content.size() - headerSize < requiredBytes)
+        return false;
+
+    /* tables */
+    size_t pos = headerSize;
+    neighborCombinations = (uint8_t**)calloc2d(neighborCombLength, 2, sizeof(uint8_t));
+    numNeighborsDense = (uint8_t*)malloc(denseGridSize * sizeof(uint8_t));
+    idxNeighborsDense = (uint8_t**)calloc2d(idxNeighborsDenseLen, denseGridSize, sizeof(uint8_t));
+    weightsNeighborsDense = (float**)calloc2d(idxNeighborsDenseLen, denseGridSize, sizeof(float));
+    maxShiftDense = (uint8_t**)calloc2d(idxNeighborsDenseLen-1, denseGridSize, sizeof(uint8_t));
+    combinationsPtr = (int8_t**)calloc2d(combinationsPtrLen, 2, sizeof(int8_t));
+    denseGrid = (float**)calloc2d(3, denseGridSize, sizeof(float));
+    if (!(readTable(content, pos, neighborCombinations, neighborCombLength, 2) &&
+          readTable(content, pos, &numNeighborsDense, 1, denseGridSize) &&
+          readTable(content, pos, idxNeighborsDense, idxNeighborsDenseLen, denseGridSize) &&
+          readTable(content, pos, weightsNeighborsDense, idxNeighborsDenseLen, denseGridSize) &&
+          readTable(content, pos, maxShiftDense, idxNeighborsDenseLen-1, denseGridSize) &&
+          readTable(content, pos, combinationsPtr, combinationsPtrLen, 2) &&
+          readTable(content, pos, denseGrid, 2, denseGridSize) &&
+          // the weights of the dense grid are not used, and not exported by
+          // all versions of the MATLAB script; zero if missing
+          (pos == content.size() || readTable(content, pos, &denseGrid[2], 1, denseGridSize))))
+        return false;
+
+    /* the sensors are numbered from 1 (0 pads the tables); the array may have
+     * more than the (N+1)^2 the order calls for */
+    numArraySensors = (N+1)*(N+1);
+    for (uint32_t i = 0; i < idxNeighborsDenseLen * denseGridSize; i++)
+        numArraySensors = SAF_MAX(numArraySensors, (uint32_t)FLATTEN2D(idxNeighborsDense)[i]);
+    return true;
+}
+
+/*
+ * registry
+ */
+SaritaRegistry& SaritaRegistry::instance()
+{
+    // never destroyed, so that it outlives any static instances
+    static SaritaRegistry* registry = new SaritaRegistry();
+    return *registry;
+}
+
+// FNV-1a
+static uint64_t hashContent(const std::string& content)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : content)
+        hash = (hash ^ c) * 1099511628211ull;
+    return hash;
+}
+
+std::shared_ptr<const SaritaConfig> SaritaRegistry::acquireConfig(const char* path)
+{
+    /* read the whole file; it is small (tens of kB) */
+    FILE* configFile = path != nullptr ? fopen(path, "rb") : nullptr;
+    if (!configFile)
+        return nullptr;
+    std::string content;
+    char chunk[16384];
+    size_t numRead;
+    while ((numRead = fread(chunk, 1, sizeof(chunk), configFile)) > 0)
+        content.append(chunk, numRead);
+    fclose(configFile);
+    uint64_t hash = hashContent(content);
+
+    /* an instance may already hold it */
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& bucket = configs[hash];
+        for (auto it = bucket.begin(); it != bucket.end();) {
+            if (auto config = it->lock()) {
+                if (config->content == content)
+                    return config;
+                ++it;
+            }
+            else
+                it = bucket.erase(it);
+        }
+    }
+
+    /* parsed outside of the lock; if another thread has meanwhile registered
+     * the same content, that one is used instead */
+    std::shared_ptr<SaritaConfig> parsed(new SaritaConfig());
+    if (!parsed->parse(std::move(content)))
+        return nullptr;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& bucket = configs[hash];
+    for (auto& entry : bucket)
+        if (auto config = entry.lock())
+            if (config->content == parsed->content)
+                return config;
+    bucket.push_back(parsed);
+    return parsed;
+}
+
+size_t SaritaRegistry::numConfigs()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t count = 0;
+    for (auto& bucket : configs)
+        for (auto& entry : bucket.second)
+            count += entry.expired() ? 0 : 1;
+    return count;
+}
+
+void* SaritaRegistry::acquireEncoder(const std::string& key)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = encodersByKey.find(key);
+    if (it == encodersByKey.end())
+        return nullptr;
+    it->second->numRefs++;
+    return it->second->data;
+}
+
+void* SaritaRegistry::publishEncoder(const std::string& key, void* encoder, void (*destroy)(void*))
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    auto it = encodersByKey.find(key);
+    if (it != encodersByKey.end()) { // computed twice at once; keep the first
+        it->second->numRefs++;
+        void* published = it->second->data;
+        lock.unlock();
+        destroy(encoder);
+        return published;
+    }
+    Encoder* entry = new Encoder{ key, encoder, destroy, 1 };
+    encodersByKey[key] = entry;
+    encodersByData[encoder] = entry;
+    return encoder;
+}
+
+void SaritaRegistry::releaseEncoder(void* encoder)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    auto it = encodersByData.find(encoder);
+    if (it == encodersByData.end() || --it->second->numRefs > 0)
+        return;
+    Encoder* entry = it->second;
+    encodersByData.erase(it);
+    encodersByKey.erase(entry->key);
+    lock.unlock();
+    entry->destroy(entry->data);
+    delete entry;
+}
+
+size_t SaritaRegistry::numEncoders()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return encodersByKey.size();
+}
+
+const array2sh_encoderCache SaritaRegistry::encoderCache = {
+    [](void* userData, const void* key, int keySize) {
+        return ((SaritaRegistry*)userData)->acquireEncoder(std::string((const char*)key, (size_t)keySize));
+    },
+    [](void* userData, const void* key, int keySize, void* encoder, void (*destroy)(void*)) {
+        return ((SaritaRegistry*)userData)->publishEncoder(std::string((const char*)key, (size_t)keySize), encoder, destroy);
+    },
+    [](void* userData, void* encoder) {
+        ((SaritaRegistry*)userData)->releaseEncoder(encoder);
+    }
+};
@@ -0,0 +1,106 @@
+//
+//  SaritaRegistry.h
+//  sparta_array2sh
+//
+//  Process-wide registry of the data that instances with the same settings
+//  can share: the tables of a config file (keyed by its content, so that the
+//  same file under another path, or re-read after a reload, is still only held
+//  once), and the array2sh encoding matrices (keyed by everything they are
+//  computed from; see array2sh_setEncoderCache()). Both are read-only once
+//  built, and are freed with their last reference; so with several instances
+//  of one config (e.g. one per microphone position), the memory and the setup
+//  time grow with the number of distinct configs, and each instance only
+//  allocates its FIFOs, frame buffers and filterbank.
+//
+//  All functions are thread-safe.
+//
+
+#ifndef sarita_registry_h
+#define sarita_registry_h
+
+#include "array2sh.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * the tables of a config file (as exported from MATLAB); see
+ * Sarita::readConfigFile()
+ */
+struct SaritaConfig
+{
+    // header
+    uint32_t fs;
+    uint32_t N;                    // order of source grid
+    uint32_t NUpsampling;          // order of target grid
+    float radius;                  // radius of array
+    uint32_t denseGridSize;
+    uint32_t maxShiftOverall;
+    uint32_t neighborCombLength;   // neighborCombinations size = neighborCombLength * 2
+    uint32_t idxNeighborsDenseLen; // idxNeighborsDense array size = idxNeighborsDenseLen * dense grid size
+    uint32_t combinationsPtrLen;   // length of combinations pointer, y is always 2
+    uint32_t numArraySensors;      // sensors of the sparse array, as the neighbour tables refer to them
+
+    // data
+    uint8_t** neighborCombinations = nullptr;   // Array containing all combinations of nearest neighbors
+    uint8_t* numNeighborsDense = nullptr;       // Number of nearest neighbors for each sampling point
+    uint8_t** idxNeighborsDense = nullptr;      // Indices of neighbors of each sampling point
+    float** weightsNeighborsDense = nullptr;    // Weights of neighbors of each sampling point
+    uint8_t** maxShiftDense = nullptr;
+    int8_t** combinationsPtr = nullptr;         // Array describing which neighbors combination is required for each cross correlations
+    float** denseGrid = nullptr;                // Az, colatitude and weight of each target sensor
+
+    std::string content;           // the file itself, to tell configs with equal hashes apart
+
+    SaritaConfig() = default;
+    SaritaConfig(const SaritaConfig&) = delete;
+    SaritaConfig& operator=(const SaritaConfig&) = delete;
+    ~SaritaConfig();
+
+    // parses the content of a config file; false if it is not a valid one
+    bool parse(std::string fileContent);
+};
+
+class SaritaRegistry
+{
+public:
+    // the registry of this process
+    static SaritaRegistry& instance();
+
+    // reads a config file, and returns its tables; shared with all other
+    // holders of a file with the same content (nullptr if it cannot be read)
+    std::shared_ptr<const SaritaConfig> acquireConfig(const char* path);
+
+    // array2sh encoder cache functions; the user data is the registry
+    static const array2sh_encoderCache encoderCache;
+
+    // number of distinct configs and encoders currently held
+    size_t numConfigs();
+    size_t numEncoders();
+
+private:
+    SaritaRegistry() = default;
+
+    void* acquireEncoder(const std::string& key);
+    void* publishEncoder(const std::string& key, void* encoder, void (*destroy)(void*));
+    void releaseEncoder(void* encoder);
+
+    struct Encoder
+    {
+        std::string key;
+        void* data;
+        void (*destroy)(void*);
+        int numRefs;
+    };
+
+    std::mutex mutex;
+    // configs by content hash; the registry itself holds no references
+    std::unordered_map<uint64_t, std::vector<std::weak_ptr<const SaritaConfig>>> configs;
+    std::unordered_map<std::string, Encoder*> encodersByKey;
+    std::unordered_map<void*, Encoder*> encodersByData;
+};
+
+#endif /* sarita_registry_h */
@@ -0,0 +1,212 @@
+//
+//  SaritaTiming.h
+//  sparta_array2sh
+//
+//  Per-stage timing of the SARITA/array2sh processing chain.
+//
+//  The audio thread is the only writer; the GUI (or a test) may take a
+//  snapshot at any time with getStats(). All counters are relaxed atomics, so a
+//  snapshot may mix values from two consecutive callbacks, which is fine for
+//  diagnostics. Define SARITA_ENABLE_TIMING=0 to compile all instrumentation
+//  points away.
+//
+
+#ifndef sarita_timing_h
+#define sarita_timing_h
+
+#ifndef SARITA_ENABLE_TIMING
+#define SARITA_ENABLE_TIMING 1
+#endif
+
+#include "array2sh.h"
+#include "sarita.h" /* stages and SaritaTimingStats */
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#if SARITA_ENABLE_TIMING && (defined(_M_X64) || defined(_M_IX86))
+    #include <intrin.h>
+#elif SARITA_ENABLE_TIMING && (defined(__x86_64__) || defined(__i386__))
+    #include <x86intrin.h>
+#endif
+
+static inline const char* saritaStageName(int stage)
+{
+    static const char* names[SARITA_NUM_STAGES] = {
+        "Xcorr", "Peak search", "Align/sum", "Overlap-add", "Filterbank", "SHT (GEMM)"
+    };
+    return (stage >= 0 && stage < SARITA_NUM_STAGES) ? names[stage] : "";
+}
+
+/* lower edge of a load bucket, relative to the deadline (0 for the first) */
+static inline double saritaLoadBucketEdge(int bucket)
+{
+    return bucket <= 0 ? 0.0 : std::ldexp(1.0, bucket - SARITA_LOAD_BUCKET_DEADLINE);
+}
+
+/* time stamp counter: cycles on x86, the virtual counter on ARM64, and
+ * nanoseconds elsewhere. Only ever used for relative comparisons */
+static inline uint64_t saritaReadTicks()
+{
+#if SARITA_ENABLE_TIMING && (defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__))
+    return (uint64_t)__rdtsc();
+#elif SARITA_ENABLE_TIMING && defined(__aarch64__)
+    uint64_t t;
+    __asm__ __volatile__ ("mrs %0, cntvct_el0" : "=r"(t));
+    return t;
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+#if SARITA_ENABLE_TIMING
+
+class SaritaTiming
+{
+public:
+    SaritaTiming() { clear(); }
+
+    // audio thread: accumulate ticks for a stage
+    inline void addTicks(int stage, uint64_t ticks)
+    {
+        add(stageTicks[stage], ticks);
+    }
+
+    // audio thread: start/end of a host callback
+    inline void beginCallback()
+    {
+        if (resetRequested.exchange(false, std::memory_order_acquire))
+            clear();
+        callbackStart = std::chrono::steady_clock::now();
+    }
+
+    void endCallback(double deadlineSeconds)
+    {
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - callbackStart).count();
+        double load = deadlineSeconds > 0.0 ? elapsed / deadlineSeconds : 0.0;
+        int exponent;
+        std::frexp(load, &exponent); // load = m * 2^exponent, m in [0.5, 1)
+        int bucket = load > 0.0 ? exponent - 1 + SARITA_LOAD_BUCKET_DEADLINE : 0;
+        bucket = bucket < 0 ? 0 : (bucket >= SARITA_NUM_LOAD_BUCKETS ? SARITA_NUM_LOAD_BUCKETS-1 : bucket);
+        add(loadHistogram[bucket], 1);
+        add(numCallbacks, 1);
+        if (load > 1.0)
+            add(numOverruns, 1);
+        uint64_t loadPpm = (uint64_t)(load * 1e6);
+        add(loadSumPpm, loadPpm);
+        if (loadPpm > maxLoadPpm.load(std::memory_order_relaxed))
+            maxLoadPpm.store(loadPpm, std::memory_order_relaxed);
+    }
+
+    // any thread: the counters are cleared at the start of the next callback
+    void requestReset() { resetRequested.store(true, std::memory_order_release); }
+
+    // any thread
+    SaritaTimingStats getStats() const
+    {
+        SaritaTimingStats stats;
+        for (int i = 0; i < SARITA_NUM_STAGES; i++)
+            stats.stageTicks[i] = stageTicks[i].load(std::memory_order_relaxed);
+        for (int i = 0; i < SARITA_NUM_LOAD_BUCKETS; i++)
+            stats.loadHistogram[i] = loadHistogram[i].load(std::memory_order_relaxed);
+        stats.numCallbacks = numCallbacks.load(std::memory_order_relaxed);
+        stats.numOverruns = numOverruns.load(std::memory_order_relaxed);
+        stats.meanLoad = stats.numCallbacks > 0 ? (double)loadSumPpm.load(std::memory_order_relaxed) * 1e-6 / (double)stats.numCallbacks : 0.0;
+        stats.maxLoad = (double)maxLoadPpm.load(std::memory_order_relaxed) * 1e-6;
+        return stats;
+    }
+
+    // hook for array2sh_setStageHook(); userData is the SaritaTiming
+    static void array2shStageHook(void* userData, ARRAY2SH_STAGES stage, int begin)
+    {
+        SaritaTiming* timing = (SaritaTiming*)userData;
+        uint64_t now = saritaReadTicks();
+        if (begin)
+            timing->array2shStageStart = now;
+        else
+            timing->addTicks(stage == ARRAY2SH_STAGE_TFT ? SARITA_STAGE_TFT : SARITA_STAGE_SHT, now - timing->array2shStageStart);
+    }
+
+private:
+    // single writer, so no read-modify-write is needed
+    static inline void add(std::atomic<uint64_t>& counter, uint64_t value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    void clear()
+    {
+        for (auto& t : stageTicks)
+            t.store(0, std::memory_order_relaxed);
+        for (auto& h : loadHistogram)
+            h.store(0, std::memory_order_relaxed);
+        numCallbacks.store(0, std::memory_order_relaxed);
+        numOverruns.store(0, std::memory_order_relaxed);
+        loadSumPpm.store(0, std::memory_order_relaxed);
+        maxLoadPpm.store(0, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> stageTicks[SARITA_NUM_STAGES];
+    std::atomic<uint64_t> loadHistogram[SARITA_NUM_LOAD_BUCKETS];
+    std::atomic<uint64_t> numCallbacks;
+    std::atomic<uint64_t> numOverruns;
+    std::atomic<uint64_t> loadSumPpm;   // sum of the loads, in parts per million
+    std::atomic<uint64_t> maxLoadPpm;
+    std::atomic<bool> resetRequested { false };
+
+    // audio thread only
+    std::chrono::steady_clock::time_point callbackStart;
+    uint64_t array2shStageStart = 0;
+};
+
+/* attributes the time between consecutive laps to the given stages, e.g.
+ *   SaritaStageClock clock(timing);
+ *   ...xcorr...   clock.lap(SARITA_STAGE_XCORR);
+ *   ...search...  clock.lap(SARITA_STAGE_PEAK_SEARCH); */
+class SaritaStageClock
+{
+public:
+    explicit SaritaStageClock(SaritaTiming& t) : timing(t), last(saritaReadTicks()) {}
+
+    inline void lap(int stage)
+    {
+        uint64_t now = saritaReadTicks();
+        timing.addTicks(stage, now - last);
+        last = now;
+    }
+
+private:
+    SaritaTiming& timing;
+    uint64_t last;
+};
+
+#else /* SARITA_ENABLE_TIMING */
+
+/* no-op versions, with the same interface */
+class SaritaTiming
+{
+public:
+    inline void addTicks(int, uint64_t) {}
+    inline void beginCallback() {}
+    inline void endCallback(double) {}
+    void requestReset() {}
+    SaritaTimingStats getStats() const
+    {
+        SaritaTimingStats stats;
+        memset(&stats, 0, sizeof(stats));
+        return stats;
+    }
+    static void array2shStageHook(void*, ARRAY2SH_STAGES, int) {}
+};
+
+class SaritaStageClock
+{
+public:
+    explicit SaritaStageClock(SaritaTiming&) {}
+    inline void lap(int) {}
+};
+
+#endif /* SARITA_ENABLE_TIMING */
+
+#endif /* sarita_timing_h */
@@ -0,0 +1,184 @@
+//
+//  SaritaTrace.cpp
+//  sparta_array2sh
+//
+
+#include "SaritaTrace.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+const uint32_t kTraceCapacity = 1u << 16; // events; must be a power of two
+const int kFlushIntervalMs = 50;
+
+struct TraceEvent
+{
+    const char* name;
+    const char* category;
+    uint64_t timeNs;
+    uint32_t tid;
+    char phase;
+};
+
+// slot of the bounded queue: 'sequence' tells producers and the consumer
+// whose turn it is (D. Vyukov's bounded MPMC queue, with a single consumer)
+struct TraceSlot
+{
+    std::atomic<uint64_t> sequence;
+    TraceEvent event;
+};
+
+std::unique_ptr<TraceSlot[]> slots;         // allocated on the first start(), never freed
+std::atomic<uint64_t> writePos { 0 };
+uint64_t readPos = 0;                       // writer thread only
+std::atomic<uint32_t> session { 0 };
+std::atomic<uint32_t> nextThreadId { 1 };
+thread_local uint32_t threadId = 0;
+thread_local uint32_t namedInSession = 0;
+
+std::mutex controlMutex;                    // start()/stop() only
+std::thread writerThread;
+std::atomic<bool> stopRequested { false };
+FILE* traceFile = nullptr;
+uint64_t startNs = 0;
+bool firstEntry = true;
+
+uint64_t nowNs()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint32_t currentThreadId()
+{
+    if (threadId == 0)
+        threadId = nextThreadId.fetch_add(1, std::memory_order_relaxed);
+    return threadId;
+}
+
+void writeEvent(const TraceEvent& e)
+{
+    if (e.timeNs < startNs) // left over from the previous trace
+        return;
+    fprintf(traceFile, "%s\n", firstEntry ? "" : ",");
+    firstEntry = false;
+    if (e.phase == 'M') {
+        fprintf(traceFile, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                e.tid, e.name);
+        return;
+    }
+    double ts_us = (double)(e.timeNs - startNs) * 1e-3;
+    fprintf(traceFile, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%u%s}",
+            e.name, e.category, e.phase, ts_us, e.tid, e.phase == 'i' ? ",\"s\":\"t\"" : "");
+}
+
+// writes out all events that are complete
+void drain()
+{
+    for (;;) {
+        TraceSlot& slot = slots[readPos & (kTraceCapacity-1)];
+        if (slot.sequence.load(std::memory_order_acquire) != readPos + 1)
+            break;
+        writeEvent(slot.event);
+        slot.sequence.store(readPos + kTraceCapacity, std::memory_order_release);
+        readPos++;
+    }
+}
+
+void writerLoop()
+{
+    while (!stopRequested.load(std::memory_order_acquire)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(kFlushIntervalMs));
+        drain();
+        fflush(traceFile);
+    }
+    drain();
+}
+
+} // namespace
+
+std::atomic<bool> SaritaTrace::running { false };
+std::atomic<uint64_t> SaritaTrace::numDropped { 0 };
+
+bool SaritaTrace::start(const char* path)
+{
+    std::lock_guard<std::mutex> lock(controlMutex);
+    if (running.load() || path == nullptr)
+        return false;
+    traceFile = fopen(path, "w");
+    if (traceFile == nullptr)
+        return false;
+    if (!slots) {
+        slots.reset(new TraceSlot[kTraceCapacity]);
+        for (uint32_t i = 0; i < kTraceCapacity; i++)
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    // the positions carry on from the last trace, so that an event that was
+    // still being recorded when it was stopped can't corrupt the queue
+    numDropped.store(0, std::memory_order_relaxed);
+    session.fetch_add(1, std::memory_order_relaxed);
+    startNs = nowNs();
+    firstEntry = true;
+    fprintf(traceFile, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+    stopRequested.store(false);
+    writerThread = std::thread(writerLoop);
+    running.store(true, std::memory_order_release);
+    return true;
+}
+
+void SaritaTrace::stop()
+{
+    std::lock_guard<std::mutex> lock(controlMutex);
+    if (!running.load())
+        return;
+    running.store(false, std::memory_order_release);
+    stopRequested.store(true, std::memory_order_release);
+    writerThread.join();
+    fprintf(traceFile, "\n],\"otherData\":{\"dropped_events\":%llu}}\n", (unsigned long long)numDropped.load());
+    fclose(traceFile);
+    traceFile = nullptr;
+}
+
+void SaritaTrace::record(const char* name, const char* category, char phase)
+{
+    if (!running.load(std::memory_order_acquire))
+        return;
+    TraceEvent e;
+    e.name = name;
+    e.category = category;
+    e.timeNs = nowNs();
+    e.tid = currentThreadId();
+    e.phase = phase;
+
+    uint64_t pos = writePos.load(std::memory_order_relaxed);
+    for (;;) {
+        TraceSlot& slot = slots[pos & (kTraceCapacity-1)];
+        uint64_t seq = slot.sequence.load(std::memory_order_acquire);
+        if (seq == pos) {
+            if (writePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                slot.event = e;
+                slot.sequence.store(pos + 1, std::memory_order_release);
+                return;
+            }
+        }
+        else if (seq < pos) { // full; the writer hasn't caught up
+            numDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        else
+            pos = writePos.load(std::memory_order_relaxed);
+    }
+}
+
+void SaritaTrace::nameThread(const char* name)
+{
+    uint32_t current = session.load(std::memory_order_relaxed);
+    if (namedInSession == current)
+        return;
+    namedInSession = current;
+    record(name, "", 'M');
+}
@@ -0,0 +1,104 @@
+//
+//  SaritaTripleBuffer.h
+//  sparta_array2sh
+//
+//  A value of trivially copyable type T, handed from one writer thread to one
+//  reader thread (the audio thread) without either of them ever waiting: the
+//  writer fills the slot neither of them is using, and swaps it with the
+//  middle one; the reader swaps the middle one with its own if it holds a
+//  newer value. Values written while the reader is busy replace each other,
+//  so the reader always gets the latest one, and always a whole one.
+//
+//  Any other thread may peek() at the latest value written. That is held in
+//  relaxed atomic words, so it is never undefined behaviour, but may mix two
+//  consecutive values if a write is in progress.
+//
+
+#ifndef sarita_triple_buffer_h
+#define sarita_triple_buffer_h
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+template <typename T>
+class SaritaTripleBuffer
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SaritaTripleBuffer needs a trivially copyable type");
+
+public:
+    SaritaTripleBuffer() { reset(T{}); }
+    explicit SaritaTripleBuffer(const T& value) { reset(value); }
+
+    SaritaTripleBuffer(const SaritaTripleBuffer&) = delete;
+    SaritaTripleBuffer& operator=(const SaritaTripleBuffer&) = delete;
+
+    // while neither thread uses it: sets all slots to 'value'
+    void reset(const T& value)
+    {
+        for (T& slot : slots)
+            slot = value;
+        latest = value;
+        writeWords(value);
+        front = 0;
+        back = 1;
+        middle.store(2, std::memory_order_release);
+    }
+
+    // writer thread: publishes a new value
+    void write(const T& value)
+    {
+        slots[back] = value;
+        latest = value;
+        writeWords(value);
+        back = middle.exchange(back | freshBit, std::memory_order_acq_rel) & indexMask;
+    }
+
+    // writer thread: the value it wrote last
+    const T& written() const { return latest; }
+
+    // reader thread: copies the latest value to 'value' and returns true, or
+    // leaves 'value' alone and returns false if nothing new has been written
+    bool read(T& value)
+    {
+        if ((middle.load(std::memory_order_relaxed) & freshBit) == 0)
+            return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & indexMask;
+        value = slots[front];
+        return true;
+    }
+
+    // any thread: the latest value written, or a mix of the latest two
+    T peek() const
+    {
+        uint32_t copy[numWords];
+        for (size_t i = 0; i < numWords; i++)
+            copy[i] = words[i].load(std::memory_order_relaxed);
+        T value;
+        memcpy(&value, copy, sizeof(T));
+        return value;
+    }
+
+private:
+    static constexpr size_t numWords = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+    static constexpr int indexMask = 3;
+    static constexpr int freshBit = 4;
+
+    void writeWords(const T& value)
+    {
+        uint32_t copy[numWords] = {};
+        memcpy(copy, &value, sizeof(T));
+        for (size_t i = 0; i < numWords; i++)
+            words[i].store(copy[i], std::memory_order_relaxed);
+    }
+
+    T slots[3];
+    int front;                 // reader only
+    int back;                  // writer only
+    std::atomic<int> middle;   // index of the third slot, | freshBit if newer than front
+    T latest;                  // writer only
+    std::atomic<uint32_t> words[numWords] = {};
+};
+
+#endif /* sarita_triple_buffer_h */
@@ -0,0 +1,905 @@
+//
+//  sarita.cpp
+//  sparta_array2sh
+//
+//  Implementation of the sarita.h API on top of the Sarita engine (see
+//  sarita_internal.h), which owns the input/output FIFOs, the overlap-add and
+//  the array2sh encoder, and swaps in new configurations and parameters
+//  without blocking the processing thread.
+//
+
+#include "sarita_internal.h"
+
+/* whether the SH signals are encoded in the time-frequency domain, straight
+ * from the signals of the sparse array (see Sarita::encodeFused()); a band
+ * split is only made there */
+static bool sarita_fusedDomain(const sarita_parameters& params)
+{
+    return params.outputType == SARITA_OUTPUT_SH &&
+           (params.upsamplingDomain == SARITA_UPSAMPLING_DOMAIN_TIME_FREQUENCY ||
+            params.bandSplit == SARITA_BAND_SPLIT_ON);
+}
+
+/* whether the encoder of the sparse array is needed, for the SH output */
+static bool sarita_bandSplit(sarita_data* pData, const sarita_parameters& params)
+{
+    return pData->engine != NULL && params.outputType == SARITA_OUTPUT_SH &&
+           params.bandSplit == SARITA_BAND_SPLIT_ON;
+}
+
+/* the sources that array2sh encodes in the time-frequency domain: the
+ * sensors of the sparse grid, or all those of the array for a band split */
+static int sarita_numSources(sarita_data* pData, const sarita_parameters& params)
+{
+    if (pData->engine == NULL || !sarita_fusedDomain(params))
+        return 0;
+    return sarita_bandSplit(pData, params) ? pData->numArraySensors : pData->sparseGridSize;
+}
+
+/* the sources array2sh mixes into the projected signals: those of
+ * sarita_numSources(), as long as the encoder has a projection to mix them
+ * into (see mixtureEncoder); none otherwise */
+static int sarita_mixtureSources(sarita_data* pData, const sarita_parameters& params)
+{
+    return pData->mixtureEncoder ? sarita_numSources(pData, params) : 0;
+}
+
+/* passes the encoding parameters that have changed since they were last
+ * applied on to array2sh, and computes the encoder and filterbank they call
+ * for (array2sh_processBlock() only ever uses them, and is silent until
+ * then); sarita_process() must not be using array2sh meanwhile */
+static void sarita_updateEncoder(sarita_data* pData, const sarita_parameters& params)
+{
+    void* hA2sh = pData->hA2sh;
+    sarita_parameters& applied = pData->appliedParameters;
+
+    if (params.order != applied.order)
+        array2sh_setEncodingOrder(hA2sh, params.order);
+    if (params.filterType != applied.filterType)
+        array2sh_setFilterType(hA2sh, params.filterType);
+    if (params.regPar != applied.regPar)
+        array2sh_setRegPar(hA2sh, params.regPar);
+    if (params.compressionTol_dB != applied.compressionTol_dB)
+        array2sh_setCompressionTol(hA2sh, params.compressionTol_dB);
+    if (params.filterbank != applied.filterbank)
+        array2sh_setFilterbank(hA2sh, params.filterbank);
+    applied = params;
+
+    /* the encoder of the sparse array has the same settings, but for the
+     * order, which is at most that of the array; it is only computed for a
+     * band split, and then only its matrices are used (see
+     * Sarita::computeMixing()) */
+    void* hA2shSparse = pData->hA2shSparse;
+    array2sh_setEncodingOrder(hA2shSparse, SAF_MAX(SAF_MIN(params.order, pData->N), 1));
+    array2sh_setFilterType(hA2shSparse, params.filterType);
+    array2sh_setRegPar(hA2shSparse, params.regPar);
+    array2sh_setCompressionTol(hA2shSparse, params.compressionTol_dB);
+    array2sh_setFilterbank(hA2shSparse, params.filterbank);
+
+    /* the mixing matrices of the engine are recomputed for a new encoder,
+     * which is first tried with the mixture sources, if any */
+    const int numSources = sarita_numSources(pData, params);
+    bool mixtureEncoder = true;
+    array2sh_setNumMixtureSources(hA2sh, numSources);
+    if (pData->engine != NULL)
+        pData->engine->invalidateMixing();
+
+    /* only needed for the SH output; otherwise left to a switch to it */
+    if (pData->engine != NULL && params.outputType == SARITA_OUTPUT_SH) {
+        SARITA_TRACE_SCOPE("sarita_updateEncoder", "background");
+        array2sh_initCodec(hA2sh);
+        /* without a projection in every band, the sparse array signals cannot
+         * be mixed into the encoder; the dense grid is then upsampled in the
+         * time domain, without a band split, until the next encoder (the same
+         * one is taken from the cache, for the dense grid signals) */
+        if (numSources > 0 && array2sh_getProjection(hA2sh) == NULL) {
+            mixtureEncoder = false;
+            array2sh_setNumMixtureSources(hA2sh, 0);
+            array2sh_initCodec(hA2sh);
+        }
+        if (params.bandSplit == SARITA_BAND_SPLIT_ON)
+            array2sh_initCodec(hA2shSparse);
+    }
+    pData->mixtureEncoder = mixtureEncoder;
+}
+
+/* the crossover frequency of the band split: as set, or else the spatial
+ * aliasing frequency of the sparse array; within the range, and below the
+ * Nyquist frequency */
+static float sarita_crossoverFrequency(sarita_data* pData, const sarita_parameters& params)
+{
+    float crossoverFreq = params.crossoverFreq;
+    if (crossoverFreq <= 0.0f && pData->radius > 0.0f)
+        crossoverFreq = (float)pData->N * 343.0f / (2.0f * SAF_PI * pData->radius);
+    crossoverFreq = SAF_MIN(crossoverFreq, 0.45f * (float)pData->fs);
+    return SAF_CLAMP(crossoverFreq, SARITA_MIN_CROSSOVER_FREQ, SARITA_MAX_CROSSOVER_FREQ);
+}
+
+/* whether sarita_updateEncoder() has anything to do; also true after a
+ * change made directly through the array2sh API (e.g. of the sensors) */
+static bool sarita_encoderNeedsUpdate(sarita_data* pData, const sarita_parameters& params)
+{
+    const sarita_parameters& applied = pData->appliedParameters;
+    return params.order != applied.order || params.filterType != applied.filterType ||
+           params.regPar != applied.regPar || params.compressionTol_dB != applied.compressionTol_dB ||
+           params.filterbank != applied.filterbank ||
+           array2sh_getNumMixtureSources(pData->hA2sh) != sarita_mixtureSources(pData, params) ||
+           (pData->engine != NULL && params.outputType == SARITA_OUTPUT_SH &&
+            array2sh_getReinitSHTmatrixFLAG(pData->hA2sh)) ||
+           (sarita_bandSplit(pData, params) && array2sh_getReinitSHTmatrixFLAG(pData->hA2shSparse));
+}
+
+static int sarita_swapEngine(sarita_data* pData, const char* path);
+
+/* applies the parameters that need recomputation, i.e. the encoder (while the
+ * SH output is held silent, see encoderBusy); the engine keeps processing
+ * meanwhile. loadMutex must be held */
+static void sarita_applyParameters(sarita_data* pData)
+{
+    sarita_parameters params = pData->parameters.peek();
+
+    if (sarita_encoderNeedsUpdate(pData, params)) {
+        pData->encoderBusy = true;
+        while (pData->procStatus == PROC_STATUS_ONGOING)
+            SAF_SLEEP(1);
+        sarita_updateEncoder(pData, params);
+        pData->encoderBusy = false;
+    }
+
+    /* a new pruning rebuilds the engine from its config file, as a load would */
+    if (pData->engine != NULL && (params.pruningThreshold != pData->enginePruningThreshold ||
+                                  params.maxPruningError != pData->engineMaxPruningError))
+        sarita_swapEngine(pData, pData->configPath.c_str());
+}
+
+/* the background thread: applies the parameters when asked to by
+ * sarita_setParameters(), and every 100 ms otherwise, so that changes made
+ * directly through the array2sh API are picked up as well */
+static void sarita_workerThread(sarita_data* pData)
+{
+    std::unique_lock<std::mutex> lock(pData->workerMutex);
+    while (!pData->workerExit) {
+        pData->workerWakeUp.wait_for(lock, std::chrono::milliseconds(100), [pData] {
+            return pData->workerExit || pData->updateRequested.load();
+        });
+        if (pData->workerExit)
+            break;
+        pData->updateRequested = false;
+        lock.unlock();
+        {
+            std::lock_guard<std::mutex> loadLock(pData->loadMutex);
+            sarita_applyParameters(pData);
+        }
+        lock.lock();
+    }
+}
+
+/* wakes the background thread up, once until it has picked the request up;
+ * the mutex is not taken, so that this may be called from the processing
+ * thread (a wake-up lost to a race is made up for by the 100 ms poll) */
+static void sarita_requestUpdate(sarita_data* pData)
+{
+    if (!pData->updateRequested.exchange(true))
+        pData->workerWakeUp.notify_one();
+}
+
+static void sarita_destroyEngine(Sarita* engine)
+{
+    engine->deallocBuffers();
+    delete engine;
+}
+
+/* builds an engine for the given config (or none, if path is NULL), and swaps
+ * it in between two calls to sarita_process(); loadMutex must be held */
+static int sarita_swapEngine(sarita_data* pData, const char* path)
+{
+    Sarita* newEngine = NULL;
+    Sarita* oldEngine;
+
+    if (path != NULL) {
+        SARITA_TRACE_SCOPE("setupSarita", "config");
+        /* with memory of its own, sized for its config; so the memory of two
+         * engines is only taken until the current one is swapped out */
+        newEngine = new (std::nothrow) Sarita();
+        if (newEngine == NULL)
+            return -1;
+        sarita_parameters params = pData->parameters.peek();
+        newEngine->setOverlap(params.overlapPercent);
+        newEngine->shiftEstimation = params.shiftEstimation;
+        newEngine->pruningThreshold = params.pruningThreshold;
+        newEngine->maxPruningError = params.maxPruningError;
+        /* not retried with these if the file cannot be read any more */
+        pData->enginePruningThreshold = params.pruningThreshold;
+        pData->engineMaxPruningError = params.maxPruningError;
+        if (newEngine->setupSarita(path, pData->blockSize, &pData->engineLimits) == -1) {
+            sarita_destroyEngine(newEngine);
+            return -1;
+        }
+        newEngine->timing = &pData->timing;
+    }
+
+    /* wait for the current block to be finished; any blocks processed
+     * meanwhile are silent */
+    pData->codecStatus = CODEC_STATUS_INITIALISING;
+    while (pData->procStatus == PROC_STATUS_ONGOING)
+        SAF_SLEEP(1);
+    oldEngine = pData->engine;
+    pData->engine = newEngine;
+    if (newEngine != NULL) {
+        newEngine->updateArrayData(pData->hA2sh);
+        newEngine->updateSparseArrayData(pData->hA2shSparse);
+        pData->configFs = (int)newEngine->fs;
+        pData->N = (int)newEngine->N;
+        pData->NUpsampling = (int)newEngine->NUpsampling;
+        pData->sparseGridSize = newEngine->sparseGridSize;
+        pData->numArraySensors = newEngine->numArraySensors;
+        pData->radius = newEngine->radius;
+        pData->denseGridSize = (int)newEngine->denseGridSize;
+        pData->maxShiftOverall = (int)newEngine->maxShiftOverall;
+        pData->numCrossCorrelations = (int)newEngine->neighborCombLength;
+        pData->maxPruningError = 0.0f;
+        for (uint32_t i = 0; i < newEngine->denseGridSize; i++)
+            pData->maxPruningError = SAF_MAX(pData->maxPruningError, newEngine->pruningError[i]);
+
+        /* so that the first block is encoded already */
+        sarita_updateEncoder(pData, pData->parameters.peek());
+    }
+    else {
+        pData->numCrossCorrelations = 0;
+        pData->maxPruningError = 0.0f;
+    }
+    pData->codecStatus = newEngine != NULL ? CODEC_STATUS_INITIALISED : CODEC_STATUS_NOT_INITIALISED;
+
+    if (oldEngine != NULL)
+        sarita_destroyEngine(oldEngine);
+    return 0;
+}
+
+void sarita_create
+(
+    void ** const phSar
+)
+{
+    sarita_data* pData = new sarita_data;
+    *phSar = (void*)pData;
+
+    /* the GEMMs of the encoders run on the audio thread (see sarita.h) */
+#if defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    openblas_set_num_threads(1);
+#elif defined(SAF_USE_INTEL_MKL_LP64) || defined(SAF_USE_INTEL_MKL_ILP64)
+    mkl_set_num_threads(1);
+#endif
+
+    pData->engine = NULL;
+    array2sh_create(&(pData->hA2sh));
+    /* instances with the same encoder settings share the encoding matrices */
+    array2sh_setEncoderCache(pData->hA2sh, &SaritaRegistry::encoderCache, &SaritaRegistry::instance());
+    array2sh_create(&(pData->hA2shSparse));
+    array2sh_setEncoderCache(pData->hA2shSparse, &SaritaRegistry::encoderCache, &SaritaRegistry::instance());
+#if SARITA_ENABLE_TIMING
+    array2sh_setStageHook(pData->hA2sh, SaritaTiming::array2shStageHook, &(pData->timing));
+    array2sh_setStageHook(pData->hA2shSparse, SaritaTiming::array2shStageHook, &(pData->timing));
+#endif
+    pData->codecStatus = CODEC_STATUS_NOT_INITIALISED;
+    pData->procStatus = PROC_STATUS_NOT_ONGOING;
+    pData->encoderBusy = false;
+    pData->mixtureEncoder = true;
+
+    /* no config yet */
+    pData->configFs = 0;
+    pData->N = 0;
+    pData->NUpsampling = 0;
+    pData->sparseGridSize = 0;
+    pData->numArraySensors = 0;
+    pData->denseGridSize = 0;
+    pData->maxShiftOverall = 0;
+    pData->numCrossCorrelations = 0;
+    pData->maxPruningError = 0.0f;
+    pData->radius = 0.0f;
+    pData->enginePruningThreshold = 0.0f;
+    pData->engineMaxPruningError = 0.0f;
+
+    /* no memory until sarita_init() */
+    pData->limits.maxSparseSensors = MAX_NUM_SH_SIGNALS;
+    pData->limits.maxDenseSensors = SARITA_DEFAULT_MAX_DENSE_SENSORS;
+    pData->limits.maxTimeShift = SARITA_DEFAULT_MAX_TIME_SHIFT;
+    pData->limits.maxCrossCorrelations = SARITA_DEFAULT_MAX_CROSS_CORRELATIONS;
+    pData->limits.maxNeighbors = SARITA_DEFAULT_MAX_NEIGHBORS;
+    pData->engineLimits = pData->limits;
+
+    /* default user parameters; the encoding ones as array2sh starts with */
+    pData->fs = 48000;
+    pData->blockSize = 0;
+    sarita_parameters params;
+    params.overlapPercent = 25.0f;
+    params.outputType = SARITA_OUTPUT_SH;
+    params.order = array2sh_getEncodingOrder(pData->hA2sh);
+    params.chOrdering = array2sh_getChOrder(pData->hA2sh);
+    params.norm = array2sh_getNormType(pData->hA2sh);
+    params.filterType = array2sh_getFilterType(pData->hA2sh);
+    params.regPar = array2sh_getRegPar(pData->hA2sh);
+    params.gain_dB = array2sh_getGain(pData->hA2sh);
+    params.compressionTol_dB = array2sh_getCompressionTol(pData->hA2sh);
+    params.filterbank = array2sh_getFilterbank(pData->hA2sh);
+    sarita_applyQualityPreset(&params, SARITA_QUALITY_FULL);
+    params.shiftEstimation = SARITA_SHIFT_ESTIMATION_FULL_RATE;
+    params.bandSplit = SARITA_BAND_SPLIT_OFF;
+    params.crossoverFreq = 0.0f;
+    params.upsamplingDomain = SARITA_UPSAMPLING_DOMAIN_TIME;
+    pData->parameters.reset(params);
+    pData->blockParameters = params;
+    pData->appliedParameters = params;
+
+    pData->workerExit = false;
+    pData->updateRequested = false;
+    pData->worker = std::thread(sarita_workerThread, pData);
+}
+
+void sarita_destroy
+(
+    void ** const phSar
+)
+{
+    sarita_data *pData = (sarita_data*)(*phSar);
+
+    if (pData != NULL) {
+        {
+            std::lock_guard<std::mutex> lock(pData->workerMutex);
+            pData->workerExit = true;
+        }
+        pData->workerWakeUp.notify_one();
+        pData->worker.join();
+        {
+            std::lock_guard<std::mutex> lock(pData->loadMutex);
+            sarita_swapEngine(pData, NULL);
+        }
+        array2sh_destroy(&(pData->hA2sh));
+        array2sh_destroy(&(pData->hA2shSparse));
+        delete pData;
+        *phSar = NULL;
+    }
+}
+
+void sarita_init
+(
+    void * const hSar,
+    int          samplerate,
+    int          blockSize
+)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    std::lock_guard<std::mutex> lock(pData->loadMutex);
+
+    pData->fs = samplerate;
+    array2sh_init(pData->hA2sh, samplerate);
+    array2sh_init(pData->hA2shSparse, samplerate);
+    pData->timing.requestReset();
+
+    /* the engine's frames are host blocks, so it is rebuilt for a new block
+     * size (and checked against new config limits) */
+    bool rebuild = blockSize != pData->blockSize ||
+                   memcmp(&pData->limits, &pData->engineLimits, sizeof(sarita_configLimits)) != 0;
+    if (rebuild || (pData->engine == NULL && !pData->configPath.empty())) {
+        pData->blockSize = blockSize;
+        pData->engineLimits = pData->limits;
+        if (pData->configPath.empty() || sarita_swapEngine(pData, pData->configPath.c_str()) != 0)
+            sarita_swapEngine(pData, NULL);
+    }
+
+    /* the filterbank and encoder for the new sampling rate */
+    sarita_applyParameters(pData);
+}
+
+int sarita_loadConfig
+(
+    void       * const hSar,
+    const char *       path
+)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    SARITA_TRACE_SCOPE("sarita_loadConfig", "config");
+    std::lock_guard<std::mutex> lock(pData->loadMutex);
+
+    if (path == NULL)
+        return -1;
+    if (pData->blockSize <= 0) { /* built by sarita_init() */
+        pData->configPath = path;
+        return 0;
+    }
+    if (sarita_swapEngine(pData, path) != 0)
+        return -1;
+    pData->configPath = path;
+    return 0;
+}
+
+/* pushes the first numSensors channels of a block of either planar or
+ * interleaved input to a FIFO, and skips the others */
+static void sarita_pushInput
+(
+    RingBuffer         * fifo,
+    const float *const * inputs,
+    const float        * interleavedInputs,
+    int                  inputStride,
+    int                  numSensors,
+    int                  numChannels,
+    int                  nSamples
+)
+{
+    if (interleavedInputs != NULL)
+        fifo->pushInterleaved(interleavedInputs, inputStride, numSensors, nSamples);
+    else
+        for (int ch = 0; ch < numSensors; ch++)
+            fifo->push(inputs[ch], nSamples, ch);
+    if (numSensors < numChannels)
+        fifo->skipPush(nSamples);
+}
+
+/* processes a block of either planar or interleaved input (see
+ * sarita_process() and sarita_processInterleaved()) */
+static void sarita_processBlock
+(
+    sarita_data        * pData,
+    const float *const * inputs,
+    const float        * interleavedInputs,
+    int                  inputStride,
+    float       *const * outputs,
+    int                  nInputs,
+    int                  nOutputs,
+    int                  nSamples
+)
+{
+    Sarita* engine;
+    int ch, numSensors, numSources, numFilled;
+    float crossoverFreq, minFreq, maxFreq;
+    bool bandSplit, fused;
+    void* hA2sh = pData->hA2sh;
+    void* hA2shSparse = pData->hA2shSparse;
+    const sarita_parameters& params = pData->blockParameters;
+
+    pData->timing.beginCallback();
+    SARITA_TRACE_SCOPE("sarita_process", "audio");
+
+    /* the parameters of this block: the latest ones published, if any */
+    pData->parameters.read(pData->blockParameters);
+
+    /* the engine (and array2sh) may only be used (or even read) once the
+     * loader has been told that processing is ongoing */
+    numFilled = 0;
+    pData->procStatus = PROC_STATUS_ONGOING;
+    if (pData->codecStatus == CODEC_STATUS_INITIALISED && nSamples == pData->blockSize) {
+        engine = pData->engine;
+
+        /* a new overlap; its window is precomputed, and applies from the next
+         * frame on (see Sarita::processFrames()) */
+        if (params.overlapPercent != engine->overlapPercent) {
+            engine->setOverlap(params.overlapPercent);
+            engine->updateOverlap(nSamples);
+        }
+        /* needs nothing recomputed; applies from the next frame on */
+        engine->shiftEstimation = params.shiftEstimation;
+
+        /* fill the input FIFO, and skip any sensors that are missing; all
+         * sensors of the array also go through the delay line of the
+         * time-frequency domain, whether it is used or not, so that it is
+         * always in time */
+        numSensors = SAF_MIN(engine->sparseGridSize, nInputs);
+        sarita_pushInput(engine->input, inputs, interleavedInputs, inputStride,
+                         numSensors, engine->sparseGridSize, nSamples);
+        sarita_pushInput(engine->sparseDelay, inputs, interleavedInputs, inputStride,
+                         SAF_MIN(engine->numArraySensors, nInputs), engine->numArraySensors, nSamples);
+
+        /* process frames when frame size fulfilled; in the time-frequency
+         * domain, they are only searched for their time shifts */
+        numSources = sarita_mixtureSources(pData, params);
+        fused = numSources > 0;
+        engine->setFusedDomain(fused, nSamples);
+        engine->processFrames(nSamples, numSensors);
+
+        /* the band split is made by the encoder, band by band: those below the
+         * crossover are encoded straight from the sparse array (see
+         * Sarita::computeMixing()) */
+        bandSplit = fused && sarita_bandSplit(pData, params);
+        crossoverFreq = bandSplit ? sarita_crossoverFrequency(pData, params) : 0.0f;
+        array2sh_getBandRange(hA2sh, &minFreq, &maxFreq);
+        if (minFreq != crossoverFreq) {
+            array2sh_setBandRange(hA2sh, crossoverFreq, FLT_MAX);
+            engine->invalidateMixing();
+        }
+
+        if (params.outputType == SARITA_OUTPUT_SH) {
+            if (pData->encoderBusy || array2sh_getReinitSHTmatrixFLAG(hA2sh) ||
+                array2sh_getNumMixtureSources(hA2sh) != numSources ||
+                (bandSplit && array2sh_getReinitSHTmatrixFLAG(hA2shSparse))) {
+                /* silent until the encoder has been rebuilt in the background;
+                 * the upsampled signals of this block are dropped */
+                if (engine->output->bufferedBytes >= nSamples)
+                    engine->output->skipPop(nSamples);
+                if (!pData->encoderBusy)
+                    sarita_requestUpdate(pData);
+            }
+            else {
+                /* those that need no recomputation; the channel order may
+                 * be refused until the order is 1, and is retried then */
+                if (array2sh_getChOrder(hA2sh) != params.chOrdering)
+                    array2sh_setChOrder(hA2sh, params.chOrdering);
+                if (array2sh_getNormType(hA2sh) != params.norm)
+                    array2sh_setNormType(hA2sh, params.norm);
+                if (array2sh_getGain(hA2sh) != params.gain_dB)
+                    array2sh_setGain(hA2sh, params.gain_dB);
+                if (fused ? engine->encodeFused(hA2sh, bandSplit ? hA2shSparse : NULL, outputs, nOutputs, nSamples)
+                          : engine->encodeOutput(hA2sh, outputs, nOutputs, nSamples))
+                    numFilled = nOutputs;
+            }
+        }
+        else if (engine->popOutput(outputs, nOutputs, nSamples))
+            numFilled = SAF_MIN(nOutputs, (int)engine->denseGridSize);
+
+        /* the delay line advances with the input, whether it was encoded or
+         * not */
+        engine->advanceDelay(nSamples);
+    }
+    pData->procStatus = PROC_STATUS_NOT_ONGOING;
+
+    for (ch = numFilled; ch < nOutputs; ch++)
+        memset(outputs[ch], 0, nSamples*sizeof(float));
+    pData->timing.endCallback((double)nSamples / (double)pData->fs);
+}
+
+void sarita_process
+(
+    void        *  const hSar,
+    const float *const * inputs,
+    float       *const * outputs,
+    int                  nInputs,
+    int                  nOutputs,
+    int                  nSamples
+)
+{
+    sarita_processBlock((sarita_data*)(hSar), inputs, NULL, 0, outputs, nInputs, nOutputs, nSamples);
+}
+
+void sarita_processInterleaved
+(
+    void        *  const hSar,
+    const float *        inputs,
+    int                  inputStride,
+    float       *const * outputs,
+    int                  nInputs,
+    int                  nOutputs,
+    int                  nSamples
+)
+{
+    sarita_processBlock((sarita_data*)(hSar), NULL, inputs, inputStride, outputs, nInputs, nOutputs, nSamples);
+}
+
+/* Set Functions */
+
+void sarita_setParameters(void* const hSar, const sarita_parameters* params)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    const sarita_parameters previous = pData->parameters.written();
+    sarita_parameters current = *params;
+    current.overlapPercent = (float)saritaOverlapStep(params->overlapPercent) * SARITA_OVERLAP_STEP_PERCENT;
+    pData->parameters.write(current);
+
+    /* anything that needs recomputation is left to the background thread */
+    if (params->outputType != previous.outputType ||
+        params->order != previous.order || params->filterType != previous.filterType ||
+        params->regPar != previous.regPar || params->compressionTol_dB != previous.compressionTol_dB ||
+        params->filterbank != previous.filterbank || params->pruningThreshold != previous.pruningThreshold ||
+        params->maxPruningError != previous.maxPruningError || params->bandSplit != previous.bandSplit ||
+        params->upsamplingDomain != previous.upsamplingDomain)
+        sarita_requestUpdate(pData);
+}
+
+void sarita_setOverlap(void* const hSar, float newOverlap)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    sarita_parameters params = pData->parameters.written();
+    params.overlapPercent = newOverlap;
+    sarita_setParameters(hSar, &params);
+}
+
+void sarita_setOutputType(void* const hSar, SARITA_OUTPUT_TYPES newType)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    sarita_parameters params = pData->parameters.written();
+    params.outputType = newType;
+    sarita_setParameters(hSar, &params);
+}
+
+void sarita_setShiftEstimation(void* const hSar, SARITA_SHIFT_ESTIMATION estimation)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    sarita_parameters params = pData->parameters.written();
+    params.shiftEstimation = estimation;
+    sarita_setParameters(hSar, &params);
+}
+
+void sarita_setBandSplit(void* const hSar, SARITA_BAND_SPLIT bandSplit)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    sarita_parameters params = pData->parameters.written();
+    params.bandSplit = bandSplit;
+    sarita_setParameters(hSar, &params);
+}
+
+void sarita_setUpsamplingDomain(void* const hSar, SARITA_UPSAMPLING_DOMAIN domain)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    sarita_parameters params = pData->parameters.written();
+    params.upsamplingDomain = domain;
+    sarita_setParameters(hSar, &params);
+}
+
+void sarita_setCrossoverFrequency(void* const hSar, float frequency)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    sarita_parameters params = pData->parameters.written();
+    params.crossoverFreq = frequency;
+    sarita_setParameters(hSar, &params);
+}
+
+void sarita_setQuality(void* const hSar, SARITA_QUALITY quality)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    sarita_parameters params = pData->parameters.written();
+    sarita_applyQualityPreset(&params, quality);
+    sarita_setParameters(hSar, &params);
+}
+
+void sarita_applyQualityPreset(sarita_parameters* params, SARITA_QUALITY quality)
+{
+    switch (quality) {
+        case SARITA_QUALITY_HIGH:   params->pruningThreshold = 0.01f; params->maxPruningError = 0.1f; break;
+        case SARITA_QUALITY_MEDIUM: params->pruningThreshold = 0.05f; params->maxPruningError = 0.2f; break;
+        case SARITA_QUALITY_LOW:    params->pruningThreshold = 0.1f;  params->maxPruningError = 0.3f; break;
+        case SARITA_QUALITY_FULL:
+        default:                    params->pruningThreshold = 0.0f;  params->maxPruningError = 0.0f; break;
+    }
+}
+
+void sarita_setConfigLimits(void* const hSar, const sarita_configLimits* limits)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    std::lock_guard<std::mutex> lock(pData->loadMutex);
+    pData->limits = *limits;
+    pData->limits.maxSparseSensors = SAF_CLAMP(limits->maxSparseSensors, 1, MAX_NUM_SH_SIGNALS);
+}
+
+void sarita_resetTimingStats(void* const hSar)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    pData->timing.requestReset();
+}
+
+/* Get Functions */
+
+void* sarita_getArray2shHandle(void* const hSar)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    return pData->hA2sh;
+}
+
+void sarita_getParameters(void* const hSar, sarita_parameters* params)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    *params = pData->parameters.peek();
+}
+
+void sarita_getConfigLimits(void* const hSar, sarita_configLimits* limits)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    std::lock_guard<std::mutex> lock(pData->loadMutex);
+    *limits = pData->limits;
+}
+
+size_t sarita_getMemorySize(void* const hSar)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    std::lock_guard<std::mutex> lock(pData->loadMutex);
+    return pData->engine != NULL ? pData->engine->memoryReserved() : 0;
+}
+
+float sarita_getOverlap(void* const hSar)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    return pData->parameters.peek().overlapPercent;
+}
+
+SARITA_OUTPUT_TYPES sarita_getOutputType(void* const hSar)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    return (SARITA_OUTPUT_TYPES)pData->parameters.peek().outputType;
+}
+
+SARITA_SHIFT_ESTIMATION sarita_getShiftEstimation(void* const hSar)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    return (SARITA_SHIFT_ESTIMATION)pData->parameters.peek().shiftEstimation;
+}
+
+SARITA_SHIFT_ESTIMATION sarita_getActiveShiftEstimation(void* const hSar)
+{
+#ifdef SAF_USE_APPLE_ACCELERATE
+    (void)hSar;
+    return SARITA_SHIFT_ESTIMATION_FULL_RATE;
+#else
+    return sarita_getShiftEstimation(hSar);
+#endif
+}
+
+SARITA_BAND_SPLIT sarita_getBandSplit(void* const hSar)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    return (SARITA_BAND_SPLIT)pData->parameters.peek().bandSplit;
+}
+
+SARITA_UPSAMPLING_DOMAIN sarita_getUpsamplingDomain(void* const hSar)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    return (SARITA_UPSAMPLING_DOMAIN)pData->parameters.peek().upsamplingDomain;
+}
+
+SARITA_UPSAMPLING_DOMAIN sarita_getActiveUpsamplingDomain(void* const hSar)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    if (pData->codecStatus == CODEC_STATUS_INITIALISED && pData->mixtureEncoder &&
+        sarita_fusedDomain(pData->parameters.peek()))
+        return SARITA_UPSAMPLING_DOMAIN_TIME_FREQUENCY;
+    return SARITA_UPSAMPLING_DOMAIN_TIME;
+}
+
+float sarita_getCrossoverFrequency(void* const hSar)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    if (pData->codecStatus != CODEC_STATUS_INITIALISED)
+        return 0.0f;
+    return sarita_crossoverFrequency(pData, pData->parameters.peek());
+}
+
+SARITA_QUALITY sarita_getQuality(void* const hSar)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    sarita_parameters params = pData->parameters.peek(), preset = params;
+    for (int quality = SARITA_QUALITY_FULL; quality <= SARITA_QUALITY_LOW; quality++) {
+        sarita_applyQualityPreset(&preset, (SARITA_QUALITY)quality);
+        if (preset.pruningThreshold == params.pruningThreshold && preset.maxPruningError == params.maxPruningError)
+            return (SARITA_QUALITY)quality;
+    }
+    return (SARITA_QUALITY)0;
+}
+
+CODEC_STATUS sarita_getCodecStatus(void* const hSar)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    return pData->codecStatus;
+}
+
+int sarita_getBlockSize(void* const hSar)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    return pData->blockSize;
+}
+
+int sarita_getConfigSamplingRate(void* const hSar)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    return pData->configFs;
+}
+
+int sarita_getSourceOrder(void* const hSar)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    return pData->N;
+}
+
+int sarita_getTargetOrder(void* const hSar)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    return pData->NUpsampling;
+}
+
+int sarita_getNumSparseSensors(void* const hSar)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    return pData->sparseGridSize;
+}
+
+int sarita_getNumArraySensors(void* const hSar)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    return pData->numArraySensors;
+}
+
+float sarita_getAliasingFrequency(void* const hSar)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    if (pData->codecStatus != CODEC_STATUS_INITIALISED || pData->radius <= 0.0f)
+        return 0.0f;
+    return (float)pData->N * 343.0f / (2.0f * SAF_PI * pData->radius);
+}
+
+int sarita_getNumDenseSensors(void* const hSar)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    return pData->denseGridSize;
+}
+
+int sarita_getMaxTimeShift(void* const hSar)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    return pData->maxShiftOverall;
+}
+
+int sarita_getNumCrossCorrelations(void* const hSar)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    return pData->numCrossCorrelations;
+}
+
+float sarita_getPruningErrors(void* const hSar, float* errors, int maxNumErrors)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    if (errors != NULL && maxNumErrors > 0) {
+        /* the engine is not swapped meanwhile */
+        std::lock_guard<std::mutex> lock(pData->loadMutex);
+        if (pData->engine != NULL)
+            memcpy(errors, pData->engine->pruningError, SAF_MIN(maxNumErrors, pData->denseGridSize) * sizeof(float));
+    }
+    return pData->maxPruningError;
+}
+
+int sarita_getProcessingDelay(void* const hSar)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    if (pData->codecStatus != CODEC_STATUS_INITIALISED)
+        return 0;
+    if (sarita_getOutputType(hSar) == SARITA_OUTPUT_SH)
+        return pData->blockSize + pData->maxShiftOverall + array2sh_getFilterbankProcessingDelay(pData->hA2sh);
+    return pData->blockSize + pData->maxShiftOverall;
+}
+
+int sarita_getSegmentAlignment(void* const hSar)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    int fifoLength, overlapSize, hop, a, b, t;
+    if (pData->codecStatus != CODEC_STATUS_INITIALISED)
+        return 0;
+
+    /* the FIFOs hold two blocks, and the frames advance by the block size less
+     * the overlap (as computed by Sarita::updateOverlap()) */
+    fifoLength = 2 * pData->blockSize;
+    overlapSize = saritaOverlapSize(pData->blockSize, saritaOverlapStep(sarita_getOverlap(hSar)));
+    hop = pData->blockSize - overlapSize;
+    for (a = fifoLength, b = hop; b != 0; t = a % b, a = b, b = t);
+    return fifoLength / a * hop;
+}
+
+int sarita_getWarmUpLength(void* const hSar)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    if (pData->codecStatus != CODEC_STATUS_INITIALISED)
+        return 0;
+
+    /* the input FIFO and the frame, the previous frame (overlap-add and
+     * shifted-out samples), the output FIFO and, if encoding, the filterbank */
+    return 6 * pData->blockSize + 2 * pData->maxShiftOverall +
+           (sarita_getOutputType(hSar) == SARITA_OUTPUT_SH ? 4 * array2sh_getFilterbankProcessingDelay(pData->hA2sh) : 0);
+}
+
+void sarita_getTimingStats(void* const hSar, SaritaTimingStats* stats)
+{
+    sarita_data *pData = (sarita_data*)(hSar);
+    *stats = pData->timing.getStats();
+}
+
+const char* sarita_getStageName(int stage)
+{
+    return saritaStageName(stage);
+}
+
+double sarita_getLoadBucketEdge(int bucket)
+{
+    return saritaLoadBucketEdge(bucket);
+}
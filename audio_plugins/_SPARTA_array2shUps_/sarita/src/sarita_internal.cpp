@@ -0,0 +1,1257 @@
+//
+//  sarita_internal.cpp
+//  sparta_array2sh
+//
+//  Created by Gary Grutzek on 11.05.22.
+//  Copyright © 2022 TH Köln. All rights reserved.
+
+#include "sarita_internal.h"
+
+
+//#ifdef VDSP_CONV
+//Sarita::Sarita() : logFile("~/logConv.txt"), logger(logFile, "Loggedilog", 0)
+//#else
+//Sarita::Sarita() : logFile("~/logFFT.txt"), logger(logFile, "Loggedilog", 0)
+//#endif
+Sarita::Sarita()
+{
+    #ifdef SAF_USE_APPLE_ACCELERATE // defined in projucer file
+    inputBuffer1.realp = NULL;
+    inputBuffer1.imagp = NULL;
+    inputBuffer2.realp = NULL;
+    inputBuffer2.imagp = NULL;
+    outputBuffer3.realp = NULL;
+    outputBuffer3.imagp = NULL;
+    #endif
+}
+
+/*
+* read config data from matlab workspace dump; the tables are shared with all
+* other engines of the same config
+*/
+int Sarita::readConfigFile(const char* path)
+{
+    config = SaritaRegistry::instance().acquireConfig(path);
+    if (!config)
+        return -1;
+
+    // header
+    fs = config->fs;
+    N = config->N;
+    NUpsampling = config->NUpsampling;
+    radius = config->radius;
+    denseGridSize = config->denseGridSize;
+    maxShiftOverall = config->maxShiftOverall;
+    neighborCombLength = config->neighborCombLength;
+    idxNeighborsDenseLen = config->idxNeighborsDenseLen;
+    combinationsPtrLen = config->combinationsPtrLen;
+    sparseGridSize = (int)(N+1)*(N+1);
+    numArraySensors = (int)config->numArraySensors;
+
+    // data
+    neighborCombinations = config->neighborCombinations;
+    numNeighborsDense = config->numNeighborsDense;
+    idxNeighborsDense = config->idxNeighborsDense;
+    weightsNeighborsDense = config->weightsNeighborsDense;
+    meanWeightsDense = config->weightsNeighborsDense;
+    maxShiftDense = config->maxShiftDense;
+    combinationsPtr = config->combinationsPtr;
+    denseGrid = config->denseGrid;
+
+    // calculate normalization factor
+    normFactor = (float)N/(float)NUpsampling;
+
+    // the dense grid signals are interpolated from the first sparseGridSize
+    // sensors only, so they lack the weights of the others; the low band is
+    // brought to the same level, as for a sound field equal at all sensors
+    double keptWeights = 0.0;
+    for (uint32_t dirIdx = 0; dirIdx < denseGridSize; dirIdx++)
+        for (uint32_t k = 0; k < idxNeighborsDenseLen; k++)
+            if (idxNeighborsDense[k][dirIdx] > 0 && idxNeighborsDense[k][dirIdx] <= sparseGridSize)
+                keptWeights += weightsNeighborsDense[k][dirIdx];
+    lowBandGain = normFactor * (float)(keptWeights / (double)denseGridSize);
+
+    return 0;
+}
+
+
+/*
+ *  custom window: window ramp up and down only in overlapping parts; the
+ *  ramps of all overlap steps are computed once, into the window bank (see
+ *  carveBuffers())
+ */
+void Sarita::initWindowBank(int blocksize)
+{
+    float *tmpWin = windowScratch;
+    for (int step = 1; step < SARITA_NUM_OVERLAP_STEPS; step++) {
+        int overlap = saritaOverlapSize(blocksize, step);
+        FLOATTYPE* ramps = &windowBank[windowRampOffsets[step]];
+        #ifdef SAF_USE_APPLE_ACCELERATE
+        vDSP_hann_window(tmpWin, overlap*2+1, 0);
+        #else
+        // ippsSet_32f & ippsWinHann_32f_I was added to custom saf ipp list!
+        ippsSet_32f(1, tmpWin, overlap*2+1);
+        ippsWinHann_32f_I(tmpWin, overlap*2+1);
+        #endif
+        memcpy(ramps, tmpWin, overlap * sizeof(float)); // ramp up
+        memcpy(&ramps[overlap], &tmpWin[overlap+1], overlap * sizeof(float)); // ramp down
+    }
+}
+
+#ifdef SAF_USE_APPLE_ACCELERATE
+void Sarita::setupFFT(int blocksize) 
+{
+    // the split complex buffers are carved with the others
+    log2n = log2(blocksize);
+    fftSetup = vDSP_create_fftsetup(log2n, kFFTRadix2);
+}
+
+void Sarita::fftXcorr(float* buf1, float* buf2, float* xcorr, int blocksize)
+{
+    // pack input data to split complex array 
+    vDSP_ctoz((DSPComplex *) buf1, 2, &inputBuffer1, 1, blocksize/2);
+    vDSP_ctoz((DSPComplex *) buf2, 2, &inputBuffer2, 1, blocksize/2);
+    // forward FFT
+    vDSP_fft_zrip(fftSetup, &inputBuffer1, 1, log2n, FFT_FORWARD);
+    vDSP_fft_zrip(fftSetup, &inputBuffer2, 1, log2n, FFT_FORWARD);
+    // complex conjugate
+    vDSP_zvconj(&inputBuffer1, 1, &inputBuffer1, 1, blocksize/2);
+    // multiply with complex conjugate. Can be done with last parameter == -1 as well
+    vDSP_zvmul(&inputBuffer1, 1, &inputBuffer2, 1, &outputBuffer3, 1, blocksize/2, 1);
+    // inverse fft
+    vDSP_fft_zrip(fftSetup, &outputBuffer3, 1, log2n, FFT_INVERSE);
+    // scale fft output
+    float scale = 1.f/(2.f*blocksize);
+    vDSP_vsmul(outputBuffer3.realp, 1, &scale, outputBuffer3.realp, 1, blocksize/2);
+    vDSP_vsmul(outputBuffer3.imagp, 1, &scale, outputBuffer3.imagp, 1, blocksize/2);
+    // unpack data to normal array
+    vDSP_ztoc(&outputBuffer3, 1, (DSPComplex *) xcorr, 2, blocksize/2);
+}
+#else
+/*
+ * the low-pass filter the frames are decimated with for the time shift
+ * search: a Hann-windowed sinc, with its cutoff a little below the Nyquist
+ * frequency of the decimated rate, a gain of 1 at 0 Hz, and symmetric, so
+ * that the decimated frames are not delayed
+ */
+void Sarita::initDecimationFilter()
+{
+    const double cutoff = 0.45 / SARITA_SHIFT_DECIMATION; // of the sampling rate
+    const int halfTaps = SARITA_DECIMATION_TAPS / 2;
+    double coefficients[SARITA_DECIMATION_TAPS], sum = 0.0;
+    for (int k = 0; k < SARITA_DECIMATION_TAPS; k++) {
+        const double t = (double)(k - halfTaps);
+        const double sinc = k == halfTaps ? 2.0 * cutoff : sin(2.0 * SAF_PI * cutoff * t) / (SAF_PI * t);
+        coefficients[k] = sinc * (0.5 + 0.5 * cos(SAF_PI * t / (halfTaps + 1)));
+        sum += coefficients[k];
+    }
+    for (int k = 0; k < SARITA_DECIMATION_TAPS; k++)
+        decimationFilter[k] = (float)(coefficients[k] / sum);
+}
+#endif
+
+void Sarita::deallocBuffers()
+{
+    // the buffers themselves are given up with their memory
+    sparseBuffer = NULL;
+    denseBuffer = NULL;
+    outputBuffer = NULL;
+    outData = NULL;
+    shiftBuffer = NULL;
+    xcorrBuffer = NULL;
+    xcorrMaxShift = NULL;
+    sparseScratch = NULL;
+    decimationFilter = NULL;
+    decimatedBuffer = NULL;
+    xcorrBufferPadded = NULL;
+    correlation = NULL;
+    tmpXcorrBuffer = NULL;
+    windowBank = NULL;
+    windowScratch = NULL;
+    currentTimeShift = NULL;
+    currentBlock = NULL;
+    prunedNumNeighbors = NULL;
+    prunedIdx = NULL;
+    prunedWeights = NULL;
+    prunedMeanWeights = NULL;
+    prunedMaxShift = NULL;
+    prunedCombinationsPtr = NULL;
+    prunedNeighborCombinations = NULL;
+    xcorrIndex = NULL;
+    pruningError = NULL;
+    framePositions = NULL;
+    frameRampUps = NULL;
+    frameShifts = NULL;
+    mixing = NULL;
+    shiftMixing = NULL;
+    mixingScratch = NULL;
+    phaseTable = NULL;
+    input = output = NULL;
+    sparseDelay = NULL;
+    bufferMemory.release();
+
+    // the config tables are only released; see SaritaRegistry.h
+    config.reset();
+    neighborCombinations = NULL;
+    numNeighborsDense = NULL;
+    idxNeighborsDense = NULL;
+    weightsNeighborsDense = NULL;
+    meanWeightsDense = NULL;
+    maxShiftDense = NULL;
+    combinationsPtr = NULL;
+    denseGrid = NULL;
+    
+    #ifdef SAF_USE_APPLE_ACCELERATE
+    if (fftSetup)
+        vDSP_destroy_fftsetup(fftSetup);
+    fftSetup = NULL;
+    #endif
+}
+
+sarita_configLimits Sarita::configSize() const
+{
+    sarita_configLimits size;
+    size.maxSparseSensors = numArraySensors;
+    size.maxDenseSensors = (int32_t)denseGridSize;
+    size.maxTimeShift = (int32_t)maxShiftOverall;
+    size.maxCrossCorrelations = (int32_t)config->neighborCombLength;
+    size.maxNeighbors = (int32_t)config->idxNeighborsDenseLen;
+    return size;
+}
+
+/*
+ * all buffers of the engine, in one arena; each is zeroed, and starts on a
+ * cache line of its own
+ */
+bool Sarita::carveBuffers(SaritaArena& arena, int blocksize, const sarita_configLimits& size)
+{
+    const size_t numDense = (size_t)size.maxDenseSensors;
+    const size_t maxShift = (size_t)size.maxTimeShift;
+    bufferSize = 2 * blocksize; // (2 - SARITA_OVERLAP)*blockSize;
+
+    // the windows of all overlap steps, and the scratch they are computed in
+    int numWindowSamples = 0;
+    for (int step = 0; step < SARITA_NUM_OVERLAP_STEPS; step++) {
+        windowRampOffsets[step] = numWindowSamples;
+        numWindowSamples += (2 * saritaOverlapSize(blocksize, step) + 15) & ~15;
+    }
+    windowBank = arena.alloc<FLOATTYPE>(numWindowSamples);
+    windowScratch = arena.alloc<float>(1 + 2 * saritaOverlapSize(blocksize, SARITA_NUM_OVERLAP_STEPS - 1));
+
+    #ifdef SAF_USE_APPLE_ACCELERATE
+    xcorrLen = blocksize;
+    // fft for vDSP XCorr
+    inputBuffer1.realp = arena.alloc<float>(blocksize/2);
+    inputBuffer1.imagp = arena.alloc<float>(blocksize/2);
+    inputBuffer2.realp = arena.alloc<float>(blocksize/2);
+    inputBuffer2.imagp = arena.alloc<float>(blocksize/2);
+    outputBuffer3.realp = arena.alloc<float>(blocksize);
+    outputBuffer3.imagp = arena.alloc<float>(blocksize);
+    correlation = arena.alloc<float>(xcorrLen);
+    // padded buffer for vDSP_conv
+    xcorrBufferPadded = arena.alloc<float>(blocksize - 1 + blocksize + blocksize - 1);
+    #else
+    xcorrLen = 2 * blocksize-1;
+    IppEnum funCfgNormNo = (IppEnum)(ippAlgAuto | ippsNormNone);
+    ippsCrossCorrNormGetBufferSize(blocksize, blocksize, xcorrLen, -(blocksize-1), ipp32f, funCfgNormNo, &tmpXcorrBufferSize);
+    tmpXcorrBuffer = arena.alloc<BYTETYPE>(tmpXcorrBufferSize);
+    #endif
+
+    sparseBuffer = arena.alloc2d<float>(size.maxSparseSensors, blocksize);
+    // over sized for shifted samples
+    denseBuffer = arena.alloc3d<float>(2, numDense, blocksize+maxShift*2);
+    outputBuffer = arena.alloc2d<float>(numDense, blocksize);
+    xcorrBuffer = arena.alloc2d<float>(size.maxCrossCorrelations, xcorrLen);
+    xcorrMaxShift = arena.alloc<uint8_t>(size.maxCrossCorrelations);
+    #ifndef SAF_USE_APPLE_ACCELERATE
+    decimationFilter = arena.alloc<float>(SARITA_DECIMATION_TAPS);
+    decimatedBuffer = arena.alloc2d<float>(size.maxSparseSensors, blocksize / SARITA_SHIFT_DECIMATION);
+    #endif
+    // stores samples which are shifted out of the frame
+    shiftBuffer = arena.alloc2d<float>(numDense, maxShift*2);
+    outData = arena.alloc2d<float>(numDense, blocksize);
+
+    float** inputData = arena.alloc2d<float>(size.maxSparseSensors, bufferSize);
+    float** outputData = arena.alloc2d<float>(numDense, bufferSize);
+    void* inputFifo = arena.alloc<RingBuffer>(1);
+    void* outputFifo = arena.alloc<RingBuffer>(1);
+
+    // the sparse array signals of the time-frequency domain: delayed by a
+    // block and the largest time shift, plus the block being pushed
+    const int delayLength = 2 * blocksize + (int)maxShift;
+    float** delayData = arena.alloc2d<float>(size.maxSparseSensors, delayLength);
+    void* delayFifo = arena.alloc<RingBuffer>(1);
+    sparseScratch = arena.alloc2d<float>(size.maxSparseSensors, blocksize);
+
+    currentBlock = arena.alloc<FLOATTYPE>(blocksize);
+
+    // the tables, once pruned
+    const size_t maxNeighbors = (size_t)SAF_MAX(size.maxNeighbors, 1);
+    currentTimeShift = arena.alloc<int>(maxNeighbors); // of the neighbours of one direction
+    prunedNumNeighbors = arena.alloc<uint8_t>(numDense);
+    prunedIdx = arena.alloc2d<uint8_t>(maxNeighbors, numDense);
+    prunedWeights = arena.alloc2d<float>(maxNeighbors, numDense);
+    prunedMeanWeights = arena.alloc2d<float>(maxNeighbors, numDense);
+    prunedMaxShift = arena.alloc2d<uint8_t>(SAF_MAX(maxNeighbors-1, (size_t)1), numDense);
+    prunedCombinationsPtr = arena.alloc2d<int8_t>(numDense*(maxNeighbors-1), 2);
+    prunedNeighborCombinations = arena.alloc2d<uint8_t>(size.maxCrossCorrelations, 2);
+    xcorrIndex = arena.alloc<int>(size.maxCrossCorrelations);
+    pruningError = arena.alloc<float>(numDense);
+
+    // the time-frequency domain: the time shifts of the frames that a block of
+    // sparseDelay may fall in, with the longest analysis delay of the
+    // filterbanks, and the mixing matrices of one frame
+    int analysisDelay = 0;
+    for (int filterbank = ARRAY2SH_FILTERBANK_AFSTFT_HYBRID; filterbank <= ARRAY2SH_FILTERBANK_STFT; filterbank++)
+        analysisDelay = SAF_MAX(analysisDelay, array2sh_getFilterbankAnalysisDelay((ARRAY2SH_FILTERBANKS)filterbank));
+    const int shortestHop = SAF_MAX(blocksize - saritaOverlapSize(blocksize, SARITA_NUM_OVERLAP_STEPS - 1), 1);
+    numFrameRecords = (2 * blocksize + (int)maxShift + analysisDelay) / shortestHop + 2;
+    framePositions = arena.alloc<int64_t>(numFrameRecords);
+    frameRampUps = arena.alloc<int>(numFrameRecords);
+    frameShifts = arena.alloc2d<uint16_t>(numFrameRecords, numDense * maxNeighbors);
+    const size_t mixingSize = (size_t)MAX_NUM_SH_SIGNALS * size.maxSparseSensors;
+    mixing = arena.alloc<float>(2 * ARRAY2SH_MAX_NUM_BANDS * mixingSize);
+    shiftMixing = arena.alloc<float>((2 * maxShift + 1) * mixingSize);
+    mixingScratch = arena.alloc<float>(2 * SARITA_MIXING_BANDS * mixingSize);
+    phaseTable = arena.alloc<float>(2 * ARRAY2SH_MAX_NUM_BANDS * (2 * maxShift + 1));
+    numFrames = framePosition = 0;
+    delayPosition = -(int64_t)(blocksize + maxShift);
+    mixingFrame = -1;
+    phaseBands = 0;
+
+    if (!arena.ok())
+        return false;
+    input = new (inputFifo) RingBuffer(inputData, sparseGridSize, bufferSize);
+    output = new (outputFifo) RingBuffer(outputData, (int)numDense, bufferSize);
+    sparseDelay = new (delayFifo) RingBuffer(delayData, size.maxSparseSensors, delayLength);
+    sparseDelay->skipPush(delayLength - blocksize); // silent, as the zeroed memory
+    return true;
+}
+
+size_t Sarita::memorySize(int blocksize, const sarita_configLimits& limits)
+{
+    Sarita engine;
+    SaritaArena measure;
+    engine.carveBuffers(measure, blocksize, limits);
+    return measure.size();
+}
+
+bool Sarita::allocBuffers(int blocksize)
+{
+    if (!bufferMemory.reserve(memorySize(blocksize, configSize())) ||
+        !carveBuffers(bufferMemory, blocksize, configSize()))
+        return false;
+
+    initWindowBank(blocksize);
+    #ifndef SAF_USE_APPLE_ACCELERATE
+    initDecimationFilter();
+    #endif
+    updateOverlap(blocksize);
+    prevOverlapSize = overlapSize;
+    prevOverlapStep = overlapStep;
+    #ifdef SAF_USE_APPLE_ACCELERATE
+    setupFFT(blocksize);
+    #endif
+    return true;
+}
+
+void Sarita::setOverlap(float newOverlap)
+{
+    overlapStep = saritaOverlapStep(newOverlap);
+    overlapPercent = (float)overlapStep * SARITA_OVERLAP_STEP_PERCENT;
+    overlapChanged = true;
+}
+
+void Sarita::updateOverlap(int blocksize)
+{
+    overlapSize = saritaOverlapSize(blocksize, overlapStep);
+    overlapChanged = false;
+}
+
+int Sarita::setupSarita(const char* path, int blocksize, const sarita_configLimits* limits)
+{
+    configError = true;
+    
+    deallocBuffers();
+
+    if(readConfigFile(path) < 0)
+        return -1;
+    if (limits != NULL) {
+        sarita_configLimits size = configSize();
+        if (size.maxSparseSensors > limits->maxSparseSensors || size.maxDenseSensors > limits->maxDenseSensors ||
+            size.maxTimeShift > limits->maxTimeShift || size.maxCrossCorrelations > limits->maxCrossCorrelations ||
+            size.maxNeighbors > limits->maxNeighbors)
+            return -1;
+    }
+    
+    if (!allocBuffers(blocksize) || !pruneNeighbors())
+        return -1;
+    findCorrelationWindows();
+    selectRenderKernel();
+	
+    configError = false;
+    return 0;
+}
+
+/*
+ * Pruning of the neighbours: of the neighbours of a direction (but the first,
+ * to which the time shifts of the others are relative, and which has the
+ * largest weight), those of weights below pruningThreshold are dropped, the
+ * smallest first, and the others scaled so that the weights still add up to
+ * the same. The dropped neighbours are left out of the tables altogether, so
+ * that neither their cross-correlations (unless another direction still uses
+ * them) nor their time shifts are computed. The mean time shift, to which the
+ * kept neighbours are aligned, is then that of the kept ones only (with their
+ * exported weights, meanWeightsDense), which misses those of the dropped ones.
+ * The expected error of a direction is the sum of two parts:
+ *   - that of the weights, |w - w'| / |w|, with w' the pruned and scaled
+ *     weights (0 for the dropped ones), relative to the weighted sum of
+ *     neighbour signals of equal power, once aligned; it bounds the error if
+ *     these are alike correlated with each other (from uncorrelated to equal,
+ *     for which it is 0)
+ *   - that of the alignment: the mean time shift is off by the sum of the
+ *     weighted time shifts of the dropped neighbours, of RMS value
+ *       d = sqrt(sum(w_k^2 maxShift_k^2) / 3)
+ *     samples, if these are uniform over their range. As the time shifts are
+ *     rounded, the direction is then one sample off in a share of about d of
+ *     the frames, which for a signal of flat spectrum is an RMS error of
+ *     sqrt(2 min(d, 1))
+ * The dropping stops before it would exceed maxPruningError
+ */
+bool Sarita::pruneNeighbors()
+{
+    const int maxNeighbors = (int)idxNeighborsDenseLen;
+    for (uint32_t n = 0; n < neighborCombLength; n++)
+        xcorrIndex[n] = -1;
+
+    uint32_t combinations = 0, keptCombinations = 0;
+    for (uint32_t dirIdx = 0; dirIdx < denseGridSize; dirIdx++) {
+        const int numNeighbors = numNeighborsDense[dirIdx];
+        if (numNeighbors < 1 || numNeighbors > maxNeighbors || combinations + numNeighbors - 1 > combinationsPtrLen)
+            return false;
+
+        /* the neighbours to keep; those beyond the sparse grid are not fed
+         * (see sparseGridSize), so they count with a weight of 0 */
+        bool keep[256];
+        float weights[256];
+        double sum = 0.0, sumSquares = 0.0;
+        for (int k = 0; k < numNeighbors; k++) {
+            const int idx = idxNeighborsDense[k][dirIdx];
+            const double w = weights[k] = idx > 0 && idx <= sparseGridSize ? weightsNeighborsDense[k][dirIdx] : 0.0f;
+            keep[k] = true;
+            sum += w;
+            sumSquares += w * w;
+        }
+        double keptSum = sum, keptSquares = sumSquares, droppedSquares = 0.0, shiftSquares = 0.0, error = 0.0;
+        while (pruningThreshold > 0.0f && sumSquares > 0.0) {
+            int smallest = -1;
+            for (int k = 1; k < numNeighbors; k++)
+                if (keep[k] && weights[k] < pruningThreshold && (smallest < 0 || weights[k] < weights[smallest]))
+                    smallest = k;
+            if (smallest < 0)
+                break;
+            const double w = weights[smallest];
+            if (keptSum - w <= 0.0)
+                break;
+            const double scale = sum / (keptSum - w);
+            const double weightError = sqrt((droppedSquares + w * w + (scale - 1.0) * (scale - 1.0) * (keptSquares - w * w)) / sumSquares);
+            const double meanWeightShift = (double)meanWeightsDense[smallest][dirIdx] * (double)maxShiftDense[smallest-1][dirIdx];
+            const double newShiftSquares = shiftSquares + meanWeightShift * meanWeightShift;
+            const double alignmentError = sqrt(2.0 * SAF_MIN(sqrt(newShiftSquares / 3.0), 1.0));
+            const double newError = weightError + alignmentError;
+            if (newError > maxPruningError)
+                break;
+            keep[smallest] = false;
+            keptSum -= w;
+            droppedSquares += w * w;
+            keptSquares -= w * w;
+            shiftSquares = newShiftSquares;
+            error = newError;
+        }
+        pruningError[dirIdx] = (float)error;
+
+        /* the kept neighbours, in their order; the weights of the sum are only
+         * scaled if any were dropped, so that they are otherwise the same */
+        const float scale = keptSum != sum ? (float)(sum / keptSum) : 1.0f;
+        int numKept = 0;
+        for (int k = 0; k < numNeighbors; k++) {
+            if (!keep[k])
+                continue;
+            const float w = weightsNeighborsDense[k][dirIdx];
+            prunedIdx[numKept][dirIdx] = idxNeighborsDense[k][dirIdx];
+            prunedWeights[numKept][dirIdx] = scale != 1.0f ? w * scale : w;
+            prunedMeanWeights[numKept][dirIdx] = meanWeightsDense[k][dirIdx];
+            if (k > 0) {
+                const int x = combinationsPtr[combinations + k - 1][0] - 1;
+                if (x < 0 || x >= (int)neighborCombLength)
+                    return false;
+                xcorrIndex[x] = 0; // used
+                prunedMaxShift[numKept-1][dirIdx] = maxShiftDense[k-1][dirIdx];
+                prunedCombinationsPtr[keptCombinations][0] = combinationsPtr[combinations + k - 1][0];
+                prunedCombinationsPtr[keptCombinations][1] = combinationsPtr[combinations + k - 1][1];
+                keptCombinations++;
+            }
+            numKept++;
+        }
+        prunedNumNeighbors[dirIdx] = (uint8_t)numKept;
+        combinations += numNeighbors - 1;
+    }
+
+    /* the correlations used, in their order */
+    uint32_t numCorrelations = 0;
+    for (uint32_t n = 0; n < neighborCombLength; n++) {
+        if (xcorrIndex[n] < 0)
+            continue;
+        xcorrIndex[n] = (int)numCorrelations;
+        prunedNeighborCombinations[numCorrelations][0] = neighborCombinations[n][0];
+        prunedNeighborCombinations[numCorrelations][1] = neighborCombinations[n][1];
+        numCorrelations++;
+    }
+    for (uint32_t c = 0; c < keptCombinations; c++)
+        prunedCombinationsPtr[c][0] = (int8_t)(xcorrIndex[prunedCombinationsPtr[c][0] - 1] + 1);
+
+    neighborCombinations = prunedNeighborCombinations;
+    neighborCombLength = numCorrelations;
+    numNeighborsDense = prunedNumNeighbors;
+    idxNeighborsDense = prunedIdx;
+    weightsNeighborsDense = prunedWeights;
+    meanWeightsDense = prunedMeanWeights;
+    maxShiftDense = prunedMaxShift;
+    combinationsPtr = prunedCombinationsPtr;
+    combinationsPtrLen = keptCombinations;
+    return true;
+}
+
+void Sarita::findCorrelationWindows()
+{
+    memset(xcorrMaxShift, 0, neighborCombLength * sizeof(uint8_t));
+    uint32_t neighborsIndexCounter = 0;
+    for (uint32_t dirIdx = 0; dirIdx < denseGridSize; dirIdx++) {
+        for (int nodeIndex = 1; nodeIndex < numNeighborsDense[dirIdx]; nodeIndex++) {
+            const int x = combinationsPtr[neighborsIndexCounter++][0] - 1;
+            xcorrMaxShift[x] = SAF_MAX(xcorrMaxShift[x], maxShiftDense[nodeIndex-1][dirIdx]);
+        }
+    }
+}
+
+void Sarita::updateArrayData(void* const hA2sh)
+{
+    int num_sensors = denseGridSize;
+    /* update with the new configuration  */
+    array2sh_setNumSensors(hA2sh, num_sensors);
+    for (int i=0; i<num_sensors; i++) {
+        array2sh_setSensorAzi_rad(hA2sh, i, denseGrid[0][i]);
+        array2sh_setSensorElev_rad(hA2sh, i, SAF_PI/2.0f - denseGrid[1][i]); // the config holds colatitudes
+        // TODO: set weights ?
+    }
+    
+    array2sh_setr(hA2sh, radius);
+    array2sh_setR(hA2sh, radius);
+    array2sh_setDiffEQpastAliasing(hA2sh, 0);
+    array2sh_setArrayType(hA2sh, ARRAY_SPHERICAL);
+    array2sh_setWeightType(hA2sh, WEIGHT_RIGID_OMNI);
+    array2sh_setc(hA2sh, 343.0);
+    
+//    array2sh_data *pData = (array2sh_data*)(hA2sh);
+//    array2sh_arrayPars* pars = (array2sh_arrayPars*)(pData->arraySpecs);
+//    pData->reinitSHTmatrixFLAG = 1;
+//    array2sh_setEvalStatus(hA2sh, EVAL_STATUS_NOT_EVALUATED);
+}
+
+/*
+ * the configs do not hold the directions of the sparse array sensors; but the
+ * arrays they are exported for mostly have a SAF preset, with the sensors in
+ * the same order, which is taken if its number of sensors and radius match.
+ * Otherwise, each sensor is placed at the mean direction of the dense grid
+ * sensors it is a neighbour of, weighted by the 8th power of its weights, so
+ * that the nearest ones dominate (for the arrays of the presets, this is
+ * within 4 degrees of them)
+ */
+void Sarita::updateSparseArrayData(void* const hA2shSparse)
+{
+    static const ARRAY2SH_MICROPHONE_ARRAY_PRESETS presets[] = {
+        MICROPHONE_ARRAY_PRESET_EIGENMIKE32, MICROPHONE_ARRAY_PRESET_EIGENMIKE64, MICROPHONE_ARRAY_PRESET_ZYLIA_1D
+    };
+    for (ARRAY2SH_MICROPHONE_ARRAY_PRESETS preset : presets) {
+        array2sh_setPreset(hA2shSparse, preset);
+        if (array2sh_getNumSensors(hA2shSparse) == numArraySensors &&
+            fabsf(array2sh_getr(hA2shSparse) - radius) < 0.5e-3f)
+            return;
+    }
+
+    array2sh_setNumSensors(hA2shSparse, numArraySensors);
+    for (int sensor = 0; sensor < numArraySensors; sensor++) {
+        double direction[3] = { 0.0, 0.0, 0.0 };
+        for (uint32_t dirIdx = 0; dirIdx < denseGridSize; dirIdx++) {
+            for (int k = 0; k < config->numNeighborsDense[dirIdx]; k++) {
+                if (config->idxNeighborsDense[k][dirIdx] != sensor + 1)
+                    continue;
+                const double weight = pow((double)config->weightsNeighborsDense[k][dirIdx], 8.0);
+                const double azi = denseGrid[0][dirIdx], colatitude = denseGrid[1][dirIdx];
+                direction[0] += weight * cos(azi) * sin(colatitude);
+                direction[1] += weight * sin(azi) * sin(colatitude);
+                direction[2] += weight * cos(colatitude);
+            }
+        }
+        const double horizontal = sqrt(direction[0] * direction[0] + direction[1] * direction[1]);
+        array2sh_setSensorAzi_rad(hA2shSparse, sensor, (float)atan2(direction[1], direction[0]));
+        array2sh_setSensorElev_rad(hA2shSparse, sensor, (float)atan2(direction[2], horizontal));
+    }
+    array2sh_setr(hA2shSparse, radius);
+    array2sh_setR(hA2shSparse, radius);
+    array2sh_setArrayType(hA2shSparse, ARRAY_SPHERICAL);
+    array2sh_setWeightType(hA2shSparse, WEIGHT_RIGID_OMNI);
+    array2sh_setc(hA2shSparse, 343.0);
+}
+
+/*
+ * process all frames that are available in the input ringbuffer
+ * overlap-add them and write to output ringbuffer
+ */
+void Sarita::processFrames (int blocksize, int numInputChannels)
+{
+    while (input->bufferedBytes >= blocksize) { // TODO: independent buffer size
+        // process frame for all channels, and if not enough input channels do skip
+        processFrame(blocksize, numInputChannels);
+        if (numInputChannels < sparseGridSize) {
+            input->skipPop(blocksize);
+        }
+        framePosition += numInputChannels < sparseGridSize ? blocksize : blocksize - overlapSize;
+        numFrames++;
+
+        // the dense grid signals are not formed in the time-frequency domain;
+        // the output FIFO only keeps time (see encodeFused())
+        if (fusedDomain) {
+            output->skipPush(blocksize - overlapSize);
+            prevOverlapSize = overlapSize;
+            prevOverlapStep = overlapStep;
+            bufferNum ^= 1;
+            continue;
+        }
+
+        SaritaStageClock clock(*timing);
+        SARITA_TRACE_BEGIN("overlapAdd", "audio");
+        // after an overlap switch, this frame overlaps the last one by the
+        // previous overlap, and the next one by the new one
+        int overlapIdx = SAF_MAX(blocksize-prevOverlapSize, 0);
+        for (uint32_t ch=0; ch<denseGridSize; ch++) {
+            // add overlapping part of current frame to last frame end
+            utility_svvadd(&denseBuffer[bufferNum][ch][0], &denseBuffer[!bufferNum][ch][overlapIdx], prevOverlapSize, outputBuffer[ch]);
+
+            // add out-of-frame-shifted samples to densebuffer
+            cblas_saxpy(maxShiftOverall*2, 1.f, &shiftBuffer[ch][0], 1, &denseBuffer[bufferNum][ch][prevOverlapSize], 1);
+        }
+        // copy last overlap to output ring buffer
+        for (uint32_t ch=0; ch<denseGridSize && prevOverlapSize > 0; ch++) {
+            output->push(outputBuffer[ch], prevOverlapSize, ch);
+        }
+        // copy non overlapping part to output ring buffer
+        for (uint32_t ch=0; ch<denseGridSize; ch++) {
+            output->push(&denseBuffer[bufferNum][ch][prevOverlapSize], blocksize-prevOverlapSize-overlapSize, ch);
+        }
+        prevOverlapSize = overlapSize;
+        prevOverlapStep = overlapStep;
+        bufferNum ^= 1; // swap buffer
+        SARITA_TRACE_END("overlapAdd", "audio");
+        clock.lap(SARITA_STAGE_OVERLAP_ADD);
+    }
+}
+
+bool Sarita::popOutput (float* const* outputs, int numOutputs, int blocksize)
+{
+    if (output->bufferedBytes < blocksize)
+        return false;
+
+    uint32_t numCh = (uint32_t)SAF_MIN(numOutputs, (int)denseGridSize);
+    for (uint32_t ch = 0; ch<numCh; ch++) {
+        output->pop(outputs[ch], ch, blocksize);
+    }
+    // increase read index cause not all ring buffer channels are used
+    if ((uint32_t)numOutputs < denseGridSize) {
+        output->skipPop(blocksize);
+    }
+    return true;
+}
+
+bool Sarita::encodeOutput (void* const hA2sh, float* const* outputs, int numOutputs, int blocksize)
+{
+    int hopSize = array2sh_getHopSize();
+
+    /* buffer filled and blocksize divisible by hop size */
+    if ((output->bufferedBytes < blocksize) || (blocksize % hopSize != 0))
+        return false;
+    SARITA_TRACE_SCOPE("encodeOutput", "audio");
+
+    const float* denseData = output->peek(blocksize);
+    if (denseData != nullptr) {
+        /* encode straight from the output FIFO into the caller's buffers */
+        array2sh_processStrided(hA2sh, denseData, output->channelStride(), (float**)outputs, denseGridSize, numOutputs, blocksize);
+        output->skipPop(blocksize);
+    }
+    else {
+        /* block wraps around the end of the FIFO; copy it out first */
+        for (int ch = 0; ch < (int)output->numChannels(); ch++)
+            output->pop(outData[ch], ch, blocksize);
+        array2sh_processBlock(hA2sh, outData, (float**)outputs, denseGridSize, numOutputs, blocksize);
+    }
+
+    // normalize sh transform; the encoder is linear, so this is applied to the (far fewer) SH channels
+    for (int ch = 0; ch < numOutputs; ch++) {
+#ifdef SAF_USE_APPLE_ACCELERATE
+        float value = normFactor;
+        vDSP_vsmul(outputs[ch], 1, &value, outputs[ch], 1, blocksize);
+#else
+        ippsMulC_32f_I(normFactor, outputs[ch], blocksize); // FIXME: find correct value
+#endif
+    }
+    return true;
+}
+
+void Sarita::advanceDelay (int blocksize)
+{
+    delayPosition += blocksize;
+    sparseDelay->skipPop(blocksize);
+}
+
+int64_t Sarita::frameAt (int64_t position) const
+{
+    // the dense grid signals of a frame start maxShiftOverall before its first
+    // input sample, as they are aligned (see renderDirections())
+    const int64_t oldest = SAF_MAX(numFrames - numFrameRecords, (int64_t)0);
+    for (int64_t frame = numFrames - 1; frame >= oldest; frame--) {
+        const int record = (int)(frame % numFrameRecords);
+        if (framePositions[record] + frameRampUps[record] / 2 <= position + maxShiftOverall)
+            return frame;
+    }
+    return numFrames > 0 ? oldest : -1;
+}
+
+/*
+ * the mixing matrices of a frame: the neighbours of each dense grid direction,
+ * weighted, are projected onto the SH (as the encoder projects the dense grid
+ * signals, see array2sh_getProjection()) and summed per time shift; each band
+ * then sums these, delayed by the phase of the time shift at its frequency
+ */
+void Sarita::computeMixing (void* const hA2sh, void* const hA2shSparse, int64_t frame, int nSH, int nBands)
+{
+    SARITA_TRACE_SCOPE("computeMixing", "audio");
+    const int numSources = array2sh_getNumMixtureSources(hA2sh);
+    const int numShifts = 2 * maxShiftOverall + 1;
+    const int mixingSize = nSH * numSources;
+    const float* projection = array2sh_getProjection(hA2sh);
+    mixingFrame = frame;
+    mixingSH = nSH;
+    mixingBands = nBands;
+
+    // the bands that are encoded from the dense grid (see
+    // array2sh_setBandRange()); a band split leaves those below the crossover
+    // to the encoder of the sparse array, and the others are silent
+    int numFreqs;
+    const float* freqs = array2sh_getFreqVector(hA2sh, &numFreqs);
+    float minFreq, maxFreq;
+    array2sh_getBandRange(hA2sh, &minFreq, &maxFreq);
+    int firstBand = 0, lastBand = nBands;
+    while (firstBand < nBands && freqs[firstBand] < minFreq)
+        firstBand++;
+    while (lastBand > firstBand && freqs[lastBand - 1] >= maxFreq)
+        lastBand--;
+    memset(mixing, 0, 2 * firstBand * mixingSize * sizeof(float));
+    memset(&mixing[2 * lastBand * mixingSize], 0, 2 * (nBands - lastBand) * mixingSize * sizeof(float));
+    if (hA2shSparse != NULL) {
+        int nSHSparse = array2sh_getEncodingOrder(hA2shSparse) + 1;
+        nSHSparse = SAF_MIN(nSHSparse * nSHSparse, nSH);
+        const int numSensors = SAF_MIN(array2sh_getNumSensors(hA2shSparse), numSources);
+        for (int band = 0; band < firstBand; band++) {
+            int stride;
+            const float* encoder = array2sh_getEncodingMatrix(hA2shSparse, band, &stride);
+            if (encoder == NULL)
+                break;
+            // at the level of the dense grid, as the low band of the time
+            // domain was (complex, so the real and imaginary parts together)
+            for (int ch = 0; ch < nSHSparse; ch++)
+                cblas_saxpy(2 * numSensors, lowBandGain, &encoder[2 * ch * stride], 1,
+                            &mixing[2 * (band * mixingSize + ch * numSources)], 1);
+        }
+    }
+    if (frame < 0 || projection == NULL) { // no encoder then (see mixtureEncoder)
+        memset(&mixing[2 * firstBand * mixingSize], 0, 2 * (lastBand - firstBand) * mixingSize * sizeof(float));
+        return;
+    }
+
+    // the phase of each time shift (relative to maxShiftOverall), per band
+    const int fs = array2sh_getSamplingRate(hA2sh);
+    if (phaseBands != nBands || phaseFs != fs || memcmp(phaseFreqs, freqs, nBands * sizeof(float)) != 0) {
+        for (int band = 0; band < nBands; band++) {
+            const double omega = 2.0 * SAF_PI * freqs[band] / (double)fs;
+            for (int shift = 0; shift < numShifts; shift++) {
+                const double phase = omega * (double)(shift - maxShiftOverall);
+                phaseTable[(2 * band) * numShifts + shift] = (float)cos(phase);
+                phaseTable[(2 * band + 1) * numShifts + shift] = (float)-sin(phase);
+            }
+        }
+        memcpy(phaseFreqs, freqs, nBands * sizeof(float));
+        phaseBands = nBands;
+        phaseFs = fs;
+    }
+
+    // the projected neighbours of each time shift of this frame; only those of
+    // the sparse grid, as in the time domain
+    const uint16_t* frameShift = frameShifts[frame % numFrameRecords];
+    memset(shiftMixing, 0, numShifts * mixingSize * sizeof(float));
+    int lowest = numShifts, highest = -1;
+    for (uint32_t dirIdx = 0; dirIdx < denseGridSize; dirIdx++) {
+        for (int nodeIndex = 0; nodeIndex < numNeighborsDense[dirIdx]; nodeIndex++) {
+            const int idx = idxNeighborsDense[nodeIndex][dirIdx] - 1;
+            const int shift = SAF_MIN((int)frameShift[dirIdx * idxNeighborsDenseLen + nodeIndex], numShifts - 1);
+            if (idx < 0 || idx >= SAF_MIN(sparseGridSize, numSources) || weightsNeighborsDense[nodeIndex][dirIdx] == 0.0f)
+                continue;
+            const float w = weightsNeighborsDense[nodeIndex][dirIdx] * normFactor;
+            cblas_saxpy(nSH, w, &projection[dirIdx], denseGridSize, &shiftMixing[shift * mixingSize + idx], numSources);
+            lowest = SAF_MIN(lowest, shift);
+            highest = SAF_MAX(highest, shift);
+        }
+    }
+    if (highest < 0) {
+        memset(&mixing[2 * firstBand * mixingSize], 0, 2 * (lastBand - firstBand) * mixingSize * sizeof(float));
+        return;
+    }
+
+    // their sum, times the phases, of a few bands at a time; the real and
+    // imaginary parts are then interleaved
+    for (int band = firstBand; band < lastBand; band += SARITA_MIXING_BANDS) {
+        const int numChunk = SAF_MIN(lastBand - band, SARITA_MIXING_BANDS);
+        cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, 2 * numChunk, mixingSize, highest - lowest + 1, 1.0f,
+                    &phaseTable[(2 * band) * numShifts + lowest], numShifts,
+                    &shiftMixing[lowest * mixingSize], mixingSize, 0.0f,
+                    mixingScratch, mixingSize);
+        for (int i = 0; i < numChunk; i++) {
+            float* bandMixing = &mixing[2 * (band + i) * mixingSize];
+            cblas_scopy(mixingSize, &mixingScratch[(2 * i) * mixingSize], 1, bandMixing, 2);
+            cblas_scopy(mixingSize, &mixingScratch[(2 * i + 1) * mixingSize], 1, &bandMixing[1], 2);
+        }
+    }
+}
+
+bool Sarita::encodeFused (void* const hA2sh, void* const hA2shSparse, float* const* outputs, int numOutputs, int blocksize)
+{
+    const int hopSize = array2sh_getHopSize();
+
+    /* as encodeOutput(); the output FIFO only keeps time */
+    if ((output->bufferedBytes < blocksize) || (blocksize % hopSize != 0))
+        return false;
+    output->skipPop(blocksize);
+    SARITA_TRACE_SCOPE("encodeFused", "audio");
+
+    /* the block of sparseDelay (see advanceDelay()); the sensors of the
+     * sparse grid, or all those of the array for a band split */
+    const int numSources = array2sh_getNumMixtureSources(hA2sh);
+    int sourceStride = blocksize;
+    const float* sources = sparseDelay->peek(blocksize);
+    if (sources != nullptr)
+        sourceStride = sparseDelay->channelStride();
+    else {
+        for (int ch = 0; ch < numSources; ch++)
+            sparseDelay->read(sparseScratch[ch], ch, blocksize);
+        sources = sparseScratch[0];
+    }
+
+    int nSH = array2sh_getEncodingOrder(hA2sh) + 1;
+    nSH *= nSH;
+    int nBands;
+    array2sh_getFreqVector(hA2sh, &nBands);
+    const int analysisDelay = array2sh_getFilterbankAnalysisDelay((ARRAY2SH_FILTERBANKS)array2sh_getFilterbank(hA2sh));
+    for (int ch = MAX_NUM_SH_SIGNALS; ch < numOutputs; ch++)
+        memset(outputs[ch], 0, blocksize * sizeof(float));
+    numOutputs = SAF_MIN(numOutputs, MAX_NUM_SH_SIGNALS);
+
+    /* each run of time slots that fall in the same frame (as the filterbank
+     * sees them) is encoded with the mixing matrices of that frame */
+    for (int slot = 0; slot < blocksize / hopSize; ) {
+        const int64_t frame = frameAt(delayPosition + slot * hopSize + hopSize / 2 - analysisDelay);
+        int numSlots = 1;
+        while (slot + numSlots < blocksize / hopSize &&
+               frameAt(delayPosition + (slot + numSlots) * hopSize + hopSize / 2 - analysisDelay) == frame)
+            numSlots++;
+        if (frame != mixingFrame || nSH != mixingSH || nBands != mixingBands) {
+            SaritaStageClock clock(*timing);
+            computeMixing(hA2sh, hA2shSparse, frame, nSH, nBands);
+            clock.lap(SARITA_STAGE_ALIGN_SUM);
+        }
+
+        float* runOutputs[MAX_NUM_SH_SIGNALS];
+        for (int ch = 0; ch < numOutputs; ch++)
+            runOutputs[ch] = &outputs[ch][slot * hopSize];
+        array2sh_processMixture(hA2sh, &sources[slot * hopSize], sourceStride, mixing, runOutputs,
+                                numSources, numOutputs, numSlots * hopSize);
+        slot += numSlots;
+    }
+    return true;
+}
+
+void Sarita::setFusedDomain (bool fused, int blocksize)
+{
+    if (fused == fusedDomain)
+        return;
+    fusedDomain = fused;
+    invalidateMixing();
+    if (!fused) {
+        /* the frames of the time domain start from silence */
+        output->silence();
+        for (int buffer = 0; buffer < 2; buffer++)
+            for (uint32_t ch = 0; ch < denseGridSize; ch++)
+                memset(denseBuffer[buffer][ch], 0, (blocksize + 2 * maxShiftOverall) * sizeof(float));
+        for (uint32_t ch = 0; ch < denseGridSize; ch++)
+            memset(shiftBuffer[ch], 0, 2 * maxShiftOverall * sizeof(float));
+    }
+}
+
+/*
+ * process all channels of a frame
+ * read from input ringbuffer and write to denseBuffer
+ */
+void Sarita::processFrame (int blocksize, int numInputChannels)
+{
+    SARITA_TRACE_SCOPE("processFrame", "audio");
+    SaritaStageClock clock(*timing);
+    SARITA_TRACE_BEGIN("xcorr", "audio");
+
+    // apply hann window: ramp up over the overlap with the previous frame, and
+    // down over the one with the next frame (see processFrames())
+    const FLOATTYPE* rampUp = &windowBank[windowRampOffsets[prevOverlapStep]];
+    const FLOATTYPE* rampDown = &windowBank[windowRampOffsets[overlapStep] + overlapSize];
+    const int record = (int)(numFrames % numFrameRecords);
+    framePositions[record] = framePosition;
+    frameRampUps[record] = prevOverlapSize;
+    for (int ch=0; ch<numInputChannels; ch++) {
+        input->popWithOverlap(sparseBuffer[ch], ch, blocksize, overlapSize);
+        float* frameEnd = &sparseBuffer[ch][blocksize-overlapSize];
+		#ifdef SAF_USE_APPLE_ACCELERATE
+		vDSP_vmul(rampUp, 1, sparseBuffer[ch], 1, sparseBuffer[ch], 1, prevOverlapSize);
+		vDSP_vmul(rampDown, 1, frameEnd, 1, frameEnd, 1, overlapSize);
+		#else
+		if (prevOverlapSize > 0)
+		    ippsMul_32f_I(rampUp, sparseBuffer[ch], prevOverlapSize);
+		if (overlapSize > 0)
+		    ippsMul_32f_I(rampDown, frameEnd, overlapSize);
+		#endif
+    }
+
+    // in each frame the cross-correlation required for the upsampling are determined
+    uint8_t n1, n2;
+    int maxSensors = numInputChannels; // Sparse grid size not dense Grid Size!
+    #ifndef SAF_USE_APPLE_ACCELERATE
+    if (shiftEstimation == SARITA_SHIFT_ESTIMATION_DECIMATED)
+        correlateDecimated(blocksize, numInputChannels);
+    else
+    #endif
+    for (uint32_t n=0; n<neighborCombLength; n++) {
+        n1 = neighborCombinations[n][0] - 1;
+        n2 = neighborCombinations[n][1] - 1;
+        // safety limit to max num channels. TODO: Assert?
+        n1 = n1 >= maxSensors? maxSensors-1 : n1;
+        n2 = n2 >= maxSensors? maxSensors-1 : n2;
+        // cxcorr(processingBuffer[BufferNum][n1], processingBuffer[BufferNum][n2], xcorrBuffer[n], blocksize, blocksize); // cpu hog
+        #ifdef SAF_USE_APPLE_ACCELERATE
+         #ifdef VDSP_CONV
+         memset(xcorrBufferPadded, 0, (blocksize-1 + blocksize + blocksize-1)*sizeof(float));
+         // copy to padded buffer
+         cblas_scopy(blocksize, sparseBuffer[n1], 1, &xcorrBufferPadded[blocksize-1], 1);
+         // correlate with padded buffer
+         vDSP_conv(xcorrBufferPadded, 1, sparseBuffer[n2], 1, xcorrBuffer[n], 1, (xcorrLen), (blocksize)); // cpu hog at higher block sizes
+         #else
+         // vDSP_vclr(xcorrBuffer[n], 1, xcorrLen);
+        fftXcorr(sparseBuffer[n2], sparseBuffer[n1], xcorrBuffer[n], blocksize); // M1: 0.1% vs 0.9% CPU (Debug)
+         #endif
+        #else
+        IppEnum funCfgNormNo = (IppEnum)(ippAlgAuto | ippsNormNone);
+        // ipp correlates the reverse way compared to Matlab
+        ippsCrossCorrNorm_32f(sparseBuffer[n2], blocksize, sparseBuffer[n1], blocksize, xcorrBuffer[n], xcorrLen, -blocksize+1, funCfgNormNo, tmpXcorrBuffer); // performs best, switches to fft calc at higher block sizes
+        #endif
+    }
+    clock.lap(SARITA_STAGE_XCORR);
+    SARITA_TRACE_END("xcorr", "audio");
+    SARITA_TRACE_BEGIN("timeShift/alignSum", "audio");
+    
+    (this->*renderKernel)(blocksize, clock);
+    SARITA_TRACE_END("timeShift/alignSum", "audio");
+}
+
+#ifndef SAF_USE_APPLE_ACCELERATE
+/* the sum of a[i] b[i+lag] over the samples of both, i.e. the cross-correlation
+ * of ippsCrossCorrNorm_32f() at that lag */
+static inline float saritaLagProduct(const float* a, const float* b, int length, int lag)
+{
+    if (lag >= 0)
+        return cblas_sdot(length - lag, a, 1, &b[lag], 1);
+    return cblas_sdot(length + lag, &a[-lag], 1, b, 1);
+}
+
+/*
+ * the cross-correlations of a frame, at the lags the time shift search looks
+ * at only (see findCorrelationWindows()): the windowed frames are decimated,
+ * the peak of the correlation of each pair of decimated frames is searched
+ * for, and the correlation of the frames themselves is computed at a few lags
+ * around it. The lags further off are given values that fall with their
+ * distance to these, so that a direction searching fewer lags (a smaller time
+ * shift) finds the one nearest to the peak, as it would at the full rate
+ */
+void Sarita::correlateDecimated(int blocksize, int numInputChannels)
+{
+    const int factor = SARITA_SHIFT_DECIMATION;
+    const int decimatedSize = blocksize / factor;
+    const int halfTaps = SARITA_DECIMATION_TAPS / 2;
+    for (int ch = 0; ch < numInputChannels; ch++) {
+        for (int m = 0; m < decimatedSize; m++) {
+            // the filter centred on sample factor*m, over the samples of the frame
+            const int start = factor * m - halfTaps;
+            const int first = SAF_MAX(-start, 0);
+            const int last = SAF_MIN(blocksize - start, SARITA_DECIMATION_TAPS);
+            decimatedBuffer[ch][m] = cblas_sdot(last - first, &decimationFilter[first], 1, &sparseBuffer[ch][start + first], 1);
+        }
+    }
+
+    for (uint32_t n = 0; n < neighborCombLength; n++) {
+        int n1 = SAF_MIN(neighborCombinations[n][0] - 1, numInputChannels - 1);
+        int n2 = SAF_MIN(neighborCombinations[n][1] - 1, numInputChannels - 1);
+        const int maxLag = xcorrMaxShift[n];
+
+        // coarse: the peak of the decimated correlation (the first, of equal ones)
+        const int coarseMaxLag = (maxLag + factor - 1) / factor;
+        int coarsePeak = -coarseMaxLag;
+        float peak = saritaLagProduct(decimatedBuffer[n2], decimatedBuffer[n1], decimatedSize, coarsePeak);
+        for (int lag = -coarseMaxLag + 1; lag <= coarseMaxLag; lag++) {
+            const float value = saritaLagProduct(decimatedBuffer[n2], decimatedBuffer[n1], decimatedSize, lag);
+            if (value > peak) {
+                peak = value;
+                coarsePeak = lag;
+            }
+        }
+
+        // fine: the full-rate lags around it, as the full-rate correlation
+        const int centre = SAF_CLAMP(factor * coarsePeak, -maxLag, maxLag);
+        const int lowest = SAF_MAX(centre - SARITA_REFINEMENT_LAGS, -maxLag);
+        const int highest = SAF_MIN(centre + SARITA_REFINEMENT_LAGS, maxLag);
+        float* zeroLag = &xcorrBuffer[n][blocksize-1];
+        for (int lag = lowest; lag <= highest; lag++)
+            zeroLag[lag] = saritaLagProduct(sparseBuffer[n2], sparseBuffer[n1], blocksize, lag);
+        for (int lag = lowest - 1; lag >= -maxLag; lag--)
+            zeroLag[lag] = nextafterf(zeroLag[lag + 1], -FLT_MAX);
+        for (int lag = highest + 1; lag <= maxLag; lag++)
+            zeroLag[lag] = nextafterf(zeroLag[lag - 1], -FLT_MAX);
+    }
+}
+#endif
+
+/*
+ * the lag (within +-maxShift) at which a cross-correlation is largest, given
+ * its value at lag 0; if it is 'flipped' (the neighbours correlated the other
+ * way round), the lag is negated. Of equal values, the first in the order of
+ * ippsMaxIndx_32f() over the (flipped) lags wins, so the time shifts are those
+ * of searching a flipped copy. With MaxShift > 0 (and maxShift <= MaxShift),
+ * the window has a fixed length, and the lags beyond maxShift are skipped
+ */
+template <int MaxShift>
+static inline int saritaPeakLag(const float* zeroLag, int maxShift, bool flipped)
+{
+    const int windowShift = MaxShift > 0 ? MaxShift : maxShift;
+    const int direction = flipped ? -1 : 1;
+    int peakLag = -direction * maxShift;
+    float peak = zeroLag[peakLag];
+    for (int i = 0; i <= 2 * windowShift; i++) {
+        const int lag = direction * (i - windowShift);
+        if (lag >= -maxShift && lag <= maxShift && zeroLag[lag] > peak) {
+            peak = zeroLag[lag];
+            peakLag = lag;
+        }
+    }
+    return direction * peakLag;
+}
+
+/*
+ * determine the time shift of each dense grid direction from the
+ * cross-correlations of its neighbours, and align, weight and sum these into
+ * denseBuffer
+ */
+template <int MaxNeighbors, int MaxShift>
+void Sarita::renderDirections(int blocksize, SaritaStageClock& clock)
+{
+    // the time shifts of the neighbours of a direction
+    int fixedTimeShift[MaxNeighbors > 0 ? MaxNeighbors : 1];
+    int* currentTimeShift = MaxNeighbors > 0 ? fixedTimeShift : this->currentTimeShift;
+    // those of this frame's record, see frameShifts
+    uint16_t* frameShift = frameShifts[numFrames % numFrameRecords];
+
+    int neighborsIndexCounter=0; // Counter which entry in combination_ptr is to be assessed
+    for (uint32_t dirIdx=0; dirIdx<denseGridSize; dirIdx++) {
+        currentTimeShift[0] = 0;
+        float timeShiftMean = 0;
+        const int numNeighbors = numNeighborsDense[dirIdx];
+        const int numNodes = MaxNeighbors > 0 ? MaxNeighbors : numNeighbors;
+        for(int nodeIndex=1; nodeIndex<numNodes; nodeIndex++) {
+            if (nodeIndex >= numNeighbors)
+                break;
+            // correlation=correlationsFrame(:,combination_ptr(1,neighborsIndexCounter));
+            int x = combinationsPtr[neighborsIndexCounter][0] - 1;
+            uint8_t maxShift = maxShiftDense[nodeIndex-1][dirIdx];
+            #ifdef SAF_USE_APPLE_ACCELERATE
+            #ifdef VDSP_CONV
+                cblas_scopy(xcorrLen, xcorrBuffer[x], 1, correlation, 1);
+            #else
+            // manual fft shift
+            vDSP_vclr(correlation, 1, blocksize);
+            cblas_scopy(blocksize/2, &xcorrBuffer[x][blocksize/2], 1, &correlation[0], 1);
+            cblas_scopy(blocksize/2, &xcorrBuffer[x][0], 1, &correlation[blocksize/2], 1);
+            #endif
+            int reverse = 0;
+            if (combinationsPtr[neighborsIndexCounter][1] == -1) {
+                #ifdef VDSP_CONV
+                vDSP_vrvrs(correlation, 1, xcorrLen); // reverse vector
+                #else
+                vDSP_vrvrs(correlation, 1, blocksize); // reverse vector
+                reverse = 1;
+                #endif
+            }
+            neighborsIndexCounter++;
+            
+            // look for maximal value in the crosscorrelated IRs only in the relevant area
+            // correlation = correlation(frame_length-maxShift(nodeIndex-1):frame_length+maxShift(nodeIndex-1));
+            int lowestLagIdx = blocksize-maxShift-1;
+            int maxPos;
+            int shiftLen = 2*maxShift+1; // TODO: correct?
+            float maxVal;
+            vDSP_Length pos;
+            #ifdef VDSP_CONV
+            vDSP_maxvi(&correlation[lowestLagIdx], 1, &maxVal, &pos, shiftLen);
+            maxPos = (int) pos;
+            currentTimeShift[nodeIndex] = (1 + maxPos - (shiftLen + 1) / 2); // conv
+            #else
+            lowestLagIdx = blocksize/2-maxShift-1;
+//            vDSP_maxvi(correlation, 1, &maxVal, &pos, blocksize);
+            vDSP_maxvi(&correlation[lowestLagIdx], 1, &maxVal, &pos, shiftLen);
+            maxPos = (int) pos;
+//            currentTimeShift[nodeIndex] = ((int)(reverse + maxPos - blocksize/2)); // fft
+            currentTimeShift[nodeIndex] = (int)(reverse + maxPos - (shiftLen + 1) / 2); // fft
+            #endif
+            #else
+            // look for maximal value in the crosscorrelated IRs only in the
+            // relevant area, in place (rather than in a copy, flipped if need be)
+            currentTimeShift[nodeIndex] = saritaPeakLag<MaxShift>(&xcorrBuffer[x][blocksize-1], maxShift,
+                                                                  combinationsPtr[neighborsIndexCounter][1] == -1);
+            neighborsIndexCounter++;
+            #endif
+            timeShiftMean += currentTimeShift[nodeIndex] * meanWeightsDense[nodeIndex][dirIdx];
+        }
+        // the final time shift of each neighbour, as maxShiftOverall is added
+        // always positive (recorded per frame, see frameShifts)
+        uint16_t* timeShiftFinal = &frameShift[dirIdx * idxNeighborsDenseLen];
+        for (int nodeIndex=0; nodeIndex<numNeighbors; nodeIndex++) {
+            int shift = round(-timeShiftMean + currentTimeShift[nodeIndex] + maxShiftOverall);
+            timeShiftFinal[nodeIndex] = (uint16_t)((shift < 0) ? 0: shift);
+        }
+        clock.lap(SARITA_STAGE_PEAK_SEARCH);
+        if (fusedDomain)
+            continue;
+        
+        // memzero fixes crackle
+        memset(denseBuffer[bufferNum][dirIdx], 0, overlapSize);
+        
+        #ifdef SAF_USE_APPLE_ACCELERATE
+        // zero denseBuffer at beginning and end
+        vDSP_vclr(&denseBuffer[bufferNum][dirIdx][0], 1, blocksize+maxShiftOverall*2);
+//        // copy last out-of-frame samples to denseBuffer
+//        cblas_scopy(2*maxShiftOverall, shiftBuffer[dirIdx], 1, denseBuffer[bufferNum][dirIdx], 1);
+        // zero shift buffer
+        vDSP_vclr(shiftBuffer[dirIdx], 1, 2*maxShiftOverall);
+        // align every block according to the calculated time shift, weight and sum up
+        for (int nodeIndex=0; nodeIndex<numNeighbors; nodeIndex++) {
+            // currentBlock = neighborsIRs(nodeIndex, :) * weights(nodeIndex);
+            int idx = idxNeighborsDense[nodeIndex][dirIdx]-1;
+            const float w = weightsNeighborsDense[nodeIndex][dirIdx];
+            if (w == 0.0f)
+                continue; // dropped by the pruning
+            vDSP_vsmul(sparseBuffer[idx], 1, &w, currentBlock, 1, blocksize);
+
+            //drirs_upsampled(dirIndex, startTab + timeShiftFinal:endTab + timeShiftFinal) = ...
+            //drirs_upsampled(dirIndex, startTab + timeShiftFinal:endTab + timeShiftFinal) + currentBlock;
+//            if (nodeIndex == 0) {
+//                cblas_scopy(blocksize, currentBlock, 1, &denseBuffer[bufferNum][dirIdx][timeShiftFinal[nodeIndex]], 1);
+//            }
+//            else {
+                cblas_saxpy(blocksize, 1.f, currentBlock, 1, &denseBuffer[bufferNum][dirIdx][timeShiftFinal[nodeIndex]], 1);
+//            }
+        }
+
+        // save out-of-frame samples to shift buffer
+        cblas_scopy(2*maxShiftOverall, &denseBuffer[bufferNum][dirIdx][blocksize], 1, shiftBuffer[dirIdx], 1);
+        #else
+        // zero dense buffer at the end
+        ippsZero_32f(&denseBuffer[bufferNum][dirIdx][0], blocksize+maxShiftOverall*2);
+        // copy last out-of-frame samples to denseBuffer
+        // ippsCopy_32f(shiftBuffer[dirIdx], denseBuffer[bufferNum][dirIdx], maxShiftOverall);
+        // zero shift buffer
+        ippsZero_32f(shiftBuffer[dirIdx], maxShiftOverall);
+
+        // align every block according to the calculated time shift, weight and sum up
+        for (int nodeIndex=0; nodeIndex<numNeighbors; nodeIndex++) {
+            // currentBlock = neighborsIRs(nodeIndex, :) * weights(nodeIndex);
+            int idx = idxNeighborsDense[nodeIndex][dirIdx]-1;
+            float w = weightsNeighborsDense[nodeIndex][dirIdx];
+            if (w == 0.0f)
+                continue; // dropped by the pruning
+            ippsMulC_32f(sparseBuffer[idx], w, currentBlock, blocksize);
+
+           /* if (timeShiftFinal > maxShiftOverall) {
+                timeShiftFinal = maxShiftOverall;
+            }*/
+            //drirs_upsampled(dirIndex, startTab + timeShiftFinal:endTab + timeShiftFinal) = ...
+            //drirs_upsampled(dirIndex, startTab + timeShiftFinal:endTab + timeShiftFinal) + currentBlock;
+            /*if (nodeIndex == 0) {
+                ippsCopy_32f(currentBlock, &denseBuffer[bufferNum][dirIdx][timeShiftFinal], blocksize);
+            }
+            else*/
+                ippsAdd_32f_I(currentBlock, &denseBuffer[bufferNum][dirIdx][timeShiftFinal[nodeIndex]], blocksize);
+        }
+
+        // save out-of-frame samples to shift buffer
+        ippsCopy_32f(&denseBuffer[bufferNum][dirIdx][blocksize], shiftBuffer[dirIdx], 2*maxShiftOverall);
+		#endif
+        clock.lap(SARITA_STAGE_ALIGN_SUM);
+    }
+}
+
+void Sarita::selectRenderKernel()
+{
+    renderKernel = &Sarita::renderDirections<0, 0>;
+    renderKernelName = "generic";
+    #ifndef SAF_USE_APPLE_ACCELERATE // the peak search of Accelerate works on a copy
+    // the specialisations, for the configs in sarita_vst_configs/ (by the order
+    // of their sparse grid); the first that covers the config is taken
+    static const struct {
+        int maxNeighbors, maxShift;
+        RenderKernel kernel;
+        const char* name;
+    } kernels[] = {
+        { 6, 5,  &Sarita::renderDirections<6, 5>,  "6 neighbours, 5 samples" },  // N4, N6
+        { 8, 9,  &Sarita::renderDirections<8, 9>,  "8 neighbours, 9 samples" },  // N3
+        { 6, 13, &Sarita::renderDirections<6, 13>, "6 neighbours, 13 samples" }, // N7
+    };
+    if (preferGenericKernel)
+        return;
+
+    // as found in the tables (which the kernels rely on), rather than the header
+    int numNeighbors = 0, maxShift = 0;
+    for (uint32_t dirIdx = 0; dirIdx < denseGridSize; dirIdx++) {
+        numNeighbors = SAF_MAX(numNeighbors, (int)numNeighborsDense[dirIdx]);
+        for (int nodeIndex = 1; nodeIndex < (int)numNeighborsDense[dirIdx]; nodeIndex++)
+            maxShift = SAF_MAX(maxShift, (int)maxShiftDense[nodeIndex-1][dirIdx]);
+    }
+    for (const auto& k : kernels) {
+        if (numNeighbors <= k.maxNeighbors && maxShift <= k.maxShift) {
+            renderKernel = k.kernel;
+            renderKernelName = k.name;
+            return;
+        }
+    }
+    #endif
+}
+
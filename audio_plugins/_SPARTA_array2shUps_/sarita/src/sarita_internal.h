@@ -0,0 +1,592 @@
+//
+//  sarita_internal.h
+//  sparta_array2sh
+//
+//  Created by Gary Grutzek on 11.05.22.
+//  Copyright © 2022 TH Köln. All rights reserved.
+/* Pseudocode for the SARITA algorithm. L total number of frames
+ 
+ // loop over dense sampling points
+ for q = 1:Q􏰉 do
+    Calculate next neighbors ΩN and weights wN
+    Calculate maximum time shift ∆tgeom based on grid geometry
+ end for
+ 
+ for f = 1:L do // loop over all frames
+    for q = 1:Q􏰉 do  // loop over dense sampling points
+        for qN = 1:ΩN do // loop over next neighbors
+            determine time shift ∆tN by cross-correlation with restriction: ∆tN < ∆tgeom
+            calculate weighted mean time shift ∆tN = ∆tN wN
+        end for
+        
+        for qN = 0:ΩN do // loop over next neighbors
+            align Bn with ∆tN
+            sum Bn weighted with wN
+        end for
+        apply time shift with ∆tN
+    end for
+ end for
+*/
+
+#ifndef sarita_internal_h
+#define sarita_internal_h
+
+#ifdef SAF_USE_APPLE_ACCELERATE  // defined in projucer file
+	#include <Accelerate/Accelerate.h>
+	#define FLOATTYPE float
+	#define BYTETYPE uint8_t
+#else
+	#include "ipp.h"
+	#define FLOATTYPE Ipp32f
+	#define BYTETYPE Ipp8u
+#endif
+//
+#include "saf.h"           /* Main include header for SAF */
+#include "saf_externals.h" /* To also include SAF dependencies (cblas etc.) */
+#include "array2sh.h"
+#include "sarita.h"
+#include "SaritaTiming.h"
+#include "SaritaTrace.h"
+#include "SaritaInterleave.h"
+#include "SaritaRegistry.h"
+#include "SaritaTripleBuffer.h"
+#include "SaritaArena.h"
+#include <atomic>
+#include <cassert>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+
+/* Note: this is the engine behind the sarita.h API (see sarita.cpp); it is kept
+ * free of JUCE, and is only used directly by the regression tests */
+
+/* number of overlap settings, see SARITA_OVERLAP_STEP_PERCENT */
+#define SARITA_NUM_OVERLAP_STEPS ( (int)(SARITA_MAX_OVERLAP_PERCENT / SARITA_OVERLAP_STEP_PERCENT + 0.5f) + 1 )
+
+/* length of the (symmetric) low-pass filter of the decimated time shift
+ * estimation, and the full-rate lags computed on either side of its peaks */
+#define SARITA_DECIMATION_TAPS ( 8 * SARITA_SHIFT_DECIMATION + 1 )
+#define SARITA_REFINEMENT_LAGS ( SARITA_SHIFT_DECIMATION / 2 + 1 )
+
+/* bands whose mixing matrices are computed at once (see Sarita::computeMixing()) */
+#define SARITA_MIXING_BANDS ( 8 )
+
+/* the overlap step nearest to an overlap in percent */
+static inline int saritaOverlapStep(float overlapPercent)
+{
+    int step = (int)lroundf(overlapPercent / SARITA_OVERLAP_STEP_PERCENT);
+    return SAF_CLAMP(step, 0, SARITA_NUM_OVERLAP_STEPS - 1);
+}
+
+/* overlap of consecutive frames of 'blocksize' samples at an overlap step, in samples */
+static inline int saritaOverlapSize(int blocksize, int step)
+{
+    float overlapPercent = (float)step * SARITA_OVERLAP_STEP_PERCENT;
+    return (int)(blocksize * overlapPercent * 0.01);
+}
+
+//#define TEST_AUDIO_OUTPUT // Don't calc spherical harmonics, write SARITA-upsampled channels to output buffers
+//#define VDSP_CONV     // prefer vDSP_conv() over fft-based correlation when SAF_USE_ACCELERATE is defined
+
+/*
+* a multi channel vector ring buffer, in memory provided by its owner
+*/
+class RingBuffer
+{
+private:
+    float** data;
+    int readIdx, writeIdx;
+    int size;
+    int channels;
+    
+public:
+    int getReadIdx() { return readIdx; }
+    int getWriteIdx() { return writeIdx; }
+    int bufferedBytes;
+    
+    int capacity() {
+        return size - bufferedBytes;
+    }
+    
+    int numChannels() {
+        return channels;
+    }
+    
+    bool empty() {
+        return bufferedBytes == 0; // writeIdx == readIdx;
+    }
+    
+    bool full() {
+        return bufferedBytes >= size;
+    }
+    
+    void reset() {
+        readIdx = writeIdx = 0;
+        bufferedBytes = 0;
+    }
+    
+    void skipPop(int len) {
+        bufferedBytes -= len;
+        readIdx += len;
+        readIdx %= size;
+    }
+    
+    // distance between the channels of the buffer, in samples
+    int channelStride() {
+        return size;
+    }
+    
+    // first channel's next len samples, if these can be read without wrap
+    // around (nullptr otherwise); other channels follow every channelStride()
+    const float* peek(int len) {
+        assert(len <= bufferedBytes);
+        if (size - readIdx >= len)
+            return &data[0][readIdx];
+        return nullptr;
+    }
+    
+    void skipPush(int len) {
+        bufferedBytes += len;
+        writeIdx += len;
+        writeIdx %= size;
+    }
+    
+    // data: channels x bufferSize samples, contiguous
+    RingBuffer(float** data, int channels, int bufferSize)
+    {
+        size = bufferSize;
+        this->channels = channels;
+        readIdx = writeIdx = 0;
+        bufferedBytes = 0;
+        this->data = data;
+    }
+    
+    void push(const float* input, int len, int ch)
+    {
+//         assert(len <= capacity());
+         assert(!full());
+         assert(len > 0);
+            if (size - writeIdx >= len) { // copy buffer to ringbuffer without wrap around
+                utility_svvcopy(input, len, &data[ch][writeIdx]);
+            }
+            else { // copy needs wrap around
+                auto numSamplesToEnd = size - writeIdx;
+                auto numSamplesAtStart = len - numSamplesToEnd;
+                utility_svvcopy(&input[0], numSamplesToEnd, &data[ch][writeIdx]);
+                utility_svvcopy(&input[numSamplesToEnd], numSamplesAtStart, &data[ch][0]);
+            }
+            if (ch == (channels-1)) { // won't work when not pushing for all channels
+                bufferedBytes += len;
+                writeIdx += len;
+                writeIdx %= size;
+            }
+    }
+    
+    // pushes len frames of the first numCh channels of interleaved input,
+    // whose frames are 'stride' samples apart
+    void pushInterleaved(const float* input, int stride, int numCh, int len)
+    {
+        assert(!full());
+        assert(len > 0);
+        int numSamplesToEnd = SAF_MIN(size - writeIdx, len);
+        saritaDeinterleave(input, stride, numCh, numSamplesToEnd, data, writeIdx);
+        if (len > numSamplesToEnd) // wrap around
+            saritaDeinterleave(&input[(size_t)numSamplesToEnd*stride], stride, numCh, len - numSamplesToEnd, data, 0);
+        if (numCh == channels) { // otherwise, see skipPush()
+            bufferedBytes += len;
+            writeIdx += len;
+            writeIdx %= size;
+        }
+    }
+    
+    // copies the next len samples of a channel, without popping them
+    void read(float* output, int ch, int len)
+    {
+        assert(len <= bufferedBytes);
+        int numSamplesFromTail = SAF_MIN(size - readIdx, len);
+        utility_svvcopy(&data[ch][readIdx], numSamplesFromTail, output);
+        if (len > numSamplesFromTail) // wrap around
+            utility_svvcopy(&data[ch][0], len - numSamplesFromTail, &output[numSamplesFromTail]);
+    }
+    
+    // silences all samples of all channels, buffered or not
+    void silence()
+    {
+        for (int ch = 0; ch < channels; ch++)
+            memset(data[ch], 0, size * sizeof(float));
+    }
+    
+    void pop(float* output, int ch, int len)
+    {
+        assert(len <= bufferedBytes);
+        assert(!empty());
+        
+        if (size - readIdx >= len) // no wrap around
+            utility_svvcopy(&data[ch][readIdx], len, output);
+        else { // copy needs wrap around
+            auto numSamplesFromTail = size - readIdx;
+            auto numSamplesFromStart = len - numSamplesFromTail;
+            utility_svvcopy(&data[ch][readIdx], numSamplesFromTail, output);
+            utility_svvcopy(&data[ch][0], numSamplesFromStart, &output[numSamplesFromTail]);
+        }
+        if (ch == (channels-1)) { // won't work when not reading all channels
+            bufferedBytes -= len;
+            readIdx += len;
+            readIdx %= size;
+        }
+    }
+    
+    void popWithOverlap(float* output, int ch, int len, int overlap)
+    {
+        assert(len <= bufferedBytes);
+        assert(!empty());
+        if (size - readIdx >= len) // no wrap around
+            utility_svvcopy(&data[ch][readIdx], len, output);
+        else { // copy needs wrap around
+            auto numSamplesFromTail = size - readIdx;
+            auto numSamplesFromStart = len - numSamplesFromTail;
+            utility_svvcopy(&data[ch][readIdx], numSamplesFromTail, output);
+            utility_svvcopy(&data[ch][0], numSamplesFromStart, &output[numSamplesFromTail]);
+        }
+        if (ch == (channels-1)) { // won't work when not reading all channels
+            bufferedBytes -= (len-overlap);
+            readIdx += (len-overlap);
+            readIdx %= size;
+        }
+    }
+};
+
+
+class Sarita
+{
+    
+public:
+    Sarita();
+   // Sarita::~Sarita() { deallocBuffers(); }
+    void processFrame (int blocksize, int numInputChannels);
+    // upsample all complete frames in the input ring buffer, and push the
+    // (overlap-added) dense grid signals to the output ring buffer
+    void processFrames (int blocksize, int numInputChannels);
+    // pop one block of upsampled dense grid signals (returns false if not
+    // enough are buffered yet)
+    bool popOutput (float* const* outputs, int numOutputs, int blocksize);
+    // encode one block of upsampled dense grid signals into (normalised)
+    // spherical harmonic signals (returns false if not enough are buffered
+    // yet, or the block size is not a multiple of the array2sh hop size)
+    bool encodeOutput (void* const hA2sh, float* const* outputs, int numOutputs, int blocksize);
+    void deallocBuffers();
+    bool allocBuffers(int blocksize);
+    // sets the overlap (rounded to a step of SARITA_OVERLAP_STEP_PERCENT),
+    // which updateOverlap() applies from the next frame on; neither allocates
+    // nor computes a window, so both may be called between any two blocks
+    void setOverlap(float newOverlap);
+    void updateOverlap(int blocksize);
+    // reads the config and allocates the buffers; -1 if it cannot be read,
+    // or exceeds 'limits' (if given)
+    int setupSarita(const char* path, int blocksize, const sarita_configLimits* limits = NULL);
+    void initWindowBank(int blocksize);
+    #ifdef SAF_USE_APPLE_ACCELERATE
+    void setupFFT(int blocksize);
+    void fftXcorr(float* buf1, float* buf2, float* xcorr, int blocksize);
+    #endif
+    int readConfigFile(const char* path);
+    
+    // copy config data to array2sh structs
+    void updateArrayData(void* const hA2sh);
+    // the sparse array, for the low band of a band split (see
+    // SARITA_BAND_SPLIT): that of the SAF preset of the same number of sensors
+    // and radius, if there is one, and otherwise estimated from the config
+    void updateSparseArrayData(void* const hA2shSparse);
+
+    // move on to the next block of the sparse array signals (see
+    // sparseDelay), after each block, whether it was encoded or not
+    void advanceDelay(int blocksize);
+
+    // the time-frequency domain upsampling (see SARITA_UPSAMPLING_DOMAIN): the
+    // frames are only searched for their time shifts, and the next block of
+    // the sparse array signals (delayed as the dense grid ones, see
+    // sparseDelay) is encoded with the mixing matrices of the frames it falls
+    // in, which are computed as they are first needed. Like encodeOutput(), it
+    // returns false if not enough frames have been processed yet, or the block
+    // size is not a multiple of the array2sh hop size; the encoder must have
+    // been set up for the mixture sources (see array2sh_setNumMixtureSources()).
+    // For a band split, the bands below the band range of hA2sh (see
+    // array2sh_setBandRange()) are encoded straight from the sparse array
+    // signals, with the encoder of hA2shSparse (NULL: no split)
+    bool encodeFused(void* const hA2sh, void* const hA2shSparse, float* const* outputs, int numOutputs, int blocksize);
+    // switches between the domains between two blocks; the dense grid signals
+    // are not formed in the time-frequency domain, so they are silent at
+    // first after a switch back
+    void setFusedDomain(bool fused, int blocksize);
+    bool fusedDomain = false;
+    // to be called whenever the encoder may have changed
+    void invalidateMixing() { mixingFrame = -1; }
+
+    // time shift search, alignment and sum of all directions of a frame (see
+    // renderDirections()); chosen by setupSarita() for the loaded config
+    typedef void (Sarita::*RenderKernel)(int blocksize, SaritaStageClock& clock);
+    RenderKernel renderKernel = NULL;
+    const char* renderKernelName = "generic";
+    bool preferGenericKernel = false; // always use the generic one (for tests)
+    void selectRenderKernel();
+
+    // see #SARITA_SHIFT_ESTIMATION; read at the start of each frame
+    int shiftEstimation = SARITA_SHIFT_ESTIMATION_FULL_RATE;
+
+    // neighbours of weights below pruningThreshold are dropped when a config
+    // is set up, as long as the expected error of their direction stays
+    // within maxPruningError (see pruneNeighbors()); none if either is 0
+    float pruningThreshold = 0.0f;
+    float maxPruningError = 0.0f;
+    // the expected relative (RMS) error of each direction due to the pruning
+    float* pruningError = NULL;
+
+    // the sizes of the loaded config (as exported, before the pruning), as limits
+    sarita_configLimits configSize() const;
+    // the memory the buffers of an engine need at most for configs within
+    // 'limits'
+    static size_t memorySize(int blocksize, const sarita_configLimits& limits);
+    // the memory of the buffers, as reserved for the loaded config
+    size_t memoryReserved() const { return bufferMemory.reserved(); }
+    
+    int bufferSize = 0;
+    int overlapSize;            // overlap with the next frame, in samples...
+    int overlapStep = 0;        // ...and as a step of SARITA_OVERLAP_STEP_PERCENT
+    int prevOverlapSize = 0;    // overlap with the previous frame (differs from
+    int prevOverlapStep = 0;    // overlapSize for one frame after a switch)
+    float overlapPercent=0.25;
+    bool overlapChanged=false;
+    
+    /* config data from MATLAB export */
+    // header
+    uint32_t fs;
+    uint32_t N;                 // order of source grid
+    uint32_t NUpsampling;       // order of target grid
+    uint32_t NRendering;        // rendering order, currently unused
+    float radius;               // radius of array
+    uint32_t denseGridSize;
+    uint32_t maxShiftOverall;
+    uint32_t neighborCombLength;   // neighborCombinations size = neighborCombLength * 2
+    uint32_t idxNeighborsDenseLen; // idxNeighborsDense array size = idxNeighborsDenseLen * dense grid size
+    uint32_t combinationsPtrLen;   // length of combinations pointer, y is always 2
+
+    // data; read-only, and shared by all engines of the same config (see
+    // SaritaRegistry.h)
+    std::shared_ptr<const SaritaConfig> config;
+    const uint8_t* const* neighborCombinations = NULL; // Array containing all combinations of nearest neighbors
+    const uint8_t* numNeighborsDense = NULL;     // Number of nearest neighbors for each sampling point
+    const uint8_t* const* idxNeighborsDense = NULL;    // Indices of neighbors of each sampling point
+    const float* const* weightsNeighborsDense = NULL;  // Weights of neighbors of each sampling point
+    const float* const* meanWeightsDense = NULL;       // Those of the mean time shift (as exported; of the kept neighbours once pruned)
+    const uint8_t* const* maxShiftDense = NULL;
+    const int8_t* const* combinationsPtr = NULL;       // Array describing which neighbors combination is required for each cross correlations
+    const float* const* denseGrid = NULL;              // Az, colatitude and weight of each target sensor
+    /* end of config data */
+	
+	// number of input channels with sensor data = (N+1)^2
+	int sparseGridSize;
+    // sensors of the sparse array (see SaritaConfig::numArraySensors)
+    int numArraySensors;
+
+    RingBuffer *input;
+    RingBuffer *output;
+    // the signals of all sensors of the sparse array, delayed by as much as
+    // the upsampling delays the dense grid ones (the block size and the
+    // largest time shift), which encodeFused() encodes
+    RingBuffer *sparseDelay = NULL;
+	float** shiftBuffer;
+
+    float** sparseBuffer = NULL; // audio of source grid
+    float*** denseBuffer = NULL; // audio of upsampled target grid
+    float** outputBuffer = NULL;
+    float** outData = NULL;
+    bool configError = true;
+    int bufferNum = 0; // double buffer 0/1
+
+    float* xcorrBufferPadded = NULL;
+
+    float normFactor;
+    // the level of the dense grid SH signals relative to those of the sparse
+    // array itself, for the low band of a band split (see readConfigFile())
+    float lowBandGain;
+    
+    // per-stage timing; see SaritaTiming.h. These are the engine's own
+    // counters, unless the owner points it to ones that outlive the engine
+    // (as sarita.cpp does, so that they carry on across config swaps)
+    SaritaTiming* timing = &ownTiming;
+    
+//    File logFile;
+//    juce::FileLogger logger;
+    
+private:
+    SaritaTiming ownTiming;
+    SaritaArena bufferMemory;   // sized for the loaded config
+
+    // assigns all buffers, for a config of the given size; false if they do
+    // not fit in 'arena' (which, if it has no memory, measures them)
+    bool carveBuffers(SaritaArena& arena, int blocksize, const sarita_configLimits& size);
+
+    // copies the neighbour tables of the config into the engine's own,
+    // without the neighbours pruned (nor their time shifts and
+    // cross-correlations); false if the tables are not consistent
+    bool pruneNeighbors();
+    // the lags each cross-correlation is searched over: up to the largest
+    // time shift of the directions that use it
+    void findCorrelationWindows();
+
+    #ifndef SAF_USE_APPLE_ACCELERATE
+    // the cross-correlations of a frame, for SARITA_SHIFT_ESTIMATION_DECIMATED
+    void initDecimationFilter();
+    void correlateDecimated(int blocksize, int numInputChannels);
+    #endif
+
+    // the kernels behind renderKernel: the specialisations are for configs of
+    // at most MaxNeighbors neighbours per direction and time shifts of at most
+    // MaxShift samples, and loop over these a fixed number of times (which the
+    // compiler unrolls); the generic kernel (0, 0) loops as far as the config
+    template <int MaxNeighbors, int MaxShift>
+    void renderDirections(int blocksize, SaritaStageClock& clock);
+    
+    // cross correlation buffersxc
+    #ifdef SAF_USE_APPLE_ACCELERATE
+    FFTSetup fftSetup = NULL;
+    vDSP_Length log2n;
+    DSPSplitComplex inputBuffer1;
+    DSPSplitComplex inputBuffer2;
+    DSPSplitComplex outputBuffer3;
+    #endif
+    
+    int xcorrLen;
+    int tmpXcorrBufferSize;
+	BYTETYPE* tmpXcorrBuffer = NULL;
+	FLOATTYPE* correlation;
+    float** xcorrBuffer;
+    uint8_t* xcorrMaxShift = NULL;  // see findCorrelationWindows()
+    float** sparseScratch = NULL;   // a block of sparseDelay, if it wraps around
+    float* decimationFilter = NULL; // SARITA_DECIMATION_TAPS
+    float** decimatedBuffer = NULL; // the decimated frames of the sparse grid
+
+    // the windows of all overlap steps, in one block: for each step, the Hann
+    // ramps up and down over the overlapping parts (the windows are 1 in
+    // between), each starting on a 64-byte boundary
+    FLOATTYPE* windowBank = NULL;
+    int windowRampOffsets[SARITA_NUM_OVERLAP_STEPS];
+    float* windowScratch = NULL;
+    int* currentTimeShift;
+	FLOATTYPE* currentBlock;
+
+    // the tables after pruneNeighbors(), which the table pointers refer to
+    // instead of the shared ones; of the kept neighbours only
+    uint8_t* prunedNumNeighbors = NULL;
+    uint8_t** prunedIdx = NULL;
+    float** prunedWeights = NULL;
+    float** prunedMeanWeights = NULL;
+    uint8_t** prunedMaxShift = NULL;
+    int8_t** prunedCombinationsPtr = NULL;
+    uint8_t** prunedNeighborCombinations = NULL;
+    int* xcorrIndex = NULL;     // the new index of each correlation, while pruning
+
+    // the time shifts of the neighbours of all directions (relative to
+    // -maxShiftOverall, as they are aligned), of the last numFrameRecords
+    // frames, with the input sample each frame starts at and its overlap with
+    // the one before; frame f is held in record f % numFrameRecords
+    int numFrameRecords = 0;
+    int64_t* framePositions = NULL;
+    int* frameRampUps = NULL;
+    uint16_t** frameShifts = NULL;   // numFrameRecords x (denseGridSize * idxNeighborsDenseLen)
+    int64_t numFrames = 0;          // processed so far
+    int64_t framePosition = 0;      // the input sample the next frame starts at
+    int64_t delayPosition = 0;      // ...and the next block of sparseDelay
+    // the latest frame whose dense grid signals start (at the middle of the
+    // overlap with the frame before) at or before an input sample; -1 if none
+    int64_t frameAt(int64_t position) const;
+
+    // the mixing matrices of encodeFused(), of one frame: nBands x nSH x
+    // the mixture sources, complex; each is the sum over the time shifts of
+    // the (weighted and projected) neighbours of each shift, times its phase.
+    // Those of the bands below the band range are the encoder of hA2shSparse
+    void computeMixing(void* const hA2sh, void* const hA2shSparse, int64_t frame, int nSH, int nBands);
+    float* mixing = NULL;
+    int64_t mixingFrame = -1;       // the frame 'mixing' holds (-1: none)
+    int mixingSH = 0, mixingBands = 0;
+    float* shiftMixing = NULL;      // (2 maxShiftOverall + 1) x nSH x the mixture sources
+    float* mixingScratch = NULL;    // the real and imaginary parts of a few bands
+    // cos and -sin of the phase of each band and time shift, interleaved per
+    // band: 2 nBands x (2 maxShiftOverall + 1), for the frequencies of the
+    // filterbank they were computed for
+    float* phaseTable = NULL;
+    float phaseFreqs[ARRAY2SH_MAX_NUM_BANDS];
+    int phaseBands = 0, phaseFs = 0;
+
+};
+
+/*
+ * main structure behind the sarita.h handle
+ */
+typedef struct _sarita_data
+{
+    /* the engine of the current config (NULL if none is loaded); only swapped
+     * while codecStatus is CODEC_STATUS_INITIALISING and no block is processed */
+    Sarita* engine;
+    void* hA2sh;                /* encodes the dense grid signals */
+    void* hA2shSparse;          /* the encoder of the sparse array, for the low band of a band split (only computed, never processed) */
+    SaritaTiming timing;        /* shared by all engines, see Sarita::timing */
+
+    /* codec and processing status (see sarita_loadConfig()) */
+    std::atomic<CODEC_STATUS> codecStatus;
+    std::atomic<PROC_STATUS> procStatus;
+    std::mutex loadMutex;       /* serialises loads and inits; never taken by sarita_process() */
+    std::string configPath;     /* last config loaded (or to be loaded by sarita_init()) */
+
+    /* the largest configs that may be loaded; each engine reserves the memory
+     * of its own config (loadMutex) */
+    sarita_configLimits limits;          /* as last set */
+    sarita_configLimits engineLimits;    /* as applied by sarita_init() */
+
+    /* properties of the current config, copied from the engine when swapped in */
+    int configFs;
+    int N;
+    int NUpsampling;
+    int sparseGridSize;
+    int numArraySensors;
+    int denseGridSize;
+    int maxShiftOverall;
+    int numCrossCorrelations;
+    float maxPruningError;
+    float radius;
+
+    /* the pruning the engine was last built with (loadMutex) */
+    float enginePruningThreshold;
+    float engineMaxPruningError;
+
+    /* user parameters; published as a whole by sarita_setParameters() (the
+     * writer), and taken over by sarita_process() (the reader) at the start
+     * of each block; any other thread only peeks at them */
+    int fs;
+    int blockSize;
+    SaritaTripleBuffer<sarita_parameters> parameters;
+    sarita_parameters blockParameters;   /* those of the current block (processing thread only) */
+    sarita_parameters appliedParameters; /* as last passed on to array2sh (loadMutex) */
+
+    /* background thread, which recomputes what the parameters are derived
+     * from (the encoder and filterbank); see sarita_applyParameters() */
+    std::thread worker;
+    std::mutex workerMutex;
+    std::condition_variable workerWakeUp;
+    bool workerExit;                     /* workerMutex */
+    std::atomic<bool> updateRequested;
+    std::atomic<bool> encoderBusy;       /* array2sh is being changed; the SH output is silent */
+    std::atomic<bool> mixtureEncoder;    /* false if the encoder has no projection (see array2sh_getProjection()), so that the time-frequency domain falls back to the time domain */
+
+} sarita_data;
+
+#endif /* sarita_internal_h */
@@ -108,6 +108,8 @@ PluginEditor::PluginEditor (PluginProcessor* ownerFilter)
     dispWindow->addItem (TRANS("Filters"), 1);
     dispWindow->addItem (TRANS("Corr"), 2);
     dispWindow->addItem (TRANS("L Diff"), 3);
+    dispWindow->addItem (TRANS("Timing"), 4);
+    dispWindow->addItem (TRANS("Grid"), 5);
     dispWindow->addListener (this);
 
     dispWindow->setBounds (721, 39, 63, 14);
@@ -164,6 +166,46 @@ PluginEditor::PluginEditor (PluginProcessor* ownerFilter)
 
     perform_SHT_btn->setBounds (240, 400, 150, 24);
 
+    compressionSlider.reset (new juce::Slider ("new slider"));
+    addAndMakeVisible (compressionSlider.get());
+    compressionSlider->setRange (-120, -10, 1);
+    compressionSlider->setSliderStyle (juce::Slider::LinearHorizontal);
+    compressionSlider->setTextBoxStyle (juce::Slider::TextBoxRight, false, 45, 20);
+    compressionSlider->setColour (juce::Slider::backgroundColourId, juce::Colour (0xff5c5d5e));
+    compressionSlider->setColour (juce::Slider::trackColourId, juce::Colour (0xff315b6d));
+    compressionSlider->addListener (this);
+
+    compressionSlider->setBounds (368, 351, 120, 16);
+
+    filterbankCB.reset (new juce::ComboBox ("new combo box"));
+    addAndMakeVisible (filterbankCB.get());
+    filterbankCB->setEditableText (false);
+    filterbankCB->setJustificationType (juce::Justification::centredLeft);
+    filterbankCB->setTextWhenNothingSelected (TRANS("afSTFT (hybrid)"));
+    filterbankCB->setTextWhenNoChoicesAvailable (TRANS("(no choices)"));
+    filterbankCB->addItem (TRANS("afSTFT (hybrid)"), 1);
+    filterbankCB->addItem (TRANS("afSTFT (low-delay)"), 2);
+    filterbankCB->addItem (TRANS("afSTFT"), 3);
+    filterbankCB->addItem (TRANS("QMF"), 4);
+    filterbankCB->addItem (TRANS("STFT"), 5);
+    filterbankCB->addListener (this);
+
+    filterbankCB->setBounds (368, 375, 120, 20);
+
+    qualityCB.reset (new juce::ComboBox ("new combo box"));
+    addAndMakeVisible (qualityCB.get());
+    qualityCB->setEditableText (false);
+    qualityCB->setJustificationType (juce::Justification::centredLeft);
+    qualityCB->setTextWhenNothingSelected (TRANS("Full quality"));
+    qualityCB->setTextWhenNoChoicesAvailable (TRANS("(no choices)"));
+    qualityCB->addItem (TRANS("Full quality"), 1);
+    qualityCB->addItem (TRANS("High quality"), 2);
+    qualityCB->addItem (TRANS("Medium quality"), 3);
+    qualityCB->addItem (TRANS("Low quality"), 4);
+    qualityCB->addListener (this);
+
+    qualityCB->setBounds (392, 402, 96, 20);
+
 
     //[UserPreSize]
     //[/UserPreSize]
@@ -176,6 +218,7 @@ PluginEditor::PluginEditor (PluginProcessor* ownerFilter)
     /* handles */
 	hVst = ownerFilter;
     hA2sh = hVst->getFXHandle();
+    hSar = hVst->getSaritaHandle();
 
     /* init OpenGL */
 #ifndef PLUGIN_EDITOR_DISABLE_OPENGL
@@ -203,6 +246,18 @@ PluginEditor::PluginEditor (PluginProcessor* ownerFilter)
     ldiffviewIncluded->setAlwaysOnTop(true);
     ldiffviewIncluded->setTopLeftPosition(228, 56);
     ldiffviewIncluded->setVisible(false);
+    diagviewIncluded.reset (new diagview(556, 209));
+    addAndMakeVisible (diagviewIncluded.get());
+    diagviewIncluded->setAlwaysOnTop(true);
+    diagviewIncluded->setTopLeftPosition(228, 56);
+    diagviewIncluded->setVisible(false);
+    diagviewIncluded->onReset = [this] { hVst->resetTimingStats(); };
+    gridviewIncluded.reset (new gridview(556, 209));
+    addAndMakeVisible (gridviewIncluded.get());
+    gridviewIncluded->setAlwaysOnTop(true);
+    gridviewIncluded->setTopLeftPosition(228, 56);
+    gridviewIncluded->setVisible(false);
+    gridviewIncluded->setArray2shHandle(hA2sh);
     dispID = SHOW_EQ;
     needScreenRefreshFLAG = true;
 
@@ -245,15 +300,11 @@ PluginEditor::PluginEditor (PluginProcessor* ownerFilter)
     for(int i=1; i<=7; i++)
         CBencodingOrder->setItemEnabled(i, (i+1)*(i+1) <= array2sh_getNumSensors(hA2sh) ? true : false);
 
-    /* sensor coord table */
-    //addAndMakeVisible (sensorCoordsVP = new Viewport ("new viewport"));
-    sensorCoordsVP.reset(new Viewport ("new viewport"));
-    addAndMakeVisible (sensorCoordsVP.get());
-    sensorCoordsView_handle = new sensorCoordsView(ownerFilter, ARRAY2SH_MAX_NUM_SENSORS, array2sh_getNumSensors(hA2sh), showDegreesInstead);
-    sensorCoordsVP->setViewedComponent (sensorCoordsView_handle);
-    sensorCoordsVP->setScrollBarsShown (true, false);
-    sensorCoordsVP->setAlwaysOnTop(true);
-    sensorCoordsVP->setBounds(24, 168, 184, 265);
+    /* sensor coord table (only the rows in view have components) */
+    sensorCoordsView_handle.reset(new sensorCoordsView(ownerFilter, ARRAY2SH_MAX_NUM_SENSORS, array2sh_getNumSensors(hA2sh), showDegreesInstead));
+    addAndMakeVisible (sensorCoordsView_handle.get());
+    sensorCoordsView_handle->setAlwaysOnTop(true);
+    sensorCoordsView_handle->setBounds(24, 168, 184, 265);
     sensorCoordsView_handle->setQ(array2sh_getNumSensors(hA2sh));
 
     /* ProgressBar */
@@ -266,14 +317,9 @@ PluginEditor::PluginEditor (PluginProcessor* ownerFilter)
     /* grab current parameter settings */
     CBencodingOrder->setSelectedId(array2sh_getEncodingOrder(hA2sh), dontSendNotification);
 
-    switch (int(hVst->sarita.overlapPercent * 10.f)) {
-        case 125: overlapCB->setSelectedId(1); break; // 12.5 %
-        default:
-        case 250: overlapCB->setSelectedId(2); break; // 25 %
-        case 500: overlapCB->setSelectedId(3); break; // 50 %
-    }
+    updateOverlapCB();
 
-	perform_SHT_btn->setToggleState (hVst->_perform_sht, juce::dontSendNotification);
+	perform_SHT_btn->setToggleState (sarita_getOutputType(hSar) == SARITA_OUTPUT_SH, juce::dontSendNotification);
 
     regAmountSlider->setRange(ARRAY2SH_MAX_GAIN_MIN_VALUE, ARRAY2SH_MAX_GAIN_MAX_VALUE, 0.01f);
     regAmountSlider->setValue(array2sh_getRegPar(hA2sh), dontSendNotification);
@@ -281,6 +327,10 @@ PluginEditor::PluginEditor (PluginProcessor* ownerFilter)
     normalisationCB->setSelectedId(array2sh_getNormType(hA2sh), dontSendNotification);
     gainSlider->setRange(ARRAY2SH_POST_GAIN_MIN_VALUE, ARRAY2SH_POST_GAIN_MAX_VALUE, 0.01f);
     gainSlider->setValue(array2sh_getGain(hA2sh), dontSendNotification);
+    compressionSlider->setRange(ARRAY2SH_COMPRESSION_TOL_MIN_VALUE, ARRAY2SH_COMPRESSION_TOL_MAX_VALUE, 1.0f);
+    compressionSlider->setValue(array2sh_getCompressionTol(hA2sh), dontSendNotification);
+    filterbankCB->setSelectedId(array2sh_getFilterbank(hA2sh), dontSendNotification);
+    qualityCB->setSelectedId(sarita_getQuality(hSar), dontSendNotification);
     showDegreesInstead = true;
     CHOrderingCB->setItemEnabled(CH_FUMA, array2sh_getEncodingOrder(hA2sh)==SH_ORDER_FIRST ? true : false);
     normalisationCB->setItemEnabled(NORM_FUMA, array2sh_getEncodingOrder(hA2sh)==SH_ORDER_FIRST ? true : false);
@@ -289,13 +339,16 @@ PluginEditor::PluginEditor (PluginProcessor* ownerFilter)
     CBencodingOrder->setTooltip("Encoding order. Note that the plug-in will require at least (order+1)^2 microphone array signals as input.");
     regAmountSlider->setTooltip("Maximum gain amplification permitted. Higher-values give a wider frequency range of usable spherical harmonic components, but at the cost of increased noise.");
     gainSlider->setTooltip("Post-gain factor (in dB).");
+    compressionSlider->setTooltip("Encoder compression tolerance (in dB). Spherical harmonic orders that contribute less than this much energy to the encoding filters of a band are dropped from that band, and the encoder is factored through the sensor-to-SH projection whenever that is cheaper and within the same tolerance. Lower values are more accurate, higher values use less CPU. The resulting per-band error and relative cost are shown after the encoder is analysed.");
+    filterbankCB->setTooltip("Time-frequency transform used for the encoding. The afSTFT (hybrid) offers the best low-frequency resolution, but has the highest latency (1536 samples); the low-delay afSTFT and the QMF bank trade some of that resolution for latency, whereas the STFT is the cheapest and has only 64 samples of latency, but applies the encoding filters with the coarse (uniform) resolution of a 256-point FFT. The reported plug-in latency is updated accordingly.");
+    qualityCB->setTooltip("Trades accuracy for CPU: the neighbours of a dense grid sensor whose weights are below 1, 5 or 10 % (High, Medium, Low) are left out, with their time shifts and the cross-correlations only they use, as long as the expected error of the sensor (of the weights, and of aligning the others to their own mean time shift) stays within 10, 20 or 30 %. The configuration is rebuilt in the background; the largest expected error is shown with the grid details.");
     filterTypeCB->setTooltip("Encoding filter design approach. Tikhonov is generally recommended as a starting point. However, Z-style may work better for Ambisonic reproduction purposes, and it can also have max_rE weights baked into the signals at the encoding stage.");
     CHOrderingCB->setTooltip("Ambisonic channel ordering convention (Note that AmbiX: ACN/SN3D).");
     normalisationCB->setTooltip("Ambisonic normalisation scheme (Note that AmbiX: ACN/SN3D).");
 //    tb_loadJSON->setTooltip("Loads microphone array sensor directions from a JSON file. The JSON file format follows the same convention as the one employed by the IEM plugin suite (https://plugins.iem.at/docs/configurationfiles/).");
 //    tb_saveJSON->setTooltip("Saves the current microphone array sensor directions to a JSON file. The JSON file format follows the same convention as the one employed by the IEM plugin suite (https://plugins.iem.at/docs/configurationfiles/).");
     textButton->setTooltip("Anlyses the performance of the currently configured microphone array, based on established objective metrics. The plug-in first simulates the microphone array and applies the current encoding matrix to it, subsequently comparing the resulting patterns with ideal spherical harmonics.");
-    dispWindow->setTooltip("Switches between the different display options. \n\nFilters: order-dependent equalisation curves, which are applied to eliminate the effect of the sphere. \n\nCorr: The spatial correlation is derived by comparing the patterns of the array responses with the patterns of ideal spherical harmonics, where '1' means they are perfect, and '0' completely uncorrelated; the spatial aliasing frequency can therefore be observed for each order, as the point where the spatial correlation tends towards 0. \n\nLdiff: The level difference is the mean level difference over all directions (diffuse level difference) between the ideal and simulated components. One can observe that higher permitted amplification limits [Max Gain (dB)] will result in noisier signals; however, this will also result in a wider frequency range of useful spherical harmonic components at each order.");
+    dispWindow->setTooltip("Switches between the different display options. \n\nFilters: order-dependent equalisation curves, which are applied to eliminate the effect of the sphere. \n\nCorr: The spatial correlation is derived by comparing the patterns of the array responses with the patterns of ideal spherical harmonics, where '1' means they are perfect, and '0' completely uncorrelated; the spatial aliasing frequency can therefore be observed for each order, as the point where the spatial correlation tends towards 0. \n\nLdiff: The level difference is the mean level difference over all directions (diffuse level difference) between the ideal and simulated components. One can observe that higher permitted amplification limits [Max Gain (dB)] will result in noisier signals; however, this will also result in a wider frequency range of useful spherical harmonic components at each order. \n\nTiming: share of the processing time spent in each stage (cross-correlation, peak search, alignment/summation, overlap-add, filterbank and encoding GEMMs), and a histogram of the callback times relative to the deadline (block size / sampling rate), where red bars are overruns. Click the panel to reset the counters. \n\nGrid: the sensor directions of the loaded config (the dense grid).");
 
     /* Plugin description */
     pluginDescription.reset (new juce::ComboBox ("new combo box"));
@@ -336,6 +389,9 @@ PluginEditor::~PluginEditor()
     overlapCB = nullptr;
     txtGrid = nullptr;
     perform_SHT_btn = nullptr;
+    compressionSlider = nullptr;
+    filterbankCB = nullptr;
+    qualityCB = nullptr;
 
 
     //[Destructor]. You can add your own custom destruction code here..
@@ -343,7 +399,8 @@ PluginEditor::~PluginEditor()
     eqviewIncluded = nullptr;
     cohviewIncluded = nullptr;
     ldiffviewIncluded = nullptr;
-    sensorCoordsVP = nullptr;
+    diagviewIncluded = nullptr;
+    gridviewIncluded = nullptr;
     sensorCoordsView_handle = nullptr;
     //[/Destructor]
 }
@@ -352,6 +409,7 @@ PluginEditor::~PluginEditor()
 void PluginEditor::paint (juce::Graphics& g)
 {
     //[UserPrePaint] Add your own custom painting code here..
+    SARITA_TRACE_SCOPE("PluginEditor::paint", "gui");
     //[/UserPrePaint]
 
     g.fillAll (juce::Colours::white);
@@ -800,6 +858,30 @@ void PluginEditor::paint (juce::Graphics& g)
                     juce::Justification::centredLeft, true);
     }
 
+    {
+        int x = 240, y = 344, width = 120, height = 30;
+        juce::String text (TRANS("Compression:"));
+        juce::Colour fillColour = juce::Colours::white;
+        //[UserPaintCustomArguments] Customize the painting arguments here..
+        //[/UserPaintCustomArguments]
+        g.setColour (fillColour);
+        g.setFont (juce::Font (15.00f, juce::Font::plain).withTypefaceStyle ("Bold"));
+        g.drawText (text, x, y, width, height,
+                    juce::Justification::centredLeft, true);
+    }
+
+    {
+        int x = 240, y = 369, width = 120, height = 30;
+        juce::String text (TRANS("Filterbank:"));
+        juce::Colour fillColour = juce::Colours::white;
+        //[UserPaintCustomArguments] Customize the painting arguments here..
+        //[/UserPaintCustomArguments]
+        g.setColour (fillColour);
+        g.setFont (juce::Font (15.00f, juce::Font::plain).withTypefaceStyle ("Bold"));
+        g.drawText (text, x, y, width, height,
+                    juce::Justification::centredLeft, true);
+    }
+
     //[UserPaint] Add your own custom painting code here..
 
 	g.setColour(Colours::white);
@@ -826,7 +908,7 @@ void PluginEditor::paint (juce::Graphics& g)
             break;
         case k_warning_NinputCH:
             g.drawText(TRANS("Insufficient number of input channels (") + String(hVst->getTotalNumInputChannels()) +
-                       TRANS("/") + String(hVst->sarita.sparseGridSize) + TRANS(")"),
+                       TRANS("/") + String(sarita_getNumSparseSensors(hSar)) + TRANS(")"),
                        getBounds().getWidth()-225, 16, 530, 11,
                        Justification::centredLeft, true);
             break;
@@ -860,20 +942,20 @@ void PluginEditor::comboBoxChanged (juce::ComboBox* comboBoxThatHasChanged)
     if (comboBoxThatHasChanged == filterTypeCB.get())
     {
         //[UserComboBoxCode_filterTypeCB] -- add your combo box handling code here..
-        array2sh_setFilterType(hA2sh, filterTypeCB->getSelectedId());
+        hVst->setParameterValue(k_filterType, (float)(filterTypeCB->getSelectedId()-1));
         needScreenRefreshFLAG = true;
         //[/UserComboBoxCode_filterTypeCB]
     }
     else if (comboBoxThatHasChanged == CHOrderingCB.get())
     {
         //[UserComboBoxCode_CHOrderingCB] -- add your combo box handling code here..
-        array2sh_setChOrder(hA2sh, CHOrderingCB->getSelectedId());
+        hVst->setParameterValue(k_channelOrder, (float)(CHOrderingCB->getSelectedId()-1));
         //[/UserComboBoxCode_CHOrderingCB]
     }
     else if (comboBoxThatHasChanged == normalisationCB.get())
     {
         //[UserComboBoxCode_normalisationCB] -- add your combo box handling code here..
-        array2sh_setNormType(hA2sh, normalisationCB->getSelectedId());
+        hVst->setParameterValue(k_normType, (float)(normalisationCB->getSelectedId()-1));
         //[/UserComboBoxCode_normalisationCB]
     }
     else if (comboBoxThatHasChanged == dispWindow.get())
@@ -887,7 +969,7 @@ void PluginEditor::comboBoxChanged (juce::ComboBox* comboBoxThatHasChanged)
     {
         //[UserComboBoxCode_CBencodingOrder] -- add your combo box handling code here..
         int newOrder = CBencodingOrder->getSelectedId();
-        array2sh_setEncodingOrder(hA2sh, newOrder);
+        hVst->setParameterValue(k_outputOrder, (float)newOrder);
         needScreenRefreshFLAG = true;
         //[/UserComboBoxCode_CBencodingOrder]
     }
@@ -898,9 +980,22 @@ void PluginEditor::comboBoxChanged (juce::ComboBox* comboBoxThatHasChanged)
         String sub = txt.upToFirstOccurrenceOf(" ", false, true);
         float val = sub.getFloatValue();
         val = jlimit(0.f, 49.f, val);
-        hVst->sarita.setOverlap(val);
+        hVst->setParameterValue(k_overlap, val);
         //[/UserComboBoxCode_overlapCB]
     }
+    else if (comboBoxThatHasChanged == filterbankCB.get())
+    {
+        //[UserComboBoxCode_filterbankCB] -- add your combo box handling code here..
+        hVst->setParameterValue(k_filterbank, (float)(filterbankCB->getSelectedId()-1));
+        needScreenRefreshFLAG = true;
+        //[/UserComboBoxCode_filterbankCB]
+    }
+    else if (comboBoxThatHasChanged == qualityCB.get())
+    {
+        //[UserComboBoxCode_qualityCB] -- add your combo box handling code here..
+        hVst->setParameterValue(k_quality, (float)(qualityCB->getSelectedId()-1));
+        //[/UserComboBoxCode_qualityCB]
+    }
 
     //[UsercomboBoxChanged_Post]
     //[/UsercomboBoxChanged_Post]
@@ -914,16 +1009,23 @@ void PluginEditor::sliderValueChanged (juce::Slider* sliderThatWasMoved)
     if (sliderThatWasMoved == regAmountSlider.get())
     {
         //[UserSliderCode_regAmountSlider] -- add your slider handling code here..
-        array2sh_setRegPar(hA2sh, (float)regAmountSlider->getValue());
+        hVst->setParameterValue(k_maxGain, (float)regAmountSlider->getValue());
         needScreenRefreshFLAG = true;
         //[/UserSliderCode_regAmountSlider]
     }
     else if (sliderThatWasMoved == gainSlider.get())
     {
         //[UserSliderCode_gainSlider] -- add your slider handling code here..
-        array2sh_setGain(hA2sh, (float)gainSlider->getValue());
+        hVst->setParameterValue(k_postGain, (float)gainSlider->getValue());
         //[/UserSliderCode_gainSlider]
     }
+    else if (sliderThatWasMoved == compressionSlider.get())
+    {
+        //[UserSliderCode_compressionSlider] -- add your slider handling code here..
+        hVst->setParameterValue(k_compressionTol, (float)compressionSlider->getValue());
+        needScreenRefreshFLAG = true;
+        //[/UserSliderCode_compressionSlider]
+    }
 
     //[UsersliderValueChanged_Post]
     //[/UsersliderValueChanged_Post]
@@ -952,8 +1054,7 @@ void PluginEditor::buttonClicked (juce::Button* buttonThatWasClicked)
             auto file = fc.getResult();
             if (file != File{}){
                 hVst->setLastDir(file.getParentDirectory());
-                hVst->newCfgFile = file;
-                hVst->sarita.wantsConfigUpdate = true;
+                hVst->loadConfiguration(file);
             }
         });
         //[/UserButtonCode_tb_loadCfg]
@@ -961,7 +1062,7 @@ void PluginEditor::buttonClicked (juce::Button* buttonThatWasClicked)
     else if (buttonThatWasClicked == perform_SHT_btn.get())
     {
         //[UserButtonCode_perform_SHT_btn] -- add your button handler code here..
-        hVst->setParameter(k_perform_sht, perform_SHT_btn.get()->getToggleState());
+        hVst->setParameterValue(k_perform_sht, perform_SHT_btn.get()->getToggleState() ? 1.0f : 0.0f);
         //[/UserButtonCode_perform_SHT_btn]
     }
 
@@ -974,42 +1075,35 @@ void PluginEditor::buttonClicked (juce::Button* buttonThatWasClicked)
 //[MiscUserCode] You can add your own definitions of your custom methods or any other code here...
 void PluginEditor::timerCallback(int timerID)
 {
+    SARITA_TRACE_THREAD_NAME("message thread");
+    SARITA_TRACE_SCOPE("PluginEditor::timerCallback", "gui");
     switch (timerID) {
         case TIMER_PROCESSING_RELATED:
             /* handled in PluginProcessor */
             break;
 
         case TIMER_GUI_RELATED: {
-			int64 pos = hVst->timeStamp;
-			int64 now = Time::currentTimeMillis();
-			// no processing since more than 100ms, safe to load config
-			if (pos < (now - 100)) {
-//				DBG("not playing: " + String(pos));
-				if (hVst->sarita.wantsConfigUpdate == true) {
-					hVst->loadConfiguration (hVst->newCfgFile);
-					hVst->sarita.wantsConfigUpdate  = false;
-				}
-			}
-
 			/* parameters whos values can change internally should be periodically refreshed */
             int curOrder = CBencodingOrder->getSelectedId();
             if (CBencodingOrder->getSelectedId() != array2sh_getEncodingOrder(hA2sh))
                 CBencodingOrder->setSelectedId(array2sh_getEncodingOrder(hA2sh), dontSendNotification);
-
-            //            // hack: force update overlap combo box => why doesn't that get updated automatically?
-            //            String ovl = overlapCB->getItemText(overlapCB->getSelectedItemIndex());
-            //            String sub = ovl.upToFirstOccurrenceOf(" ", false, true);
-            //            float val = sub.getFloatValue();
-            //            val = jlimit(0.f, 50.f, val);
-            //            if (val != hVst->sarita.overlapPercent) {
-            //                int id = 1;
-            //                if (val < 25)
-            //                    id = 0;
-            //                else if (val > 25)
-            //                    id = 2;
-            //                overlapCB->setSelectedId(id);
-            //            }
-            if (!hVst->sarita.configError) {
+            if (filterbankCB->getSelectedId() != array2sh_getFilterbank(hA2sh))
+                filterbankCB->setSelectedId(array2sh_getFilterbank(hA2sh), dontSendNotification);
+            if (qualityCB->getSelectedId() != sarita_getQuality(hSar))
+                qualityCB->setSelectedId(sarita_getQuality(hSar), dontSendNotification);
+            if (filterTypeCB->getSelectedId() != array2sh_getFilterType(hA2sh))
+                filterTypeCB->setSelectedId(array2sh_getFilterType(hA2sh), dontSendNotification);
+            if ((float)regAmountSlider->getValue() != array2sh_getRegPar(hA2sh))
+                regAmountSlider->setValue(array2sh_getRegPar(hA2sh), dontSendNotification);
+            if ((float)gainSlider->getValue() != array2sh_getGain(hA2sh))
+                gainSlider->setValue(array2sh_getGain(hA2sh), dontSendNotification);
+            if ((float)compressionSlider->getValue() != array2sh_getCompressionTol(hA2sh))
+                compressionSlider->setValue(array2sh_getCompressionTol(hA2sh), dontSendNotification);
+            if (perform_SHT_btn->getToggleState() != (sarita_getOutputType(hSar) == SARITA_OUTPUT_SH))
+                perform_SHT_btn->setToggleState(sarita_getOutputType(hSar) == SARITA_OUTPUT_SH, dontSendNotification);
+
+            updateOverlapCB();
+            if (sarita_getCodecStatus(hSar) == CODEC_STATUS_INITIALISED) {
                 sensorCoordsView_handle->setQ(array2sh_getNumSensors(hA2sh));
                 if (CHOrderingCB->getSelectedId() != array2sh_getChOrder(hA2sh))
                     CHOrderingCB->setSelectedId(array2sh_getChOrder(hA2sh), dontSendNotification);
@@ -1033,8 +1127,8 @@ void PluginEditor::timerCallback(int timerID)
                     regAmountSlider->setEnabled(false);
                 if (CBencodingOrder->isEnabled())
                     CBencodingOrder->setEnabled(false);
-                if (sensorCoordsVP->isEnabled())
-                    sensorCoordsVP->setEnabled(false);
+                if (sensorCoordsView_handle->isEnabled())
+                    sensorCoordsView_handle->setEnabled(false);
             }
             else {
                 if (!filterTypeCB->isEnabled())
@@ -1043,8 +1137,8 @@ void PluginEditor::timerCallback(int timerID)
                     regAmountSlider->setEnabled(true);
                 if (!CBencodingOrder->isEnabled())
                     CBencodingOrder->setEnabled(true);
-                if (!sensorCoordsVP->isEnabled())
-                    sensorCoordsVP->setEnabled(true);
+                if (!sensorCoordsView_handle->isEnabled())
+                    sensorCoordsView_handle->setEnabled(true);
             }
 
             /* draw magnitude/spatial-correlation/level-difference curves */
@@ -1056,15 +1150,17 @@ void PluginEditor::timerCallback(int timerID)
                     eqviewIncluded->setVisible(true);
                     cohviewIncluded->setVisible(false);
                     ldiffviewIncluded->setVisible(false);
-                    eqviewIncluded->repaint();
+                    diagviewIncluded->setVisible(false);
+                    gridviewIncluded->setVisible(false);
                     break;
                 case SHOW_SPATIAL_COH:
                     eqviewIncluded->setVisible(false);
                     ldiffviewIncluded->setVisible(false);
+                    diagviewIncluded->setVisible(false);
+                    gridviewIncluded->setVisible(false);
                     if ((array2sh_getEvalStatus(hA2sh) == EVAL_STATUS_EVALUATED)) {
                         cohviewIncluded->setNumCurves(array2sh_getEncodingOrder(hA2sh) + 1);
                         cohviewIncluded->setVisible(true);
-                        cohviewIncluded->repaint();
                     }
                     else
                         cohviewIncluded->setVisible(false);
@@ -1072,18 +1168,54 @@ void PluginEditor::timerCallback(int timerID)
                 case SHOW_LEVEL_DIFF:
                     eqviewIncluded->setVisible(false);
                     cohviewIncluded->setVisible(false);
+                    diagviewIncluded->setVisible(false);
+                    gridviewIncluded->setVisible(false);
                     if ((array2sh_getEvalStatus(hA2sh) == EVAL_STATUS_EVALUATED)) {
                         ldiffviewIncluded->setNumCurves(array2sh_getEncodingOrder(hA2sh) + 1);
                         ldiffviewIncluded->setVisible(true);
-                        ldiffviewIncluded->repaint();
                     }
                     else
                         ldiffviewIncluded->setVisible(false);
                     break;
+                case SHOW_DIAGNOSTICS:
+                    eqviewIncluded->setVisible(false);
+                    cohviewIncluded->setVisible(false);
+                    ldiffviewIncluded->setVisible(false);
+                    diagviewIncluded->setVisible(true);
+                    gridviewIncluded->setVisible(false);
+                    break;
+                case SHOW_GRID:
+                    eqviewIncluded->setVisible(false);
+                    cohviewIncluded->setVisible(false);
+                    ldiffviewIncluded->setVisible(false);
+                    diagviewIncluded->setVisible(false);
+                    gridviewIncluded->setVisible(true);
+                    gridviewIncluded->refreshGrid();
+                    break;
                 }
                 needScreenRefreshFLAG = false;
             }
 
+            /* the curves are only redrawn once they have been recomputed */
+            if (!array2sh_getReinitSHTmatrixFLAG(hA2sh)) {
+                if (eqviewIncluded->isVisible())
+                    eqviewIncluded->setCurvesVersion(array2sh_getbNVersion(hA2sh));
+                if (cohviewIncluded->isVisible())
+                    cohviewIncluded->setCurvesVersion(array2sh_getEvalVersion(hA2sh));
+                if (ldiffviewIncluded->isVisible())
+                    ldiffviewIncluded->setCurvesVersion(array2sh_getEvalVersion(hA2sh));
+            }
+
+            /* the timing counters change with every callback */
+            if (dispID == SHOW_DIAGNOSTICS && diagviewIncluded->isVisible()) {
+                diagviewIncluded->setStats(hVst->getTimingStats());
+                diagviewIncluded->repaint();
+            }
+
+            /* the grid changes with the config; redrawn only if it did */
+            if (dispID == SHOW_GRID && gridviewIncluded->isVisible())
+                gridviewIncluded->refreshGrid();
+
             /* Progress bar */
             if (array2sh_getEvalStatus(hA2sh) == EVAL_STATUS_EVALUATING) {
                 addAndMakeVisible(progressbar);
@@ -1099,32 +1231,32 @@ void PluginEditor::timerCallback(int timerID)
             for (int i = 1; i <= 7; i++)
                 CBencodingOrder->setItemEnabled(i, (i + 1) * (i + 1) <= array2sh_getNumSensors(hA2sh) ? true : false);
 
-            /* display warning message, if needed */
-            if ((hVst->getCurrentBlockSize() % array2sh_getFrameSize()) != 0) {
-                currentWarning = k_warning_frameSize;
-                repaint(0, 0, getWidth(), 32);
-            }
-            else if (!((array2sh_getSamplingRate(hA2sh) == 44.1e3) || (array2sh_getSamplingRate(hA2sh) == 48e3))) {
-                currentWarning = k_warning_supported_fs;
-                repaint(0, 0, getWidth(), 32);
-            }
-            else if ((hVst->getCurrentNumInputs() < (hVst->sarita.sparseGridSize) /*array2sh_getNumSensors(hA2sh)*/)) {
-                currentWarning = k_warning_NinputCH;
-                repaint(0, 0, getWidth(), 32);
-            }
-            else if ((hVst->getCurrentNumOutputs() < array2sh_getNSHrequired(hA2sh))) {
-                currentWarning = k_warning_NoutputCH;
-                repaint(0, 0, getWidth(), 32);
-            }
-            else if (currentWarning) {
-                currentWarning = k_warning_none;
+            /* display warning message, if needed (repainted only if it has changed) */
+            SPARTA_WARNINGS newWarning = k_warning_none;
+            if ((hVst->getCurrentBlockSize() % array2sh_getFrameSize()) != 0)
+                newWarning = k_warning_frameSize;
+            else if (!((array2sh_getSamplingRate(hA2sh) == 44.1e3) || (array2sh_getSamplingRate(hA2sh) == 48e3)))
+                newWarning = k_warning_supported_fs;
+            else if ((hVst->getCurrentNumInputs() < sarita_getNumSparseSensors(hSar) /*array2sh_getNumSensors(hA2sh)*/))
+                newWarning = k_warning_NinputCH;
+            else if ((hVst->getCurrentNumOutputs() < array2sh_getNSHrequired(hA2sh)))
+                newWarning = k_warning_NoutputCH;
+            if (newWarning != currentWarning) {
+                currentWarning = newWarning;
                 repaint(0, 0, getWidth(), 32);
             }
 			
-			if (hVst->sarita.configError == false) { // needScreenRefreshFLAG &&
-				auto txt = "Source Grid Order: " + String(hVst->sarita.N) + "\n";
-				txt.append("Target Grid Order: " + String(hVst->sarita.NUpsampling) + "\n", 64);
-				txt.append("Number of Sensors: " + String(hVst->sarita.denseGridSize) + "\n", 64);
+			if (sarita_getCodecStatus(hSar) == CODEC_STATUS_INITIALISED) { // needScreenRefreshFLAG &&
+				auto txt = "Source Grid Order: " + String(sarita_getSourceOrder(hSar)) + "\n";
+				txt.append("Target Grid Order: " + String(sarita_getTargetOrder(hSar)) + "\n", 64);
+				txt.append("Number of Sensors: " + String(sarita_getNumDenseSensors(hSar)) + "\n", 64);
+				if (sarita_getPruningErrors(hSar, NULL, 0) > 0.0f)
+					txt.append("Max. Pruning Error: " + String(100.0f * sarita_getPruningErrors(hSar, NULL, 0), 1) + " %\n", 64);
+				if (sarita_getOutputType(hSar) == SARITA_OUTPUT_SH &&
+				    sarita_getActiveUpsamplingDomain(hSar) != sarita_getUpsamplingDomain(hSar))
+					txt.append("Upsampling Domain: Time (no projection)\n", 64);
+				if (sarita_getActiveShiftEstimation(hSar) != sarita_getShiftEstimation(hSar))
+					txt.append("Time Shift Estimation: Full rate (Accelerate)\n", 64);
 				txtGrid->setText(txt);
 				sensorCoordsView_handle->setUseDegreesInstead(true); // refreshCoords()
 			}
@@ -1132,6 +1264,16 @@ void PluginEditor::timerCallback(int timerID)
     } // switch
 }
 
+/* shows the overlap in effect, which may also be one between the presets
+ * (set by automation, or by a preset "50 %" limited to the maximum) */
+void PluginEditor::updateOverlapCB()
+{
+    float overlap = sarita_getOverlap(hSar);
+    String txt = (overlap == std::floor(overlap) ? String(roundToInt(overlap)) : String(overlap, 1)) + " %";
+    if (overlapCB->getText() != txt)
+        overlapCB->setText(txt, dontSendNotification);
+}
+
 
 
 //[/MiscUserCode]
@@ -1245,6 +1387,12 @@ BEGIN_JUCER_METADATA
     <TEXT pos="240 305 120 30" fill="solid: ffffffff" hasStroke="0" text="Window Overlap:"
           fontname="Default font" fontsize="15.0" kerning="0.0" bold="1"
           italic="0" justification="33" typefaceStyle="Bold"/>
+    <TEXT pos="240 344 120 30" fill="solid: ffffffff" hasStroke="0" text="Compression:"
+          fontname="Default font" fontsize="15.0" kerning="0.0" bold="1"
+          italic="0" justification="33" typefaceStyle="Bold"/>
+    <TEXT pos="240 369 120 30" fill="solid: ffffffff" hasStroke="0" text="Filterbank:"
+          fontname="Default font" fontsize="15.0" kerning="0.0" bold="1"
+          italic="0" justification="33" typefaceStyle="Bold"/>
   </BACKGROUND>
   <COMBOBOX name="new combo box" id="d818d0d5310dc52a" memberName="filterTypeCB"
             virtualName="" explicitFocusOrder="0" pos="640 276 128 16" editable="0"
@@ -1270,7 +1418,7 @@ BEGIN_JUCER_METADATA
               buttonText="Analyse" connectedEdges="0" needsCallback="1" radioGroupId="0"/>
   <COMBOBOX name="new combo box" id="fb3d8d6828195921" memberName="dispWindow"
             virtualName="" explicitFocusOrder="0" pos="721 39 63 14" editable="0"
-            layout="33" items="Filters&#10;Corr&#10;L Diff" textWhenNonSelected="Filters"
+            layout="33" items="Filters&#10;Corr&#10;L Diff&#10;Timing&#10;Grid" textWhenNonSelected="Filters"
             textWhenNoItems="(no choices)"/>
   <TEXTBUTTON name="new button" id="527e24c6748d02d4" memberName="tb_loadCfg"
               virtualName="" explicitFocusOrder="0" pos="120 64 80 16" bgColOff="ff14889e"
@@ -1290,6 +1438,19 @@ BEGIN_JUCER_METADATA
                 virtualName="" explicitFocusOrder="0" pos="240 400 150 24" tooltip="If disabled, perform upsampling only, if enabled, the output are SH signlas."
                 buttonText="Ambisonics Output" connectedEdges="0" needsCallback="1"
                 radioGroupId="0" state="0"/>
+  <SLIDER name="new slider" id="5c1d0e2f7a93b846" memberName="compressionSlider"
+          virtualName="" explicitFocusOrder="0" pos="368 351 120 16" bkgcol="ff5c5d5e"
+          trackcol="ff315b6d" min="-120.0" max="-10.0" int="1.0" style="LinearHorizontal"
+          textBoxPos="TextBoxRight" textBoxEditable="1" textBoxWidth="45"
+          textBoxHeight="20" skewFactor="1.0" needsCallback="1"/>
+  <COMBOBOX name="new combo box" id="3b7f1e92c0d4a856" memberName="filterbankCB"
+            virtualName="" explicitFocusOrder="0" pos="368 375 120 20" editable="0"
+            layout="33" items="afSTFT (hybrid)&#10;afSTFT (low-delay)&#10;afSTFT&#10;QMF&#10;STFT"
+            textWhenNonSelected="afSTFT (hybrid)" textWhenNoItems="(no choices)"/>
+  <COMBOBOX name="new combo box" id="8e4a61d7b05f2c39" memberName="qualityCB"
+            virtualName="" explicitFocusOrder="0" pos="392 402 96 20" editable="0"
+            layout="33" items="Full quality&#10;High quality&#10;Medium quality&#10;Low quality"
+            textWhenNonSelected="Full quality" textWhenNoItems="(no choices)"/>
 </JUCER_COMPONENT>
 
 END_JUCER_METADATA
@@ -25,13 +25,17 @@
 #include "eqview.h"
 #include "anaview.h"
 #include "sensorCoordsView.h"
+#include "diagview.h"
+#include "gridview.h"
 #include "../../resources/SPARTALookAndFeel.h"
 #include "JuceHeader.h"
 
 typedef enum {
     SHOW_EQ = 1,
     SHOW_SPATIAL_COH,
-    SHOW_LEVEL_DIFF
+    SHOW_LEVEL_DIFF,
+    SHOW_DIAGNOSTICS,
+    SHOW_GRID
 }DISP_WINDOW;
 
 typedef enum _SPARTA_WARNINGS{
@@ -84,8 +88,10 @@ private:
     //[UserVariables]   -- You can add your own custom variables in this section.
     PluginProcessor* hVst;
     void* hA2sh;
+    void* hSar;
 
     void timerCallback(int timerID) override;
+    void updateOverlapCB();
 #ifndef PLUGIN_EDITOR_DISABLE_OPENGL
     std::unique_ptr<OpenGLGraphicsContextCustomShader> shader;
     OpenGLContext openGLContext;
@@ -97,11 +103,12 @@ private:
     SPARTALookAndFeel LAF;
 
     /* Custom components */
-    std::unique_ptr<Viewport> sensorCoordsVP;
-    sensorCoordsView* sensorCoordsView_handle;
+    std::unique_ptr<sensorCoordsView> sensorCoordsView_handle;
     std::unique_ptr<eqview> eqviewIncluded;
     std::unique_ptr<anaview> cohviewIncluded;
     std::unique_ptr<anaview> ldiffviewIncluded;
+    std::unique_ptr<diagview> diagviewIncluded;
+    std::unique_ptr<gridview> gridviewIncluded;
     DISP_WINDOW dispID;
 
     bool needScreenRefreshFLAG;
@@ -133,6 +140,9 @@ private:
     std::unique_ptr<juce::ComboBox> overlapCB;
     std::unique_ptr<juce::TextEditor> txtGrid;
     std::unique_ptr<juce::ToggleButton> perform_SHT_btn;
+    std::unique_ptr<juce::Slider> compressionSlider;
+    std::unique_ptr<juce::ComboBox> filterbankCB;
+    std::unique_ptr<juce::ComboBox> qualityCB;
 
 
     //==============================================================================
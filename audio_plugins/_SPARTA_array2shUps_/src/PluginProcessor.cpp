@@ -21,97 +21,148 @@
 */
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "SaritaRtCheck.h"
+
+/* host parameter IDs, in the order of the parameter tags */
+static const char* const parameterIDs[k_NumOfParameters] = {
+    "order", "channel_order", "norm_type", "filter_type", "max_gain",
+    "post_gain", "overlap", "perform_sht", "compression_tol", "filterbank",
+    "quality", "shift_estimation", "band_split", "upsampling_domain"
+};
 
 PluginProcessor::PluginProcessor() :
 	AudioProcessor(BusesProperties()
 		.withInput("Input", AudioChannelSet::discreteChannels(64), true)
-	    .withOutput("Output", AudioChannelSet::discreteChannels(64), true))
-{
-	array2sh_create(&hA2sh);
+	    .withOutput("Output", AudioChannelSet::discreteChannels(64), true)),
+    parameters(*this, nullptr, "PARAMETERS", createParameterLayout())
+{
+	sarita_create(&hSar);
+    hA2sh = sarita_getArray2shHandle(hSar);
+    for (int index = 0; index < k_NumOfParameters; index++) {
+        parameterValues[index] = parameters.getRawParameterValue(parameterIDs[index]);
+        parameters.addParameterListener(parameterIDs[index], this);
+    }
+    publishParameters();
+#if SARITA_ENABLE_TRACING
+    /* timeline tracing; the first instance to be created writes the trace */
+    if (const char* tracePath = getenv("SARITA_TRACE"))
+        ownsTrace = SaritaTrace::start(tracePath);
+#endif
     startTimer(TIMER_PROCESSING_RELATED, 80);
 
 }
 
 PluginProcessor::~PluginProcessor()
 {
-	array2sh_destroy(&hA2sh);
-}
-
-void PluginProcessor::setParameter (int index, float newValue)
-{
-    /* standard parameters */
-    if(index < k_NumOfParameters){
-        switch (index) {
-            case k_overlap:       sarita.setOverlap(newValue); break;
-            case k_perform_sht: {
-				_perform_sht = (newValue > 0.5f? true: false); 
-				DBG("change SHT mode: " + String(newValue));
-				if (_perform_sht)
-					AudioProcessor::setLatencySamples(nHostBlockSize + sarita.maxShiftOverall + array2sh_getProcessingDelay());
-				else
-					AudioProcessor::setLatencySamples(nHostBlockSize + sarita.maxShiftOverall);
-			} break;
-            case k_outputOrder:   array2sh_setEncodingOrder(hA2sh, (SH_ORDERS)(int)(newValue*(float)(MAX_SH_ORDER-1) + 1.5f)); break;
-            case k_channelOrder:  array2sh_setChOrder(hA2sh, (int)(newValue*(float)(NUM_CH_ORDERINGS-1) + 1.5f)); break;
-            case k_normType:      array2sh_setNormType(hA2sh, (int)(newValue*(float)(NUM_NORM_TYPES-1) + 1.5f)); break;
-            case k_filterType:    array2sh_setFilterType(hA2sh, (ARRAY2SH_FILTER_TYPES)(int)(newValue*(float)(ARRAY2SH_NUM_FILTER_TYPES-1) + 1.5f)); break;
-            case k_maxGain:       array2sh_setRegPar(hA2sh, newValue*(ARRAY2SH_MAX_GAIN_MAX_VALUE-ARRAY2SH_MAX_GAIN_MIN_VALUE)+ARRAY2SH_MAX_GAIN_MIN_VALUE); break;
-            case k_postGain:      array2sh_setGain(hA2sh, newValue*(ARRAY2SH_POST_GAIN_MAX_VALUE-ARRAY2SH_POST_GAIN_MIN_VALUE)+ARRAY2SH_POST_GAIN_MIN_VALUE); break;
-        }
-    }
-    /* sensor direction parameters */
-    else{
-        index-=k_NumOfParameters;
-        float newValueScaled;
-        if (!(index % 2)){
-            newValueScaled = (newValue - 0.5f)*360.0f;
-            if (newValueScaled != array2sh_getSensorAzi_deg(hA2sh, index/2)){
-                array2sh_setSensorAzi_deg(hA2sh, index/2, newValueScaled);
-            }
-        }
-        else{
-            newValueScaled = (newValue - 0.5f)*180.0f;
-            if (newValueScaled != array2sh_getSensorElev_deg(hA2sh, index/2)){
-                array2sh_setSensorElev_deg(hA2sh, index/2, newValueScaled);
-            }
-        }
+    for (int index = 0; index < k_NumOfParameters; index++)
+        parameters.removeParameterListener(parameterIDs[index], this);
+	sarita_destroy(&hSar);
+    if (ownsTrace)
+        SaritaTrace::stop();
+#if SARITA_RT_CHECK
+    if (SaritaRtCheck::getNumViolations() > 0) {
+        fprintf(stderr, "sparta_array2sh: %llu real-time violations in processBlock:\n",
+                (unsigned long long)SaritaRtCheck::getNumViolations());
+        SaritaRtCheck::printReport(stderr, 10);
     }
+#endif
 }
 
-void PluginProcessor::setCurrentProgram (int /*index*/)
-{
-}
-
-float PluginProcessor::getParameter (int index)
-{
-    /* standard parameters */
-    if(index < k_NumOfParameters){
-        switch (index) {
-            case k_overlap: return (float) sarita.overlapPercent;
-            case k_perform_sht:   return _perform_sht;
-            case k_outputOrder:   return (float)(array2sh_getEncodingOrder(hA2sh)-1)/(float)(MAX_SH_ORDER-1);
-            case k_channelOrder:  return (float)(array2sh_getChOrder(hA2sh)-1)/(float)(NUM_CH_ORDERINGS-1);
-            case k_normType:      return (float)(array2sh_getNormType(hA2sh)-1)/(float)(NUM_NORM_TYPES-1);
-            case k_filterType:    return (float)(array2sh_getFilterType(hA2sh)-1)/(float)(ARRAY2SH_NUM_FILTER_TYPES-1);
-            case k_maxGain:       return
-                (array2sh_getRegPar(hA2sh)-ARRAY2SH_MAX_GAIN_MIN_VALUE)/(ARRAY2SH_MAX_GAIN_MAX_VALUE-ARRAY2SH_MAX_GAIN_MIN_VALUE);
-            case k_postGain:      return (array2sh_getGain(hA2sh)-ARRAY2SH_POST_GAIN_MIN_VALUE)/(ARRAY2SH_POST_GAIN_MAX_VALUE-ARRAY2SH_POST_GAIN_MIN_VALUE);
-            default: return 0.0f;
-        }
-    }
-    /* sensor direction parameters */
-    else{
-        index-=k_NumOfParameters;
-        if (!(index % 2))
-            return (array2sh_getSensorAzi_deg(hA2sh, index/2)/360.0f) + 0.5f;
-        else
-            return (array2sh_getSensorElev_deg(hA2sh, (index-1)/2)/180.0f) + 0.5f;
-    }
+AudioProcessorValueTreeState::ParameterLayout PluginProcessor::createParameterLayout()
+{
+    auto dB = [](float value, int /*maxLength*/) { return String(value, 1) + " dB"; };
+    std::vector<std::unique_ptr<RangedAudioParameter>> params;
+    params.push_back(std::make_unique<AudioParameterInt>(parameterIDs[k_outputOrder], "Order", 1, MAX_SH_ORDER, SH_ORDER_FIRST));
+    params.push_back(std::make_unique<AudioParameterChoice>(parameterIDs[k_channelOrder], "Channel Order",
+                                                            StringArray{ "ACN", "FuMa" }, CH_ACN-1));
+    params.push_back(std::make_unique<AudioParameterChoice>(parameterIDs[k_normType], "Normalisation",
+                                                            StringArray{ "N3D", "SN3D", "FuMa" }, NORM_SN3D-1));
+    params.push_back(std::make_unique<AudioParameterChoice>(parameterIDs[k_filterType], "Filter Type",
+                                                            StringArray{ "Soft-Limiting", "Tikhonov", "Z-style", "Z-style (max_rE)" }, FILTER_TIKHONOV-1));
+    params.push_back(std::make_unique<AudioParameterFloat>(parameterIDs[k_maxGain], "Max Gain",
+                                                           NormalisableRange<float>(ARRAY2SH_MAX_GAIN_MIN_VALUE, ARRAY2SH_MAX_GAIN_MAX_VALUE, 0.01f), 15.0f,
+                                                           String(), AudioProcessorParameter::genericParameter, dB));
+    params.push_back(std::make_unique<AudioParameterFloat>(parameterIDs[k_postGain], "Post Gain",
+                                                           NormalisableRange<float>(ARRAY2SH_POST_GAIN_MIN_VALUE, ARRAY2SH_POST_GAIN_MAX_VALUE, 0.01f), 0.0f,
+                                                           String(), AudioProcessorParameter::genericParameter, dB));
+    params.push_back(std::make_unique<AudioParameterFloat>(parameterIDs[k_overlap], "Overlap",
+                                                           NormalisableRange<float>(0.0f, SARITA_MAX_OVERLAP_PERCENT, 0.5f), 25.0f,
+                                                           String(), AudioProcessorParameter::genericParameter,
+                                                           [](float value, int /*maxLength*/) { return String(value, 1) + " %"; }));
+    params.push_back(std::make_unique<AudioParameterBool>(parameterIDs[k_perform_sht], "Ambisonics Output", true));
+    params.push_back(std::make_unique<AudioParameterFloat>(parameterIDs[k_compressionTol], "Compression Tolerance",
+                                                           NormalisableRange<float>(ARRAY2SH_COMPRESSION_TOL_MIN_VALUE, ARRAY2SH_COMPRESSION_TOL_MAX_VALUE, 1.0f), -100.0f,
+                                                           String(), AudioProcessorParameter::genericParameter, dB));
+    params.push_back(std::make_unique<AudioParameterChoice>(parameterIDs[k_filterbank], "Filterbank",
+                                                            StringArray{ "afSTFT (hybrid)", "afSTFT (low-delay)", "afSTFT", "QMF", "STFT" },
+                                                            ARRAY2SH_FILTERBANK_AFSTFT_HYBRID-1));
+    params.push_back(std::make_unique<AudioParameterChoice>(parameterIDs[k_quality], "Quality",
+                                                            StringArray{ "Full", "High", "Medium", "Low" },
+                                                            SARITA_QUALITY_FULL-1));
+    params.push_back(std::make_unique<AudioParameterChoice>(parameterIDs[k_shiftEstimation], "Time Shift Estimation",
+                                                            StringArray{ "Full rate", "Decimated" },
+                                                            SARITA_SHIFT_ESTIMATION_FULL_RATE-1));
+    params.push_back(std::make_unique<AudioParameterChoice>(parameterIDs[k_bandSplit], "Band Split",
+                                                            StringArray{ "Off", "On" },
+                                                            SARITA_BAND_SPLIT_OFF-1));
+    params.push_back(std::make_unique<AudioParameterChoice>(parameterIDs[k_upsamplingDomain], "Upsampling Domain",
+                                                            StringArray{ "Time", "Time-Frequency" },
+                                                            SARITA_UPSAMPLING_DOMAIN_TIME-1));
+    return { params.begin(), params.end() };
+}
+
+void PluginProcessor::setParameterValue (int index, float newValue)
+{
+    RangedAudioParameter* param = parameters.getParameter(parameterIDs[index]);
+    param->setValueNotifyingHost(param->convertTo0to1(newValue)); /* calls parameterChanged() */
+}
+
+/* called on whichever thread the parameter is changed (by the host, possibly
+ * the audio thread, and the GUI at the same time) */
+void PluginProcessor::parameterChanged (const String& /*parameterID*/, float /*newValue*/)
+{
+    parametersChanged.store(true, std::memory_order_release);
+}
+
+/* sarita takes its parameters from one thread at a time: the audio thread, at
+ * the start of each block, or the timer. Neither waits for the other: the one
+ * that finds the other publishing leaves the change to the next attempt */
+void PluginProcessor::publishChangedParameters()
+{
+    if (!parametersChanged.load(std::memory_order_acquire) || publishing.test_and_set(std::memory_order_acquire))
+        return;
+    if (parametersChanged.exchange(false, std::memory_order_acq_rel))
+        publishParameters();
+    publishing.clear(std::memory_order_release);
+}
+
+/* publishes all parameters to sarita, as one snapshot; never waits, but only
+ * one thread at a time may call it (see publishChangedParameters()) */
+void PluginProcessor::publishParameters()
+{
+    auto value = [this](int index) { return parameterValues[index]->load(std::memory_order_relaxed); };
+    auto choice = [&value](int index) { return (int)(value(index) + 0.5f) + 1; }; /* the enums start at 1 */
+    sarita_parameters params;
+    params.overlapPercent = value(k_overlap);
+    params.outputType = value(k_perform_sht) > 0.5f ? SARITA_OUTPUT_SH : SARITA_OUTPUT_DENSE_GRID;
+    params.order = (int)(value(k_outputOrder) + 0.5f);
+    params.chOrdering = choice(k_channelOrder);
+    params.norm = choice(k_normType);
+    params.filterType = choice(k_filterType);
+    params.regPar = value(k_maxGain);
+    params.gain_dB = value(k_postGain);
+    params.compressionTol_dB = value(k_compressionTol);
+    params.filterbank = choice(k_filterbank);
+    sarita_applyQualityPreset(&params, (SARITA_QUALITY)choice(k_quality));
+    params.shiftEstimation = choice(k_shiftEstimation);
+    params.bandSplit = choice(k_bandSplit);
+    params.crossoverFreq = 0.0f; /* at the spatial aliasing frequency */
+    params.upsamplingDomain = choice(k_upsamplingDomain);
+    sarita_setParameters(hSar, &params);
 }
 
-int PluginProcessor::getNumParameters()
+void PluginProcessor::setCurrentProgram (int /*index*/)
 {
-	return k_NumOfParameters + 2*ARRAY2SH_MAX_NUM_SENSORS;
 }
 
 const String PluginProcessor::getName() const
@@ -119,76 +170,6 @@ const String PluginProcessor::getName() const
     return JucePlugin_Name;
 }
 
-const String PluginProcessor::getParameterName (int index)
-{
-    /* standard parameters */
-    if(index < k_NumOfParameters){
-        switch (index) {
-            case k_overlap:         return "overlap";
-            case k_outputOrder:     return "order";
-            case k_channelOrder:    return "channel_order";
-            case k_normType:        return "norm_type";
-            case k_filterType:      return "filter_type";
-            case k_maxGain:         return "max_gain";
-            case k_postGain:        return "post_gain";
-            case k_perform_sht:     return "perform_sht";
-            default: return "NULL";
-        }
-    }
-    /* sensor direction parameters */
-    else{
-        index-=k_NumOfParameters;
-        if (!(index % 2))
-            return TRANS("Azim_") + String(index/2);
-        else
-            return TRANS("Elev_") + String((index-1)/2);
-    }
-}
-
-const String PluginProcessor::getParameterText(int index)
-{
-    /* standard parameters */
-    if(index < k_NumOfParameters){
-        switch (index) {
-            case k_overlap: return "FIXME";
-            case k_outputOrder: return String(array2sh_getEncodingOrder(hA2sh));
-            case k_channelOrder:
-                switch(array2sh_getChOrder(hA2sh)){
-                    case CH_ACN:  return "ACN";
-                    case CH_FUMA: return "FuMa";
-                    default: return "NULL";
-                }
-            case k_normType:
-                switch(array2sh_getNormType(hA2sh)){
-                    case NORM_N3D:  return "N3D";
-                    case NORM_SN3D: return "SN3D";
-                    case NORM_FUMA: return "FuMa";
-                    default: return "NULL";
-                }
-                
-            case k_filterType:
-                switch(array2sh_getFilterType(hA2sh)){
-                    case FILTER_SOFT_LIM:      return "Soft-Limiting";
-                    case FILTER_TIKHONOV:      return "Tikhonov";
-                    case FILTER_Z_STYLE:       return "Z-style";
-                    case FILTER_Z_STYLE_MAXRE: return "Z-style (max_rE)";
-                    default: return "NULL";
-                }
-            case k_maxGain:      return String(array2sh_getRegPar(hA2sh)) + " dB";
-            case k_postGain:     return String(array2sh_getGain(hA2sh)) + " dB";
-            default: return "NULL";
-        }
-    }
-    /* sensor direction parameters */
-    else{
-        index-=k_NumOfParameters;
-        if (!(index % 2))
-            return String(array2sh_getSensorAzi_deg(hA2sh, index/2));
-        else
-            return String(array2sh_getSensorElev_deg(hA2sh, (index-1)/2));
-    }
-}
-
 const String PluginProcessor::getInputChannelName (int channelIndex) const
 {
     return String (channelIndex + 1);
@@ -201,9 +182,7 @@ const String PluginProcessor::getOutputChannelName (int channelIndex) const
 
 void PluginProcessor::numChannelsChanged()
 {
-	sarita.configError = true;
 	prepareToPlay(getSampleRate(), getBlockSize());
-	
 }
 
 double PluginProcessor::getTailLengthSeconds() const
@@ -267,35 +246,13 @@ void PluginProcessor::changeProgramName (int /*index*/, const String& /*newName*
 
 void PluginProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    bool sampleRateChanged = nSampleRate != sampleRate;
-    bool blocksizeChanged = nHostBlockSize != samplesPerBlock;
-
     nHostBlockSize = samplesPerBlock;
-    
-    int inputNum = getTotalNumInputChannels();
-    bool inputCountChanged = inputNum != nNumInputs;
-    if (inputCountChanged && !sarita.configError) {
-        sarita.deallocBuffers();
-        sarita.allocBuffers(nHostBlockSize, inputNum);
-    }
     nNumInputs =  getTotalNumInputChannels();
     nNumOutputs =  getTotalNumOutputChannels();
     nSampleRate = (int)(sampleRate + 0.5);
     
-    array2sh_init(hA2sh, nSampleRate);
-    
-    if (sarita.configError == true || sampleRateChanged || blocksizeChanged || inputCountChanged) {
-		loadConfiguration(newCfgFile); // also calls setupSarite()
-		sarita.wantsConfigUpdate = false;
-	}
-    
-	if (sarita.configError == false) {
-		// DBG("SHT mode: " + String((int)_perform_sht));
-		if (_perform_sht)
-			AudioProcessor::setLatencySamples(nHostBlockSize + sarita.maxShiftOverall + array2sh_getProcessingDelay());
-		else
-			AudioProcessor::setLatencySamples(nHostBlockSize + sarita.maxShiftOverall);
-	}
+    sarita_init(hSar, nSampleRate, nHostBlockSize); // also rebuilds the engine for a new block size
+    updateLatency();
 }
 
 void PluginProcessor::releaseResources()
@@ -306,113 +263,16 @@ void PluginProcessor::processBlock (AudioSampleBuffer& buffer, MidiBuffer& /*mid
 {
     int nCurrentBlockSize = buffer.getNumSamples();
     nNumOutputs = jmin(getTotalNumOutputChannels(), buffer.getNumChannels());
-	
-	int numInputSensors = jmin(sarita.sparseGridSize, nNumInputs);
-	
-	timeStamp = Time::currentTimeMillis(); // detect from editor if we are processing 
-	
-    if (sarita.overlapChanged) {
-        sarita.updateOverlap(nHostBlockSize);
-    }
-    else if(sarita.wantsConfigUpdate) {
-        sarita.wantsConfigUpdate = false;
-        DBG("load cfg");
-        loadConfiguration(newCfgFile);
-    }
 
-    // if config file read is not successful
-    if (sarita.configError || nCurrentBlockSize < nHostBlockSize) {
-        buffer.clear();
-    }
-    else {
-        // fill input ring buffer
-        for (int ch = 0; ch < numInputSensors; ch++) {
-            auto* channelData = buffer.getReadPointer(ch);
-            sarita.input->push(channelData, nCurrentBlockSize, ch);
-        }
-		// and if not enough input channels do skip
-		if (nNumInputs < sarita.sparseGridSize) {
-			sarita.input->skipPush(nHostBlockSize);
-		}
-
-        // process frame when frame size fulfilled
-        while (sarita.input->bufferedBytes >= nHostBlockSize) { // TODO: independent buffer size
-            // process frame for all channels, and if not enough input channels do skip
-            sarita.processFrame(nCurrentBlockSize, numInputSensors);
-			if (nNumInputs < sarita.sparseGridSize) {
-				sarita.input->skipPop(nHostBlockSize); 
-			}
-			
-            int overlapIdx = juce::jmax(nCurrentBlockSize-sarita.overlapSize, 0);
-            for (uint32_t ch=0; ch<sarita.denseGridSize; ch++) {
-				// add overlapping part of current frame to last frame end
-                utility_svvadd(&sarita.denseBuffer[sarita.bufferNum][ch][0], &sarita.denseBuffer[!sarita.bufferNum][ch][overlapIdx], sarita.overlapSize, sarita.outputBuffer[ch]);
-				
-				// add out-of-frame-shifted samples to densebuffer
-				cblas_saxpy(sarita.maxShiftOverall*2, 1.f, &sarita.shiftBuffer[ch][0], 1, &sarita.denseBuffer[sarita.bufferNum][ch][sarita.overlapSize], 1);
-            }
-            // copy last overlap to output ring buffer
-            for (uint32_t ch=0; ch<sarita.denseGridSize ; ch++) {
-                sarita.output->push(sarita.outputBuffer[ch], sarita.overlapSize, ch);
-            }
-            // copy non overlapping part to output ring buffer
-            for (uint32_t ch=0; ch<sarita.denseGridSize; ch++) {
-                sarita.output->push(&sarita.denseBuffer[sarita.bufferNum][ch][sarita.overlapSize], nHostBlockSize-2*sarita.overlapSize, ch);
-            }
-            sarita.bufferNum ^= 1; // swap buffer
-        }
+    SARITA_TRACE_THREAD_NAME("audio");
+    SARITA_TRACE_SCOPE("processBlock", "audio");
+    SARITA_RT_SCOPE();
+    publishChangedParameters();
 
-        // test output
-        if (!_perform_sht) {
-            if (sarita.output->bufferedBytes >= nHostBlockSize) {
-                uint32_t numCh = juce::jmin((int)buffer.getNumChannels(), (int)sarita.denseGridSize);
-                for (uint32_t ch = 0; ch<numCh; ch++) {
-                    float* channelData = buffer.getWritePointer(ch);
-                    sarita.output->pop(channelData, ch, nHostBlockSize);
-                }
-                // increase read index cause not all ring buffer channels are used
-                if ((uint32_t)buffer.getNumChannels() < (uint32_t)sarita.denseGridSize) {
-                    sarita.output->skipPop(nHostBlockSize);
-                }
-            } else {
-                buffer.clear();
-            }
-        } else {
-            /*
-             * process array2sh with dense grid
-             */
-            float** bufferData = (float**)buffer.getArrayOfWritePointers();
-            float* pFrameData[MAX_NUM_CHANNELS];
-            int frameSize = array2sh_getFrameSize();
-            
-            if ((sarita.output->bufferedBytes >= nHostBlockSize) && (nHostBlockSize % frameSize == 0)) { /* buffer filled and blocksize divisible by frame size */
-                for (int frame = 0; frame < nCurrentBlockSize/frameSize; frame++) {
-                    for (int ch = 0; ch < (int)sarita.output->numChannels(); ch++) {
-                        // copy to array2Sh processing buffer
-                        sarita.output->pop(sarita.outData[ch], ch, frameSize);
-                        // normalize sh transform input
-#ifdef SAF_USE_APPLE_ACCELERATE
-                        float value = sarita.normFactor;
-                        vDSP_vsmul(sarita.outData[ch], 1, &value, sarita.outData[ch], 1, frameSize);
-#else
-                        ippsMulC_32f_I(sarita.normFactor, sarita.outData[ch], frameSize); // FIXME: find correct value
-#endif
-                    }
-                    
-                    // gather channel pointers to output buffer
-                    for (int ch = 0; ch < nNumOutputs; ch++) {
-                        pFrameData[ch] = &bufferData[ch][frame*frameSize];
-                    }
-                    
-                    /* perform processing and write to AudioSampleBuffer */
-                    array2sh_process(hA2sh, sarita.outData, pFrameData, sarita.denseGridSize, nNumOutputs, frameSize);
-                }
-            }
-            else {
-                buffer.clear();
-            }
-        }
-    }
+    /* in place; silent while no config is loaded, and for partial blocks */
+    float* const* bufferData = buffer.getArrayOfWritePointers();
+    sarita_process(hSar, bufferData, bufferData, jmin(nNumInputs, buffer.getNumChannels()),
+                   buffer.getNumChannels(), nCurrentBlockSize);
 }
 
 //==============================================================================
@@ -431,9 +291,10 @@ void PluginProcessor::getStateInformation (MemoryBlock& destData)
 {
     XmlElement xml("ARRAY2SHPLUGINSETTINGS");
     
-    xml.setAttribute("order", array2sh_getEncodingOrder(hA2sh));
-    xml.setAttribute("overlap", sarita.overlapPercent);
-	xml.setAttribute("performSht", _perform_sht);
+    /* the parameters, under the attribute names of earlier versions; choices as the 1-based enums */
+    xml.setAttribute("order", (int)(parameterValues[k_outputOrder]->load() + 0.5f));
+    xml.setAttribute("overlap", parameterValues[k_overlap]->load());
+	xml.setAttribute("performSht", parameterValues[k_perform_sht]->load() > 0.5f);
 //    xml.setAttribute("Q", array2sh_getNumSensors(hA2sh));
 //    for(int i=0; i<MAX_NUM_CHANNELS; i++){
 //        xml.setAttribute("AziRad" + String(i), array2sh_getSensorAzi_rad(hA2sh,i));
@@ -443,12 +304,18 @@ void PluginProcessor::getStateInformation (MemoryBlock& destData)
 //    xml.setAttribute("R", array2sh_getR(hA2sh));
 //    xml.setAttribute("arrayType", ARRAY_SPHERICAL); // array2sh_getArrayType(hA2sh));
     xml.setAttribute("weightType", array2sh_getWeightType(hA2sh));
-    xml.setAttribute("filterType", array2sh_getFilterType(hA2sh));
-    xml.setAttribute("regPar", array2sh_getRegPar(hA2sh));
-    xml.setAttribute("chOrder", array2sh_getChOrder(hA2sh));
-    xml.setAttribute("normType", array2sh_getNormType(hA2sh));
+    xml.setAttribute("filterType", (int)(parameterValues[k_filterType]->load() + 0.5f) + 1);
+    xml.setAttribute("regPar", parameterValues[k_maxGain]->load());
+    xml.setAttribute("chOrder", (int)(parameterValues[k_channelOrder]->load() + 0.5f) + 1);
+    xml.setAttribute("normType", (int)(parameterValues[k_normType]->load() + 0.5f) + 1);
     xml.setAttribute("c", array2sh_getc(hA2sh));
-    xml.setAttribute("gain", array2sh_getGain(hA2sh));
+    xml.setAttribute("gain", parameterValues[k_postGain]->load());
+    xml.setAttribute("compressionTol", parameterValues[k_compressionTol]->load());
+    xml.setAttribute("filterbank", (int)(parameterValues[k_filterbank]->load() + 0.5f) + 1);
+    xml.setAttribute("quality", (int)(parameterValues[k_quality]->load() + 0.5f) + 1);
+    xml.setAttribute("shiftEstimation", (int)(parameterValues[k_shiftEstimation]->load() + 0.5f) + 1);
+    xml.setAttribute("bandSplit", (int)(parameterValues[k_bandSplit]->load() + 0.5f) + 1);
+    xml.setAttribute("upsamplingDomain", (int)(parameterValues[k_upsamplingDomain]->load() + 0.5f) + 1);
     //xml.setAttribute("maxFreq", array2sh_getMaxFreq(hA2sh));
     xml.setAttribute("enableDiffPastAliasing", 0); // array2sh_getDiffEQpastAliasing(hA2sh));
     
@@ -475,11 +342,11 @@ void PluginProcessor::setStateInformation (const void* data, int sizeInBytes)
 //                    array2sh_setSensorElev_rad(hA2sh, i, (float)xmlState->getDoubleAttribute("ElevRad" + String(i), 0.0f));
 //            }
             if(xmlState->hasAttribute("order"))
-                array2sh_setEncodingOrder(hA2sh, xmlState->getIntAttribute("order", 1));
+                setParameterValue(k_outputOrder, (float)xmlState->getIntAttribute("order", 1));
             if(xmlState->hasAttribute("overlap"))
-                sarita.setOverlap(xmlState->getDoubleAttribute("overlap", 25.0));
+                setParameterValue(k_overlap, (float)xmlState->getDoubleAttribute("overlap", 25.0));
 			if(xmlState->hasAttribute("performSht"))
-				_perform_sht = xmlState->getBoolAttribute("performSht", true);
+				setParameterValue(k_perform_sht, xmlState->getBoolAttribute("performSht", true) ? 1.0f : 0.0f);
 //            if(xmlState->hasAttribute("Q"))
 //                array2sh_setNumSensors(hA2sh, xmlState->getIntAttribute("Q", 4));
 //            if(xmlState->hasAttribute("r"))
@@ -491,17 +358,29 @@ void PluginProcessor::setStateInformation (const void* data, int sizeInBytes)
 //            if(xmlState->hasAttribute("weightType"))
 //                array2sh_setWeightType(hA2sh, xmlState->getIntAttribute("weightType", 1));
             if(xmlState->hasAttribute("filterType"))
-                array2sh_setFilterType(hA2sh, xmlState->getIntAttribute("filterType", 3));
+                setParameterValue(k_filterType, (float)(xmlState->getIntAttribute("filterType", 3) - 1));
             if(xmlState->hasAttribute("regPar"))
-                array2sh_setRegPar(hA2sh, (float)xmlState->getDoubleAttribute("regPar", 15.0));
+                setParameterValue(k_maxGain, (float)xmlState->getDoubleAttribute("regPar", 15.0));
             if(xmlState->hasAttribute("chOrder"))
-                array2sh_setChOrder(hA2sh, xmlState->getIntAttribute("chOrder", 1));
+                setParameterValue(k_channelOrder, (float)(xmlState->getIntAttribute("chOrder", 1) - 1));
             if(xmlState->hasAttribute("normType"))
-                array2sh_setNormType(hA2sh, xmlState->getIntAttribute("normType", 1));
+                setParameterValue(k_normType, (float)(xmlState->getIntAttribute("normType", 1) - 1));
 //            if(xmlState->hasAttribute("c"))
 //                array2sh_setc(hA2sh, (float)xmlState->getDoubleAttribute("c", 343.0));
             if(xmlState->hasAttribute("gain"))
-                array2sh_setGain(hA2sh, (float)xmlState->getDoubleAttribute("gain", 0.0));
+                setParameterValue(k_postGain, (float)xmlState->getDoubleAttribute("gain", 0.0));
+            if(xmlState->hasAttribute("compressionTol"))
+                setParameterValue(k_compressionTol, (float)xmlState->getDoubleAttribute("compressionTol", -100.0));
+            if(xmlState->hasAttribute("filterbank"))
+                setParameterValue(k_filterbank, (float)(xmlState->getIntAttribute("filterbank", 1) - 1));
+            if(xmlState->hasAttribute("quality"))
+                setParameterValue(k_quality, (float)(xmlState->getIntAttribute("quality", 1) - 1));
+            if(xmlState->hasAttribute("shiftEstimation"))
+                setParameterValue(k_shiftEstimation, (float)(xmlState->getIntAttribute("shiftEstimation", 1) - 1));
+            if(xmlState->hasAttribute("bandSplit"))
+                setParameterValue(k_bandSplit, (float)(xmlState->getIntAttribute("bandSplit", 1) - 1));
+            if(xmlState->hasAttribute("upsamplingDomain"))
+                setParameterValue(k_upsamplingDomain, (float)(xmlState->getIntAttribute("upsamplingDomain", 1) - 1));
             //if(xmlState->hasAttribute("maxFreq"))
             //    array2sh_setMaxFreq(hA2sh, (float)xmlState->getDoubleAttribute("maxFreq", 20000.0));
 //            if(xmlState->hasAttribute("enableDiffPastAliasing"))
@@ -516,9 +395,7 @@ void PluginProcessor::setStateInformation (const void* data, int sizeInBytes)
                 if (!cfgFile.existsAsFile())
                     return;
 
-                newCfgFile = cfgFile;
-                //sarita.updateArrayData(hA2sh);
-                sarita.wantsConfigUpdate = true;
+                loadConfiguration(cfgFile);
             }
             array2sh_refreshSettings(hA2sh);
         }
@@ -553,17 +430,23 @@ void PluginProcessor::saveConfigurationToFile (File destination)
     Result result = ConfigurationHelper::writeConfigurationToFile (destination, var (jsonObj));
 }
 
-/*   */
+/* may be called from any thread but the audio thread; the new config is
+ * swapped in between two blocks */
 void PluginProcessor::loadConfiguration (const File& configFile)
 {
+    SARITA_TRACE_SCOPE("loadConfiguration", "config");
     if (!configFile.existsAsFile())
         return;
     
-    const char *p = configFile.getFullPathName().getCharPointer();
-    if(sarita.setupSarita(p, nHostBlockSize, nNumInputs) == -1)
-        return; // config error
+    if (sarita_loadConfig(hSar, configFile.getFullPathName().toRawUTF8()) != 0)
+        return; // config error; the current one is kept
 
     lastCfgFile = configFile;
-    sarita.updateArrayData(hA2sh);
+    updateLatency();
 }
 
+void PluginProcessor::updateLatency()
+{
+    if (sarita_getCodecStatus(hSar) == CODEC_STATUS_INITIALISED)
+        AudioProcessor::setLatencySamples(sarita_getProcessingDelay(hSar));
+}
@@ -23,8 +23,10 @@
 #define PLUGINPROCESSOR_H_INCLUDED
 
 #include "array2sh.h"
+#include <atomic>
 #include <thread>
-#include "Sarita.h"
+#include "sarita.h"
+#include "SaritaTrace.h"
 #include <JuceHeader.h>
 #define CONFIGURATIONHELPER_ENABLE_GENERICLAYOUT_METHODS 1
 #include "../../resources/ConfigurationHelper.h"
@@ -39,7 +41,9 @@ typedef enum _TIMERS{
     TIMER_GUI_RELATED
 }TIMERS;
 
-/* Parameter tags: for the default VST GUI */
+/* Parameter tags: for the default VST GUI (in the order of the host's
+ * parameter indices). The sensor directions are not parameters; they are
+ * determined by the loaded config */
 enum {
     k_outputOrder,
     k_channelOrder,
@@ -49,20 +53,35 @@ enum {
     k_postGain,
     k_overlap,
     k_perform_sht,
+    k_compressionTol,
+    k_filterbank,
+    k_quality,
+    k_shiftEstimation,
+    k_bandSplit,
+    k_upsamplingDomain,
     
 	k_NumOfParameters
 };
 
 class PluginProcessor  : public AudioProcessor,
                          public MultiTimer,
-                         public VSTCallbackHandler
+                         public VSTCallbackHandler,
+                         private AudioProcessorValueTreeState::Listener
 {
 public:
     /* Get functions */
     void* getFXHandle() { return hA2sh; }
+    void* getSaritaHandle() { return hSar; }
     int getCurrentBlockSize(){ return nHostBlockSize; }
     int getCurrentNumInputs(){ return nNumInputs; }
     int getCurrentNumOutputs(){ return nNumOutputs; }
+    /* per-stage timing and callback load histogram (see sarita_getTimingStats()) */
+    SaritaTimingStats getTimingStats() { SaritaTimingStats stats; sarita_getTimingStats(hSar, &stats); return stats; }
+    void resetTimingStats() { sarita_resetTimingStats(hSar); }
+
+    /* Parameters; set by the GUI in their own units (e.g. dB, or the order),
+     * which also notifies the host */
+    void setParameterValue(int index, float newValue);
 	
 	void numChannelsChanged() override;
     
@@ -82,28 +101,52 @@ public:
         return 0;
     }
     
-    Sarita sarita; // FIXME: make private?
-    File newCfgFile;
-	bool _perform_sht;
-
 private:
-    void* hA2sh;           /* array2sh handle */
+    void* hSar;            /* sarita handle */
+    void* hA2sh;           /* array2sh handle (owned by sarita) */
     int nNumInputs;        /* current number of input channels */
     int nNumOutputs;       /* current number of output channels */
     int nSampleRate;       /* current host sample rate */
     int nHostBlockSize;    /* typical host block size to expect, in samples */
     File lastDir;
     File lastCfgFile;
+    bool ownsTrace = false;  /* this instance started the timeline trace (see SaritaTrace.h) */
     ValueTree sensors {"Sensors"};
+
+    /* Parameters: after any change (by the host or the GUI), all of them are
+     * published to sarita as one snapshot, at the start of the next block (or
+     * by the timer while no blocks are processed); sarita takes them over at
+     * the start of the block after (see sarita_setParameters()) */
+    AudioProcessorValueTreeState parameters;
+    std::atomic<float>* parameterValues[k_NumOfParameters];  /* in the units of each parameter */
+    std::atomic<bool> parametersChanged { false };
+    std::atomic_flag publishing = ATOMIC_FLAG_INIT;  /* held by the thread publishing them */
+
+    static AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+    void parameterChanged(const String& parameterID, float newValue) override;
+    void publishChangedParameters();
+    void publishParameters();
+    void updateLatency();
     
     void timerCallback(int timerID) override
     {
         switch(timerID){
             case TIMER_PROCESSING_RELATED:
+                publishChangedParameters();
+
+                /* the output type and the filterbank are applied in the
+                 * background; the host is told once they are */
+                updateLatency();
+
                 /* reinitialise codec if needed */
                 if(array2sh_getRequestEncoderEvalFLAG(hA2sh)){
                     try{
-                        std::thread threadInit(array2sh_evalEncoder, hA2sh);
+                        void* handle = hA2sh;
+                        std::thread threadInit([handle] {
+                            SARITA_TRACE_THREAD_NAME("encoder build");
+                            SARITA_TRACE_SCOPE("array2sh_evalEncoder", "background");
+                            array2sh_evalEncoder(handle);
+                        });
                         //needScreenRefreshFLAG = 1;
                         array2sh_setRequestEncoderEvalFLAG(hA2sh, 0);
                         threadInit.detach();
@@ -131,11 +174,6 @@ public:
     AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override;
     const String getName() const override;
-    int getNumParameters() override;
-    float getParameter (int index) override;
-    void setParameter (int index, float newValue) override;
-    const String getParameterName (int index) override;
-    const String getParameterText (int index) override;
     const String getInputChannelName (int channelIndex) const override;
     const String getOutputChannelName (int channelIndex) const override;
     bool acceptsMidi() const override;
@@ -152,7 +190,6 @@ public:
     void getStateInformation (MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
-	int64 timeStamp = 0;
 private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginProcessor)
 };
@@ -0,0 +1,574 @@
+//
+//  SaritaRtCheck.cpp
+//  sparta_array2sh
+//
+
+/* the fortified (inline) stdio wrappers would clash with the interposers */
+#ifdef _FORTIFY_SOURCE
+# undef _FORTIFY_SOURCE
+#endif
+
+#include "SaritaRtCheck.h"
+
+#if SARITA_RT_CHECK
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#if defined(_MSC_VER)
+# include <malloc.h>
+#endif
+#if defined(__GLIBC__) || defined(__APPLE__)
+# define SARITA_RT_HAS_BACKTRACE 1
+# include <cxxabi.h>
+# include <dlfcn.h>
+# include <execinfo.h>
+#else
+# define SARITA_RT_HAS_BACKTRACE 0
+#endif
+#if defined(__GLIBC__)
+# define SARITA_RT_INTERPOSES_LIBC 1
+# include <pthread.h>
+# include <sys/types.h>
+#else
+# define SARITA_RT_INTERPOSES_LIBC 0
+#endif
+
+/* thread-local state must not itself allocate on first use (which dynamic TLS
+ * may do), as it is read from within malloc() */
+#if defined(__GNUC__)
+# define SARITA_RT_CALLER __builtin_return_address(0)
+#elif defined(_MSC_VER)
+# include <intrin.h>
+# define SARITA_RT_CALLER _ReturnAddress()
+#else
+# define SARITA_RT_CALLER nullptr
+#endif
+
+#if defined(__GNUC__)
+# define SARITA_RT_TLS static thread_local __attribute__((tls_model("initial-exec")))
+#else
+# define SARITA_RT_TLS static thread_local
+#endif
+
+namespace {
+
+/* the violations that are accepted: by their kind, and the function they are
+ * made from (i.e. the caller of the interposed function). Only for libraries
+ * whose behaviour cannot be changed from here, each with the reason */
+struct Suppression
+{
+    int kind;
+    const char* function;
+    const char* reason;
+};
+
+const Suppression suppressions[] = {
+    /* OpenBLAS (unless built with USE_TLS=1) takes the work buffer of every
+     * GEMM from a pool shared by all threads, under a lock; it is only
+     * contended by GEMMs running on other threads at the same time */
+    { SARITA_RT_LOCK, "blas_memory_alloc", "OpenBLAS buffer pool, build with USE_TLS=1 to avoid" },
+    { SARITA_RT_LOCK, "blas_memory_free", "OpenBLAS buffer pool, build with USE_TLS=1 to avoid" },
+};
+
+struct SiteSlot
+{
+    std::atomic<uint64_t> key;   // hash of kind + stack; 0 if free
+    std::atomic<uint64_t> count;
+    std::atomic<bool> ready;     // stack written
+    const char* suppression;
+    int kind;
+    int stackDepth;
+    void* stack[SARITA_RT_MAX_STACK_DEPTH];
+};
+
+SiteSlot siteTable[SARITA_RT_MAX_SITES];
+std::atomic<uint64_t> kindCounts[SARITA_RT_NUM_KINDS];
+std::atomic<uint64_t> suppressedCounts[SARITA_RT_NUM_KINDS];
+
+SARITA_RT_TLS int callbackDepth = 0;
+SARITA_RT_TLS int inHandler = 0;
+
+const char* kindNames[SARITA_RT_NUM_KINDS] = { "alloc", "free", "lock", "file_io" };
+
+uint64_t hashSite(int kind, void* caller)
+{
+    uint64_t h = ((uint64_t)(uintptr_t)caller ^ ((uint64_t)kind << 56)) * 0x9E3779B97F4A7C15ull;
+    return h == 0 ? 1 : h;
+}
+
+/* the reason a violation from 'caller' is accepted, or nullptr */
+const char* findSuppression(int kind, void* caller)
+{
+#if SARITA_RT_HAS_BACKTRACE
+    Dl_info info;
+    if (!dladdr(caller, &info) || info.dli_sname == nullptr)
+        return nullptr;
+    for (const Suppression& s : suppressions)
+        if (s.kind == kind && strcmp(s.function, info.dli_sname) == 0)
+            return s.reason;
+#else
+    (void)kind;
+    (void)caller;
+#endif
+    return nullptr;
+}
+
+/* counts the violation at its site; returns the suppression that applies to
+ * it, if any (looked up once per site) */
+const char* recordSite(int kind, void* caller)
+{
+    uint64_t key = hashSite(kind, caller);
+    for (int probe = 0; probe < SARITA_RT_MAX_SITES; probe++) {
+        SiteSlot& slot = siteTable[(key + probe) % SARITA_RT_MAX_SITES];
+        uint64_t current = slot.key.load(std::memory_order_acquire);
+        if (current == 0) {
+            if (slot.key.compare_exchange_strong(current, key, std::memory_order_acq_rel)) {
+                /* new site: unwind once */
+                slot.kind = kind;
+                slot.suppression = findSuppression(kind, caller);
+#if SARITA_RT_HAS_BACKTRACE
+                void* frames[SARITA_RT_MAX_STACK_DEPTH + 4];
+                int depth = backtrace(frames, SARITA_RT_MAX_STACK_DEPTH + 4);
+                /* drop the frames of the checker itself */
+                int skip = 0;
+                while (skip < depth && frames[skip] != caller)
+                    skip++;
+                if (skip == depth)
+                    skip = 0;
+                depth = skip + SARITA_RT_MAX_STACK_DEPTH < depth ? skip + SARITA_RT_MAX_STACK_DEPTH : depth;
+                slot.stackDepth = depth - skip;
+                memcpy(slot.stack, &frames[skip], slot.stackDepth * sizeof(void*));
+#else
+                slot.stack[0] = caller;
+                slot.stackDepth = 1;
+#endif
+                slot.ready.store(true, std::memory_order_release);
+                slot.count.fetch_add(1, std::memory_order_relaxed);
+                return slot.suppression;
+            }
+        }
+        if (current == key) {
+            slot.count.fetch_add(1, std::memory_order_relaxed);
+            /* the thread that took the slot may not have got to it yet */
+            return slot.ready.load(std::memory_order_acquire) ? slot.suppression : findSuppression(kind, caller);
+        }
+    }
+    /* table full; still counted per kind */
+    return findSuppression(kind, caller);
+}
+
+#if SARITA_RT_HAS_BACKTRACE
+/* backtrace() loads the unwinder (and allocates) on its first call */
+struct BacktraceWarmUp
+{
+    BacktraceWarmUp()
+    {
+        void* frames[2];
+        backtrace(frames, 2);
+    }
+} backtraceWarmUp;
+#endif
+
+} // namespace
+
+bool SaritaRtCheck::interposesLibc()
+{
+    return SARITA_RT_INTERPOSES_LIBC != 0;
+}
+
+void SaritaRtCheck::enterCallback()
+{
+    callbackDepth++;
+}
+
+void SaritaRtCheck::exitCallback()
+{
+    callbackDepth--;
+}
+
+void SaritaRtCheck::noteViolation(int kind, void* caller)
+{
+    if (callbackDepth <= 0 || inHandler)
+        return;
+    inHandler = 1;
+    if (recordSite(kind, caller) != nullptr)
+        suppressedCounts[kind].fetch_add(1, std::memory_order_relaxed);
+    else
+        kindCounts[kind].fetch_add(1, std::memory_order_relaxed);
+    inHandler = 0;
+}
+
+uint64_t SaritaRtCheck::getNumViolations(int kind)
+{
+    return kindCounts[kind].load(std::memory_order_relaxed);
+}
+
+uint64_t SaritaRtCheck::getNumViolations()
+{
+    uint64_t total = 0;
+    for (int i = 0; i < SARITA_RT_NUM_KINDS; i++)
+        total += getNumViolations(i);
+    return total;
+}
+
+uint64_t SaritaRtCheck::getNumSuppressed(int kind)
+{
+    return suppressedCounts[kind].load(std::memory_order_relaxed);
+}
+
+uint64_t SaritaRtCheck::getNumSuppressed()
+{
+    uint64_t total = 0;
+    for (int i = 0; i < SARITA_RT_NUM_KINDS; i++)
+        total += getNumSuppressed(i);
+    return total;
+}
+
+int SaritaRtCheck::getSites(SaritaRtSite* sites, int maxSites)
+{
+    int numSites = 0;
+    for (int i = 0; i < SARITA_RT_MAX_SITES && numSites < maxSites; i++) {
+        SiteSlot& slot = siteTable[i];
+        if (slot.key.load(std::memory_order_acquire) == 0 || !slot.ready.load(std::memory_order_acquire))
+            continue;
+        SaritaRtSite& site = sites[numSites++];
+        site.kind = slot.kind;
+        site.count = slot.count.load(std::memory_order_relaxed);
+        site.suppression = slot.suppression;
+        site.stackDepth = slot.stackDepth;
+        memcpy(site.stack, slot.stack, slot.stackDepth * sizeof(void*));
+    }
+    /* violations first, then the most frequent first */
+    auto before = [](const SaritaRtSite& a, const SaritaRtSite& b) {
+        if ((a.suppression == nullptr) != (b.suppression == nullptr))
+            return a.suppression == nullptr;
+        return a.count > b.count;
+    };
+    for (int i = 1; i < numSites; i++)
+        for (int j = i; j > 0 && before(sites[j], sites[j-1]); j--) {
+            SaritaRtSite tmp = sites[j];
+            sites[j] = sites[j-1];
+            sites[j-1] = tmp;
+        }
+    return numSites;
+}
+
+void SaritaRtCheck::printReport(FILE* out, int maxSites)
+{
+    SaritaRtSite sites[SARITA_RT_MAX_SITES];
+    int numSites = getSites(sites, SARITA_RT_MAX_SITES);
+    for (int i = 0; i < numSites && i < maxSites; i++) {
+        if (sites[i].suppression != nullptr)
+            fprintf(out, "%llu x %s (suppressed: %s), from:\n", (unsigned long long)sites[i].count,
+                    getKindName(sites[i].kind), sites[i].suppression);
+        else
+            fprintf(out, "%llu x %s, from:\n", (unsigned long long)sites[i].count, getKindName(sites[i].kind));
+#if SARITA_RT_HAS_BACKTRACE
+        for (int f = 0; f < sites[i].stackDepth; f++) {
+            Dl_info info;
+            if (dladdr(sites[i].stack[f], &info) && info.dli_sname != nullptr) {
+                int status = -1;
+                char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+                fprintf(out, "    #%-2d %s + %ld\n", f, status == 0 ? demangled : info.dli_sname,
+                        (long)((const char*)sites[i].stack[f] - (const char*)info.dli_saddr));
+                free(demangled);
+            }
+            else
+                fprintf(out, "    #%-2d %p (%s)\n", f, sites[i].stack[f],
+                        info.dli_fname != nullptr ? info.dli_fname : "?");
+        }
+#endif
+    }
+}
+
+void SaritaRtCheck::reset()
+{
+    for (auto& c : kindCounts)
+        c.store(0, std::memory_order_relaxed);
+    for (auto& c : suppressedCounts)
+        c.store(0, std::memory_order_relaxed);
+    for (auto& slot : siteTable) {
+        slot.ready.store(false, std::memory_order_relaxed);
+        slot.count.store(0, std::memory_order_relaxed);
+        slot.key.store(0, std::memory_order_release);
+    }
+}
+
+const char* SaritaRtCheck::getKindName(int kind)
+{
+    return (kind >= 0 && kind < SARITA_RT_NUM_KINDS) ? kindNames[kind] : "";
+}
+
+/* ========================================================================== */
+/*                                Interposers                                 */
+/* ========================================================================== */
+
+#if SARITA_RT_INTERPOSES_LIBC
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t num, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void* __libc_valloc(size_t size);
+void* __libc_pvalloc(size_t size);
+void __libc_free(void* ptr);
+}
+
+namespace {
+
+/* the other functions are looked up on first use */
+template <typename Fn>
+Fn nextSymbol(Fn& cached, const char* name)
+{
+    if (cached == nullptr)
+        cached = (Fn)dlsym(RTLD_NEXT, name);
+    return cached;
+}
+
+int (*nextMutexLock)(pthread_mutex_t*) = nullptr;
+FILE* (*nextFopen)(const char*, const char*) = nullptr;
+int (*nextFclose)(FILE*) = nullptr;
+size_t (*nextFread)(void*, size_t, size_t, FILE*) = nullptr;
+size_t (*nextFwrite)(const void*, size_t, size_t, FILE*) = nullptr;
+int (*nextOpen)(const char*, int, ...) = nullptr;
+ssize_t (*nextRead)(int, void*, size_t) = nullptr;
+ssize_t (*nextWrite)(int, const void*, size_t) = nullptr;
+
+/* resolve them all before any callback is checked */
+struct ResolveSymbols
+{
+    ResolveSymbols()
+    {
+        nextSymbol(nextMutexLock, "pthread_mutex_lock");
+        nextSymbol(nextFopen, "fopen");
+        nextSymbol(nextFclose, "fclose");
+        nextSymbol(nextFread, "fread");
+        nextSymbol(nextFwrite, "fwrite");
+        nextSymbol(nextOpen, "open");
+        nextSymbol(nextRead, "read");
+        nextSymbol(nextWrite, "write");
+    }
+} resolveSymbols;
+
+} // namespace
+
+extern "C" {
+
+void* malloc(size_t size)
+{
+    SaritaRtCheck::noteViolation(SARITA_RT_ALLOC, SARITA_RT_CALLER);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t num, size_t size)
+{
+    SaritaRtCheck::noteViolation(SARITA_RT_ALLOC, SARITA_RT_CALLER);
+    return __libc_calloc(num, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    SaritaRtCheck::noteViolation(SARITA_RT_ALLOC, SARITA_RT_CALLER);
+    return __libc_realloc(ptr, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size)
+{
+    SaritaRtCheck::noteViolation(SARITA_RT_ALLOC, SARITA_RT_CALLER);
+    *ptr = __libc_memalign(alignment, size);
+    return *ptr == nullptr ? 12 /* ENOMEM */ : 0;
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+    SaritaRtCheck::noteViolation(SARITA_RT_ALLOC, SARITA_RT_CALLER);
+    return __libc_memalign(alignment, size);
+}
+
+void* memalign(size_t alignment, size_t size)
+{
+    SaritaRtCheck::noteViolation(SARITA_RT_ALLOC, SARITA_RT_CALLER);
+    return __libc_memalign(alignment, size);
+}
+
+void* valloc(size_t size)
+{
+    SaritaRtCheck::noteViolation(SARITA_RT_ALLOC, SARITA_RT_CALLER);
+    return __libc_valloc(size);
+}
+
+void* pvalloc(size_t size)
+{
+    SaritaRtCheck::noteViolation(SARITA_RT_ALLOC, SARITA_RT_CALLER);
+    return __libc_pvalloc(size);
+}
+
+void free(void* ptr)
+{
+    if (ptr != nullptr)
+        SaritaRtCheck::noteViolation(SARITA_RT_FREE, SARITA_RT_CALLER);
+    __libc_free(ptr);
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex)
+{
+    SaritaRtCheck::noteViolation(SARITA_RT_LOCK, SARITA_RT_CALLER);
+    return nextSymbol(nextMutexLock, "pthread_mutex_lock")(mutex);
+}
+
+FILE* fopen(const char* path, const char* mode)
+{
+    SaritaRtCheck::noteViolation(SARITA_RT_FILE_IO, SARITA_RT_CALLER);
+    return nextSymbol(nextFopen, "fopen")(path, mode);
+}
+
+int fclose(FILE* stream)
+{
+    SaritaRtCheck::noteViolation(SARITA_RT_FILE_IO, SARITA_RT_CALLER);
+    return nextSymbol(nextFclose, "fclose")(stream);
+}
+
+size_t fread(void* ptr, size_t size, size_t count, FILE* stream)
+{
+    SaritaRtCheck::noteViolation(SARITA_RT_FILE_IO, SARITA_RT_CALLER);
+    return nextSymbol(nextFread, "fread")(ptr, size, count, stream);
+}
+
+size_t fwrite(const void* ptr, size_t size, size_t count, FILE* stream)
+{
+    SaritaRtCheck::noteViolation(SARITA_RT_FILE_IO, SARITA_RT_CALLER);
+    return nextSymbol(nextFwrite, "fwrite")(ptr, size, count, stream);
+}
+
+int open(const char* path, int flags, ...)
+{
+    /* the mode is only passed with O_CREAT or O_TMPFILE */
+    unsigned int mode = 0;
+    if ((flags & 0100) || (flags & 020000000)) {
+        va_list args;
+        va_start(args, flags);
+        mode = va_arg(args, unsigned int);
+        va_end(args);
+    }
+    SaritaRtCheck::noteViolation(SARITA_RT_FILE_IO, SARITA_RT_CALLER);
+    return nextSymbol(nextOpen, "open")(path, flags, mode);
+}
+
+ssize_t read(int fd, void* buf, size_t count)
+{
+    SaritaRtCheck::noteViolation(SARITA_RT_FILE_IO, SARITA_RT_CALLER);
+    return nextSymbol(nextRead, "read")(fd, buf, count);
+}
+
+ssize_t write(int fd, const void* buf, size_t count)
+{
+    SaritaRtCheck::noteViolation(SARITA_RT_FILE_IO, SARITA_RT_CALLER);
+    return nextSymbol(nextWrite, "write")(fd, buf, count);
+}
+
+} // extern "C"
+
+#endif /* SARITA_RT_INTERPOSES_LIBC */
+
+/* C++ allocations; these call the real allocator directly, so that they are
+ * attributed to the caller of new/delete rather than to the operators */
+static void* checkedNew(size_t size, void* caller)
+{
+    SaritaRtCheck::noteViolation(SARITA_RT_ALLOC, caller);
+#if SARITA_RT_INTERPOSES_LIBC
+    void* ptr = __libc_malloc(size == 0 ? 1 : size);
+#else
+    void* ptr = malloc(size == 0 ? 1 : size);
+#endif
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+static void checkedDelete(void* ptr, void* caller)
+{
+    if (ptr != nullptr)
+        SaritaRtCheck::noteViolation(SARITA_RT_FREE, caller);
+#if SARITA_RT_INTERPOSES_LIBC
+    __libc_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+void* operator new(size_t size) { return checkedNew(size, SARITA_RT_CALLER); }
+void* operator new[](size_t size) { return checkedNew(size, SARITA_RT_CALLER); }
+void operator delete(void* ptr) noexcept { checkedDelete(ptr, SARITA_RT_CALLER); }
+void operator delete[](void* ptr) noexcept { checkedDelete(ptr, SARITA_RT_CALLER); }
+void operator delete(void* ptr, size_t) noexcept { checkedDelete(ptr, SARITA_RT_CALLER); }
+void operator delete[](void* ptr, size_t) noexcept { checkedDelete(ptr, SARITA_RT_CALLER); }
+
+/* the nothrow versions would otherwise be attributed to the standard library,
+ * which implements them with the ones above */
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    try { return checkedNew(size, SARITA_RT_CALLER); } catch (...) { return nullptr; }
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    try { return checkedNew(size, SARITA_RT_CALLER); } catch (...) { return nullptr; }
+}
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { checkedDelete(ptr, SARITA_RT_CALLER); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { checkedDelete(ptr, SARITA_RT_CALLER); }
+
+#if defined(__cpp_aligned_new)
+/* over-aligned types (C++17) */
+static void* checkedAlignedNew(size_t size, std::align_val_t alignment, void* caller)
+{
+    SaritaRtCheck::noteViolation(SARITA_RT_ALLOC, caller);
+    size = size == 0 ? 1 : size;
+#if SARITA_RT_INTERPOSES_LIBC
+    void* ptr = __libc_memalign((size_t)alignment, size);
+#elif defined(_MSC_VER)
+    void* ptr = _aligned_malloc(size, (size_t)alignment);
+#else
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, (size_t)alignment, size) != 0)
+        ptr = nullptr;
+#endif
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+static void checkedAlignedDelete(void* ptr, void* caller)
+{
+    if (ptr != nullptr)
+        SaritaRtCheck::noteViolation(SARITA_RT_FREE, caller);
+#if SARITA_RT_INTERPOSES_LIBC
+    __libc_free(ptr);
+#elif defined(_MSC_VER)
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+void* operator new(size_t size, std::align_val_t al) { return checkedAlignedNew(size, al, SARITA_RT_CALLER); }
+void* operator new[](size_t size, std::align_val_t al) { return checkedAlignedNew(size, al, SARITA_RT_CALLER); }
+void* operator new(size_t size, std::align_val_t al, const std::nothrow_t&) noexcept
+{
+    try { return checkedAlignedNew(size, al, SARITA_RT_CALLER); } catch (...) { return nullptr; }
+}
+void* operator new[](size_t size, std::align_val_t al, const std::nothrow_t&) noexcept
+{
+    try { return checkedAlignedNew(size, al, SARITA_RT_CALLER); } catch (...) { return nullptr; }
+}
+void operator delete(void* ptr, std::align_val_t) noexcept { checkedAlignedDelete(ptr, SARITA_RT_CALLER); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { checkedAlignedDelete(ptr, SARITA_RT_CALLER); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { checkedAlignedDelete(ptr, SARITA_RT_CALLER); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { checkedAlignedDelete(ptr, SARITA_RT_CALLER); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { checkedAlignedDelete(ptr, SARITA_RT_CALLER); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { checkedAlignedDelete(ptr, SARITA_RT_CALLER); }
+#endif
+
+#endif /* SARITA_RT_CHECK */
@@ -0,0 +1,123 @@
+//
+//  SaritaRtCheck.h
+//  sparta_array2sh
+//
+//  Real-time safety checker for debug and benchmark builds.
+//
+//  While a thread is inside an SaritaRtScope (i.e. the audio callback), every
+//  heap allocation or release, mutex lock and file operation it makes is
+//  counted as a violation, and attributed to the call stack it was made from.
+//  The checks are made by interposing malloc()/free() and friends,
+//  pthread_mutex_lock() and the stdio/POSIX file functions (on glibc), and by
+//  replacing the global operator new/delete (everywhere), so they only belong
+//  in debug builds and the benchmark: build with SARITA_RT_CHECK=1.
+//
+//  Violations that are known and accepted (i.e. the lock OpenBLAS takes in
+//  every GEMM, unless it is built with USE_TLS=1) are suppressed by the
+//  function they are made from, as listed in SaritaRtCheck.cpp: they are
+//  counted and reported separately, and not as violations.
+//
+
+#ifndef sarita_rt_check_h
+#define sarita_rt_check_h
+
+#ifndef SARITA_RT_CHECK
+#define SARITA_RT_CHECK 0
+#endif
+
+#include <cstdint>
+#include <cstdio>
+
+/* kinds of violations */
+typedef enum {
+    SARITA_RT_ALLOC = 0, // malloc, calloc, realloc, posix_memalign,
+                         // aligned_alloc, memalign, valloc, pvalloc, new
+    SARITA_RT_FREE,      // free, delete
+    SARITA_RT_LOCK,      // pthread_mutex_lock (and so std::mutex)
+    SARITA_RT_FILE_IO,   // fopen, fclose, fread, fwrite, open, read, write
+    SARITA_RT_NUM_KINDS
+} SARITA_RT_VIOLATIONS;
+
+#define SARITA_RT_MAX_STACK_DEPTH ( 16 )
+#define SARITA_RT_MAX_SITES ( 64 )
+
+/* one call site and its number of violations; the stack is the one it was
+ * first reached from */
+struct SaritaRtSite
+{
+    int kind;
+    uint64_t count;
+    const char* suppression; // why it is accepted; nullptr for a violation
+    int stackDepth;
+    void* stack[SARITA_RT_MAX_STACK_DEPTH];
+};
+
+#if SARITA_RT_CHECK
+
+class SaritaRtCheck
+{
+public:
+    // true if malloc/locks/file I/O are checked, false if only new/delete are
+    static bool interposesLibc();
+
+    // marks the calling thread as being inside (or outside of) the callback;
+    // these nest
+    static void enterCallback();
+    static void exitCallback();
+
+    // counts and call sites since the last reset(); any thread. Suppressed
+    // violations are only counted by getNumSuppressed(); the sites are sorted
+    // violations first, and then by count
+    static uint64_t getNumViolations(int kind);
+    static uint64_t getNumViolations();
+    static uint64_t getNumSuppressed(int kind);
+    static uint64_t getNumSuppressed();
+    static int getSites(SaritaRtSite* sites, int maxSites);
+    // writes the (symbolised) call stacks of the first sites
+    static void printReport(FILE* out, int maxSites);
+    static void reset();
+
+    static const char* getKindName(int kind);
+
+    // called by the interposed functions, with their return address; a call
+    // stack is only unwound the first time a caller is seen
+    static void noteViolation(int kind, void* caller);
+};
+
+#else /* SARITA_RT_CHECK */
+
+/* no-op version, with the same interface */
+class SaritaRtCheck
+{
+public:
+    static bool interposesLibc() { return false; }
+    static void enterCallback() {}
+    static void exitCallback() {}
+    static uint64_t getNumViolations(int) { return 0; }
+    static uint64_t getNumViolations() { return 0; }
+    static uint64_t getNumSuppressed(int) { return 0; }
+    static uint64_t getNumSuppressed() { return 0; }
+    static int getSites(SaritaRtSite*, int) { return 0; }
+    static void printReport(FILE*, int) {}
+    static void reset() {}
+    static const char* getKindName(int) { return ""; }
+    static void noteViolation(int, void*) {}
+};
+
+#endif /* SARITA_RT_CHECK */
+
+// marks the enclosing scope as real-time
+class SaritaRtScope
+{
+public:
+    SaritaRtScope() { SaritaRtCheck::enterCallback(); }
+    ~SaritaRtScope() { SaritaRtCheck::exitCallback(); }
+};
+
+#if SARITA_RT_CHECK
+    #define SARITA_RT_SCOPE() SaritaRtScope saritaRtScope_
+#else
+    #define SARITA_RT_SCOPE() ((void)0)
+#endif
+
+#endif /* sarita_rt_check_h */
@@ -99,7 +99,34 @@ void anaview::paint (juce::Graphics& g)
 
     //[UserPaint] Add your own custom painting code here..
 
+    /* the labels do not change; only drawn once */
     localBounds = getBounds();
+    if (labelsImage.getWidth() != localBounds.getWidth() || labelsImage.getHeight() != localBounds.getHeight())
+        renderLabels();
+    g.drawImageAt(labelsImage, 0, 0);
+
+    /* draw curves */
+    //anaview_windowIncluded->repaint();/* No need to call, as eqview will repaint any children too */
+
+    //[/UserPaint]
+}
+
+void anaview::resized()
+{
+    //[UserPreResize] Add your own custom resize code here..
+    //[/UserPreResize]
+
+    //[UserResized] Add your own custom resize handling here..
+    //[/UserResized]
+}
+
+
+
+//[MiscUserCode] You can add your own definitions of your custom methods or any other code here...
+void anaview::renderLabels()
+{
+    labelsImage = Image(Image::ARGB, jmax(1, localBounds.getWidth()), jmax(1, localBounds.getHeight()), true);
+    Graphics g(labelsImage);
     int pow10;
     int min_pow10, max_pow10;
     float val, freq;
@@ -163,25 +190,8 @@ void anaview::paint (juce::Graphics& g)
                localBounds.getHeight()/2 - border_pixels_top - textWidth/2,
                textWidth, 50, Justification::centred);
     g.addTransform(AffineTransform());
-
-    /* draw curves */
-    //anaview_windowIncluded->repaint();/* No need to call, as eqview will repaint any children too */
-
-    //[/UserPaint]
-}
-
-void anaview::resized()
-{
-    //[UserPreResize] Add your own custom resize code here..
-    //[/UserPreResize]
-
-    //[UserResized] Add your own custom resize handling here..
-    //[/UserResized]
 }
 
-
-
-//[MiscUserCode] You can add your own definitions of your custom methods or any other code here...
 //void overlay::refreshView(){
 
     //repaint();
@@ -54,6 +54,10 @@ public:
     void setNumCurves(int _numCurves){
         anaview_windowIncluded->setNumCurves(_numCurves);
     }
+    /* repaints the curves if they have changed since the last call; see array2sh_getEvalVersion() */
+    void setCurvesVersion(unsigned int version){
+        anaview_windowIncluded->setCurvesVersion(version);
+    }
 
     //[/UserMethods]
 
@@ -68,6 +72,9 @@ private:
     float min_freq, max_freq, min_Y, max_Y, fs;
     String ylabel;
     float yaxislineStepSize;
+    Image labelsImage;
+
+    void renderLabels();
 
     //[/UserVariables]
 
@@ -44,6 +44,25 @@ static void setCurveColour(Graphics& g, int n){
         case 7: g.setColour(Colours::darkblue); break;
     }
 }
+
+/* appends the curve to 'path'; points that cannot be plotted (e.g. 0 Hz or -inf dB) break the line */
+template <typename GetY>
+static void addCurveToPath(Path& path, const float* freqVector, int numFreqPoints, float c, float m, GetY getYpixel){
+    bool newSubPath = true;
+    for(int f=0; f<numFreqPoints; f++){
+        float Xpixel = (log10f(freqVector[f]) - c)/m;
+        float Ypixel = getYpixel(f);
+        if (!std::isfinite(Xpixel) || !std::isfinite(Ypixel)) {
+            newSubPath = true;
+            continue;
+        }
+        if (newSubPath)
+            path.startNewSubPath(Xpixel, Ypixel);
+        else
+            path.lineTo(Xpixel, Ypixel);
+        newSubPath = false;
+    }
+}
 //[/MiscUserDefs]
 
 //==============================================================================
@@ -75,6 +94,9 @@ anaview_window::anaview_window (int _width, int _height, float _min_freq, float
 
     freqVector = NULL;
     solidCurves = NULL;
+    numCurves = 0;
+    numFreqPoints = 0;
+    setOpaque(true);
 
     //[/Constructor]
 }
@@ -98,6 +120,69 @@ void anaview_window::paint (Graphics& g)
 
     //[UserPaint] Add your own custom painting code here..
 
+    if (backgroundImage.getWidth() != localBounds.getWidth() || backgroundImage.getHeight() != localBounds.getHeight())
+        renderBackground();
+    if (curvesAreStale)
+        buildCurvePaths();
+    g.drawImageAt(backgroundImage, 0, 0);
+
+    /* plot solid curves (if defined) */
+    for(int crv=0; crv<(int)solidPaths.size(); crv++){
+        /* background line */
+        g.setColour(Colours::white);
+        g.setOpacity(0.1f);
+        g.strokePath(solidPaths[crv], PathStrokeType(5.0f));
+        /* main */
+        setCurveColour(g, crv);
+        g.setOpacity(1.0f);
+        g.strokePath(solidPaths[crv], PathStrokeType(2.0f));
+    }
+
+    /* Plot legend */
+    float leg_x = 460;
+    float leg_y = 82;
+    g.setColour(Colours::grey);
+    g.setOpacity(1.0f);
+    g.drawRect(leg_x, leg_y, 38.0f, 10.0f*(float)numCurves, 1.0f);
+    g.setOpacity(0.25f);
+    g.fillRect(leg_x, leg_y, 38.0f, 10.0f*(float)numCurves);
+    g.setOpacity(1.0f);
+    g.setFont(9.0f);
+    String suffix;
+    for(int crv=0; crv<numCurves; crv++){
+        g.setColour(Colours::white);
+        if(crv==1)
+            suffix = "st";
+        else if(crv==2)
+            suffix = "nd";
+        else if(crv==3)
+            suffix = "rd";
+        else
+            suffix = "th";
+        g.drawText(String(crv)+suffix, leg_x+2.0f, leg_y+(float)crv*10.0f, 30.0f, 8.0f, Justification::centredLeft);
+        setCurveColour(g, crv);
+        g.drawLine(leg_x+18.0f, leg_y+(float)crv*10.0f+4.0f, leg_x+34.0f, leg_y+(float)crv*10.0f+4.0f, 2.0f);
+    }
+    //[/UserPaint]
+}
+
+void anaview_window::resized()
+{
+    //[UserPreResize] Add your own custom resize code here..
+    //[/UserPreResize]
+
+    //[UserResized] Add your own custom resize handling here..
+    //[/UserResized]
+}
+
+
+
+//[MiscUserCode] You can add your own definitions of your custom methods or any other code here...
+void anaview_window::renderBackground()
+{
+    backgroundImage = Image(Image::RGB, jmax(1, localBounds.getWidth()), jmax(1, localBounds.getHeight()), false);
+    Graphics g(backgroundImage);
+
     /* background */
     //Colour fillColour1 = Colour (0x75707070), fillColour2 = Colour (0xa1202020);
     Colour fillColour1 = Colour (0xff4e4e4e), fillColour2 = Colour (0xff202020);
@@ -140,73 +225,25 @@ void anaview_window::paint (Graphics& g)
             g.drawLine(0,localBounds.getHeight()-Ypixel, localBounds.getWidth(), localBounds.getHeight()-Ypixel,1.0f);
         }
     }
-
-    /* plot solid curves (if defined) */
-    if ( (freqVector != NULL) && (solidCurves != NULL) ){
-        for(int crv=0; crv<numCurves; crv++){
-            for(int f=0; f<numFreqPoints-1; f++){
-                float Xpixel = (log10f(freqVector[f]) - c)/m;
-                float Ypixel = (solidCurves[f*numCurves+crv]-min_Y)* ((float)localBounds.getHeight()/(max_Y-min_Y));
-                float Xpixel_next = (log10f(freqVector[f+1]) - c)/m;
-                float Ypixel_next = (solidCurves[(f+1)*numCurves+crv]-min_Y)* ((float)localBounds.getHeight()/(max_Y-min_Y));
-                /* background line */
-                g.setColour(Colours::white);
-                g.setOpacity(0.1f);
-                g.drawLine(Xpixel, localBounds.getHeight()-Ypixel, Xpixel_next, localBounds.getHeight()-Ypixel_next, 5.0f);
-                /* main */
-                setCurveColour(g, crv);
-                g.setOpacity(1.0f);
-                g.drawLine(Xpixel, localBounds.getHeight()-Ypixel, Xpixel_next, localBounds.getHeight()-Ypixel_next, 2.0f);
-            }
-        }
-    }
-
-    /* Plot legend */
-    float leg_x = 460;
-    float leg_y = 82;
-    g.setColour(Colours::grey);
-    g.setOpacity(1.0f);
-    g.drawRect(leg_x, leg_y, 38.0f, 10.0f*(float)numCurves, 1.0f);
-    g.setOpacity(0.25f);
-    g.fillRect(leg_x, leg_y, 38.0f, 10.0f*(float)numCurves);
-    g.setOpacity(1.0f);
-    g.setFont(9.0f);
-    String suffix;
-    for(int crv=0; crv<numCurves; crv++){
-        g.setColour(Colours::white);
-        if(crv==1)
-            suffix = "st";
-        else if(crv==2)
-            suffix = "nd";
-        else if(crv==3)
-            suffix = "rd";
-        else
-            suffix = "th";
-        g.drawText(String(crv)+suffix, leg_x+2.0f, leg_y+(float)crv*10.0f, 30.0f, 8.0f, Justification::centredLeft);
-        setCurveColour(g, crv);
-        g.drawLine(leg_x+18.0f, leg_y+(float)crv*10.0f+4.0f, leg_x+34.0f, leg_y+(float)crv*10.0f+4.0f, 2.0f);
-    }
-    //[/UserPaint]
 }
 
-void anaview_window::resized()
+void anaview_window::buildCurvePaths()
 {
-    //[UserPreResize] Add your own custom resize code here..
-    //[/UserPreResize]
-
-    //[UserResized] Add your own custom resize handling here..
-    //[/UserResized]
+    float c = log10f(min_freq);
+    float m = (log10f(max_freq) - c)/(float)localBounds.getWidth();
+    float scale = (float)localBounds.getHeight()/(max_Y-min_Y);
+    float bottom = (float)localBounds.getHeight();
+
+    /* solid curves (if defined) */
+    solidPaths.resize( (freqVector != NULL) && (solidCurves != NULL) ? (size_t)numCurves : 0 );
+    for(int crv=0; crv<(int)solidPaths.size(); crv++){
+        solidPaths[crv].clear();
+        addCurveToPath(solidPaths[crv], freqVector, numFreqPoints, c, m,
+                       [&](int f) { return bottom - (solidCurves[f*numCurves+crv]-min_Y)*scale; });
+    }
+    curvesAreStale = false;
 }
 
-
-
-//[MiscUserCode] You can add your own definitions of your custom methods or any other code here...
-//void overlay::refreshPowerMap(){
-//
-//    repaint();
-//
-//}
-
 //[/MiscUserCode]
 
 
@@ -0,0 +1,197 @@
+/*
+  ==============================================================================
+
+  This is an automatically generated GUI class created by the Projucer!
+
+  Be careful when adding custom code to these files, as only the code within
+  the "//[xyz]" and "//[/xyz]" sections will be retained when the file is loaded
+  and re-saved.
+
+  Created with Projucer version: 6.0.5
+
+  ------------------------------------------------------------------------------
+
+  The Projucer is part of the JUCE library.
+  Copyright (c) 2020 - Raw Material Software Limited.
+
+  ==============================================================================
+*/
+
+//[Headers] You can add your own extra header files here...
+
+//[/Headers]
+
+#include "diagview.h"
+
+
+//[MiscUserDefs] You can add your own user definitions and misc code here...
+
+const int diag_border_pixels = 8;
+const int diag_header_height = 18;
+const int diag_label_height = 16;
+const int diag_stage_label_width = 80;
+
+//[/MiscUserDefs]
+
+//==============================================================================
+diagview::diagview (int _width, int _height)
+{
+    //[Constructor_pre] You can add your own custom stuff here..
+    //[/Constructor_pre]
+
+
+    //[UserPreSize]
+    //[/UserPreSize]
+
+    setSize (600, 400);
+
+
+    //[Constructor] You can add your own custom stuff here..
+    setSize (_width, _height);
+    localBounds = getLocalBounds();
+
+    width = _width;
+    height =_height;
+    memset(&stats, 0, sizeof(stats));
+
+    //[/Constructor]
+}
+
+diagview::~diagview()
+{
+    //[Destructor_pre]. You can add your own custom destruction code here..
+    //[/Destructor_pre]
+
+
+
+    //[Destructor]. You can add your own custom destruction code here..
+    //[/Destructor]
+}
+
+//==============================================================================
+void diagview::paint (juce::Graphics& g)
+{
+    //[UserPrePaint] Add your own custom painting code here..
+    //[/UserPrePaint]
+
+    //[UserPaint] Add your own custom painting code here..
+
+    /* background */
+    Colour fillColour1 = Colour (0xff4e4e4e), fillColour2 = Colour (0xff202020);
+    g.setGradientFill (ColourGradient (fillColour1, 0, 0,
+                                       fillColour2, 0, (float)height,
+                                       false));
+    g.fillRect (localBounds);
+    g.setColour(Colours::white);
+    g.setOpacity(0.3f);
+    g.drawRect (localBounds);
+
+    /* summary */
+    g.setColour(Colours::white);
+    g.setFont(Font(12.00f, Font::plain));
+#if SARITA_ENABLE_TIMING
+    String summary = "Callbacks: " + String((int64)stats.numCallbacks) +
+                     "   Overruns: " + String((int64)stats.numOverruns) +
+                     "   Mean load: " + String(100.0*stats.meanLoad, 1) + " %" +
+                     "   Max load: " + String(100.0*stats.maxLoad, 1) + " %";
+#else
+    String summary = "Timing was disabled at compile time (SARITA_ENABLE_TIMING=0)";
+#endif
+    g.drawText(summary, diag_border_pixels, 2, width-2*diag_border_pixels, diag_header_height, Justification::centredLeft);
+
+    /* share of each stage */
+    int stagesWidth = width/2 - 2*diag_border_pixels;
+    int barX = diag_border_pixels + diag_stage_label_width;
+    int barMaxWidth = stagesWidth - diag_stage_label_width - 45;
+    int rowHeight = (height - diag_header_height - 2*diag_border_pixels)/SARITA_NUM_STAGES;
+    uint64_t totalTicks = 0;
+    for (int i = 0; i < SARITA_NUM_STAGES; i++)
+        totalTicks += stats.stageTicks[i];
+    for (int i = 0; i < SARITA_NUM_STAGES; i++) {
+        int y = diag_header_height + diag_border_pixels + i*rowHeight;
+        float share = totalTicks > 0 ? (float)stats.stageTicks[i]/(float)totalTicks : 0.0f;
+        g.setColour(Colours::white);
+        g.drawText(sarita_getStageName(i), diag_border_pixels, y, diag_stage_label_width, rowHeight, Justification::centredLeft);
+        g.setColour(Colour (0xff5c68a4));
+        g.fillRect((float)barX, (float)y + 0.2f*(float)rowHeight, share*(float)barMaxWidth, 0.6f*(float)rowHeight);
+        g.setColour(Colours::white);
+        g.drawText(String(100.0f*share, 1) + " %", barX + barMaxWidth, y, 45, rowHeight, Justification::centredRight);
+    }
+
+    /* callback time / deadline histogram */
+    int histX = width/2 + diag_border_pixels;
+    int histWidth = width/2 - 2*diag_border_pixels;
+    int histTop = diag_header_height + diag_border_pixels;
+    int histHeight = height - histTop - diag_border_pixels - diag_label_height;
+    float bucketWidth = (float)histWidth/(float)SARITA_NUM_LOAD_BUCKETS;
+    uint64_t maxCount = 1;
+    for (int i = 0; i < SARITA_NUM_LOAD_BUCKETS; i++)
+        maxCount = jmax(maxCount, stats.loadHistogram[i]);
+    for (int i = 0; i < SARITA_NUM_LOAD_BUCKETS; i++) {
+        /* counts are shown on a log scale, so that rare overruns stay visible */
+        float h = stats.loadHistogram[i] > 0 ? (float)(std::log10((double)stats.loadHistogram[i] + 1.0)/std::log10((double)maxCount + 1.0)) : 0.0f;
+        float x = (float)histX + (float)i*bucketWidth;
+        g.setColour(i >= SARITA_LOAD_BUCKET_DEADLINE ? Colour (0xffc84c4c) : Colour (0xff14889e));
+        g.fillRect(x + 1.0f, (float)histTop + (1.0f-h)*(float)histHeight, bucketWidth - 2.0f, h*(float)histHeight);
+        if (i % 3 == 0) {
+            double edge = sarita_getLoadBucketEdge(i);
+            String label = i == 0 ? String("0") : (edge < 1.0 ? "1/" + String((int)(1.0/edge + 0.5)) : String((int)edge));
+            g.setColour(Colours::white);
+            g.drawText(label, (int)x - 15, histTop + histHeight, 30, diag_label_height, Justification::centred);
+        }
+    }
+    /* deadline */
+    float deadlineX = (float)histX + (float)SARITA_LOAD_BUCKET_DEADLINE*bucketWidth;
+    g.setColour(Colours::white);
+    g.setOpacity(0.6f);
+    g.drawLine(deadlineX, (float)histTop, deadlineX, (float)(histTop + histHeight), 1.0f);
+    g.drawText("deadline", (int)deadlineX + 3, histTop, 60, diag_label_height, Justification::centredLeft);
+
+    //[/UserPaint]
+}
+
+void diagview::resized()
+{
+    //[UserPreResize] Add your own custom resize code here..
+    //[/UserPreResize]
+
+    //[UserResized] Add your own custom resize handling here..
+    //[/UserResized]
+}
+
+
+
+//[MiscUserCode] You can add your own definitions of your custom methods or any other code here...
+void diagview::mouseDown (const juce::MouseEvent& /*e*/)
+{
+    if (onReset)
+        onReset();
+}
+
+//[/MiscUserCode]
+
+
+//==============================================================================
+#if 0
+/*  -- Projucer information section --
+
+    This is where the Projucer stores the metadata that describe this GUI layout, so
+    make changes in here at your peril!
+
+BEGIN_JUCER_METADATA
+
+<JUCER_COMPONENT documentType="Component" className="diagview" componentName=""
+                 parentClasses="public Component" constructorParams="int _width, int _height"
+                 variableInitialisers="" snapPixels="8" snapActive="1" snapShown="1"
+                 overlayOpacity="0.330" fixedSize="1" initialWidth="600" initialHeight="400">
+  <BACKGROUND backgroundColour="222222"/>
+</JUCER_COMPONENT>
+
+END_JUCER_METADATA
+*/
+#endif
+
+
+//[EndFile] You can add extra defines here...
+//[/EndFile]
+
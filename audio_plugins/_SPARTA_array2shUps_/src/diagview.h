@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+
+  This is an automatically generated GUI class created by the Projucer!
+
+  Be careful when adding custom code to these files, as only the code within
+  the "//[xyz]" and "//[/xyz]" sections will be retained when the file is loaded
+  and re-saved.
+
+  Created with Projucer version: 6.0.5
+
+  ------------------------------------------------------------------------------
+
+  The Projucer is part of the JUCE library.
+  Copyright (c) 2020 - Raw Material Software Limited.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+//[Headers]     -- You can add your own extra header files here --
+
+#include "JuceHeader.h"
+#include "sarita.h"
+
+//[/Headers]
+
+
+
+//==============================================================================
+/**
+                                                                    //[Comments]
+    Diagnostics panel: share of the processing time spent in each stage of the
+    SARITA/array2sh chain, and a histogram of the callback times relative to
+    the deadline (blocksize/fs). Click the panel to reset the counters.
+                                                                    //[/Comments]
+*/
+class diagview  : public juce::Component
+{
+public:
+    //==============================================================================
+    diagview (int _width, int _height);
+    ~diagview() override;
+
+    //==============================================================================
+    //[UserMethods]     -- You can add your own custom methods in this section.
+    juce::Rectangle<int> localBounds;
+    std::function<void()> onReset;
+
+    void setStats(const SaritaTimingStats& _stats){
+        stats = _stats;
+    }
+    void mouseDown (const juce::MouseEvent& e) override;
+
+    //[/UserMethods]
+
+    void paint (juce::Graphics& g) override;
+    void resized() override;
+
+
+
+private:
+    //[UserVariables]   -- You can add your own custom variables in this section.
+    int width, height;
+    SaritaTimingStats stats;
+
+    //[/UserVariables]
+
+    //==============================================================================
+
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (diagview)
+};
+
+//[EndFile] You can add extra defines here...
+//[/EndFile]
+
@@ -98,7 +98,34 @@ void eqview::paint (juce::Graphics& g)
 
     //[UserPaint] Add your own custom painting code here..
 
+    /* the labels do not change; only drawn once */
     localBounds = getBounds();
+    if (labelsImage.getWidth() != localBounds.getWidth() || labelsImage.getHeight() != localBounds.getHeight())
+        renderLabels();
+    g.drawImageAt(labelsImage, 0, 0);
+
+    /* draw curves */
+    //eqview_windowIncluded->repaint(); /* No need to call, as eqview will repaint any children too */
+
+    //[/UserPaint]
+}
+
+void eqview::resized()
+{
+    //[UserPreResize] Add your own custom resize code here..
+    //[/UserPreResize]
+
+    //[UserResized] Add your own custom resize handling here..
+    //[/UserResized]
+}
+
+
+
+//[MiscUserCode] You can add your own definitions of your custom methods or any other code here...
+void eqview::renderLabels()
+{
+    labelsImage = Image(Image::ARGB, jmax(1, localBounds.getWidth()), jmax(1, localBounds.getHeight()), true);
+    Graphics g(labelsImage);
     int pow10;
     int min_pow10, max_pow10;
     float val, freq;
@@ -162,25 +189,8 @@ void eqview::paint (juce::Graphics& g)
                localBounds.getHeight()/2 - border_pixels_top - textWidth/2,
                textWidth, 50, Justification::centred);
     g.addTransform(AffineTransform());
-
-    /* draw curves */
-    //eqview_windowIncluded->repaint(); /* No need to call, as eqview will repaint any children too */
-
-    //[/UserPaint]
-}
-
-void eqview::resized()
-{
-    //[UserPreResize] Add your own custom resize code here..
-    //[/UserPreResize]
-
-    //[UserResized] Add your own custom resize handling here..
-    //[/UserResized]
 }
 
-
-
-//[MiscUserCode] You can add your own definitions of your custom methods or any other code here...
 //void overlay::refreshView(){
 
     //repaint();
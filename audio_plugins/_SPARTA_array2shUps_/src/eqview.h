@@ -57,6 +57,10 @@ public:
     void setNumCurves(int _numCurves){
         eqview_windowIncluded->setNumCurves(_numCurves);
     }
+    /* repaints the curves if they have changed since the last call; see array2sh_getbNVersion() */
+    void setCurvesVersion(unsigned int version){
+        eqview_windowIncluded->setCurvesVersion(version);
+    }
 
     //[/UserMethods]
 
@@ -69,7 +73,9 @@ private:
     //[UserVariables]   -- You can add your own custom variables in this section.
     int width, height;
     float min_freq, max_freq, min_dB, max_dB, fs;
+    Image labelsImage;
 
+    void renderLabels();
 
     //[/UserVariables]
 
@@ -45,6 +45,25 @@ static void setCurveColour(Graphics& g, int n){
         case 7: g.setColour(Colours::darkblue); break;
     }
 }
+
+/* appends the curve to 'path'; points that cannot be plotted (e.g. 0 Hz or -inf dB) break the line */
+template <typename GetY>
+static void addCurveToPath(Path& path, const float* freqVector, int numFreqPoints, float c, float m, GetY getYpixel){
+    bool newSubPath = true;
+    for(int f=0; f<numFreqPoints; f++){
+        float Xpixel = (log10f(freqVector[f]) - c)/m;
+        float Ypixel = getYpixel(f);
+        if (!std::isfinite(Xpixel) || !std::isfinite(Ypixel)) {
+            newSubPath = true;
+            continue;
+        }
+        if (newSubPath)
+            path.startNewSubPath(Xpixel, Ypixel);
+        else
+            path.lineTo(Xpixel, Ypixel);
+        newSubPath = false;
+    }
+}
 //[/MiscUserDefs]
 
 //==============================================================================
@@ -76,6 +95,9 @@ eqview_window::eqview_window (int _width, int _height, float _min_freq, float _m
     freqVector = NULL;
     solidCurves = NULL;
     faintCurves = NULL;
+    numCurves = 0;
+    numFreqPoints = 0;
+    setOpaque(true);
 
     //[/Constructor]
 }
@@ -99,87 +121,34 @@ void eqview_window::paint (Graphics& g)
 
     //[UserPaint] Add your own custom painting code here..
 
-    /* background */
-    //Colour fillColour1 = Colour (0x75707070), fillColour2 = Colour (0xa1202020);
-    Colour fillColour1 = Colour (0xff4e4e4e), fillColour2 = Colour (0xff202020);
-    g.setGradientFill (ColourGradient (fillColour1, 0, 0,
-                                       fillColour2, 0, localBounds.getHeight(),
-                                       false));
-    g.fillRect (localBounds);
-    g.setColour(Colours::white);
-    g.setOpacity(0.3f);
-    g.drawRect (localBounds);
-
-    /* draw frequency guide lines */
-    g.setColour(Colours::white);
-    g.setOpacity(0.22f);
-    float freq;
-    float c = log10f(min_freq);
-    float m = (log10f(max_freq) - c)/(float)localBounds.getWidth();
-    bool done = false;
-    freq = min_freq;
-    while(!done){
-        float Xpixel = (log10f(freq) - c)/m;
-        g.drawLine(Xpixel, 0.0f, Xpixel, localBounds.getHeight(), 1.0f);
-        if (freq <= max_freq){
-            if(freq<10.0f){ freq+=1.0f; } else if(freq<1e2){ freq+=10.0f; } else if (freq<1e3f){ freq+=100.0f; }
-            else if (freq<1e4f){ freq+=1000.0f; } else if (freq<1e5f){ freq+=10000.0f; }
-        }
-        else{
-            done = true;
-        }
-    }
-
-    /* draw magnitude guide lines */
-    g.setColour(Colours::white);
-    g.setOpacity(0.08f);
-    float start_dB = round_nearest(min_dB<0 ? min_dB-mag_lines_interval : min_dB, mag_lines_interval);
-    float end_dB= round_nearest(max_dB, mag_lines_interval);
-    for (int i = start_dB; i<=end_dB; i+=mag_lines_interval){
-        float Ypixel = ((float)i-min_dB)* ((float)localBounds.getHeight()/(max_dB-min_dB));
-        if ((i>min_dB-1) && (i< max_dB+1)){
-            g.drawLine(0,localBounds.getHeight()-Ypixel, localBounds.getWidth(), localBounds.getHeight()-Ypixel,1.0f);
-        }
-    }
+    if (backgroundImage.getWidth() != localBounds.getWidth() || backgroundImage.getHeight() != localBounds.getHeight())
+        renderBackground();
+    if (curvesAreStale)
+        buildCurvePaths();
+    g.drawImageAt(backgroundImage, 0, 0);
 
     /* plot faint magnitude curves (if defined) */
-    if ( (freqVector != NULL) && (faintCurves != NULL) ){
-        for(int crv=0; crv<numCurves; crv++){
-            for(int f=0; f<numFreqPoints-1; f++){
-                float Xpixel = (log10f(freqVector[f]) - c)/m;
-                float Ypixel = (faintCurves[f][crv]-min_dB)* ((float)localBounds.getHeight()/(max_dB-min_dB));
-                float Xpixel_next = (log10f(freqVector[f+1]) - c)/m;
-                float Ypixel_next = (faintCurves[f+1][crv]-min_dB)* ((float)localBounds.getHeight()/(max_dB-min_dB));
-                /* background line */
-                g.setColour(Colours::white);
-                g.setOpacity(0.1f);
-                g.drawLine(Xpixel, localBounds.getHeight()-Ypixel, Xpixel_next, localBounds.getHeight()-Ypixel_next, 2.0f);
-                /* main */
-                setCurveColour(g, crv);
-                g.setOpacity(0.3f);
-                g.drawLine(Xpixel, localBounds.getHeight()-Ypixel, Xpixel_next, localBounds.getHeight()-Ypixel_next, 1.0f);
-            }
-        }
+    for(int crv=0; crv<(int)faintPaths.size(); crv++){
+        /* background line */
+        g.setColour(Colours::white);
+        g.setOpacity(0.1f);
+        g.strokePath(faintPaths[crv], PathStrokeType(2.0f));
+        /* main */
+        setCurveColour(g, crv);
+        g.setOpacity(0.3f);
+        g.strokePath(faintPaths[crv], PathStrokeType(1.0f));
     }
 
     /* plot solid magnitude curves (if defined) */
-    if ( (freqVector != NULL) && (solidCurves != NULL) ){
-        for(int crv=0; crv<numCurves; crv++){
-            for(int f=0; f<numFreqPoints-1; f++){
-                float Xpixel = (log10f(freqVector[f]) - c)/m;
-                float Ypixel = (solidCurves[f][crv]-min_dB)* ((float)localBounds.getHeight()/(max_dB-min_dB));
-                float Xpixel_next = (log10f(freqVector[f+1]) - c)/m;
-                float Ypixel_next = (solidCurves[f+1][crv]-min_dB)* ((float)localBounds.getHeight()/(max_dB-min_dB));
-                /* background line */
-                g.setColour(Colours::white);
-                g.setOpacity(0.1f);
-                g.drawLine(Xpixel, localBounds.getHeight()-Ypixel, Xpixel_next, localBounds.getHeight()-Ypixel_next, 5.0f);
-                /* main */
-                setCurveColour(g, crv);
-                g.setOpacity(1.0f);
-                g.drawLine(Xpixel, localBounds.getHeight()-Ypixel, Xpixel_next, localBounds.getHeight()-Ypixel_next, 2.0f);
-            }
-        }
+    for(int crv=0; crv<(int)solidPaths.size(); crv++){
+        /* background line */
+        g.setColour(Colours::white);
+        g.setOpacity(0.1f);
+        g.strokePath(solidPaths[crv], PathStrokeType(5.0f));
+        /* main */
+        setCurveColour(g, crv);
+        g.setOpacity(1.0f);
+        g.strokePath(solidPaths[crv], PathStrokeType(2.0f));
     }
 
     /* Plot legend */
@@ -222,11 +191,79 @@ void eqview_window::resized()
 
 
 //[MiscUserCode] You can add your own definitions of your custom methods or any other code here...
-//void overlay::refreshPowerMap(){
-//
-//    repaint();
-//
-//}
+void eqview_window::renderBackground()
+{
+    backgroundImage = Image(Image::RGB, jmax(1, localBounds.getWidth()), jmax(1, localBounds.getHeight()), false);
+    Graphics g(backgroundImage);
+
+    /* background */
+    //Colour fillColour1 = Colour (0x75707070), fillColour2 = Colour (0xa1202020);
+    Colour fillColour1 = Colour (0xff4e4e4e), fillColour2 = Colour (0xff202020);
+    g.setGradientFill (ColourGradient (fillColour1, 0, 0,
+                                       fillColour2, 0, localBounds.getHeight(),
+                                       false));
+    g.fillRect (localBounds);
+    g.setColour(Colours::white);
+    g.setOpacity(0.3f);
+    g.drawRect (localBounds);
+
+    /* draw frequency guide lines */
+    g.setColour(Colours::white);
+    g.setOpacity(0.22f);
+    float freq;
+    float c = log10f(min_freq);
+    float m = (log10f(max_freq) - c)/(float)localBounds.getWidth();
+    bool done = false;
+    freq = min_freq;
+    while(!done){
+        float Xpixel = (log10f(freq) - c)/m;
+        g.drawLine(Xpixel, 0.0f, Xpixel, localBounds.getHeight(), 1.0f);
+        if (freq <= max_freq){
+            if(freq<10.0f){ freq+=1.0f; } else if(freq<1e2){ freq+=10.0f; } else if (freq<1e3f){ freq+=100.0f; }
+            else if (freq<1e4f){ freq+=1000.0f; } else if (freq<1e5f){ freq+=10000.0f; }
+        }
+        else{
+            done = true;
+        }
+    }
+
+    /* draw magnitude guide lines */
+    g.setColour(Colours::white);
+    g.setOpacity(0.08f);
+    float start_dB = round_nearest(min_dB<0 ? min_dB-mag_lines_interval : min_dB, mag_lines_interval);
+    float end_dB= round_nearest(max_dB, mag_lines_interval);
+    for (int i = start_dB; i<=end_dB; i+=mag_lines_interval){
+        float Ypixel = ((float)i-min_dB)* ((float)localBounds.getHeight()/(max_dB-min_dB));
+        if ((i>min_dB-1) && (i< max_dB+1)){
+            g.drawLine(0,localBounds.getHeight()-Ypixel, localBounds.getWidth(), localBounds.getHeight()-Ypixel,1.0f);
+        }
+    }
+}
+
+void eqview_window::buildCurvePaths()
+{
+    float c = log10f(min_freq);
+    float m = (log10f(max_freq) - c)/(float)localBounds.getWidth();
+    float scale = (float)localBounds.getHeight()/(max_dB-min_dB);
+    float bottom = (float)localBounds.getHeight();
+
+    /* faint magnitude curves (if defined) */
+    faintPaths.resize( (freqVector != NULL) && (faintCurves != NULL) ? (size_t)numCurves : 0 );
+    for(int crv=0; crv<(int)faintPaths.size(); crv++){
+        faintPaths[crv].clear();
+        addCurveToPath(faintPaths[crv], freqVector, numFreqPoints, c, m,
+                       [&](int f) { return bottom - (faintCurves[f][crv]-min_dB)*scale; });
+    }
+
+    /* solid magnitude curves (if defined) */
+    solidPaths.resize( (freqVector != NULL) && (solidCurves != NULL) ? (size_t)numCurves : 0 );
+    for(int crv=0; crv<(int)solidPaths.size(); crv++){
+        solidPaths[crv].clear();
+        addCurveToPath(solidPaths[crv], freqVector, numFreqPoints, c, m,
+                       [&](int f) { return bottom - (solidCurves[f][crv]-min_dB)*scale; });
+    }
+    curvesAreStale = false;
+}
 
 //[/MiscUserCode]
 
@@ -56,6 +56,7 @@ public:
         solidCurves = _solidCurves;
         numCurves =_numCurves;
         numFreqPoints = _numFreqPoints;
+        curvesAreStale = true;
     }
 
     void setFaintCurves_Handle(float* _freqVector, float** _faintCurves, int _numFreqPoints, int _numCurves)
@@ -64,10 +65,24 @@ public:
         faintCurves = _faintCurves;
         numCurves =_numCurves;
         numFreqPoints = _numFreqPoints;
+        curvesAreStale = true;
     }
 
     void setNumCurves(int _numCurves){
-        numCurves = _numCurves;
+        if (_numCurves != numCurves) {
+            numCurves = _numCurves;
+            curvesAreStale = true;
+            repaint();
+        }
+    }
+
+    /* the curves are only re-read when this has changed (e.g. array2sh_getbNVersion()) */
+    void setCurvesVersion(unsigned int version){
+        if (version != curvesVersion) {
+            curvesVersion = version;
+            curvesAreStale = true;
+            repaint();
+        }
     }
 
     //[/UserMethods]
@@ -88,6 +103,15 @@ private:
     int numCurves;
     int numFreqPoints;
 
+    /* background and guide lines, drawn once; paths of the curves, rebuilt when they have changed */
+    Image backgroundImage;
+    std::vector<Path> solidPaths, faintPaths;
+    unsigned int curvesVersion = 0;
+    bool curvesAreStale = true;
+
+    void renderBackground();
+    void buildCurvePaths();
+
     //[/UserVariables]
 
     //==============================================================================
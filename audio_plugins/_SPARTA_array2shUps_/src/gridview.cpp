@@ -0,0 +1,198 @@
+/*
+  ==============================================================================
+
+  This is an automatically generated GUI class created by the Projucer!
+
+  Be careful when adding custom code to these files, as only the code within
+  the "//[xyz]" and "//[/xyz]" sections will be retained when the file is loaded
+  and re-saved.
+
+  Created with Projucer version: 6.0.5
+
+  ------------------------------------------------------------------------------
+
+  The Projucer is part of the JUCE library.
+  Copyright (c) 2020 - Raw Material Software Limited.
+
+  ==============================================================================
+*/
+
+//[Headers] You can add your own extra header files here...
+
+//[/Headers]
+
+#include "gridview.h"
+
+
+//[MiscUserDefs] You can add your own user definitions and misc code here...
+
+const int grid_border_pixels = 8;
+const int grid_header_height = 18;
+const int grid_label_width = 28;
+
+//[/MiscUserDefs]
+
+//==============================================================================
+gridview::gridview (int _width, int _height)
+{
+    //[Constructor_pre] You can add your own custom stuff here..
+    //[/Constructor_pre]
+
+
+    //[UserPreSize]
+    //[/UserPreSize]
+
+    setSize (600, 400);
+
+
+    //[Constructor] You can add your own custom stuff here..
+    setSize (_width, _height);
+    localBounds = getLocalBounds();
+
+    width = _width;
+    height =_height;
+    dirs_deg.reserve(2*ARRAY2SH_MAX_NUM_SENSORS);
+    setOpaque(true);
+
+    //[/Constructor]
+}
+
+gridview::~gridview()
+{
+    //[Destructor_pre]. You can add your own custom destruction code here..
+    //[/Destructor_pre]
+
+
+
+    //[Destructor]. You can add your own custom destruction code here..
+    //[/Destructor]
+}
+
+//==============================================================================
+void gridview::paint (juce::Graphics& g)
+{
+    //[UserPrePaint] Add your own custom painting code here..
+    //[/UserPrePaint]
+
+    //[UserPaint] Add your own custom painting code here..
+    if (gridImageIsStale || gridImage.getWidth() != width || gridImage.getHeight() != height)
+        renderGrid();
+    g.drawImageAt(gridImage, 0, 0);
+    //[/UserPaint]
+}
+
+void gridview::resized()
+{
+    //[UserPreResize] Add your own custom resize code here..
+    //[/UserPreResize]
+
+    //[UserResized] Add your own custom resize handling here..
+    localBounds = getLocalBounds();
+    width = getWidth();
+    height = getHeight();
+    gridImageIsStale = true;
+    //[/UserResized]
+}
+
+
+
+//[MiscUserCode] You can add your own definitions of your custom methods or any other code here...
+void gridview::refreshGrid()
+{
+    if (hA2sh == nullptr)
+        return;
+    int Q = array2sh_getNumSensors(hA2sh);
+    bool changed = Q != numSensors;
+    dirs_deg.resize((size_t)(2*Q));
+    for (int i = 0; i < Q; i++) {
+        float azi = array2sh_getSensorAzi_deg(hA2sh, i);
+        float elev = array2sh_getSensorElev_deg(hA2sh, i);
+        changed = changed || azi != dirs_deg[(size_t)(2*i)] || elev != dirs_deg[(size_t)(2*i+1)];
+        dirs_deg[(size_t)(2*i)] = azi;
+        dirs_deg[(size_t)(2*i+1)] = elev;
+    }
+    numSensors = Q;
+    if (changed) {
+        gridImageIsStale = true;
+        repaint();
+    }
+}
+
+void gridview::renderGrid()
+{
+    gridImage = Image(Image::RGB, jmax(1, width), jmax(1, height), false);
+    Graphics g(gridImage);
+
+    /* background */
+    Colour fillColour1 = Colour (0xff4e4e4e), fillColour2 = Colour (0xff202020);
+    g.setGradientFill (ColourGradient (fillColour1, 0, 0,
+                                       fillColour2, 0, (float)height,
+                                       false));
+    g.fillRect (localBounds);
+    g.setColour(Colours::white);
+    g.setOpacity(0.3f);
+    g.drawRect (localBounds);
+
+    /* plot area: azimuth from +180 (left) to -180 degrees, elevation from +90 (top) to -90 */
+    Rectangle<float> area((float)(grid_border_pixels + grid_label_width), (float)grid_header_height,
+                          (float)(width - 2*grid_border_pixels - grid_label_width),
+                          (float)(height - grid_header_height - 2*grid_border_pixels));
+    auto toX = [&](float azi_deg) { return area.getX() + (180.0f - azi_deg)/360.0f*area.getWidth(); };
+    auto toY = [&](float elev_deg) { return area.getY() + (90.0f - elev_deg)/180.0f*area.getHeight(); };
+
+    /* grid lines and labels */
+    g.setFont(Font(11.00f, Font::plain));
+    for (int azi = -180; azi <= 180; azi += 45) {
+        g.setColour(Colours::white.withAlpha(azi == 0 ? 0.35f : 0.15f));
+        g.drawVerticalLine((int)toX((float)azi), area.getY(), area.getBottom());
+    }
+    for (int elev = -90; elev <= 90; elev += 30) {
+        g.setColour(Colours::white.withAlpha(elev == 0 ? 0.35f : 0.15f));
+        g.drawHorizontalLine((int)toY((float)elev), area.getX(), area.getRight());
+        g.setColour(Colours::white.withAlpha(0.6f));
+        g.drawText(String(elev), grid_border_pixels, (int)toY((float)elev) - 6, grid_label_width - 4, 12, Justification::centredRight);
+    }
+
+    /* header */
+    g.setColour(Colours::white);
+    g.setFont(Font(12.00f, Font::plain));
+    g.drawText("Sensor directions: " + String(numSensors) + "   (azimuth +180 .. -180, elevation -90 .. 90 degrees)",
+               grid_border_pixels, 0, width - 2*grid_border_pixels, grid_header_height, Justification::centredLeft);
+
+    /* sensors; smaller dots for denser grids */
+    float dotSize = numSensors > 1000 ? 2.0f : (numSensors > 100 ? 3.0f : 5.0f);
+    g.setColour(Colour (0xff14889e).brighter(0.5f));
+    for (int i = 0; i < numSensors; i++) {
+        float azi = std::remainder(dirs_deg[(size_t)(2*i)], 360.0f);
+        g.fillEllipse(toX(azi) - 0.5f*dotSize, toY(dirs_deg[(size_t)(2*i+1)]) - 0.5f*dotSize, dotSize, dotSize);
+    }
+    gridImageIsStale = false;
+}
+
+//[/MiscUserCode]
+
+
+//==============================================================================
+#if 0
+/*  -- Projucer information section --
+
+    This is where the Projucer stores the metadata that describe this GUI layout, so
+    make changes in here at your peril!
+
+BEGIN_JUCER_METADATA
+
+<JUCER_COMPONENT documentType="Component" className="gridview" componentName=""
+                 parentClasses="public Component" constructorParams="int _width, int _height"
+                 variableInitialisers="" snapPixels="8" snapActive="1" snapShown="1"
+                 overlayOpacity="0.330" fixedSize="1" initialWidth="600" initialHeight="400">
+  <BACKGROUND backgroundColour="222222"/>
+</JUCER_COMPONENT>
+
+END_JUCER_METADATA
+*/
+#endif
+
+
+//[EndFile] You can add extra defines here...
+//[/EndFile]
+
@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+  This is an automatically generated GUI class created by the Projucer!
+
+  Be careful when adding custom code to these files, as only the code within
+  the "//[xyz]" and "//[/xyz]" sections will be retained when the file is loaded
+  and re-saved.
+
+  Created with Projucer version: 6.0.5
+
+  ------------------------------------------------------------------------------
+
+  The Projucer is part of the JUCE library.
+  Copyright (c) 2020 - Raw Material Software Limited.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+//[Headers]     -- You can add your own extra header files here --
+
+#include "JuceHeader.h"
+#include "array2sh.h"
+
+//[/Headers]
+
+
+
+//==============================================================================
+/**
+                                                                    //[Comments]
+    Scatter plot of the sensor directions (the dense grid of the loaded
+    config), azimuth vs. elevation. The plot is rendered into an image, which
+    is only redrawn when the directions (or the size) change.
+                                                                    //[/Comments]
+*/
+class gridview  : public juce::Component
+{
+public:
+    //==============================================================================
+    gridview (int _width, int _height);
+    ~gridview() override;
+
+    //==============================================================================
+    //[UserMethods]     -- You can add your own custom methods in this section.
+    juce::Rectangle<int> localBounds;
+
+    void setArray2shHandle(void* _hA2sh){
+        hA2sh = _hA2sh;
+        refreshGrid();
+    }
+    /* re-reads the directions; repaints if they have changed */
+    void refreshGrid();
+
+    //[/UserMethods]
+
+    void paint (juce::Graphics& g) override;
+    void resized() override;
+
+
+
+private:
+    //[UserVariables]   -- You can add your own custom variables in this section.
+    int width, height;
+    void* hA2sh = nullptr;
+    int numSensors = 0;
+    std::vector<float> dirs_deg;   /* azimuth, elevation of each sensor */
+    Image gridImage;
+    bool gridImageIsStale = true;
+
+    void renderGrid();
+
+    //[/UserVariables]
+
+    //==============================================================================
+
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (gridview)
+};
+
+//[EndFile] You can add extra defines here...
+//[/EndFile]
+
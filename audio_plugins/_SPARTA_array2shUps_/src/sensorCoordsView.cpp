@@ -27,6 +27,82 @@
 //[MiscUserDefs] You can add your own user definitions and misc code here...
 const int sensorEdit_width = 176;
 const int sensorEdit_height = 32;
+
+/* the components of a row in view; reused for other rows when scrolled */
+class sensorCoordsView::SensorRow  : public Component,
+                                     private Slider::Listener
+{
+public:
+    SensorRow(void* _hA2sh) : hA2sh(_hA2sh)
+    {
+        addAndMakeVisible (aziSlider);
+        aziSlider.setSliderStyle (Slider::LinearHorizontal);
+        aziSlider.setTextBoxStyle (Slider::TextBoxRight, false, 70, 20);
+        aziSlider.setBounds(-25, 8, 96, 16);
+        aziSlider.addListener (this);
+
+        addAndMakeVisible (elevSlider);
+        elevSlider.setSliderStyle (Slider::LinearHorizontal);
+        elevSlider.setTextBoxStyle (Slider::TextBoxLeft, false, 70, 20);
+        elevSlider.setBounds(105, 8, 96, 16);
+        elevSlider.addListener (this);
+    }
+
+    /* shows the direction of sensor "newRow" */
+    void update(int newRow, bool _useDegreesInstead)
+    {
+        if (newRow != row)
+            repaint();
+        row = newRow;
+        useDegreesInstead = _useDegreesInstead;
+        if(useDegreesInstead){
+            aziSlider.setRange (-360.0*2, 360.0*2, 0.001);
+            aziSlider.setValue(array2sh_getSensorAzi_deg(hA2sh, row), dontSendNotification);
+            elevSlider.setRange (-180.0*2, 180.0*2, 0.001);
+            elevSlider.setValue(array2sh_getSensorElev_deg(hA2sh, row), dontSendNotification);
+        }
+        else{
+            aziSlider.setRange (-2.0*M_PI*2, 2.0*M_PI*2, 0.00001);
+            aziSlider.setValue(array2sh_getSensorAzi_rad(hA2sh, row), dontSendNotification);
+            elevSlider.setRange (-M_PI*2, M_PI*2, 0.00001);
+            elevSlider.setValue(array2sh_getSensorElev_rad(hA2sh, row), dontSendNotification);
+        }
+    }
+
+    void paint (Graphics& g) override
+    {
+        /* sensor ID */
+        g.setColour (Colours::white);
+        g.setFont (Font (15.00f, Font::plain).withTypefaceStyle ("Regular"));
+        g.drawText (String(row+1), 72, 5, 33, 23, Justification::centred, true);
+
+        /* rectangle around the sensor parameters */
+        g.setOpacity(0.15f);
+        g.drawRect (0, 0, sensorEdit_width, sensorEdit_height+1, 1);
+    }
+
+private:
+    void sliderValueChanged (Slider* sliderThatWasMoved) override
+    {
+        if (sliderThatWasMoved == &aziSlider) {
+            if(useDegreesInstead)
+                array2sh_setSensorAzi_deg(hA2sh, row, (float)aziSlider.getValue());
+            else
+                array2sh_setSensorAzi_rad(hA2sh, row, (float)aziSlider.getValue());
+        }
+        else {
+            if(useDegreesInstead)
+                array2sh_setSensorElev_deg(hA2sh, row, (float)elevSlider.getValue());
+            else
+                array2sh_setSensorElev_rad(hA2sh, row, (float)elevSlider.getValue());
+        }
+    }
+
+    void* hA2sh;
+    int row = -1;
+    bool useDegreesInstead = true;
+    Slider aziSlider, elevSlider;
+};
 //[/MiscUserDefs]
 
 //==============================================================================
@@ -35,14 +111,6 @@ sensorCoordsView::sensorCoordsView (PluginProcessor* ownerFilter, int _maxQ, int
     //[Constructor_pre] You can add your own custom stuff here..
     //[/Constructor_pre]
 
-    dummySlider.reset (new Slider ("new slider"));
-    addAndMakeVisible (dummySlider.get());
-    dummySlider->setRange (0.01, 0.3, 0.001);
-    dummySlider->setSliderStyle (Slider::LinearHorizontal);
-    dummySlider->setTextBoxStyle (Slider::TextBoxRight, false, 70, 20);
-    dummySlider->addListener (this);
-
-    dummySlider->setBounds (-176, 144, 96, 16);
 
     //[UserPreSize]
     //[/UserPreSize]
@@ -50,51 +118,17 @@ sensorCoordsView::sensorCoordsView (PluginProcessor* ownerFilter, int _maxQ, int
     setSize (176, 400);
 
     //[Constructor] You can add your own custom stuff here..
-    setSize (sensorEdit_width, sensorEdit_height*_currentQ);
     hVst = ownerFilter;
     hA2sh = hVst->getFXHandle();
     maxQ = _maxQ;
-    currentQ =_currentQ;
+    currentQ = jmin(_currentQ, maxQ);
     useDegreesInstead =  _useDegreesInstead;
-    aziSliders =  new std::unique_ptr<Slider>[(unsigned long)maxQ];
-    elevSliders =  new std::unique_ptr<Slider>[(unsigned long)maxQ];
 
-    for( int i=0; i<maxQ; i++){
-        /* create and initialise azimuth sliders */
-        aziSliders[i].reset (new Slider ("new slider"));
-        addAndMakeVisible (aziSliders[i].get());
-        if(useDegreesInstead){
-            aziSliders[i]->setRange (-360.0*2, 360.0*2, 0.001);
-            aziSliders[i]->setValue(array2sh_getSensorAzi_deg(hA2sh, i));
-        }
-        else{
-            aziSliders[i]->setRange (-2.0*M_PI*2, 2.0*M_PI*2, 0.00001);
-            aziSliders[i]->setValue(array2sh_getSensorAzi_rad(hA2sh, i));
-        }
-        aziSliders[i]->setSliderStyle (Slider::LinearHorizontal);
-        aziSliders[i]->setTextBoxStyle (Slider::TextBoxRight, false, 70, 20);
-        aziSliders[i]->setBounds(-25, 8 + i*sensorEdit_height, 96, 16);
-        aziSliders[i]->addListener (this);
-
-        /* create and initialise elevation sliders */
-        elevSliders[i].reset (new Slider ("new slider"));
-        addAndMakeVisible (elevSliders[i].get());
-        if(useDegreesInstead){
-            elevSliders[i]->setRange (-180.0*2, 180.0*2, 0.001);
-            elevSliders[i]->setValue(array2sh_getSensorElev_deg(hA2sh, i));
-        }
-        else {
-            elevSliders[i]->setRange (-M_PI*2, M_PI*2, 0.00001);
-            elevSliders[i]->setValue(array2sh_getSensorElev_rad(hA2sh, i));
-        }
-        elevSliders[i]->setSliderStyle (Slider::LinearHorizontal);
-        elevSliders[i]->setTextBoxStyle (Slider::TextBoxLeft, false, 70, 20);
-        elevSliders[i]->setBounds(105, 8 + i*sensorEdit_height, 96, 16);
-        elevSliders[i]->addListener (this);
-    }
-
-    refreshCoords();
-    resized();
+    sensorList.setModel (this);
+    sensorList.setRowHeight (sensorEdit_height);
+    sensorList.setColour (ListBox::backgroundColourId, Colours::transparentBlack);
+    sensorList.getViewport()->setScrollBarsShown (true, false);
+    addAndMakeVisible (sensorList);
 
     //[/Constructor]
 }
@@ -104,16 +138,10 @@ sensorCoordsView::~sensorCoordsView()
     //[Destructor_pre]. You can add your own custom destruction code here..
     //[/Destructor_pre]
 
-    dummySlider = nullptr;
 
 
     //[Destructor]. You can add your own custom destruction code here..
-    for( int i=0; i<maxQ; i++){
-        aziSliders[i] = nullptr;
-        elevSliders[i] = nullptr;
-    }
-    delete [] aziSliders;
-    delete [] elevSliders;
+    sensorList.setModel (nullptr);
     //[/Destructor]
 }
 
@@ -124,7 +152,7 @@ void sensorCoordsView::paint (Graphics& g)
     //[/UserPrePaint]
 
     {
-        int x = 88, y = 0, width = 88, height = 2048;
+        int x = 88, y = 0, width = 88, height = getHeight();
         Colour fillColour1 = Colour (0x21ffffff), fillColour2 = Colour (0x05252a25);
         //[UserPaintCustomArguments] Customize the painting arguments here..
         //[/UserPaintCustomArguments]
@@ -139,7 +167,7 @@ void sensorCoordsView::paint (Graphics& g)
     }
 
     {
-        int x = 0, y = 0, width = 88, height = 2048;
+        int x = 0, y = 0, width = 88, height = getHeight();
         Colour fillColour1 = Colour (0x21ffffff), fillColour2 = Colour (0x05252a25);
         //[UserPaintCustomArguments] Customize the painting arguments here..
         //[/UserPaintCustomArguments]
@@ -154,25 +182,6 @@ void sensorCoordsView::paint (Graphics& g)
     }
 
     //[UserPaint] Add your own custom painting code here..
-    Colour fillColour = Colours::white;
-    g.setColour (fillColour);
-    g.setFont (Font (15.00f, Font::plain).withTypefaceStyle ("Regular"));
-
-    for( int i=0; i<maxQ; i++){
-        /* draw sensor IDs */
-        g.setColour (fillColour);
-        g.drawText (String(i+1), 72, 5+ i*sensorEdit_height, 33, 23,
-                    Justification::centred, true);
-
-        /* draw rectangle around sensor parameter */
-        //Colour strokeColour = Colour (0x2370702b);
-        //g.setColour (strokeColour);
-        g.setColour(Colours::white);
-        g.setOpacity(0.15f);
-        g.drawRect (0, i*sensorEdit_height, sensorEdit_width, sensorEdit_height+1, 1);
-    }
-
-
     //[/UserPaint]
 }
 
@@ -182,63 +191,39 @@ void sensorCoordsView::resized()
     //[/UserPreResize]
 
     //[UserResized] Add your own custom resize handling here..
-    setSize (sensorEdit_width, sensorEdit_height*currentQ+1);
-    repaint();
+    sensorList.setBounds (getLocalBounds());
     //[/UserResized]
 }
 
-void sensorCoordsView::sliderValueChanged (Slider* sliderThatWasMoved)
-{
-    //[UsersliderValueChanged_Pre]
-    for(int i=0; i<maxQ; i++){
-        if (sliderThatWasMoved == aziSliders[i].get()) {
-            if(useDegreesInstead)
-                array2sh_setSensorAzi_deg(hA2sh, i, (float)aziSliders[i]->getValue());
-            else
-                array2sh_setSensorAzi_rad(hA2sh, i, (float)aziSliders[i]->getValue());
-            break;
-        }
-        if (sliderThatWasMoved == elevSliders[i].get()) {
-            if(useDegreesInstead)
-                array2sh_setSensorElev_deg(hA2sh, i, (float)elevSliders[i]->getValue());
-            else
-                array2sh_setSensorElev_rad(hA2sh, i, (float)elevSliders[i]->getValue());
-            break;
-        }
-    }
 
-    //[/UsersliderValueChanged_Pre]
 
-    if (sliderThatWasMoved == dummySlider.get())
-    {
-        //[UserSliderCode_dummySlider] -- add your slider handling code here..
-        //[/UserSliderCode_dummySlider]
-    }
+//[MiscUserCode] You can add your own definitions of your custom methods or any other code here...
 
-    //[UsersliderValueChanged_Post]
-    //[/UsersliderValueChanged_Post]
+void sensorCoordsView::paintListBoxItem (int /*rowNumber*/, Graphics& /*g*/, int /*width*/, int /*height*/, bool /*rowIsSelected*/)
+{
+    /* drawn by the row components */
 }
 
-
-
-//[MiscUserCode] You can add your own definitions of your custom methods or any other code here...
+Component* sensorCoordsView::refreshComponentForRow (int rowNumber, bool /*isRowSelected*/, Component* existingComponentToUpdate)
+{
+    auto* row = static_cast<SensorRow*>(existingComponentToUpdate);
+    if (rowNumber >= currentQ) {
+        delete row;
+        return nullptr;
+    }
+    if (row == nullptr)
+        row = new SensorRow(hA2sh);
+    row->update(rowNumber, useDegreesInstead);
+    return row;
+}
 
 void sensorCoordsView::refreshCoords(){
-    /* update slider values and limits */
-    for( int i=0; i<maxQ; i++){
-        if(useDegreesInstead){
-            aziSliders[i]->setRange (-360.0*2, 360.0*2, 0.001);
-            aziSliders[i]->setValue(array2sh_getSensorAzi_deg(hA2sh, i), dontSendNotification);
-            elevSliders[i]->setRange (-180.0*2, 180.0*2, 0.001);
-            elevSliders[i]->setValue(array2sh_getSensorElev_deg(hA2sh, i), dontSendNotification);
-        }
-        else{
-            aziSliders[i]->setRange (-2.0*M_PI*2, 2.0*M_PI*2, 0.00001);
-            aziSliders[i]->setValue(array2sh_getSensorAzi_rad(hA2sh, i), dontSendNotification);
-            elevSliders[i]->setRange (-M_PI*2, M_PI*2, 0.00001);
-            elevSliders[i]->setValue(array2sh_getSensorElev_rad(hA2sh, i), dontSendNotification);
-        }
-    }
+    /* update the slider values and limits of the rows in view */
+    int firstRow = sensorList.getViewport()->getViewPositionY()/sensorEdit_height;
+    int lastRow = jmin(firstRow + sensorList.getNumRowsOnScreen(), currentQ - 1);
+    for (int i = firstRow; i <= lastRow; i++)
+        if (auto* row = static_cast<SensorRow*>(sensorList.getComponentForRowNumber(i)))
+            row->update(i, useDegreesInstead);
 }
 
 
@@ -260,7 +245,7 @@ void sensorCoordsView::setUseDegreesInstead(bool newState)
 BEGIN_JUCER_METADATA
 
 <JUCER_COMPONENT documentType="Component" className="sensorCoordsView" componentName=""
-                 parentClasses="public Component" constructorParams="PluginProcessor* ownerFilter, int _maxQ, int _currentQ, bool _useDegreesInstead"
+                 parentClasses="public Component, private ListBoxModel" constructorParams="PluginProcessor* ownerFilter, int _maxQ, int _currentQ, bool _useDegreesInstead"
                  variableInitialisers="" snapPixels="8" snapActive="1" snapShown="1"
                  overlayOpacity="0.330" fixedSize="1" initialWidth="176" initialHeight="400">
   <BACKGROUND backgroundColour="323e10">
@@ -269,11 +254,6 @@ BEGIN_JUCER_METADATA
     <RECT pos="0 0 88 2048" fill="linear: 88 128, 0 128, 0=21ffffff, 1=5252a25"
           hasStroke="0"/>
   </BACKGROUND>
-  <SLIDER name="new slider" id="4689db34530ab7c7" memberName="dummySlider"
-          virtualName="" explicitFocusOrder="0" pos="-176 144 96 16" min="0.01"
-          max="0.3" int="0.001" style="LinearHorizontal" textBoxPos="TextBoxRight"
-          textBoxEditable="1" textBoxWidth="70" textBoxHeight="20" skewFactor="1.0"
-          needsCallback="1"/>
 </JUCER_COMPONENT>
 
 END_JUCER_METADATA
@@ -31,54 +31,59 @@
 //==============================================================================
 /**
                                                                     //[Comments]
-    An auto-generated component, created by the Projucer.
-
-    Describe your class and how it works here!
+    List of the sensor directions (the dense grid of the loaded config), one
+    row of azimuth/elevation sliders per sensor. The list is virtualised: only
+    the rows in view have components, which read the directions when they are
+    shown, so its cost does not depend on the number of sensors.
                                                                     //[/Comments]
 */
 class sensorCoordsView  : public juce::Component,
-                          public Slider::Listener
+                          private ListBoxModel
 {
 public:
     //==============================================================================
     sensorCoordsView (PluginProcessor* ownerFilter, int _maxQ, int _currentQ, bool _useDegreesInstead);
-    ~sensorCoordsView();
+    ~sensorCoordsView() override;
 
     //==============================================================================
     //[UserMethods]     -- You can add your own custom methods in this section.
     void setUseDegreesInstead(bool newState);
     void setQ(int newQ){
-//		newQ = newQ > 64 ? 64 : newQ;
+        newQ = jmin(newQ, maxQ);
+        if (newQ != currentQ) {
+            currentQ = newQ;
+            sensorList.updateContent();
+        }
         refreshCoords();
-		if (newQ != currentQ) {
-			currentQ = newQ;
-			resized();
-		}
     }
     //[/UserMethods]
 
     void paint (Graphics& g) override;
     void resized() override;
-    void sliderValueChanged (Slider* sliderThatWasMoved) override;
 
 
 
 private:
     //[UserVariables]   -- You can add your own custom variables in this section.
+    class SensorRow;
+
     PluginProcessor* hVst;
     void* hA2sh;
-    void refreshCoords();
-
-    std::unique_ptr<Slider>* aziSliders;
-    std::unique_ptr<Slider>* elevSliders;
+    ListBox sensorList;
 
     int maxQ, currentQ;
     bool useDegreesInstead;
 
+    void refreshCoords();
+
+    /* ListBoxModel */
+    int getNumRows() override { return currentQ; }
+    void paintListBoxItem (int rowNumber, Graphics& g, int width, int height, bool rowIsSelected) override;
+    Component* refreshComponentForRow (int rowNumber, bool isRowSelected, Component* existingComponentToUpdate) override;
+
     //[/UserVariables]
 
     //==============================================================================
-    std::unique_ptr<Slider> dummySlider;
 
 
     //==============================================================================
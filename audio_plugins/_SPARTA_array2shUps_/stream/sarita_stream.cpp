@@ -0,0 +1,450 @@
+//
+//  sarita_stream.cpp
+//  sparta_array2sh
+//
+//  Streaming daemon: runs the SARITA engine (and array2sh encoder) as a
+//  long-lived process on raw PCM streams, for server-side pipelines that have
+//  no host. The input is interleaved 32-bit float frames (native byte order)
+//  of the sparse array, and the output is interleaved 32-bit float frames of
+//  the spherical harmonic (or dense grid) signals.
+//
+//  usage: sarita_stream --config <file.cfg> [--block-size <n>] [--channels <n>]
+//                       [--output sh|dense] [--order <n>] [--overlap <percent>]
+//                       [--fs <Hz>] [--queue-blocks <n>]
+//                       [--input <path> | --listen <socket path>]
+//
+//  By default one stream is read from stdin (or from --input, e.g. a named
+//  pipe) and written to stdout, until the input is closed. With --listen, the
+//  daemon accepts any number of connections on a Unix socket, and each is a
+//  stream of its own, whose output is written back to the connection.
+//
+//  Each stream has its own engine and three threads: one reads blocks of
+//  frames, one processes them, and one writes them, with --queue-blocks
+//  blocks (2 by default, i.e. double buffering) queued between each of them.
+//  So the reading and writing never hold up the processing, and the latency
+//  is bounded: at most the processing delay (see sarita_getProcessingDelay())
+//  plus the queued blocks. If the output is not taken up as fast as the input
+//  arrives, the input is no longer read (i.e. the sender is held up), rather
+//  than queued without bound.
+//
+//  On SIGHUP the configuration file is read again, and swapped into every
+//  stream between two blocks (see sarita_loadConfig()); if it cannot be read,
+//  the current one is kept. The number of channels of a stream is fixed when
+//  it starts, so a new configuration with another number of sensors has the
+//  missing ones silent and the surplus ones ignored.
+//
+
+#include "saf.h"
+#include "array2sh.h"
+#include "sarita.h"
+#include "SaritaInterleave.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+struct StreamSettings
+{
+    std::string configPath;
+    SARITA_OUTPUT_TYPES outputType = SARITA_OUTPUT_SH;
+    int order = 4;
+    int blockSize = 512;
+    int numChannels = 0; // as the config
+    float overlapPercent = 25.0f;
+    int fs = 48000;
+    int numQueueBlocks = 2;
+};
+
+/* ========================================================================== */
+/*                                Block queue                                 */
+/* ========================================================================== */
+
+// A fixed number of blocks, handed from one thread to another in order. The
+// producer waits while all of them are full, and the consumer while all of
+// them are empty. Either side may close the queue: the producer once it has
+// pushed its last block (the consumer still gets the ones queued), or the
+// consumer to stop the producer.
+class BlockQueue
+{
+public:
+    BlockQueue(int numBlocks, size_t blockLength)
+        : blocks(numBlocks, std::vector<float>(blockLength)), numFrames(numBlocks, 0) {}
+
+    // the next empty block, or nullptr if the queue was closed
+    float* acquireEmpty()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this]() { return count < (int)blocks.size() || closed; });
+        return closed ? nullptr : blocks[(head + count) % blocks.size()].data();
+    }
+    // queues the block returned by acquireEmpty(), holding 'frames' frames
+    void pushFull(int frames)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        numFrames[(head + count) % blocks.size()] = frames;
+        count++;
+        changed.notify_all();
+    }
+    // the oldest full block, or nullptr once the queue is closed and empty
+    float* acquireFull(int& frames)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this]() { return count > 0 || closed; });
+        if (count == 0)
+            return nullptr;
+        frames = numFrames[head];
+        return blocks[head].data();
+    }
+    // hands the block returned by acquireFull() back to the producer
+    void popFull()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        head = (head + 1) % (int)blocks.size();
+        count--;
+        changed.notify_all();
+    }
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        changed.notify_all();
+    }
+
+private:
+    std::vector<std::vector<float>> blocks;
+    std::vector<int> numFrames;
+    int head = 0, count = 0;
+    bool closed = false;
+    std::mutex mutex;
+    std::condition_variable changed;
+};
+
+/* ========================================================================== */
+/*                                   Stream                                   */
+/* ========================================================================== */
+
+class Stream
+{
+public:
+    // the stream closes inFd and outFd (once) when it finishes
+    Stream(const StreamSettings& settings, int inFd, int outFd, const std::string& name)
+        : settings(settings), inFd(inFd), outFd(outFd), name(name) {}
+    ~Stream()
+    {
+        join();
+        if (hSar != nullptr)
+            sarita_destroy(&hSar);
+        free(outFrame);
+    }
+
+    // creates the engine and starts the threads; returns false if the config
+    // can't be loaded
+    bool start()
+    {
+        sarita_create(&hSar);
+        sarita_parameters params;
+        sarita_getParameters(hSar, &params);
+        params.overlapPercent = settings.overlapPercent;
+        params.outputType = settings.outputType;
+        params.order = settings.order;
+        sarita_setParameters(hSar, &params);
+        sarita_init(hSar, settings.fs, settings.blockSize);
+        if (sarita_loadConfig(hSar, settings.configPath.c_str()) != 0) {
+            closeFds();
+            finished = true;
+            return false;
+        }
+        if (sarita_getConfigSamplingRate(hSar) != settings.fs)
+            fprintf(stderr, "%s: the config is for %d Hz, but the stream is %d Hz\n", name.c_str(),
+                    sarita_getConfigSamplingRate(hSar), settings.fs);
+
+        numChannels = settings.numChannels > 0 ? settings.numChannels : sarita_getNumSparseSensors(hSar);
+        numOutputs = settings.outputType == SARITA_OUTPUT_SH ? ORDER2NSH(settings.order) : sarita_getNumDenseSensors(hSar);
+        outFrame = (float**)malloc2d(numOutputs, settings.blockSize, sizeof(float));
+        inQueue.reset(new BlockQueue(settings.numQueueBlocks, (size_t)settings.blockSize * numChannels));
+        outQueue.reset(new BlockQueue(settings.numQueueBlocks, (size_t)settings.blockSize * numOutputs));
+        fprintf(stderr, "%s: %d channels in, %d out, latency of up to %d samples\n", name.c_str(), numChannels, numOutputs,
+                sarita_getProcessingDelay(hSar) + 2 * settings.numQueueBlocks * settings.blockSize);
+
+        readThread = std::thread(&Stream::readLoop, this);
+        processThread = std::thread(&Stream::processLoop, this);
+        writeThread = std::thread(&Stream::writeLoop, this);
+        return true;
+    }
+
+    void join()
+    {
+        for (std::thread* t : { &readThread, &processThread, &writeThread })
+            if (t->joinable())
+                t->join();
+    }
+
+    bool isFinished() const { return finished; }
+
+    // reads the config again, and swaps it in between two blocks (called
+    // from the signal thread)
+    void reload()
+    {
+        if (sarita_loadConfig(hSar, settings.configPath.c_str()) != 0)
+            fprintf(stderr, "%s: could not reload %s, the current config is kept\n", name.c_str(), settings.configPath.c_str());
+        else if (sarita_getNumSparseSensors(hSar) > numChannels)
+            fprintf(stderr, "%s: reloaded, but the config has %d sensors, and the stream only %d channels\n", name.c_str(),
+                    sarita_getNumSparseSensors(hSar), numChannels);
+        else
+            fprintf(stderr, "%s: reloaded %s\n", name.c_str(), settings.configPath.c_str());
+    }
+
+private:
+    /* reads whole blocks (the last one is padded with silence), until the
+     * input is closed */
+    void readLoop()
+    {
+        const size_t blockBytes = (size_t)settings.blockSize * numChannels * sizeof(float);
+        const size_t frameBytes = (size_t)numChannels * sizeof(float);
+        for (bool eof = false; !eof;) {
+            float* block = inQueue->acquireEmpty();
+            if (block == nullptr)
+                break;
+            size_t numBytes = 0;
+            while (numBytes < blockBytes) {
+                ssize_t n = read(inFd, (char*)block + numBytes, blockBytes - numBytes);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n <= 0) {
+                    eof = true;
+                    break;
+                }
+                numBytes += (size_t)n;
+            }
+            memset((char*)block + numBytes, 0, blockBytes - numBytes);
+            if (numBytes >= frameBytes)
+                inQueue->pushFull((int)((numBytes + frameBytes - 1) / frameBytes));
+        }
+        inQueue->close();
+        threadFinished();
+    }
+
+    void processLoop()
+    {
+        int numFrames;
+        for (const float* in; (in = inQueue->acquireFull(numFrames)) != nullptr; inQueue->popFull()) {
+            float* out = outQueue->acquireEmpty();
+            if (out == nullptr)
+                break;
+            sarita_processInterleaved(hSar, in, numChannels, outFrame, numChannels, numOutputs, settings.blockSize);
+            saritaInterleave(outFrame, 0, numOutputs, settings.blockSize, out, numOutputs);
+            outQueue->pushFull(numFrames);
+        }
+        inQueue->close(); /* if the writer stopped */
+        outQueue->close();
+        threadFinished();
+    }
+
+    void writeLoop()
+    {
+        int numFrames;
+        bool failed = false;
+        for (const float* out; (out = outQueue->acquireFull(numFrames)) != nullptr; outQueue->popFull()) {
+            const size_t numBytes = (size_t)numFrames * numOutputs * sizeof(float);
+            for (size_t written = 0; written < numBytes;) {
+                ssize_t n = write(outFd, (const char*)out + written, numBytes - written);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n <= 0) {
+                    failed = true;
+                    break;
+                }
+                written += (size_t)n;
+            }
+            if (failed)
+                break;
+        }
+        if (failed) {
+            /* nobody is listening; stop the others (a socket is shut down,
+             * so that the reader no longer waits for input) */
+            fprintf(stderr, "%s: the output was closed\n", name.c_str());
+            outQueue->close();
+            shutdown(inFd, SHUT_RDWR);
+        }
+        threadFinished();
+    }
+
+    /* the last of the threads to finish closes the stream */
+    void threadFinished()
+    {
+        if (--numRunning > 0)
+            return;
+        closeFds();
+        fprintf(stderr, "%s: finished\n", name.c_str());
+        finished = true;
+    }
+
+    void closeFds()
+    {
+        if (inFd > 2)
+            close(inFd);
+        if (outFd > 2 && outFd != inFd)
+            close(outFd);
+        inFd = outFd = -1;
+    }
+
+    const StreamSettings settings;
+    int inFd, outFd;
+    const std::string name;
+    void* hSar = nullptr;
+    int numChannels = 0, numOutputs = 0;
+    float** outFrame = nullptr;
+    std::unique_ptr<BlockQueue> inQueue, outQueue;
+    std::thread readThread, processThread, writeThread;
+    std::atomic<int> numRunning { 3 };
+    std::atomic<bool> finished { false };
+};
+
+/* ========================================================================== */
+/*                                    Main                                    */
+/* ========================================================================== */
+
+static std::mutex streamsMutex;
+static std::list<std::unique_ptr<Stream>> streams;
+
+/* SIGHUP is blocked on all threads, and taken here instead of by a handler,
+ * so that the configs may be reloaded outside of signal context */
+static void signalLoop(sigset_t signals)
+{
+    for (;;) {
+        int signal;
+        if (sigwait(&signals, &signal) != 0 || signal != SIGHUP)
+            continue;
+        std::lock_guard<std::mutex> lock(streamsMutex);
+        for (auto& stream : streams)
+            if (!stream->isFinished())
+                stream->reload();
+    }
+}
+
+static int listenOn(const char* path)
+{
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "%s: the socket path is too long\n", path);
+        return -1;
+    }
+    strcpy(address.sun_path, path);
+    unlink(path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        fprintf(stderr, "%s: could not listen (%s)\n", path, strerror(errno));
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr, "usage: %s --config <file.cfg> [--block-size <n>] [--channels <n>] [--output sh|dense] [--order <n>]\n"
+                    "       [--overlap <percent>] [--fs <Hz>] [--queue-blocks <n>] [--input <path> | --listen <socket path>]\n", name);
+}
+
+int main(int argc, char** argv)
+{
+    StreamSettings settings;
+    std::string inputPath, listenPath;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        std::string value = i+1 < argc ? argv[i+1] : "";
+        if (i+1 >= argc)                                { usage(argv[0]); return 1; }
+        else if (arg == "--config")                     settings.configPath = argv[++i];
+        else if (arg == "--block-size")                 settings.blockSize = atoi(argv[++i]);
+        else if (arg == "--channels")                   settings.numChannels = atoi(argv[++i]);
+        else if (arg == "--order")                      settings.order = atoi(argv[++i]);
+        else if (arg == "--overlap")                    settings.overlapPercent = (float)atof(argv[++i]);
+        else if (arg == "--fs")                         settings.fs = atoi(argv[++i]);
+        else if (arg == "--queue-blocks")               settings.numQueueBlocks = atoi(argv[++i]);
+        else if (arg == "--input")                      inputPath = argv[++i];
+        else if (arg == "--listen")                     listenPath = argv[++i];
+        else if (arg == "--output" && value == "sh")    { settings.outputType = SARITA_OUTPUT_SH; i++; }
+        else if (arg == "--output" && value == "dense") { settings.outputType = SARITA_OUTPUT_DENSE_GRID; i++; }
+        else { usage(argv[0]); return 1; }
+    }
+    if (settings.configPath.empty() || (!inputPath.empty() && !listenPath.empty())) {
+        usage(argv[0]);
+        return 1;
+    }
+    settings.order = SAF_CLAMP(settings.order, 1, MAX_SH_ORDER);
+    settings.overlapPercent = SAF_CLAMP(settings.overlapPercent, 0.0f, SARITA_MAX_OVERLAP_PERCENT);
+    settings.numQueueBlocks = SAF_MAX(settings.numQueueBlocks, 1);
+    if (settings.blockSize <= 0 || settings.blockSize % array2sh_getHopSize() != 0) {
+        fprintf(stderr, "the block size must be a multiple of %d\n", array2sh_getHopSize());
+        return 1;
+    }
+
+    /* a closed output is an error of the stream, not a reason to quit */
+    signal(SIGPIPE, SIG_IGN);
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    std::thread(signalLoop, signals).detach();
+
+    if (listenPath.empty()) {
+        int inFd = inputPath.empty() ? STDIN_FILENO : open(inputPath.c_str(), O_RDONLY);
+        if (inFd < 0) {
+            fprintf(stderr, "%s: could not be opened (%s)\n", inputPath.c_str(), strerror(errno));
+            return 1;
+        }
+        Stream* stream = new Stream(settings, inFd, STDOUT_FILENO, inputPath.empty() ? "stdin" : inputPath);
+        {
+            std::lock_guard<std::mutex> lock(streamsMutex);
+            streams.emplace_back(stream);
+            if (!stream->start()) {
+                fprintf(stderr, "could not load %s\n", settings.configPath.c_str());
+                return 1;
+            }
+        }
+        stream->join();
+        return 0;
+    }
+
+    int listenFd = listenOn(listenPath.c_str());
+    if (listenFd < 0)
+        return 1;
+    fprintf(stderr, "listening on %s\n", listenPath.c_str());
+    for (int numConnections = 0;;) {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            fprintf(stderr, "%s: accept failed (%s)\n", listenPath.c_str(), strerror(errno));
+            break;
+        }
+
+        /* the streams that have finished are cleaned up as new ones come in */
+        std::lock_guard<std::mutex> lock(streamsMutex);
+        streams.remove_if([](const std::unique_ptr<Stream>& stream) { return stream->isFinished(); });
+        Stream* stream = new Stream(settings, fd, fd, "connection " + std::to_string(++numConnections));
+        streams.emplace_back(stream);
+        if (!stream->start())
+            fprintf(stderr, "could not load %s\n", settings.configPath.c_str());
+    }
+    close(listenFd);
+    unlink(listenPath.c_str());
+    return 1;
+}
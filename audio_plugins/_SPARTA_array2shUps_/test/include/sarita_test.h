@@ -0,0 +1,97 @@
+//
+//  sarita_test.h
+//  sparta_array2sh
+//
+//  Regression tests of the SARITA engine (upsampling + array2sh encoding),
+//  in the same style (and with the same unity/timer resources) as the SAF
+//  unit testing program; see SDKs/Spatial_Audio_Framework/test.
+//
+//  New tests are added as for saf_test: a prototype here, the test itself in
+//  test__sarita.cpp, and a RUN_TEST() call in sarita_test.cpp.
+//
+//  The golden references (references/Sarita_<config>.ref) are regenerated by
+//  running the program with the environment variable
+//  SARITA_TEST_GENERATE_REFERENCES=1; only do so for changes that are meant
+//  to change the output.
+//
+
+#ifndef sarita_test_h
+#define sarita_test_h
+
+#include "resources/unity.h" /* unit testing suite (MIT license) */
+#include "resources/timer.h" /* for timing the individual tests */
+
+/**
+ * Runs the engine on fixed input for each shipped config, and compares the
+ * dense grid and spherical harmonic outputs against the stored references,
+ * with per-config tolerances */
+void test__sarita_goldenOutput(void);
+/**
+ * Checks that the output does not depend on how the input and output are
+ * split into host blocks, for each overlap setting (bit-exact) */
+void test__sarita_blockSplits(void);
+/**
+ * Checks that engines running on several threads at once produce the same
+ * output as a single engine (bit-exact) */
+void test__sarita_threads(void);
+/**
+ * Checks the sarita.h API against the engine it wraps (dense grid bit-exact,
+ * with planar and interleaved input, SH within rounding), its handling of
+ * configs that cannot be read, and a config swap while blocks are being
+ * processed */
+void test__sarita_api(void);
+/**
+ * Checks that an instance started at a restart point (see
+ * sarita_getSegmentAlignment()) produces the same output as one that has been
+ * running from the start, once it has warmed up (bit-exact) */
+void test__sarita_segments(void);
+/**
+ * Checks that instances of the same config share its tables and their
+ * encoding matrices (which give the same output as an encoder of their own),
+ * and that these are freed with the last instance; and that a config whose
+ * header does not match its size is rejected */
+void test__sarita_sharedData(void);
+/**
+ * Changes all parameters from another thread while blocks are being processed,
+ * and checks that the output stays finite, and that the last set published is
+ * taken over (in the background) without further calls */
+void test__sarita_parameterChanges(void);
+/**
+ * Checks that switching the overlap while processing keeps the output in step
+ * with that of a constant overlap, without a glitch at the switches */
+void test__sarita_overlapSwitch(void);
+/**
+ * Checks that an instance keeps the memory of one engine, sized for the
+ * loaded config (with the same output as the engine driven directly), and
+ * rejects configs beyond the config limits */
+void test__sarita_memory(void);
+/**
+ * Checks that each shipped config gets a specialised render kernel, and that
+ * its output is bit-identical to that of the generic kernel */
+void test__sarita_kernels(void);
+/**
+ * Checks that pruning the neighbours (the quality presets) keeps the expected
+ * error of each direction within its bound, and the measured error of the
+ * dense grid signals near it, drops correlations, and is applied to a running
+ * instance; and that the full quality is the unpruned output */
+void test__sarita_pruning(void);
+/**
+ * Checks that the decimated time shift estimation finds the time shifts of
+ * (almost) all directions that the full-rate one does, and prints both of
+ * their processing times */
+void test__sarita_decimatedShifts(void);
+/**
+ * Checks the band split: the crossover at the spatial aliasing frequency of
+ * the sparse array, the level of the SH signals that of the full band, and
+ * the low band in time with the high band */
+void test__sarita_bandSplit(void);
+/**
+ * Checks the time-frequency domain upsampling: the SH signals alike in level
+ * and time to those of the time domain */
+void test__sarita_fusedDomain(void);
+/**
+ * Prints the processing time of each config, with and without the SHT (this
+ * test does not fail on timings) */
+void test__sarita_performance(void);
+
+#endif /* sarita_test_h */
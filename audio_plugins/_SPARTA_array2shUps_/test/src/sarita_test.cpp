@@ -0,0 +1,66 @@
+//
+//  sarita_test.cpp
+//  sparta_array2sh
+//
+//  Regression test program for the SARITA engine; see sarita_test.h
+//
+
+#include "sarita_test.h"
+#include "saf.h"
+#include "saf_externals.h"
+#include <cstdio>
+
+static tick_t start;      /* Start time for whole test program */
+static tick_t start_test; /* Start time for the current unit test */
+/* Called before each unit test is executed */
+void setUp(void) { start_test = timer_current(); }
+/* Called after each unit test is executed */
+void tearDown(void) { }
+/* Displays the time taken to run the current unit test */
+static void timerResult(void) {
+    printf("    (Time elapsed: %lfs) \n", (double)timer_elapsed(start_test));
+}
+
+#undef RUN_TEST
+/* A custom Unity RUN_TEST, which calls timerResult() upon exiting each test */
+#define RUN_TEST(testfunc)  UNITY_NEW_TEST(#testfunc) \
+    if (TEST_PROTECT()) {  setUp();  testfunc();  } \
+    if (TEST_PROTECT() && (!TEST_IS_IGNORED))  {tearDown(); } \
+    UnityConcludeTest(); timerResult();
+
+int main(void) {
+    printf("%s\n", SAF_VERSION_BANNER);
+    printf("%s\n", SAF_EXTERNALS_CONFIGURATION_STRING);
+    printf("Executing the SARITA regression tests");
+#ifdef NDEBUG
+    printf(" (Release):\n");
+#else
+    printf(" (Debug):\n");
+#endif
+
+    /* initialise */
+    timer_lib_initialize();
+    start = timer_current();
+    UNITY_BEGIN();
+
+    RUN_TEST(test__sarita_goldenOutput);
+    RUN_TEST(test__sarita_blockSplits);
+    RUN_TEST(test__sarita_threads);
+    RUN_TEST(test__sarita_api);
+    RUN_TEST(test__sarita_segments);
+    RUN_TEST(test__sarita_sharedData);
+    RUN_TEST(test__sarita_parameterChanges);
+    RUN_TEST(test__sarita_overlapSwitch);
+    RUN_TEST(test__sarita_memory);
+    RUN_TEST(test__sarita_kernels);
+    RUN_TEST(test__sarita_pruning);
+    RUN_TEST(test__sarita_decimatedShifts);
+    RUN_TEST(test__sarita_bandSplit);
+    RUN_TEST(test__sarita_fusedDomain);
+    RUN_TEST(test__sarita_performance);
+
+    /* close */
+    timer_lib_shutdown();
+    printf("\nTotal time elapsed: %lfs", (double)timer_elapsed(start));
+    return UNITY_END();
+}
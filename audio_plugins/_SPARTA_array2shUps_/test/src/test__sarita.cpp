@@ -0,0 +1,1153 @@
+//
+//  test__sarita.cpp
+//  sparta_array2sh
+//
+//  Regression tests of the SARITA engine; see sarita_test.h
+//
+
+#include "sarita_test.h"
+#include "sarita_internal.h"
+#include "sarita.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef SARITA_CONFIG_DIR
+# define SARITA_CONFIG_DIR "sarita_vst_configs"
+#endif
+#ifndef SARITA_TEST_REFERENCE_DIR
+# define SARITA_TEST_REFERENCE_DIR "references"
+#endif
+
+/* The shipped configs, and the accepted relative (RMS) error of each stored
+ * dense grid and SH channel. Perturbing the input at float precision (by a
+ * relative 1e-6) changes the dense grid signals by about 6e-7, and the SH
+ * signals by 7e-6 (N3, N4) to 1.4e-5 (N7), as the encoding filters amplify
+ * it more at higher orders. The tolerances leave a margin of about 100 over
+ * that, for other FFT/BLAS implementations and reordered arithmetic, but
+ * still catch any change of a time shift or weight */
+typedef struct {
+    const char* name;
+    float denseTolerance;
+    float shTolerance;
+} SaritaTestConfig;
+
+static const SaritaTestConfig testConfigs[] = {
+    { "eigenmike32_N4", 1e-4f, 1e-3f },
+    { "eigenmike64_N6", 1e-4f, 1e-3f },
+    { "hosma_N7",       1e-4f, 2e-3f },
+    { "zylia_N3",       1e-4f, 1e-3f }
+};
+static const int numTestConfigs = (int)(sizeof(testConfigs)/sizeof(testConfigs[0]));
+
+static const int fs = 48000;             /* all configs are exported for 48 kHz */
+static const int frameSize = 512;        /* engine frame size */
+static const int referenceLength = 256;  /* stored samples per channel... */
+static const int referenceOffset = 8192; /* ...from this sample of the output */
+static const int numReferenceDense = 8;  /* stored dense grid channels */
+
+/* Host block sizes (cycled through) */
+static const int regularBlocks[] = { 512 };
+static const int irregularBlocks[] = { 100, 412, 37, 512, 263 };
+static const int hopBlocks[] = { 128, 384, 256, 512 }; /* SH: multiples of the array2sh hop size */
+
+/* The options of a test run, of the engine driven directly (runSarita()) or
+ * of an instance (runInstance()); each defaults to that of the plug-in, and
+ * is changed with the setter of its name, e.g.
+ * SaritaTestRun().withSH(true).withBlocks(irregularBlocks) */
+struct SaritaTestRun {
+    float overlapPercent = 25.0f;
+    bool sht = false;                  /* false: dense grid signals, true: SH signals */
+    const int* hostBlocks = regularBlocks;
+    int numHostBlocks = 1;
+    bool genericKernel = false;        /* the generic render kernel, whatever the config (engine only) */
+    SARITA_SHIFT_ESTIMATION shiftEstimation = SARITA_SHIFT_ESTIMATION_FULL_RATE;
+    SARITA_QUALITY quality = SARITA_QUALITY_FULL;                 /* (instance only) */
+    SARITA_BAND_SPLIT bandSplit = SARITA_BAND_SPLIT_OFF;         /* (instance only) */
+    SARITA_UPSAMPLING_DOMAIN domain = SARITA_UPSAMPLING_DOMAIN_TIME; /* (instance only) */
+
+    SaritaTestRun& withOverlap(float percent) { overlapPercent = percent; return *this; }
+    SaritaTestRun& withSH(bool enabled) { sht = enabled; return *this; }
+    template <size_t NumBlocks>
+    SaritaTestRun& withBlocks(const int (&blocks)[NumBlocks]) { hostBlocks = blocks; numHostBlocks = (int)NumBlocks; return *this; }
+    SaritaTestRun& withGenericKernel(bool enabled) { genericKernel = enabled; return *this; }
+    SaritaTestRun& withShiftEstimation(SARITA_SHIFT_ESTIMATION estimation) { shiftEstimation = estimation; return *this; }
+    SaritaTestRun& withQuality(SARITA_QUALITY preset) { quality = preset; return *this; }
+    SaritaTestRun& withBandSplit(SARITA_BAND_SPLIT split) { bandSplit = split; return *this; }
+    SaritaTestRun& withDomain(SARITA_UPSAMPLING_DOMAIN newDomain) { domain = newDomain; return *this; }
+};
+
+/* ========================================================================== */
+/*                                  Helpers                                   */
+/* ========================================================================== */
+
+/* deterministic test input (independent of the platform's rand()): one
+ * broadband source, which reaches each sensor with a different delay, plus a
+ * little uncorrelated noise per sensor, so that the correlation peaks the
+ * engine searches for are well defined */
+static void makeTestInput(float** input, int numInputs, int length)
+{
+    const int maxDelay = 6;
+    uint32_t state = 0x5a17a5u;
+    auto nextRand = [&state]() {
+        state ^= state << 13; state ^= state >> 17; state ^= state << 5; /* xorshift32 */
+        return (float)((double)state / 2147483648.0 - 1.0);
+    };
+    std::vector<float> source(length + maxDelay);
+    for (auto& s : source)
+        s = nextRand();
+    for (int ch = 0; ch < numInputs; ch++) {
+        int delay = (ch * 7) % (maxDelay + 1);
+        for (int i = 0; i < length; i++)
+            input[ch][i] = 0.5f * source[i + maxDelay - delay] + 0.05f * nextRand();
+    }
+}
+
+/* the source order of a config, from its name */
+static int configOrder(const std::string& name)
+{
+    return atoi(name.substr(name.rfind('N') + 1).c_str());
+}
+
+/* sets the parameters of an instance to the options of a run; before its
+ * config is loaded (as the renderer does), so that they apply from the first
+ * block on */
+static void setTestParameters(void* hSar, const SaritaTestRun& run, int order)
+{
+    sarita_parameters params;
+    sarita_getParameters(hSar, &params);
+    params.overlapPercent = run.overlapPercent;
+    params.outputType = run.sht ? SARITA_OUTPUT_SH : SARITA_OUTPUT_DENSE_GRID;
+    params.order = order;
+    params.shiftEstimation = run.shiftEstimation;
+    sarita_applyQualityPreset(&params, run.quality);
+    params.bandSplit = run.bandSplit;
+    params.upsamplingDomain = run.domain;
+    sarita_setParameters(hSar, &params);
+}
+
+/* Runs one engine (and encoder) over the whole input, pushing the input and
+ * popping the output in blocks of the given sizes, as a host would. 'output'
+ * receives everything that was popped: all dense grid channels, or the SH
+ * channels up to the order of the config. If 'processingTime' is given, it
+ * receives the time spent processing (from the second host block on).
+ * Returns false if the config
+ * could not be loaded */
+static bool runSarita(const char* config, const SaritaTestRun& run, float* const* input, int length,
+                      std::vector<std::vector<float>>& output, double* processingTime = nullptr)
+{
+    std::string path = std::string(SARITA_CONFIG_DIR) + "/Sarita_" + config + ".cfg";
+    Sarita sarita;
+    void* hA2sh;
+    array2sh_create(&hA2sh);
+    array2sh_init(hA2sh, fs);
+    sarita.setOverlap(run.overlapPercent);
+    sarita.preferGenericKernel = run.genericKernel;
+    sarita.shiftEstimation = run.shiftEstimation;
+    if (sarita.setupSarita(path.c_str(), frameSize) == -1 || (int)sarita.fs != fs) {
+        sarita.deallocBuffers();
+        array2sh_destroy(&hA2sh);
+        return false;
+    }
+    sarita.updateArrayData(hA2sh);
+    array2sh_setEncodingOrder(hA2sh, (int)sarita.N);
+    array2sh_initCodec(hA2sh); /* as the worker of sarita does */
+
+    const int numInputs = sarita.sparseGridSize;
+    const int numOutputs = run.sht ? ORDER2NSH((int)sarita.N) : (int)sarita.denseGridSize;
+    const int hopSize = array2sh_getHopSize();
+    float** outBlock = (float**)malloc2d(numOutputs, frameSize, sizeof(float));
+    output.assign(numOutputs, std::vector<float>());
+    for (auto& ch : output)
+        ch.reserve(length);
+
+    tick_t start = 0;
+    for (int pos = 0, b = 0; pos < length; b++) {
+        if (b == 1)
+            start = timer_current();
+        int n = SAF_MIN(run.hostBlocks[b % run.numHostBlocks], length - pos);
+        if (sarita.overlapChanged)
+            sarita.updateOverlap(frameSize);
+        for (int ch = 0; ch < numInputs; ch++)
+            sarita.input->push(&input[ch][pos], n, ch);
+        pos += n;
+        sarita.processFrames(frameSize, numInputs);
+
+        /* pop whatever is available (at most a frame at a time) */
+        for (;;) {
+            int numPop = SAF_MIN(sarita.output->bufferedBytes, frameSize);
+            if (run.sht)
+                numPop -= numPop % hopSize;
+            if (numPop == 0)
+                break;
+            bool popped = run.sht ? sarita.encodeOutput(hA2sh, outBlock, numOutputs, numPop) :
+                                    sarita.popOutput(outBlock, numOutputs, numPop);
+            if (!popped)
+                break;
+            for (int ch = 0; ch < numOutputs; ch++)
+                output[ch].insert(output[ch].end(), outBlock[ch], outBlock[ch] + numPop);
+        }
+    }
+    if (processingTime != nullptr)
+        *processingTime = (double)timer_elapsed(start);
+
+    free(outBlock);
+    sarita.deallocBuffers();
+    array2sh_destroy(&hA2sh);
+    return true;
+}
+
+/* relative RMS error of 'y' against 'ref', over 'len' samples */
+static double relativeError(const float* ref, const float* y, int len)
+{
+    double errEnergy = 0.0, refEnergy = 0.0;
+    for (int i = 0; i < len; i++) {
+        errEnergy += ((double)y[i] - (double)ref[i]) * ((double)y[i] - (double)ref[i]);
+        refEnergy += (double)ref[i] * (double)ref[i];
+    }
+    return sqrt(errEnergy / SAF_MAX(refEnergy, 1e-20));
+}
+
+/* Reference files: a header, followed by the stored dense grid channels and
+ * then the SH channels, referenceLength float samples each */
+typedef struct {
+    char magic[4];          /* "SRTR" */
+    int32_t version;
+    int32_t numDense;
+    int32_t denseStride;    /* dense grid channels 0, denseStride, ... */
+    int32_t numSH;
+    int32_t offset;
+    int32_t length;
+} SaritaReferenceHeader;
+
+static std::string referencePath(const char* config)
+{
+    return std::string(SARITA_TEST_REFERENCE_DIR) + "/Sarita_" + config + ".ref";
+}
+
+static bool writeReference(const char* config, const SaritaReferenceHeader& header,
+                           const std::vector<std::vector<float>>& dense, const std::vector<std::vector<float>>& sh)
+{
+    FILE* fid = fopen(referencePath(config).c_str(), "wb");
+    if (fid == NULL)
+        return false;
+    bool ok = fwrite(&header, sizeof(header), 1, fid) == 1;
+    for (int i = 0; i < header.numDense; i++)
+        ok = ok && fwrite(&dense[i*header.denseStride][header.offset], sizeof(float), header.length, fid) == (size_t)header.length;
+    for (int i = 0; i < header.numSH; i++)
+        ok = ok && fwrite(&sh[i][header.offset], sizeof(float), header.length, fid) == (size_t)header.length;
+    fclose(fid);
+    return ok;
+}
+
+static bool readReference(const char* config, SaritaReferenceHeader& header, std::vector<float>& data)
+{
+    FILE* fid = fopen(referencePath(config).c_str(), "rb");
+    if (fid == NULL)
+        return false;
+    bool ok = fread(&header, sizeof(header), 1, fid) == 1 && memcmp(header.magic, "SRTR", 4) == 0 &&
+              header.version == 1 && header.length > 0;
+    if (ok) {
+        data.resize((size_t)(header.numDense + header.numSH) * header.length);
+        ok = fread(data.data(), sizeof(float), data.size(), fid) == data.size();
+    }
+    fclose(fid);
+    return ok;
+}
+
+/* ========================================================================== */
+/*                                   Tests                                    */
+/* ========================================================================== */
+
+void test__sarita_goldenOutput(void)
+{
+    const int length = referenceOffset + referenceLength + 4*frameSize; /* covers the latency */
+    const bool generate = getenv("SARITA_TEST_GENERATE_REFERENCES") != NULL;
+    float** input = (float**)malloc2d(MAX_NUM_SH_SIGNALS, length, sizeof(float));
+    makeTestInput(input, MAX_NUM_SH_SIGNALS, length);
+
+    for (int c = 0; c < numTestConfigs; c++) {
+        const SaritaTestConfig& config = testConfigs[c];
+        std::vector<std::vector<float>> dense, sh;
+        SaritaTestRun denseRun;
+        SaritaTestRun shRun = SaritaTestRun().withSH(true);
+        TEST_ASSERT_TRUE_MESSAGE(runSarita(config.name, denseRun, input, length, dense), config.name);
+        TEST_ASSERT_TRUE_MESSAGE(runSarita(config.name, shRun, input, length, sh), config.name);
+        TEST_ASSERT_TRUE((int)dense[0].size() >= referenceOffset + referenceLength);
+        TEST_ASSERT_TRUE((int)sh[0].size() >= referenceOffset + referenceLength);
+
+        if (generate) {
+            SaritaReferenceHeader header = { {'S','R','T','R'}, 1, numReferenceDense,
+                (int32_t)dense.size() / numReferenceDense, (int32_t)sh.size(), referenceOffset, referenceLength };
+            TEST_ASSERT_TRUE_MESSAGE(writeReference(config.name, header, dense, sh), "could not write the reference");
+            continue;
+        }
+
+        SaritaReferenceHeader header;
+        std::vector<float> reference;
+        TEST_ASSERT_TRUE_MESSAGE(readReference(config.name, header, reference), "could not read the reference");
+        TEST_ASSERT_TRUE(header.numSH == (int)sh.size());
+        TEST_ASSERT_TRUE(header.denseStride * (header.numDense-1) < (int)dense.size());
+        const float* ref = reference.data();
+        for (int i = 0; i < header.numDense; i++, ref += header.length) {
+            double err = relativeError(ref, &dense[i*header.denseStride][header.offset], header.length);
+            if (err > config.denseTolerance)
+                printf("    %s: dense grid channel %d is off by %.2f dB\n", config.name, i*header.denseStride, 20.0*log10(err));
+            TEST_ASSERT_TRUE_MESSAGE(err <= config.denseTolerance, config.name);
+        }
+        for (int i = 0; i < header.numSH; i++, ref += header.length) {
+            double err = relativeError(ref, &sh[i][header.offset], header.length);
+            if (err > config.shTolerance)
+                printf("    %s: SH channel %d is off by %.2f dB\n", config.name, i, 20.0*log10(err));
+            TEST_ASSERT_TRUE_MESSAGE(err <= config.shTolerance, config.name);
+        }
+    }
+    free(input);
+    if (generate)
+        TEST_IGNORE_MESSAGE("references written");
+}
+
+void test__sarita_blockSplits(void)
+{
+    const int length = 8192;
+    const float overlaps[] = { 12.5f, 25.0f, 49.0f };
+    float** input = (float**)malloc2d(MAX_NUM_SH_SIGNALS, length, sizeof(float));
+    makeTestInput(input, MAX_NUM_SH_SIGNALS, length);
+
+    for (int c = 0; c < numTestConfigs; c++) {
+        const char* name = testConfigs[c].name;
+        for (float overlap : overlaps) {
+            /* dense grid: only copies depend on the split, so bit-exact */
+            std::vector<std::vector<float>> regular, split;
+            SaritaTestRun regularRun = SaritaTestRun().withOverlap(overlap);
+            SaritaTestRun splitRun = SaritaTestRun().withOverlap(overlap).withBlocks(irregularBlocks);
+            TEST_ASSERT_TRUE_MESSAGE(runSarita(name, regularRun, input, length, regular), name);
+            TEST_ASSERT_TRUE_MESSAGE(runSarita(name, splitRun, input, length, split), name);
+            int numCompare = (int)SAF_MIN(regular[0].size(), split[0].size());
+            TEST_ASSERT_TRUE(numCompare > length/2);
+            for (size_t ch = 0; ch < regular.size(); ch++)
+                TEST_ASSERT_EQUAL_MEMORY(regular[ch].data(), split[ch].data(), numCompare*sizeof(float));
+        }
+
+        /* SH: the encoder is batched over the samples it is given, so the
+         * rounding may differ slightly between block sizes */
+        std::vector<std::vector<float>> regular, split;
+        SaritaTestRun regularRun = SaritaTestRun().withSH(true);
+        SaritaTestRun splitRun = SaritaTestRun().withSH(true).withBlocks(hopBlocks);
+        TEST_ASSERT_TRUE_MESSAGE(runSarita(name, regularRun, input, length, regular), name);
+        TEST_ASSERT_TRUE_MESSAGE(runSarita(name, splitRun, input, length, split), name);
+        int numCompare = (int)SAF_MIN(regular[0].size(), split[0].size());
+        TEST_ASSERT_TRUE(numCompare > length/2);
+        for (size_t ch = 0; ch < regular.size(); ch++)
+            TEST_ASSERT_TRUE_MESSAGE(relativeError(regular[ch].data(), split[ch].data(), numCompare) < 1e-5, name);
+    }
+    free(input);
+}
+
+void test__sarita_threads(void)
+{
+    const int length = 8192;
+    const int numThreads = 4;
+    float** input = (float**)malloc2d(MAX_NUM_SH_SIGNALS, length, sizeof(float));
+    makeTestInput(input, MAX_NUM_SH_SIGNALS, length);
+
+    for (int c = 0; c < numTestConfigs; c++) {
+        const char* name = testConfigs[c].name;
+        SaritaTestRun run = SaritaTestRun().withSH(true);
+        std::vector<std::vector<float>> single;
+        TEST_ASSERT_TRUE_MESSAGE(runSarita(name, run, input, length, single), name);
+
+        /* the same, on several threads at once */
+        std::vector<std::vector<std::vector<float>>> outputs(numThreads);
+        bool loaded[numThreads];
+        std::vector<std::thread> threads;
+        for (int t = 0; t < numThreads; t++)
+            threads.emplace_back([&, t]() { loaded[t] = runSarita(name, run, input, length, outputs[t]); });
+        for (auto& thread : threads)
+            thread.join();
+        for (int t = 0; t < numThreads; t++) {
+            TEST_ASSERT_TRUE_MESSAGE(loaded[t], name);
+            TEST_ASSERT_TRUE(outputs[t].size() == single.size() && outputs[t][0].size() == single[0].size());
+            for (size_t ch = 0; ch < single.size(); ch++)
+                TEST_ASSERT_EQUAL_MEMORY(single[ch].data(), outputs[t][ch].data(), single[ch].size()*sizeof(float));
+        }
+    }
+    free(input);
+}
+
+void test__sarita_api(void)
+{
+    const int length = 8192;
+    float** input = (float**)malloc2d(MAX_NUM_SH_SIGNALS, length, sizeof(float));
+    float** ioBlock = (float**)malloc2d(ARRAY2SH_MAX_NUM_SENSORS, frameSize, sizeof(float));
+    makeTestInput(input, MAX_NUM_SH_SIGNALS, length);
+
+    for (int c = 0; c < numTestConfigs; c++) {
+        const char* name = testConfigs[c].name;
+        std::string path = std::string(SARITA_CONFIG_DIR) + "/Sarita_" + name + ".cfg";
+        for (int sht = 0; sht < 2; sht++) {
+            /* the engine driven directly, as reference */
+            std::vector<std::vector<float>> reference;
+            SaritaTestRun run = SaritaTestRun().withSH(sht);
+            TEST_ASSERT_TRUE_MESSAGE(runSarita(name, run, input, length, reference), name);
+
+            /* a config loaded before sarita_init() is read by it */
+            void* hSar;
+            sarita_create(&hSar);
+            TEST_ASSERT_EQUAL_INT(0, sarita_loadConfig(hSar, path.c_str()));
+            TEST_ASSERT_EQUAL_INT(CODEC_STATUS_NOT_INITIALISED, sarita_getCodecStatus(hSar));
+            setTestParameters(hSar, SaritaTestRun().withSH(sht), configOrder(name));
+            sarita_init(hSar, fs, frameSize);
+            TEST_ASSERT_EQUAL_INT(CODEC_STATUS_INITIALISED, sarita_getCodecStatus(hSar));
+            TEST_ASSERT_EQUAL_INT(configOrder(name), sarita_getSourceOrder(hSar));
+            void* hA2sh = sarita_getArray2shHandle(hSar);
+            const int numInputs = sarita_getNumSparseSensors(hSar);
+            const int numOutputs = (int)reference.size();
+            TEST_ASSERT_EQUAL_INT(sht ? ORDER2NSH(sarita_getSourceOrder(hSar)) : sarita_getNumDenseSensors(hSar), numOutputs);
+            TEST_ASSERT_EQUAL_INT(frameSize + sarita_getMaxTimeShift(hSar) + (sht ? array2sh_getFilterbankProcessingDelay(hA2sh) : 0),
+                                  sarita_getProcessingDelay(hSar));
+            TEST_ASSERT_EQUAL_INT(SARITA_SHIFT_ESTIMATION_FULL_RATE, sarita_getActiveShiftEstimation(hSar));
+            sarita_setShiftEstimation(hSar, SARITA_SHIFT_ESTIMATION_DECIMATED);
+#ifdef SAF_USE_APPLE_ACCELERATE
+            TEST_ASSERT_EQUAL_INT(SARITA_SHIFT_ESTIMATION_FULL_RATE, sarita_getActiveShiftEstimation(hSar));
+#else
+            TEST_ASSERT_EQUAL_INT(SARITA_SHIFT_ESTIMATION_DECIMATED, sarita_getActiveShiftEstimation(hSar));
+#endif
+            sarita_setShiftEstimation(hSar, SARITA_SHIFT_ESTIMATION_FULL_RATE);
+
+            /* a config that cannot be read leaves the current one in place */
+            TEST_ASSERT_EQUAL_INT(-1, sarita_loadConfig(hSar, "does_not_exist.cfg"));
+            TEST_ASSERT_EQUAL_INT(CODEC_STATUS_INITIALISED, sarita_getCodecStatus(hSar));
+
+            /* processed in place; the output is one block behind the engine's
+             * own, as it is only popped once a whole block is buffered */
+            for (int pos = 0; pos + frameSize <= length; pos += frameSize) {
+                for (int ch = 0; ch < numInputs; ch++)
+                    memcpy(ioBlock[ch], &input[ch][pos], frameSize*sizeof(float));
+                sarita_process(hSar, ioBlock, ioBlock, numInputs, numOutputs, frameSize);
+                for (int ch = 0; ch < numOutputs; ch++) {
+                    if (pos == 0) {
+                        for (int i = 0; i < frameSize; i++)
+                            TEST_ASSERT_EQUAL_FLOAT(0.0f, ioBlock[ch][i]);
+                    }
+                    else if (!sht) /* same copies: bit-exact */
+                        TEST_ASSERT_EQUAL_MEMORY(&reference[ch][pos-frameSize], ioBlock[ch], frameSize*sizeof(float));
+                    else /* batched differently by the encoder (see blockSplits), which
+                          * matters most while its output is still fading in */
+                        TEST_ASSERT_TRUE_MESSAGE(relativeError(&reference[ch][pos-frameSize], ioBlock[ch], frameSize) <= testConfigs[c].shTolerance, name);
+                }
+            }
+
+            /* interleaved input (with a spare channel per frame) is processed
+             * as the same planar input */
+            if (!sht) {
+                void* hSarInterleaved;
+                sarita_create(&hSarInterleaved);
+                sarita_init(hSarInterleaved, fs, frameSize);
+                sarita_setOutputType(hSarInterleaved, SARITA_OUTPUT_DENSE_GRID);
+                TEST_ASSERT_EQUAL_INT(0, sarita_loadConfig(hSarInterleaved, path.c_str()));
+                const int stride = numInputs + 1;
+                std::vector<float> frames((size_t)frameSize * stride);
+                for (int pos = 0; pos + frameSize <= length; pos += frameSize) {
+                    for (int i = 0; i < frameSize; i++)
+                        for (int ch = 0; ch < stride; ch++)
+                            frames[(size_t)i*stride + ch] = ch < numInputs ? input[ch][pos + i] : 1.0f;
+                    sarita_processInterleaved(hSarInterleaved, frames.data(), stride, ioBlock, numInputs, numOutputs, frameSize);
+                    for (int ch = 0; pos > 0 && ch < numOutputs; ch++)
+                        TEST_ASSERT_EQUAL_MEMORY(&reference[ch][pos-frameSize], ioBlock[ch], frameSize*sizeof(float));
+                }
+                sarita_destroy(&hSarInterleaved);
+            }
+
+            /* swap in another config while blocks are being processed */
+            if (!sht) {
+                const SaritaTestConfig& next = testConfigs[(c + 1) % numTestConfigs];
+                std::string nextPath = std::string(SARITA_CONFIG_DIR) + "/Sarita_" + next.name + ".cfg";
+                int loaded = -1;
+                std::thread loader([&]() { loaded = sarita_loadConfig(hSar, nextPath.c_str()); });
+                for (int b = 0; b < 32; b++) {
+                    for (int ch = 0; ch < MAX_NUM_SH_SIGNALS; ch++)
+                        memcpy(ioBlock[ch], &input[ch][b*frameSize % (length-frameSize)], frameSize*sizeof(float));
+                    sarita_process(hSar, ioBlock, ioBlock, MAX_NUM_SH_SIGNALS, MAX_NUM_CHANNELS, frameSize);
+                }
+                loader.join();
+                TEST_ASSERT_EQUAL_INT(0, loaded);
+                TEST_ASSERT_EQUAL_INT(CODEC_STATUS_INITIALISED, sarita_getCodecStatus(hSar));
+                TEST_ASSERT_EQUAL_INT(configOrder(next.name), sarita_getSourceOrder(hSar));
+            }
+            sarita_destroy(&hSar);
+            TEST_ASSERT_NULL(hSar);
+        }
+    }
+    free(input);
+    free(ioBlock);
+}
+
+void test__sarita_segments(void)
+{
+    const float overlaps[] = { 12.5f, 25.0f };
+    float** input = NULL;
+    float** outBlock = (float**)malloc2d(ARRAY2SH_MAX_NUM_SENSORS, frameSize, sizeof(float));
+
+    for (int c = 0; c < numTestConfigs; c++) {
+        const char* name = testConfigs[c].name;
+        std::string path = std::string(SARITA_CONFIG_DIR) + "/Sarita_" + name + ".cfg";
+        for (float overlap : overlaps) {
+            for (int sht = 0; sht < 2; sht++) {
+                /* one instance from the start, and one from the first restart
+                 * point on, for a few blocks past its warm-up */
+                void* hSar[2];
+                for (int i = 0; i < 2; i++) {
+                    sarita_create(&hSar[i]);
+                    setTestParameters(hSar[i], SaritaTestRun().withOverlap(overlap).withSH(sht), MAX_SH_ORDER);
+                    sarita_init(hSar[i], fs, frameSize);
+                    TEST_ASSERT_EQUAL_INT_MESSAGE(0, sarita_loadConfig(hSar[i], path.c_str()), name);
+                }
+                const int alignment = sarita_getSegmentAlignment(hSar[0]);
+                const int warmUp = sarita_getWarmUpLength(hSar[0]);
+                TEST_ASSERT_TRUE(alignment > 0 && alignment % frameSize == 0 && warmUp > 0);
+                const int restart = alignment;
+                const int compareFrom = restart + (warmUp + frameSize - 1) / frameSize * frameSize;
+                const int length = compareFrom + 8 * frameSize;
+                const int numInputs = sarita_getNumSparseSensors(hSar[0]);
+                const int numOutputs = sht ? MAX_NUM_SH_SIGNALS : sarita_getNumDenseSensors(hSar[0]);
+                free(input);
+                input = (float**)malloc2d(MAX_NUM_SH_SIGNALS, length, sizeof(float));
+                makeTestInput(input, MAX_NUM_SH_SIGNALS, length);
+
+                std::vector<std::vector<float>> output(numOutputs, std::vector<float>(length - compareFrom));
+                for (int pos = 0; pos < length; pos += frameSize) {
+                    float* inBlock[MAX_NUM_SH_SIGNALS];
+                    for (int ch = 0; ch < numInputs; ch++)
+                        inBlock[ch] = &input[ch][pos];
+                    sarita_process(hSar[0], inBlock, outBlock, numInputs, numOutputs, frameSize);
+                    if (pos >= compareFrom)
+                        for (int ch = 0; ch < numOutputs; ch++)
+                            memcpy(&output[ch][pos - compareFrom], outBlock[ch], frameSize*sizeof(float));
+                    if (pos < restart)
+                        continue;
+                    sarita_process(hSar[1], inBlock, outBlock, numInputs, numOutputs, frameSize);
+                    if (pos >= compareFrom)
+                        for (int ch = 0; ch < numOutputs; ch++)
+                            TEST_ASSERT_EQUAL_MEMORY_MESSAGE(&output[ch][pos - compareFrom], outBlock[ch], frameSize*sizeof(float), name);
+                }
+                sarita_destroy(&hSar[0]);
+                sarita_destroy(&hSar[1]);
+            }
+        }
+    }
+    free(input);
+    free(outBlock);
+}
+
+void test__sarita_sharedData(void)
+{
+    const int length = 8192;
+    const int numInstances = 3;
+    SaritaRegistry& registry = SaritaRegistry::instance();
+    float** input = (float**)malloc2d(MAX_NUM_SH_SIGNALS, length, sizeof(float));
+    float** outBlock = (float**)malloc2d(MAX_NUM_SH_SIGNALS, frameSize, sizeof(float));
+    makeTestInput(input, MAX_NUM_SH_SIGNALS, length);
+
+    for (int c = 0; c < numTestConfigs; c++) {
+        const char* name = testConfigs[c].name;
+        std::string path = std::string(SARITA_CONFIG_DIR) + "/Sarita_" + name + ".cfg";
+        const size_t numConfigs = registry.numConfigs();
+        const size_t numEncoders = registry.numEncoders();
+
+        /* the engine driven directly, with its own encoder, as reference */
+        std::vector<std::vector<float>> reference;
+        SaritaTestRun run = SaritaTestRun().withSH(true);
+        TEST_ASSERT_TRUE_MESSAGE(runSarita(name, run, input, length, reference), name);
+        const int numOutputs = (int)reference.size();
+
+        /* several instances of the same config hold its tables once */
+        void* hSar[numInstances];
+        for (int i = 0; i < numInstances; i++) {
+            sarita_create(&hSar[i]);
+            setTestParameters(hSar[i], SaritaTestRun().withSH(true), configOrder(name));
+            sarita_init(hSar[i], fs, frameSize);
+            TEST_ASSERT_EQUAL_INT_MESSAGE(0, sarita_loadConfig(hSar[i], path.c_str()), name);
+            TEST_ASSERT_TRUE(((sarita_data*)hSar[i])->engine->config == ((sarita_data*)hSar[0])->engine->config);
+        }
+        TEST_ASSERT_EQUAL_INT(numConfigs + 1, registry.numConfigs());
+
+        /* ...and compute the encoder once, which is the same as their own */
+        const int numInputs = sarita_getNumSparseSensors(hSar[0]);
+        std::vector<float> first((size_t)numOutputs * frameSize);
+        for (int pos = 0; pos + frameSize <= length; pos += frameSize) {
+            const float* inBlock[MAX_NUM_SH_SIGNALS];
+            for (int ch = 0; ch < numInputs; ch++)
+                inBlock[ch] = &input[ch][pos];
+            for (int i = 0; i < numInstances; i++) {
+                sarita_process(hSar[i], inBlock, outBlock, numInputs, numOutputs, frameSize);
+                for (int ch = 0; ch < numOutputs; ch++) {
+                    if (i == 0)
+                        memcpy(&first[(size_t)ch * frameSize], outBlock[ch], frameSize*sizeof(float));
+                    else
+                        TEST_ASSERT_EQUAL_MEMORY_MESSAGE(&first[(size_t)ch * frameSize], outBlock[ch], frameSize*sizeof(float), name);
+                    if (pos > 0)
+                        TEST_ASSERT_TRUE_MESSAGE(relativeError(&reference[ch][pos-frameSize], outBlock[ch], frameSize) <= testConfigs[c].shTolerance, name);
+                }
+            }
+        }
+        TEST_ASSERT_EQUAL_INT(numEncoders + 1, registry.numEncoders());
+        /* the projection is part of the encoder, so they share it too */
+        for (int i = 1; i < numInstances; i++) {
+            TEST_ASSERT_NOT_NULL(array2sh_getProjection(sarita_getArray2shHandle(hSar[i])));
+            TEST_ASSERT_TRUE(array2sh_getProjection(sarita_getArray2shHandle(hSar[i])) ==
+                             array2sh_getProjection(sarita_getArray2shHandle(hSar[0])));
+        }
+
+        /* both are freed with the last instance */
+        for (int i = 0; i < numInstances; i++)
+            sarita_destroy(&hSar[i]);
+        TEST_ASSERT_EQUAL_INT(numConfigs, registry.numConfigs());
+        TEST_ASSERT_EQUAL_INT(numEncoders, registry.numEncoders());
+    }
+
+    /* a header whose tables would not fit into the file is rejected */
+    {
+        const uint32_t header[] = { fs, 4, 0, 0, 64, 10, 0xffffffffu, 20, 0xffffffffu };
+        SaritaConfig config;
+        TEST_ASSERT_FALSE(config.parse(std::string((const char*)header, sizeof(header))));
+    }
+    free(input);
+    free(outBlock);
+}
+
+void test__sarita_parameterChanges(void)
+{
+    const char* name = testConfigs[0].name;
+    std::string path = std::string(SARITA_CONFIG_DIR) + "/Sarita_" + name + ".cfg";
+    const int order = configOrder(name);
+    const int numBlocks = 400;
+    const int length = numBlocks * frameSize;
+    float** input = (float**)malloc2d(MAX_NUM_SH_SIGNALS, length, sizeof(float));
+    float** outBlock = (float**)malloc2d(MAX_NUM_SH_SIGNALS, frameSize, sizeof(float));
+    makeTestInput(input, MAX_NUM_SH_SIGNALS, length);
+
+    void* hSar;
+    sarita_create(&hSar);
+    setTestParameters(hSar, SaritaTestRun().withSH(true), order);
+    sarita_init(hSar, fs, frameSize);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(0, sarita_loadConfig(hSar, path.c_str()), name);
+    const int numInputs = sarita_getNumSparseSensors(hSar);
+
+    /* automation of all parameters from another thread, while processing */
+    const float overlaps[] = { 12.5f, 25.0f, 49.0f }; /* as offered by the plug-in */
+    std::atomic<bool> stop(false);
+    std::thread automation([&]() {
+        for (int i = 0; !stop; i++) {
+            sarita_parameters params;
+            sarita_getParameters(hSar, &params);
+            params.overlapPercent = overlaps[i % 3];
+            params.order = 1 + i % order;
+            params.norm = i % 2 ? NORM_N3D : NORM_SN3D;
+            params.gain_dB = (float)(i % 7 - 3);
+            params.filterType = i % 3 ? FILTER_TIKHONOV : FILTER_SOFT_LIM;
+            sarita_setParameters(hSar, &params);
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+    });
+    for (int b = 0; b < numBlocks; b++) {
+        const float* inBlock[MAX_NUM_SH_SIGNALS];
+        for (int ch = 0; ch < numInputs; ch++)
+            inBlock[ch] = &input[ch][b * frameSize];
+        sarita_process(hSar, inBlock, outBlock, numInputs, ORDER2NSH(order), frameSize);
+        for (int ch = 0; ch < ORDER2NSH(order); ch++)
+            for (int i = 0; i < frameSize; i++)
+                TEST_ASSERT_TRUE(std::isfinite(outBlock[ch][i]));
+    }
+    stop = true;
+    automation.join();
+
+    /* the last set is taken over as a whole, and the output resumes */
+    setTestParameters(hSar, SaritaTestRun().withSH(true), order);
+    sarita_parameters params;
+    sarita_getParameters(hSar, &params);
+    params.gain_dB = 0.0f;
+    sarita_setParameters(hSar, &params);
+    void* hA2sh = sarita_getArray2shHandle(hSar);
+    float energy = 0.0f;
+    for (int b = 0; b < 200 && energy == 0.0f; b++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        const float* inBlock[MAX_NUM_SH_SIGNALS];
+        for (int ch = 0; ch < numInputs; ch++)
+            inBlock[ch] = &input[ch][(b % numBlocks) * frameSize];
+        sarita_process(hSar, inBlock, outBlock, numInputs, ORDER2NSH(order), frameSize);
+        if (array2sh_getEncodingOrder(hA2sh) == order && !array2sh_getReinitSHTmatrixFLAG(hA2sh))
+            for (int i = 0; i < frameSize; i++)
+                energy += outBlock[ORDER2NSH(order) - 1][i] * outBlock[ORDER2NSH(order) - 1][i];
+    }
+    TEST_ASSERT_TRUE(energy > 0.0f);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, array2sh_getGain(hA2sh));
+    TEST_ASSERT_EQUAL_INT(frameSize / 4, ((sarita_data*)hSar)->engine->overlapSize);
+    TEST_ASSERT_EQUAL_FLOAT(25.0f, sarita_getOverlap(hSar));
+
+    sarita_destroy(&hSar);
+    free(input);
+    free(outBlock);
+}
+
+void test__sarita_overlapSwitch(void)
+{
+    const char* name = testConfigs[0].name;
+    std::string path = std::string(SARITA_CONFIG_DIR) + "/Sarita_" + name + ".cfg";
+    const int numBlocks = 80;
+    const int length = numBlocks * frameSize;
+    const float switches[][2] = { { 20, 12.5f }, { 30, 49.0f }, { 45, 6.0f }, { 55, 30.3f }, { 65, 25.0f } }; /* block, overlap */
+
+    /* the same signal on all sensors, so that the engine finds no time shifts
+     * and its output follows the input (scaled), whatever the overlap */
+    float** input = (float**)malloc2d(MAX_NUM_SH_SIGNALS, length, sizeof(float));
+    makeTestInput(input, 1, length);
+    for (int ch = 1; ch < MAX_NUM_SH_SIGNALS; ch++)
+        memcpy(input[ch], input[0], length * sizeof(float));
+
+    /* one instance at a constant overlap, and one switching between overlaps */
+    void* hSar[2];
+    std::vector<std::vector<float>> output(2, std::vector<float>(length));
+    float** outBlock = (float**)malloc2d(ARRAY2SH_MAX_NUM_SENSORS, frameSize, sizeof(float));
+    for (int i = 0; i < 2; i++) {
+        sarita_create(&hSar[i]);
+        setTestParameters(hSar[i], SaritaTestRun(), 1);
+        sarita_init(hSar[i], fs, frameSize);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(0, sarita_loadConfig(hSar[i], path.c_str()), name);
+        const int numInputs = sarita_getNumSparseSensors(hSar[i]);
+        const int numOutputs = sarita_getNumDenseSensors(hSar[i]);
+        for (int b = 0, s = 0; b < numBlocks; b++) {
+            if (i == 1 && s < (int)(sizeof(switches)/sizeof(switches[0])) && b == (int)switches[s][0])
+                sarita_setOverlap(hSar[i], switches[s++][1]);
+            const float* inBlock[MAX_NUM_SH_SIGNALS];
+            for (int ch = 0; ch < numInputs; ch++)
+                inBlock[ch] = &input[ch][b * frameSize];
+            sarita_process(hSar[i], inBlock, outBlock, numInputs, numOutputs, frameSize);
+            memcpy(&output[i][b * frameSize], outBlock[0], frameSize * sizeof(float));
+        }
+    }
+
+    /* overlaps are rounded to the precomputed steps */
+    TEST_ASSERT_EQUAL_FLOAT(25.0f, sarita_getOverlap(hSar[1]));
+    sarita_setOverlap(hSar[1], 30.3f);
+    TEST_ASSERT_EQUAL_FLOAT(30.5f, sarita_getOverlap(hSar[1]));
+
+    /* both stay in step, and each block (including those with a switch) only
+     * differs by the ripple of the windows */
+    for (int b = 2; b < numBlocks; b++)
+        TEST_ASSERT_TRUE_MESSAGE(relativeError(&output[0][b * frameSize], &output[1][b * frameSize], frameSize) < 0.05, name);
+
+    for (int i = 0; i < 2; i++)
+        sarita_destroy(&hSar[i]);
+    free(input);
+    free(outBlock);
+}
+
+void test__sarita_memory(void)
+{
+    const int length = 8192;
+    const char* name = testConfigs[0].name;
+    std::string path = std::string(SARITA_CONFIG_DIR) + "/Sarita_" + name + ".cfg";
+    float** input = (float**)malloc2d(MAX_NUM_SH_SIGNALS, length, sizeof(float));
+    float** outBlock = (float**)malloc2d(ARRAY2SH_MAX_NUM_SENSORS, frameSize, sizeof(float));
+    makeTestInput(input, MAX_NUM_SH_SIGNALS, length);
+
+    /* limits that this config just fits in */
+    Sarita engine;
+    TEST_ASSERT_EQUAL_INT(0, engine.setupSarita(path.c_str(), frameSize));
+    sarita_configLimits limits = engine.configSize();
+    engine.deallocBuffers();
+    std::vector<std::vector<float>> reference;
+    SaritaTestRun run;
+    TEST_ASSERT_TRUE_MESSAGE(runSarita(name, run, input, length, reference), name);
+    const int numOutputs = (int)reference.size();
+
+    void* hSar;
+    sarita_create(&hSar);
+    sarita_setConfigLimits(hSar, &limits);
+    setTestParameters(hSar, SaritaTestRun(), configOrder(name));
+    TEST_ASSERT_EQUAL_INT(0, (int)sarita_getMemorySize(hSar));
+    sarita_init(hSar, fs, frameSize);
+    TEST_ASSERT_EQUAL_INT(0, (int)sarita_getMemorySize(hSar));
+    const size_t memorySize = Sarita::memorySize(frameSize, limits);
+
+    /* reloaded several times, the output is that of the engine driven
+     * directly, and the memory is that of one engine */
+    for (int load = 0; load < 3; load++) {
+        TEST_ASSERT_EQUAL_INT_MESSAGE(0, sarita_loadConfig(hSar, path.c_str()), name);
+        const int numInputs = sarita_getNumSparseSensors(hSar);
+        for (int pos = 0; pos + frameSize <= length; pos += frameSize) {
+            const float* inBlock[MAX_NUM_SH_SIGNALS];
+            for (int ch = 0; ch < numInputs; ch++)
+                inBlock[ch] = &input[ch][pos];
+            sarita_process(hSar, inBlock, outBlock, numInputs, numOutputs, frameSize);
+            for (int ch = 0; pos > 0 && ch < numOutputs; ch++)
+                TEST_ASSERT_EQUAL_MEMORY_MESSAGE(&reference[ch][pos-frameSize], outBlock[ch], frameSize*sizeof(float), name);
+        }
+        TEST_ASSERT_EQUAL_INT((int)memorySize, (int)sarita_getMemorySize(hSar));
+    }
+
+    /* the other configs exceed the limits, and leave the current one in place */
+    for (int c = 1; c < numTestConfigs; c++) {
+        std::string otherPath = std::string(SARITA_CONFIG_DIR) + "/Sarita_" + testConfigs[c].name + ".cfg";
+        TEST_ASSERT_EQUAL_INT_MESSAGE(-1, sarita_loadConfig(hSar, otherPath.c_str()), testConfigs[c].name);
+        TEST_ASSERT_EQUAL_INT(CODEC_STATUS_INITIALISED, sarita_getCodecStatus(hSar));
+        TEST_ASSERT_EQUAL_INT(configOrder(name), sarita_getSourceOrder(hSar));
+    }
+
+    /* but all load within the default limits, once sarita_init() has applied
+     * them, each with the memory of its own config */
+    limits.maxSparseSensors = MAX_NUM_SH_SIGNALS;
+    limits.maxDenseSensors = SARITA_DEFAULT_MAX_DENSE_SENSORS;
+    limits.maxTimeShift = SARITA_DEFAULT_MAX_TIME_SHIFT;
+    limits.maxCrossCorrelations = SARITA_DEFAULT_MAX_CROSS_CORRELATIONS;
+    limits.maxNeighbors = SARITA_DEFAULT_MAX_NEIGHBORS;
+    sarita_setConfigLimits(hSar, &limits);
+    sarita_init(hSar, fs, frameSize);
+    TEST_ASSERT_EQUAL_INT(CODEC_STATUS_INITIALISED, sarita_getCodecStatus(hSar));
+    TEST_ASSERT_EQUAL_INT((int)memorySize, (int)sarita_getMemorySize(hSar));
+    for (int c = 0; c < numTestConfigs; c++) {
+        std::string otherPath = std::string(SARITA_CONFIG_DIR) + "/Sarita_" + testConfigs[c].name + ".cfg";
+        TEST_ASSERT_EQUAL_INT_MESSAGE(0, sarita_loadConfig(hSar, otherPath.c_str()), testConfigs[c].name);
+        TEST_ASSERT_EQUAL_INT(configOrder(testConfigs[c].name), sarita_getSourceOrder(hSar));
+        TEST_ASSERT_EQUAL_INT(0, engine.setupSarita(otherPath.c_str(), frameSize));
+        TEST_ASSERT_EQUAL_INT((int)Sarita::memorySize(frameSize, engine.configSize()), (int)sarita_getMemorySize(hSar));
+        engine.deallocBuffers();
+    }
+
+    sarita_destroy(&hSar);
+    free(input);
+    free(outBlock);
+}
+
+void test__sarita_kernels(void)
+{
+    const int length = 16384;
+    float** input = (float**)malloc2d(MAX_NUM_SH_SIGNALS, length, sizeof(float));
+    makeTestInput(input, MAX_NUM_SH_SIGNALS, length);
+
+    for (int c = 0; c < numTestConfigs; c++) {
+        const char* name = testConfigs[c].name;
+        std::string path = std::string(SARITA_CONFIG_DIR) + "/Sarita_" + name + ".cfg";
+        Sarita engine;
+        TEST_ASSERT_EQUAL_INT_MESSAGE(0, engine.setupSarita(path.c_str(), frameSize), name);
+        TEST_ASSERT_TRUE_MESSAGE(strcmp(engine.renderKernelName, "generic") != 0, name);
+        engine.deallocBuffers();
+
+        /* the same time shifts are found, so the output is the same to the bit */
+        std::vector<std::vector<float>> specialised, generic;
+        SaritaTestRun run = SaritaTestRun().withBlocks(irregularBlocks);
+        TEST_ASSERT_TRUE_MESSAGE(runSarita(name, run, input, length, specialised), name);
+        run.withGenericKernel(true);
+        TEST_ASSERT_TRUE_MESSAGE(runSarita(name, run, input, length, generic), name);
+        TEST_ASSERT_EQUAL_INT_MESSAGE((int)generic.size(), (int)specialised.size(), name);
+        for (size_t ch = 0; ch < generic.size(); ch++) {
+            TEST_ASSERT_EQUAL_INT_MESSAGE((int)generic[ch].size(), (int)specialised[ch].size(), name);
+            TEST_ASSERT_EQUAL_MEMORY_MESSAGE(generic[ch].data(), specialised[ch].data(), generic[ch].size()*sizeof(float), name);
+        }
+    }
+    free(input);
+}
+
+void test__sarita_decimatedShifts(void)
+{
+    const int length = 16384;
+    const int skip = 8 * frameSize; /* warm-up */
+    float** input = (float**)malloc2d(MAX_NUM_SH_SIGNALS, length, sizeof(float));
+    makeTestInput(input, MAX_NUM_SH_SIGNALS, length);
+
+    for (int c = 0; c < numTestConfigs; c++) {
+        const char* name = testConfigs[c].name;
+        std::vector<std::vector<float>> full, decimated;
+        double fullTime, decimatedTime;
+        SaritaTestRun run;
+        TEST_ASSERT_TRUE_MESSAGE(runSarita(name, run, input, length, full, &fullTime), name);
+        run.withShiftEstimation(SARITA_SHIFT_ESTIMATION_DECIMATED);
+        TEST_ASSERT_TRUE_MESSAGE(runSarita(name, run, input, length, decimated, &decimatedTime), name);
+
+        /* a direction of which the same time shifts are found is the same to
+         * the bit; the correlation peaks of the test input are well defined, so
+         * that is the case for almost all */
+        const int numCompare = (int)SAF_MIN(full[0].size(), decimated[0].size()) - skip;
+        TEST_ASSERT_TRUE(numCompare > length/2);
+        int numSame = 0;
+        double maxError = 0.0;
+        for (size_t ch = 0; ch < full.size(); ch++) {
+            if (memcmp(&full[ch][skip], &decimated[ch][skip], numCompare * sizeof(float)) == 0)
+                numSame++;
+            maxError = SAF_MAX(maxError, relativeError(&full[ch][skip], &decimated[ch][skip], numCompare));
+        }
+        printf("    %-15s %d of %d directions the same (max. error %.1f %%), %.2f ms instead of %.2f ms\n",
+               name, numSame, (int)full.size(), 100.0 * maxError, 1e3 * decimatedTime, 1e3 * fullTime);
+        TEST_ASSERT_TRUE_MESSAGE(numSame >= 0.95 * full.size(), name);
+    }
+    free(input);
+}
+
+/* Runs an instance with the options of 'run' over the whole input, in host
+ * blocks of the frame size, and returns its output (all dense grid channels,
+ * or the SH channels up to the order of the config; one block later than that
+ * of runSarita(), as sarita_process() pops a block before the engine driven
+ * directly does). The instance is returned for its state to be checked, and
+ * is destroyed by the caller */
+static void* runInstance(const char* config, const SaritaTestRun& run, float* const* input, int length,
+                         std::vector<std::vector<float>>& output)
+{
+    std::string path = std::string(SARITA_CONFIG_DIR) + "/Sarita_" + config + ".cfg";
+    const int order = configOrder(config);
+    void* hSar;
+    sarita_create(&hSar);
+    setTestParameters(hSar, run, order);
+    sarita_init(hSar, fs, frameSize);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(0, sarita_loadConfig(hSar, path.c_str()), config);
+    const int numInputs = sarita_getNumArraySensors(hSar);
+    const int numOutputs = run.sht ? ORDER2NSH(order) : sarita_getNumDenseSensors(hSar);
+    float** outBlock = (float**)malloc2d(numOutputs, frameSize, sizeof(float));
+    output.assign(numOutputs, std::vector<float>());
+    for (int pos = 0; pos + frameSize <= length; pos += frameSize) {
+        const float* inBlock[MAX_NUM_SH_SIGNALS];
+        for (int ch = 0; ch < numInputs; ch++)
+            inBlock[ch] = &input[ch][pos];
+        sarita_process(hSar, inBlock, outBlock, numInputs, numOutputs, frameSize);
+        for (int ch = 0; ch < numOutputs; ch++)
+            output[ch].insert(output[ch].end(), outBlock[ch], outBlock[ch] + frameSize);
+    }
+    free(outBlock);
+    return hSar;
+}
+
+/* runs an instance of the given quality over the input, and returns its dense
+ * grid signals, and the number of correlations and the expected error of each
+ * direction that it was pruned to */
+static void runQuality(const char* config, SARITA_QUALITY quality, float* const* input, int length,
+                       std::vector<std::vector<float>>& output, int& numCrossCorrelations, std::vector<float>& errors)
+{
+    void* hSar = runInstance(config, SaritaTestRun().withQuality(quality), input, length, output);
+    const int numOutputs = (int)output.size();
+    numCrossCorrelations = sarita_getNumCrossCorrelations(hSar);
+    errors.assign(numOutputs, -1.0f);
+    float maxError = sarita_getPruningErrors(hSar, errors.data(), numOutputs);
+    for (float error : errors)
+        TEST_ASSERT_TRUE(error >= 0.0f && error <= maxError);
+    sarita_destroy(&hSar);
+}
+
+void test__sarita_pruning(void)
+{
+    const int length = 16384;
+    const int skip = 8 * frameSize; /* warm-up */
+    float** input = (float**)malloc2d(MAX_NUM_SH_SIGNALS, length, sizeof(float));
+    makeTestInput(input, MAX_NUM_SH_SIGNALS, length);
+    const SARITA_QUALITY qualities[] = { SARITA_QUALITY_HIGH, SARITA_QUALITY_MEDIUM, SARITA_QUALITY_LOW };
+
+    for (int c = 0; c < numTestConfigs; c++) {
+        const char* name = testConfigs[c].name;
+
+        /* the full quality drops no neighbours, so the output is that of the
+         * engine driven directly (which leaves out no correlations) */
+        std::vector<std::vector<float>> full, reference;
+        std::vector<float> errors;
+        int numFull, numPruned;
+        SaritaTestRun run;
+        TEST_ASSERT_TRUE_MESSAGE(runSarita(name, run, input, length, reference), name);
+        runQuality(name, SARITA_QUALITY_FULL, input, length, full, numFull, errors);
+        for (size_t ch = 0; ch < full.size(); ch++) {
+            TEST_ASSERT_EQUAL_MEMORY_MESSAGE(reference[ch].data(), &full[ch][frameSize], (length-frameSize)*sizeof(float), name);
+            TEST_ASSERT_EQUAL_FLOAT(0.0f, errors[ch]);
+        }
+
+        /* the expected error of each direction is within the bound of the
+         * preset, and bounds the measured one: the aligned signals of this
+         * input are alike correlated (up to the float rounding of the sums),
+         * and their time shifts are whole samples, so that the mean of the
+         * kept neighbours is off by less than that of the bound. Both grow
+         * with the share of the neighbours dropped, while the
+         * cross-correlations only the dropped ones used are left out */
+        double prevMeasured = 0.0;
+        for (SARITA_QUALITY quality : qualities) {
+            sarita_parameters bound;
+            sarita_applyQualityPreset(&bound, quality);
+            std::vector<std::vector<float>> pruned;
+            runQuality(name, quality, input, length, pruned, numPruned, errors);
+            TEST_ASSERT_TRUE_MESSAGE(numPruned <= numFull, name);
+            double sumMeasured = 0.0, maxExpected = 0.0, worstMargin = -1.0;
+            for (size_t ch = 0; ch < full.size(); ch++) {
+                TEST_ASSERT_TRUE_MESSAGE(errors[ch] <= bound.maxPruningError, name);
+                double measured = relativeError(&full[ch][skip], &pruned[ch][skip], length - skip);
+                TEST_ASSERT_TRUE_MESSAGE(measured <= errors[ch] + 1e-4, name);
+                sumMeasured += measured * measured;
+                maxExpected = SAF_MAX(maxExpected, errors[ch]);
+                worstMargin = SAF_MAX(worstMargin, measured - errors[ch]);
+            }
+            const double rmsMeasured = sqrt(sumMeasured / full.size());
+            printf("    %s, quality %d: expected error <= %.1f %%, measured %.2f %% (rms), above the expected by %+.4f %% at most\n",
+                   name, (int)quality, 100.0 * maxExpected, 100.0 * rmsMeasured, 100.0 * worstMargin);
+            TEST_ASSERT_TRUE_MESSAGE(maxExpected > 0.0, name);
+            TEST_ASSERT_TRUE_MESSAGE(rmsMeasured >= prevMeasured, name);
+            prevMeasured = rmsMeasured;
+        }
+
+        /* a running instance is rebuilt in the background */
+        void* hSar;
+        sarita_create(&hSar);
+        setTestParameters(hSar, SaritaTestRun(), configOrder(name));
+        sarita_init(hSar, fs, frameSize);
+        std::string path = std::string(SARITA_CONFIG_DIR) + "/Sarita_" + name + ".cfg";
+        TEST_ASSERT_EQUAL_INT_MESSAGE(0, sarita_loadConfig(hSar, path.c_str()), name);
+        TEST_ASSERT_EQUAL_FLOAT(0.0f, sarita_getPruningErrors(hSar, NULL, 0));
+        sarita_setQuality(hSar, SARITA_QUALITY_LOW);
+        for (int i = 0; i < 400 && sarita_getPruningErrors(hSar, NULL, 0) == 0.0f; i++)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        TEST_ASSERT_TRUE_MESSAGE(sarita_getPruningErrors(hSar, NULL, 0) > 0.0f, name);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(numPruned, sarita_getNumCrossCorrelations(hSar), name);
+        sarita_destroy(&hSar);
+    }
+    free(input);
+}
+
+/* runs an instance over the input, with or without the band split, and
+ * returns its SH signals up to the order of the config */
+static void runBandSplit(const char* config, SARITA_BAND_SPLIT bandSplit, float* const* input, int length,
+                         std::vector<std::vector<float>>& output, float& crossoverFreq, float& aliasingFreq)
+{
+    void* hSar = runInstance(config, SaritaTestRun().withSH(true).withBandSplit(bandSplit), input, length, output);
+    TEST_ASSERT_TRUE_MESSAGE(sarita_getNumArraySensors(hSar) >= sarita_getNumSparseSensors(hSar), config);
+    /* the bands are split by the encoder, in the time-frequency domain */
+    if (bandSplit == SARITA_BAND_SPLIT_ON)
+        TEST_ASSERT_EQUAL_INT_MESSAGE(SARITA_UPSAMPLING_DOMAIN_TIME_FREQUENCY, sarita_getActiveUpsamplingDomain(hSar), config);
+    crossoverFreq = sarita_getCrossoverFrequency(hSar);
+    aliasingFreq = sarita_getAliasingFrequency(hSar);
+    sarita_destroy(&hSar);
+}
+
+void test__sarita_bandSplit(void)
+{
+    const int length = 16384;
+    const int skip = 8 * frameSize; /* warm-up */
+    const int maxLag = 8;
+    float** input = (float**)malloc2d(MAX_NUM_SH_SIGNALS, length, sizeof(float));
+    makeTestInput(input, MAX_NUM_SH_SIGNALS, length);
+
+    for (int c = 0; c < numTestConfigs; c++) {
+        const char* name = testConfigs[c].name;
+        std::vector<std::vector<float>> full, split;
+        float crossoverFreq, aliasingFreq;
+        runBandSplit(name, SARITA_BAND_SPLIT_OFF, input, length, full, crossoverFreq, aliasingFreq);
+        runBandSplit(name, SARITA_BAND_SPLIT_ON, input, length, split, crossoverFreq, aliasingFreq);
+        TEST_ASSERT_TRUE_MESSAGE(aliasingFreq > 1000.0f && aliasingFreq < 10000.0f, name);
+        TEST_ASSERT_EQUAL_FLOAT_MESSAGE(aliasingFreq, crossoverFreq, name);
+
+        /* the omnidirectional signal of this input is about the same below the
+         * crossover, whether from the sparse array or from the dense grid, and
+         * the same above it; the bands are split by the filterbank, without
+         * a crossover filter, so the two signals are most alike at the same
+         * sample */
+        const int numCompare = length - skip - maxLag;
+        double fullEnergy = 0.0, splitEnergy = 0.0, bestProduct = 0.0;
+        int bestLag = 0;
+        for (int i = skip; i < skip + numCompare; i++) {
+            fullEnergy += full[0][i] * full[0][i];
+            splitEnergy += split[0][i] * split[0][i];
+        }
+        for (int lag = -maxLag; lag <= maxLag; lag++) {
+            double product = 0.0;
+            for (int i = skip; i < skip + numCompare; i++)
+                product += full[0][i] * split[0][i + lag];
+            if (product > bestProduct) {
+                bestProduct = product;
+                bestLag = lag;
+            }
+        }
+        const double levelDifference = 10.0 * log10(splitEnergy / fullEnergy);
+        printf("    %-15s crossover %.0f Hz, omni level %+.2f dB, lag %d, correlation %.3f\n", name, crossoverFreq,
+               levelDifference, bestLag, bestProduct / sqrt(fullEnergy * splitEnergy));
+        TEST_ASSERT_TRUE_MESSAGE(fabs(levelDifference) < 1.0, name);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(0, bestLag, name);
+    }
+    free(input);
+}
+
+/* runs an instance over the input, in either domain, and returns its SH
+ * signals up to the order of the config */
+static void runDomain(const char* config, SARITA_UPSAMPLING_DOMAIN domain, float* const* input, int length,
+                      std::vector<std::vector<float>>& output)
+{
+    void* hSar = runInstance(config, SaritaTestRun().withSH(true).withDomain(domain), input, length, output);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(domain, sarita_getUpsamplingDomain(hSar), config);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(domain, sarita_getActiveUpsamplingDomain(hSar), config);
+    sarita_destroy(&hSar);
+}
+
+void test__sarita_fusedDomain(void)
+{
+    const int length = 16384;
+    const int skip = 8 * frameSize; /* warm-up */
+    const int maxLag = 8;
+    float** input = (float**)malloc2d(MAX_NUM_SH_SIGNALS, length, sizeof(float));
+    makeTestInput(input, MAX_NUM_SH_SIGNALS, length);
+
+    for (int c = 0; c < numTestConfigs; c++) {
+        const char* name = testConfigs[c].name;
+        std::vector<std::vector<float>> timeDomain, fused;
+        runDomain(name, SARITA_UPSAMPLING_DOMAIN_TIME, input, length, timeDomain);
+        runDomain(name, SARITA_UPSAMPLING_DOMAIN_TIME_FREQUENCY, input, length, fused);
+
+        /* the time shifts are applied as phases, per band and time slot
+         * rather than per sample and frame, so the SH signals are alike,
+         * rather than equal, in level and time */
+        const int numCompare = length - skip - maxLag;
+        double worstLevel = 0.0, worstCorrelation = 1.0;
+        for (int ch = 0; ch < (int)fused.size(); ch++) {
+            double timeEnergy = 0.0, fusedEnergy = 0.0, bestProduct = 0.0;
+            int bestLag = 0;
+            for (int i = skip; i < skip + numCompare; i++) {
+                timeEnergy += timeDomain[ch][i] * timeDomain[ch][i];
+                fusedEnergy += fused[ch][i] * fused[ch][i];
+            }
+            for (int lag = -maxLag; lag <= maxLag; lag++) {
+                double product = 0.0;
+                for (int i = skip; i < skip + numCompare; i++)
+                    product += timeDomain[ch][i] * fused[ch][i + lag];
+                if (product > bestProduct) {
+                    bestProduct = product;
+                    bestLag = lag;
+                }
+            }
+            const double levelDifference = 10.0 * log10(fusedEnergy / timeEnergy);
+            if (fabs(levelDifference) > fabs(worstLevel))
+                worstLevel = levelDifference;
+            worstCorrelation = SAF_MIN(worstCorrelation, bestProduct / sqrt(timeEnergy * fusedEnergy));
+            TEST_ASSERT_EQUAL_INT_MESSAGE(0, bestLag, name);
+        }
+        printf("    %-15s worst of %d channels: level %+.2f dB, correlation %.3f\n", name, (int)fused.size(),
+               worstLevel, worstCorrelation);
+        TEST_ASSERT_TRUE_MESSAGE(fabs(worstLevel) < 0.5, name);
+        TEST_ASSERT_TRUE_MESSAGE(worstCorrelation > 0.98, name);
+    }
+    free(input);
+}
+
+void test__sarita_performance(void)
+{
+    const int length = fs; /* one second */
+    float** input = (float**)malloc2d(MAX_NUM_SH_SIGNALS, length, sizeof(float));
+    makeTestInput(input, MAX_NUM_SH_SIGNALS, length);
+
+    printf("\n");
+    for (int c = 0; c < numTestConfigs; c++) {
+        for (int sht = 0; sht < 2; sht++) {
+            std::vector<std::vector<float>> output;
+            SaritaTestRun run = SaritaTestRun().withSH(sht);
+            double seconds = 0.0;
+            TEST_ASSERT_TRUE_MESSAGE(runSarita(testConfigs[c].name, run, input, length, output, &seconds), testConfigs[c].name);
+            double audioSeconds = (double)(length - frameSize) / (double)fs;
+            printf("    %-15s %-5s %8.2f ms per second of audio (%.1fx realtime)\n", testConfigs[c].name,
+                   sht ? "SHT" : "dense", 1e3 * seconds / audioSeconds, audioSeconds / SAF_MAX(seconds, 1e-9));
+        }
+    }
+    free(input);
+}